@@ -15,6 +15,7 @@
 export 'src/constants.dart';
 export 'src/core/room.dart';
 export 'src/core/room_preconnect.dart';
+export 'src/data_stream/compression.dart';
 export 'src/data_stream/stream_reader.dart';
 export 'src/data_stream/stream_writer.dart';
 export 'src/e2ee/e2ee_manager.dart';
@@ -36,18 +37,32 @@ export 'src/preconnect/pre_connect_audio_buffer.dart';
 export 'src/publication/local.dart';
 export 'src/publication/remote.dart';
 export 'src/publication/track_publication.dart';
+export 'src/stats/audio_source_stats.dart';
+export 'src/stats/native_audio_source_stats.dart';
+export 'src/stats/talk_stats.dart';
+export 'src/support/codec.dart' show BandFrame, BandFrameExtension, CodecExtension, LiveKitMessageCodec;
 export 'src/support/platform.dart';
+export 'src/track/audio_file_source.dart';
+export 'src/track/audio_frequency_monitor.dart';
+export 'src/track/audio_replay_buffer.dart';
 export 'src/track/audio_visualizer.dart';
+export 'src/track/echo_leak_detector.dart';
+export 'src/track/latest_bands.dart';
 export 'src/track/local/audio.dart';
 export 'src/track/local/local.dart';
 export 'src/track/local/video.dart';
 export 'src/track/options.dart';
+export 'src/track/pcm_audio_source.dart';
 export 'src/track/processor.dart';
 export 'src/track/processor_native.dart' if (dart.library.js_interop) 'src/track/processor_web.dart';
 export 'src/track/remote/audio.dart';
 export 'src/track/remote/remote.dart';
 export 'src/track/remote/video.dart';
 export 'src/track/track.dart';
+export 'src/track/utterance_segmenter.dart';
+export 'src/track/video_quality_analyzer.dart';
+export 'src/track/video_thumbnail.dart';
+export 'src/track/visualizer_stats.dart';
 export 'src/types/attribute_typings.dart';
 export 'src/types/data_stream.dart';
 export 'src/types/other.dart';
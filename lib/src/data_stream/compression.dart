@@ -0,0 +1,129 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:typed_data';
+
+import '../types/data_stream.dart' show kStreamChunkSize;
+import 'compression_ffi.dart' if (dart.library.js_interop) 'compression_ffi_web.dart';
+
+const _flushNone = 0;
+const _flushSync = 1;
+const _flushFinish = 2;
+
+/// Compresses data stream payloads such as transcripts and files with zlib
+/// (RFC 1950), natively and without copying them through the Dart heap
+/// twice.
+///
+/// Every [add] ends with a sync flush, so each returned chunk can be sent as
+/// one data stream chunk and the receiver can decode everything written so
+/// far as soon as it arrives. Chunks are at most [chunkSize] bytes. Receivers
+/// decode with [DataStreamDecompressor], or any zlib implementation such as
+/// dart:io's `ZLibDecoder`; use stream attributes to tell them a stream is
+/// compressed. Only supported on Linux, see [isSupported].
+class DataStreamCompressor {
+  static bool get isSupported => NativeZlibStream.isSupported;
+
+  final int chunkSize;
+  final NativeZlibStream _stream;
+  bool _closed = false;
+
+  DataStreamCompressor._(this._stream, this.chunkSize);
+
+  /// [level] is a zlib compression level from 0 to 9, 6 by default. Throws an
+  /// [UnsupportedError] where [isSupported] is false.
+  factory DataStreamCompressor({int level = 6, int chunkSize = kStreamChunkSize}) {
+    final stream = NativeZlibStream.create(compress: true, level: level);
+    if (stream == null) {
+      throw UnsupportedError('Native compression is not available on this platform');
+    }
+    return DataStreamCompressor._(stream, chunkSize);
+  }
+
+  /// Compresses [data] and returns the chunks to send, possibly none.
+  List<Uint8List> add(Uint8List data) => _process(data, _flushSync);
+
+  /// Ends the stream and returns its last chunks.
+  List<Uint8List> close() {
+    if (_closed) {
+      return const [];
+    }
+    final chunks = _process(Uint8List(0), _flushFinish);
+    _closed = true;
+    return chunks;
+  }
+
+  List<Uint8List> _process(Uint8List data, int flush) {
+    if (_closed) {
+      throw StateError('DataStreamCompressor is closed');
+    }
+    final chunks = <Uint8List>[];
+    var offset = 0;
+    while (true) {
+      final chunk = Uint8List(chunkSize);
+      final written = _stream.process(data, offset, chunk, flush);
+      if (written < 0) {
+        throw StateError('Compression failed');
+      }
+      offset += _stream.consumed;
+      if (written > 0) {
+        chunks.add(written == chunkSize ? chunk : Uint8List.sublistView(chunk, 0, written));
+      }
+      if (offset == data.length && written < chunkSize) {
+        return chunks;
+      }
+    }
+  }
+}
+
+/// Decompresses the chunks of a stream compressed with
+/// [DataStreamCompressor], in order. Only supported on Linux.
+class DataStreamDecompressor {
+  static bool get isSupported => NativeZlibStream.isSupported;
+
+  static const _bufferSize = 64 * 1024;
+
+  final NativeZlibStream _stream;
+  final _buffer = Uint8List(_bufferSize);
+
+  DataStreamDecompressor._(this._stream);
+
+  /// Throws an [UnsupportedError] where [isSupported] is false.
+  factory DataStreamDecompressor() {
+    final stream = NativeZlibStream.create(compress: false);
+    if (stream == null) {
+      throw UnsupportedError('Native compression is not available on this platform');
+    }
+    return DataStreamDecompressor._(stream);
+  }
+
+  /// Returns the bytes decoded from [chunk]. Throws a [FormatException] on
+  /// corrupt data.
+  Uint8List add(Uint8List chunk) {
+    final output = BytesBuilder(copy: true);
+    var offset = 0;
+    while (true) {
+      final written = _stream.process(chunk, offset, _buffer, _flushNone);
+      if (written < 0) {
+        throw const FormatException('Corrupt compressed data stream');
+      }
+      offset += _stream.consumed;
+      if (written > 0) {
+        output.add(Uint8List.sublistView(_buffer, 0, written));
+      }
+      if (offset == chunk.length && written < _bufferSize) {
+        return output.takeBytes();
+      }
+    }
+  }
+}
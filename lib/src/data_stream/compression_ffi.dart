@@ -0,0 +1,86 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:ffi';
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+typedef _NewC = Pointer<Void> Function(Int32 compress, Int32 level);
+typedef _NewDart = Pointer<Void> Function(int compress, int level);
+typedef _ProcessC = Int32 Function(Pointer<Void> stream, Pointer<Uint8> input, Int32 inputSize,
+    Pointer<Int32> inputConsumed, Pointer<Uint8> output, Int32 outputCapacity, Int32 flush);
+typedef _ProcessDart = int Function(Pointer<Void> stream, Pointer<Uint8> input, int inputSize,
+    Pointer<Int32> inputConsumed, Pointer<Uint8> output, int outputCapacity, int flush);
+
+class _Bindings {
+  final _NewDart create;
+  final _ProcessDart process;
+  final NativeFinalizer finalizer;
+
+  _Bindings(this.create, this.process, this.finalizer);
+}
+
+// Declared in linux/include/livekit_client/live_kit_plugin.h. The plugin
+// library is linked into the runner, so its symbols resolve in the process.
+final _Bindings? _bindings = () {
+  if (!Platform.isLinux) {
+    return null;
+  }
+  try {
+    final library = DynamicLibrary.process();
+    return _Bindings(
+      library.lookupFunction<_NewC, _NewDart>('livekit_zlib_stream_new'),
+      library.lookupFunction<_ProcessC, _ProcessDart>('livekit_zlib_stream_process', isLeaf: true),
+      NativeFinalizer(library.lookup<NativeFunction<Void Function(Pointer<Void>)>>('livekit_zlib_stream_free')),
+    );
+  } catch (_) {
+    return null;
+  }
+}();
+
+/// A native zlib stream, freed when garbage collected.
+class NativeZlibStream implements Finalizable {
+  static bool get isSupported => _bindings != null;
+
+  final Pointer<Void> _stream;
+  final _consumed = Int32List(1);
+
+  NativeZlibStream._(this._stream);
+
+  /// Returns null where the native library is unavailable.
+  static NativeZlibStream? create({required bool compress, int level = -1}) {
+    final bindings = _bindings;
+    if (bindings == null) {
+      return null;
+    }
+    final stream = bindings.create(compress ? 1 : 0, level);
+    if (stream == nullptr) {
+      return null;
+    }
+    final result = NativeZlibStream._(stream);
+    bindings.finalizer.attach(result, stream);
+    return result;
+  }
+
+  /// Bytes of the input consumed by the last [process] call.
+  int get consumed => _consumed[0];
+
+  /// Processes [input] from [offset] into [output] and returns the number of
+  /// bytes written, or -1 on corrupt input. See livekit_zlib_stream_process.
+  int process(Uint8List input, int offset, Uint8List output, int flush) {
+    final rest = Uint8List.sublistView(input, offset);
+    return _bindings!.process(
+        _stream, rest.address, rest.length, _consumed.address, output.address, output.length, flush);
+  }
+}
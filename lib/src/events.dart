@@ -22,6 +22,7 @@ import 'publication/local.dart';
 import 'publication/remote.dart';
 import 'publication/track_publication.dart';
 import 'stats/stats.dart';
+import 'support/codec.dart' show BandFrame;
 import 'track/processor.dart';
 import 'track/track.dart';
 import 'types/other.dart';
@@ -566,9 +567,13 @@ class VideoReceiverStatsEvent with TrackEvent {
 class AudioVisualizerEvent with TrackEvent {
   final Track track;
   final List<Object?> event;
+
+  /// Timing metadata of [event], when the platform provides it.
+  final BandFrame? frame;
   const AudioVisualizerEvent({
     required this.track,
     required this.event,
+    this.frame,
   });
 
   @override
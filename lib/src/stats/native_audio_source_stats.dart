@@ -0,0 +1,99 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import '../track/local/local.dart' show AudioTrack;
+import '../track/remote/remote.dart' show RemoteTrack;
+import 'audio_source_stats.dart';
+
+final _uuid = uuid.Uuid();
+
+/// Computes the level counters of [AudioSourceStats] natively for a group of
+/// audio tracks, without polling and parsing `getStats` reports.
+///
+/// Only [AudioSourceStats.audioLevel], [AudioSourceStats.totalAudioEnergy]
+/// and [AudioSourceStats.totalSamplesDuration] are filled in, counted from
+/// when the track was added. Levels are RMS based. Stats of all tracks are
+/// read with a single method call. Only supported on Linux.
+class NativeAudioSourceStatsCollector extends Disposable {
+  final String collectorId = _uuid.v4();
+  final Map<String, AudioTrack> _tracks = {};
+
+  NativeAudioSourceStatsCollector() {
+    onDispose(() async {
+      if (_tracks.isNotEmpty) {
+        _tracks.clear();
+        await Native.stopAudioSourceStats(collectorId: collectorId);
+      }
+    });
+  }
+
+  /// Starts computing stats for [track]. Returns false if not supported.
+  Future<bool> add(AudioTrack track) async {
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+    if (_tracks.containsKey(trackId)) {
+      return true;
+    }
+    final started = await Native.startAudioSourceStats(trackId, collectorId: collectorId);
+    if (started) {
+      _tracks[trackId] = track;
+    }
+    return started;
+  }
+
+  Future<void> remove(AudioTrack track) async {
+    final trackId = track.mediaStreamTrack.id;
+    if (trackId == null || _tracks.remove(trackId) == null) {
+      return;
+    }
+    await Native.stopAudioSourceStats(collectorId: collectorId, trackId: trackId);
+  }
+
+  /// Current stats of every added track.
+  Future<Map<AudioTrack, AudioSourceStats>> getStats() async {
+    if (_tracks.isEmpty) {
+      return {};
+    }
+    final trackIds = _tracks.keys.toList();
+    final values = await Native.getAudioSourceStats(collectorId: collectorId, trackIds: trackIds);
+    if (values == null || values.length != trackIds.length * 3) {
+      return {};
+    }
+    final result = <AudioTrack, AudioSourceStats>{};
+    for (var i = 0; i < trackIds.length; i++) {
+      final audioLevel = values[i * 3];
+      if (audioLevel.isNaN) {
+        continue;
+      }
+      final track = _tracks[trackIds[i]]!;
+      result[track] = AudioSourceStats(
+        audioLevel: audioLevel,
+        totalAudioEnergy: values[i * 3 + 1],
+        totalSamplesDuration: values[i * 3 + 2],
+        echoReturnLoss: null,
+        echoReturnLossEnhancement: null,
+        trackIdentifier: trackIds[i],
+        remoteSource: track is RemoteTrack,
+      );
+    }
+    return result;
+  }
+}
@@ -0,0 +1,137 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import '../track/local/local.dart' show AudioTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Talk time counters of one audio track, accumulated since it was added to
+/// a [TalkStatsCollector].
+class TalkStats {
+  /// Duration of audio received from the track.
+  final Duration totalTime;
+
+  /// Time the track carried speech.
+  final Duration voicedTime;
+
+  /// Voiced time during which another track of the collector was voiced too.
+  final Duration overlapTime;
+
+  /// Sum of the squared audio level times duration, like WebRTC's
+  /// `totalAudioEnergy`.
+  final double energy;
+
+  /// Number of times the track went from silence to speech.
+  final int talkSpurts;
+
+  /// Talk spurts that started while another track was voiced.
+  final int interruptions;
+
+  /// Whether the track is currently voiced.
+  final bool speaking;
+
+  const TalkStats({
+    required this.totalTime,
+    required this.voicedTime,
+    required this.overlapTime,
+    required this.energy,
+    required this.talkSpurts,
+    required this.interruptions,
+    required this.speaking,
+  });
+
+  factory TalkStats.fromMap(Map<Object?, Object?> map) {
+    Duration seconds(Object? value) => Duration(microseconds: ((value as num? ?? 0) * 1e6).round());
+    return TalkStats(
+      totalTime: seconds(map['totalTime']),
+      voicedTime: seconds(map['voicedTime']),
+      overlapTime: seconds(map['overlapTime']),
+      energy: (map['energy'] as num? ?? 0).toDouble(),
+      talkSpurts: (map['talkSpurts'] as num? ?? 0).toInt(),
+      interruptions: (map['interruptions'] as num? ?? 0).toInt(),
+      speaking: map['speaking'] == true,
+    );
+  }
+
+  /// Fraction of [totalTime] without speech.
+  double get silenceRatio =>
+      totalTime == Duration.zero ? 1 : 1 - voicedTime.inMicroseconds / totalTime.inMicroseconds;
+
+  @override
+  String toString() => '${runtimeType}(totalTime: $totalTime, voicedTime: $voicedTime, overlapTime: $overlapTime, '
+      'talkSpurts: $talkSpurts, interruptions: $interruptions, speaking: $speaking)';
+}
+
+/// Accumulates talk time, energy and overlapping speech for a group of audio
+/// tracks, typically every participant of a room.
+///
+/// Counters are maintained natively from each track's audio callbacks, so
+/// nothing runs on the Dart side until [getStats] is called. Overlap and
+/// interruptions are measured between the tracks of the same collector.
+/// Only supported on Linux.
+class TalkStatsCollector extends Disposable {
+  final String collectorId = _uuid.v4();
+  final Map<String, AudioTrack> _tracks = {};
+
+  TalkStatsCollector() {
+    onDispose(() async {
+      if (_tracks.isNotEmpty) {
+        _tracks.clear();
+        await Native.stopTalkStats(collectorId: collectorId);
+      }
+    });
+  }
+
+  /// Starts accounting for [track]. Returns false if not supported.
+  Future<bool> add(AudioTrack track) async {
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+    if (_tracks.containsKey(trackId)) {
+      return true;
+    }
+    final started = await Native.startTalkStats(trackId, collectorId: collectorId);
+    if (started) {
+      _tracks[trackId] = track;
+    }
+    return started;
+  }
+
+  /// Stops accounting for [track] and drops its counters.
+  Future<void> remove(AudioTrack track) async {
+    final trackId = track.mediaStreamTrack.id;
+    if (trackId == null || _tracks.remove(trackId) == null) {
+      return;
+    }
+    await Native.stopTalkStats(collectorId: collectorId, trackId: trackId);
+  }
+
+  /// Current counters of every added track.
+  Future<Map<AudioTrack, TalkStats>> getStats() async {
+    if (_tracks.isEmpty) {
+      return {};
+    }
+    final stats = await Native.getTalkStats(collectorId: collectorId);
+    return {
+      for (final entry in stats.entries)
+        if (_tracks[entry.key] != null) _tracks[entry.key]!: TalkStats.fromMap(entry.value),
+    };
+  }
+}
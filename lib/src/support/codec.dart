@@ -0,0 +1,142 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+import 'package:meta/meta.dart';
+
+/// Encodes one custom type of [LiveKitMessageCodec] as its type byte followed
+/// by a layout of its own. Must match the StandardCodecExtension of the same
+/// [type] in the native plugin.
+abstract class CodecExtension<T extends Object> {
+  const CodecExtension();
+
+  /// Type byte, from 128 to 255; lower values are used by the standard codec.
+  int get type;
+
+  void write(StandardMessageCodec codec, WriteBuffer buffer, T value);
+
+  T read(StandardMessageCodec codec, ReadBuffer buffer);
+
+  bool _tryWrite(StandardMessageCodec codec, WriteBuffer buffer, Object value) {
+    if (value is! T) {
+      return false;
+    }
+    buffer.putUint8(type);
+    write(codec, buffer, value);
+    return true;
+  }
+}
+
+/// [StandardMessageCodec] with [CodecExtension]s for typed records. Values
+/// without an extension are encoded as by the standard codec.
+class LiveKitMessageCodec extends StandardMessageCodec {
+  final List<CodecExtension> extensions;
+
+  const LiveKitMessageCodec({this.extensions = const [BandFrameExtension()]});
+
+  @override
+  void writeValue(WriteBuffer buffer, Object? value) {
+    if (value != null) {
+      for (final extension in extensions) {
+        if (extension._tryWrite(this, buffer, value)) {
+          return;
+        }
+      }
+    }
+    super.writeValue(buffer, value);
+  }
+
+  @override
+  Object? readValueOfType(int type, ReadBuffer buffer) {
+    for (final extension in extensions) {
+      if (extension.type == type) {
+        return extension.read(this, buffer);
+      }
+    }
+    return super.readValueOfType(type, buffer);
+  }
+}
+
+/// Method codec of the plugin's event channels.
+@internal
+const livekitMethodCodec = StandardMethodCodec(LiveKitMessageCodec());
+
+/// Visualizer bands sent by the native plugin with their timing metadata.
+class BandFrame {
+  /// Time the bands were computed, on a monotonic clock of the native side.
+  final Duration timestamp;
+
+  /// Counts the frames of one visualizer from 0, so gaps reveal dropped
+  /// frames.
+  final int sequence;
+
+  /// Sample rate of the analysed audio.
+  final int sampleRate;
+
+  final Float32List bands;
+
+  /// Peak hold values of [bands] when the visualizer smooths them with an
+  /// envelope, otherwise empty.
+  final Float32List peaks;
+
+  BandFrame({
+    required this.timestamp,
+    required this.sequence,
+    required this.sampleRate,
+    required this.bands,
+    Float32List? peaks,
+  }) : peaks = peaks ?? Float32List(0);
+}
+
+/// Layout: band count (standard size encoding), int64 timestamp in
+/// microseconds, uint32 sequence, int32 sample rate, float32 bands aligned to
+/// 4 bytes, peak count (standard size encoding), float32 peaks aligned to 4
+/// bytes.
+class BandFrameExtension extends CodecExtension<BandFrame> {
+  const BandFrameExtension();
+
+  @override
+  int get type => 128;
+
+  @override
+  void write(StandardMessageCodec codec, WriteBuffer buffer, BandFrame value) {
+    codec.writeSize(buffer, value.bands.length);
+    buffer
+      ..putInt64(value.timestamp.inMicroseconds)
+      ..putUint32(value.sequence)
+      ..putInt32(value.sampleRate)
+      ..putFloat32List(value.bands);
+    codec.writeSize(buffer, value.peaks.length);
+    buffer.putFloat32List(value.peaks);
+  }
+
+  @override
+  BandFrame read(StandardMessageCodec codec, ReadBuffer buffer) {
+    final length = codec.readSize(buffer);
+    final timestamp = Duration(microseconds: buffer.getInt64());
+    final sequence = buffer.getUint32();
+    final sampleRate = buffer.getInt32();
+    final bands = buffer.getFloat32List(length);
+    return BandFrame(
+      timestamp: timestamp,
+      sequence: sequence,
+      sampleRate: sampleRate,
+      bands: bands,
+      peaks: buffer.getFloat32List(codec.readSize(buffer)),
+    );
+  }
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 import 'dart:async';
+import 'dart:typed_data';
 
 import 'package:flutter/services.dart';
 
@@ -20,6 +21,7 @@ import 'package:meta/meta.dart';
 
 import '../logger.dart';
 import '../managers/broadcast_manager.dart';
+import '../track/audio_visualizer.dart' show VisualizerEnvelope;
 import 'native_audio.dart';
 
 // Method channel methods to call native code.
@@ -57,6 +59,9 @@ class Native {
     int barCount = 7,
     String visualizerId = '',
     bool smoothTransition = true,
+    bool publishLatest = false,
+    int? idleReleaseMs,
+    VisualizerEnvelope? envelope,
   }) async {
     try {
       final result = await channel.invokeMethod<bool>(
@@ -67,6 +72,16 @@ class Native {
           'barCount': barCount,
           'visualizerId': visualizerId,
           'smoothTransition': smoothTransition,
+          'publishLatest': publishLatest,
+          if (idleReleaseMs != null) 'idleReleaseMs': idleReleaseMs,
+          if (envelope != null) ...{
+            'envelope': true,
+            'attackMs': envelope.attack.inMilliseconds,
+            'releaseMs': envelope.release.inMilliseconds,
+            'peakHoldMs': envelope.peakHold.inMilliseconds,
+            'peakFallPerSecond': envelope.peakFallPerSecond,
+            'frameRate': envelope.frameRate,
+          },
         },
       );
       return result == true;
@@ -91,6 +106,535 @@ class Native {
     }
   }
 
+  @internal
+  static Future<bool> setVisualizerShadowMode({
+    required double fraction,
+    required bool useFixedPoint,
+    int? fftSize,
+    double? minFrequency,
+    double? maxFrequency,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'setVisualizerShadowMode',
+        <String, dynamic>{
+          'fraction': fraction,
+          'useFixedPoint': useFixedPoint,
+          if (fftSize != null) 'fftSize': fftSize,
+          if (minFrequency != null) 'minFrequency': minFrequency,
+          if (maxFrequency != null) 'maxFrequency': maxFrequency,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('setVisualizerShadowMode did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<Map<Object?, Object?>?> getVisualizerStats() async {
+    try {
+      return await channel.invokeMethod<Map<Object?, Object?>>('getVisualizerStats');
+    } catch (error) {
+      logger.warning('getVisualizerStats did throw $error');
+      return null;
+    }
+  }
+
+  @internal
+  static Future<bool> startFrequencyMonitor(
+    String trackId, {
+    required String monitorId,
+    required List<double> frequencies,
+    int? windowMs,
+    int? intervalMs,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startFrequencyMonitor',
+        <String, dynamic>{
+          'trackId': trackId,
+          'monitorId': monitorId,
+          'frequencies': frequencies,
+          if (windowMs != null) 'windowMs': windowMs,
+          if (intervalMs != null) 'intervalMs': intervalMs,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startFrequencyMonitor did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopFrequencyMonitor({required String monitorId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopFrequencyMonitor',
+        <String, dynamic>{
+          'monitorId': monitorId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopFrequencyMonitor did throw $error');
+    }
+  }
+
+  @internal
+  static Future<bool> startReplayBuffer(
+    String trackId, {
+    required String bufferId,
+    required double seconds,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startReplayBuffer',
+        <String, dynamic>{
+          'trackId': trackId,
+          'bufferId': bufferId,
+          'seconds': seconds,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startReplayBuffer did throw $error');
+      return false;
+    }
+  }
+
+  /// Saves a replay buffer to a WAV file at [path] and returns the seconds
+  /// of audio written, or null on failure.
+  @internal
+  static Future<double?> saveReplayBuffer({
+    required String bufferId,
+    required String path,
+    double? seconds,
+  }) async {
+    try {
+      return await channel.invokeMethod<double>(
+        'saveReplayBuffer',
+        <String, dynamic>{
+          'bufferId': bufferId,
+          'path': path,
+          if (seconds != null) 'seconds': seconds,
+        },
+      );
+    } catch (error) {
+      logger.warning('saveReplayBuffer did throw $error');
+      return null;
+    }
+  }
+
+  @internal
+  static Future<void> stopReplayBuffer({required String bufferId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopReplayBuffer',
+        <String, dynamic>{
+          'bufferId': bufferId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopReplayBuffer did throw $error');
+    }
+  }
+
+  @internal
+  static Future<bool> startUtteranceSegmenter(
+    String trackId, {
+    required String segmenterId,
+    required String format,
+    int? preRollMs,
+    int? hangoverMs,
+    int? minSpeechMs,
+    int? maxUtteranceMs,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startUtteranceSegmenter',
+        <String, dynamic>{
+          'trackId': trackId,
+          'segmenterId': segmenterId,
+          'format': format,
+          if (preRollMs != null) 'preRollMs': preRollMs,
+          if (hangoverMs != null) 'hangoverMs': hangoverMs,
+          if (minSpeechMs != null) 'minSpeechMs': minSpeechMs,
+          if (maxUtteranceMs != null) 'maxUtteranceMs': maxUtteranceMs,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startUtteranceSegmenter did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopUtteranceSegmenter({required String segmenterId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopUtteranceSegmenter',
+        <String, dynamic>{
+          'segmenterId': segmenterId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopUtteranceSegmenter did throw $error');
+    }
+  }
+
+  @internal
+  static Future<bool> startVideoQualityAnalyzer(
+    String trackId, {
+    required String analyzerId,
+    int? analysisIntervalMs,
+    int? reportIntervalMs,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startVideoQualityAnalyzer',
+        <String, dynamic>{
+          'trackId': trackId,
+          'analyzerId': analyzerId,
+          if (analysisIntervalMs != null) 'analysisIntervalMs': analysisIntervalMs,
+          if (reportIntervalMs != null) 'reportIntervalMs': reportIntervalMs,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startVideoQualityAnalyzer did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopVideoQualityAnalyzer({required String analyzerId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopVideoQualityAnalyzer',
+        <String, dynamic>{
+          'analyzerId': analyzerId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopVideoQualityAnalyzer did throw $error');
+    }
+  }
+
+  @internal
+  static Future<int?> startThumbnail(
+    String trackId, {
+    required String thumbnailId,
+    required int width,
+    required int height,
+    int? maxFps,
+  }) async {
+    try {
+      return await channel.invokeMethod<int>(
+        'startThumbnail',
+        <String, dynamic>{
+          'trackId': trackId,
+          'thumbnailId': thumbnailId,
+          'width': width,
+          'height': height,
+          if (maxFps != null) 'maxFps': maxFps,
+        },
+      );
+    } catch (error) {
+      logger.warning('startThumbnail did throw $error');
+      return null;
+    }
+  }
+
+  @internal
+  static Future<void> stopThumbnail({required String thumbnailId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopThumbnail',
+        <String, dynamic>{
+          'thumbnailId': thumbnailId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopThumbnail did throw $error');
+    }
+  }
+
+  @internal
+  static Future<bool> startEchoDetector(
+    String trackId, {
+    required String detectorId,
+    required List<String> remoteTrackIds,
+    double? coherenceThreshold,
+  }) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startEchoDetector',
+        <String, dynamic>{
+          'trackId': trackId,
+          'detectorId': detectorId,
+          'remoteTrackIds': remoteTrackIds,
+          if (coherenceThreshold != null) 'coherenceThreshold': coherenceThreshold,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startEchoDetector did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopEchoDetector({required String detectorId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopEchoDetector',
+        <String, dynamic>{
+          'detectorId': detectorId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopEchoDetector did throw $error');
+    }
+  }
+
+  @internal
+  static Future<bool> startTalkStats(String trackId, {required String collectorId}) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startTalkStats',
+        <String, dynamic>{
+          'trackId': trackId,
+          'collectorId': collectorId,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startTalkStats did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopTalkStats({required String collectorId, String? trackId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopTalkStats',
+        <String, dynamic>{
+          'collectorId': collectorId,
+          if (trackId != null) 'trackId': trackId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopTalkStats did throw $error');
+    }
+  }
+
+  @internal
+  static Future<Map<String, Map<Object?, Object?>>> getTalkStats({required String collectorId}) async {
+    try {
+      final result = await channel.invokeMethod<Map<Object?, Object?>>(
+        'getTalkStats',
+        <String, dynamic>{
+          'collectorId': collectorId,
+        },
+      );
+      return {
+        for (final entry in (result ?? const {}).entries)
+          if (entry.key is String && entry.value is Map) entry.key as String: entry.value as Map<Object?, Object?>,
+      };
+    } catch (error) {
+      logger.warning('getTalkStats did throw $error');
+      return {};
+    }
+  }
+
+  @internal
+  static Future<bool> startAudioSourceStats(String trackId, {required String collectorId}) async {
+    try {
+      final result = await channel.invokeMethod<bool>(
+        'startAudioSourceStats',
+        <String, dynamic>{
+          'trackId': trackId,
+          'collectorId': collectorId,
+        },
+      );
+      return result == true;
+    } catch (error) {
+      logger.warning('startAudioSourceStats did throw $error');
+      return false;
+    }
+  }
+
+  @internal
+  static Future<void> stopAudioSourceStats({required String collectorId, String? trackId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'stopAudioSourceStats',
+        <String, dynamic>{
+          'collectorId': collectorId,
+          if (trackId != null) 'trackId': trackId,
+        },
+      );
+    } catch (error) {
+      logger.warning('stopAudioSourceStats did throw $error');
+    }
+  }
+
+  /// Returns audioLevel, totalAudioEnergy and totalSamplesDuration for each of
+  /// [trackIds], flattened in the same order. Untracked ids yield NaNs.
+  @internal
+  static Future<Float64List?> getAudioSourceStats({
+    required String collectorId,
+    required List<String> trackIds,
+  }) async {
+    try {
+      return await channel.invokeMethod<Float64List>(
+        'getAudioSourceStats',
+        <String, dynamic>{
+          'collectorId': collectorId,
+          'trackIds': trackIds,
+        },
+      );
+    } catch (error) {
+      logger.warning('getAudioSourceStats did throw $error');
+      return null;
+    }
+  }
+
+  /// Returns the latest bands of the visualizers [visualizerIds] as a map
+  /// with `versions` (an Int64List, 0 when nothing was published) and `bands`
+  /// (a list of Float32List or null), both in request order.
+  @internal
+  static Future<Map<Object?, Object?>?> getLatestBands(List<String> visualizerIds) async {
+    try {
+      return await channel.invokeMethod<Map<Object?, Object?>>(
+        'getLatestBands',
+        <String, dynamic>{
+          'visualizerIds': visualizerIds,
+        },
+      );
+    } catch (error) {
+      logger.warning('getLatestBands did throw $error');
+      return null;
+    }
+  }
+
+  /// Creates a native audio track fed with PCM over a binary channel. Returns
+  /// a map with the `trackId` and the `channel` name, or null on failure.
+  @internal
+  static Future<Map<Object?, Object?>?> createPcmSource({
+    required String sourceId,
+    required int sampleRate,
+    required int channels,
+    required int bufferMs,
+    required int prebufferMs,
+  }) async {
+    try {
+      return await channel.invokeMethod<Map<Object?, Object?>>(
+        'createPcmSource',
+        <String, dynamic>{
+          'sourceId': sourceId,
+          'sampleRate': sampleRate,
+          'channels': channels,
+          'bufferMs': bufferMs,
+          'prebufferMs': prebufferMs,
+        },
+      );
+    } catch (error) {
+      logger.warning('createPcmSource did throw $error');
+      return null;
+    }
+  }
+
+  @internal
+  static Future<void> disposePcmSource({required String sourceId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'disposePcmSource',
+        <String, dynamic>{
+          'sourceId': sourceId,
+        },
+      );
+    } catch (error) {
+      logger.warning('disposePcmSource did throw $error');
+    }
+  }
+
+  @internal
+  static Future<Map<Object?, Object?>?> getPcmSourceStats({required String sourceId}) async {
+    try {
+      return await channel.invokeMethod<Map<Object?, Object?>>(
+        'getPcmSourceStats',
+        <String, dynamic>{
+          'sourceId': sourceId,
+        },
+      );
+    } catch (error) {
+      logger.warning('getPcmSourceStats did throw $error');
+      return null;
+    }
+  }
+
+  /// Creates a native audio track playing the WAV file at [path]. Returns a
+  /// map with the `trackId` and the file `duration` in seconds, or null on
+  /// failure.
+  @internal
+  static Future<Map<Object?, Object?>?> createFileSource({
+    required String sourceId,
+    required String path,
+    required bool loop,
+    int? sampleRate,
+    int? channels,
+  }) async {
+    try {
+      return await channel.invokeMethod<Map<Object?, Object?>>(
+        'createFileSource',
+        <String, dynamic>{
+          'sourceId': sourceId,
+          'path': path,
+          'loop': loop,
+          if (sampleRate != null) 'sampleRate': sampleRate,
+          if (channels != null) 'channels': channels,
+        },
+      );
+    } catch (error) {
+      logger.warning('createFileSource did throw $error');
+      return null;
+    }
+  }
+
+  @internal
+  static Future<void> seekFileSource({required String sourceId, required double position}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'seekFileSource',
+        <String, dynamic>{
+          'sourceId': sourceId,
+          'position': position,
+        },
+      );
+    } catch (error) {
+      logger.warning('seekFileSource did throw $error');
+    }
+  }
+
+  @internal
+  static Future<void> disposeFileSource({required String sourceId}) async {
+    try {
+      await channel.invokeMethod<void>(
+        'disposeFileSource',
+        <String, dynamic>{
+          'sourceId': sourceId,
+        },
+      );
+    } catch (error) {
+      logger.warning('disposeFileSource did throw $error');
+    }
+  }
+
   @internal
   static Future<bool> startAudioRenderer({
     required String trackId,
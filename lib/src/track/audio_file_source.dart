@@ -0,0 +1,81 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+
+final _uuid = uuid.Uuid();
+
+/// An audio track that plays a WAV file, for synthetic participants and
+/// repeatable load tests.
+///
+/// The file is memory-mapped and converted natively 10 ms at a time as the
+/// track plays, so nothing is decoded in Dart or up front, and many sources,
+/// even of the same file, can play at once: they share one native clock
+/// thread and the file's pages. 8, 16, 24 and 32-bit integer and 32-bit float
+/// files are supported.
+///
+/// The track is registered with flutter_webrtc as a local track under
+/// [trackId]. Only supported on Linux.
+class AudioFileSource extends Disposable {
+  final String sourceId;
+  final String trackId;
+
+  /// Length of the file.
+  final Duration duration;
+
+  AudioFileSource._(this.sourceId, this.trackId, this.duration) {
+    onDispose(() => Native.disposeFileSource(sourceId: sourceId));
+  }
+
+  /// Opens the WAV file at [path], played [loop]ing or once followed by
+  /// silence. The track uses the file's sample rate and up to two of its
+  /// channels unless [sampleRate] (a multiple of 100) or [channels] (1 or 2)
+  /// are given. Returns null if the file cannot be played or this is not
+  /// supported.
+  static Future<AudioFileSource?> create(
+    String path, {
+    bool loop = true,
+    int? sampleRate,
+    int? channels,
+  }) async {
+    if (lkPlatformIs(PlatformType.web)) {
+      return null;
+    }
+    final sourceId = _uuid.v4();
+    final result = await Native.createFileSource(
+      sourceId: sourceId,
+      path: path,
+      loop: loop,
+      sampleRate: sampleRate,
+      channels: channels,
+    );
+    final trackId = result?['trackId'];
+    final duration = result?['duration'];
+    if (trackId is! String || duration is! num) {
+      return null;
+    }
+    return AudioFileSource._(sourceId, trackId, Duration(microseconds: (duration * 1e6).round()));
+  }
+
+  /// Continues playback from [position] into the file.
+  Future<void> seek(Duration position) async {
+    if (!isDisposed) {
+      await Native.seekFileSource(sourceId: sourceId, position: position.inMicroseconds / 1e6);
+    }
+  }
+}
@@ -0,0 +1,107 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:async';
+
+import 'package:flutter/services.dart';
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/local.dart' show AudioTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Reports the level of a few fixed frequencies of an [AudioTrack], such as a
+/// tone detector or a mains hum monitor.
+///
+/// Levels are computed natively with a sliding DFT that only tracks the
+/// requested frequencies, which is far cheaper than a full spectrum analysis.
+/// Each frequency is rounded to the nearest multiple of `1 / window`.
+/// Only supported on Linux.
+class AudioFrequencyMonitor extends Disposable {
+  final AudioTrack track;
+  final List<double> frequencies;
+
+  /// Length of the analysis window. Longer windows resolve closer frequencies
+  /// but react more slowly.
+  final Duration window;
+
+  /// How often [levels] emits.
+  final Duration interval;
+
+  final String monitorId = _uuid.v4();
+
+  EventChannel? _eventChannel;
+  StreamSubscription? _subscription;
+  final _controller = StreamController<List<double>>.broadcast();
+
+  /// Level in dBFS of each entry of [frequencies], in the same order.
+  Stream<List<double>> get levels => _controller.stream;
+
+  AudioFrequencyMonitor(
+    this.track, {
+    required this.frequencies,
+    this.window = const Duration(milliseconds: 100),
+    this.interval = const Duration(milliseconds: 50),
+  }) {
+    onDispose(() async {
+      await stop();
+      await _controller.close();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_eventChannel != null) {
+      return true;
+    }
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+
+    final started = await Native.startFrequencyMonitor(
+      trackId,
+      monitorId: monitorId,
+      frequencies: frequencies,
+      windowMs: window.inMilliseconds,
+      intervalMs: interval.inMilliseconds,
+    );
+    if (!started) {
+      return false;
+    }
+
+    _eventChannel = EventChannel('io.livekit.audio.frequency_monitor/eventChannel-$trackId-$monitorId');
+    _subscription = _eventChannel?.receiveBroadcastStream().listen((event) {
+      if (event is List) {
+        _controller.add(event.cast<double>());
+      }
+    });
+    return true;
+  }
+
+  Future<void> stop() async {
+    if (_eventChannel == null) {
+      return;
+    }
+
+    await _subscription?.cancel();
+    _subscription = null;
+
+    await Native.stopFrequencyMonitor(monitorId: monitorId);
+    _eventChannel = null;
+  }
+}
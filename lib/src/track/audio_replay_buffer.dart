@@ -0,0 +1,90 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/local.dart' show AudioTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Keeps the last [length] of an [AudioTrack]'s audio so that it can be saved
+/// after the fact, e.g. when a moderator reports an incident.
+///
+/// Audio is kept natively, mixed to mono and mu-law encoded in preallocated
+/// blocks: a minute at 48 kHz takes under 3 MB per track. Create one buffer
+/// per track to cover a whole room.
+/// Only supported on Linux.
+class AudioReplayBuffer extends Disposable {
+  final AudioTrack track;
+  final Duration length;
+
+  final String bufferId = _uuid.v4();
+
+  bool _started = false;
+
+  AudioReplayBuffer(
+    this.track, {
+    this.length = const Duration(seconds: 60),
+  }) {
+    onDispose(() async {
+      await stop();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_started) {
+      return true;
+    }
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+
+    _started = await Native.startReplayBuffer(
+      trackId,
+      bufferId: bufferId,
+      seconds: length.inMilliseconds / 1000,
+    );
+    return _started;
+  }
+
+  /// Writes the last [last] of audio, or everything buffered, to [path] as a
+  /// 16-bit mono WAV file. The file is written on a background thread.
+  /// Returns the duration saved, or null if nothing was.
+  Future<Duration?> save(String path, {Duration? last}) async {
+    if (!_started) {
+      return null;
+    }
+    final seconds = await Native.saveReplayBuffer(
+      bufferId: bufferId,
+      path: path,
+      seconds: last != null ? last.inMilliseconds / 1000 : null,
+    );
+    if (seconds == null) {
+      return null;
+    }
+    return Duration(microseconds: (seconds * Duration.microsecondsPerSecond).round());
+  }
+
+  Future<void> stop() async {
+    if (!_started) {
+      return;
+    }
+    _started = false;
+    await Native.stopReplayBuffer(bufferId: bufferId);
+  }
+}
@@ -8,14 +8,60 @@ import 'local/local.dart' show AudioTrack;
 
 final _uuid = uuid.Uuid();
 
+/// Attack/release smoothing with peak hold, computed natively so that bars
+/// can be drawn as received, without animating each of them. Frames then
+/// carry the smoothed bands and `BandFrame.peaks`. Only used on Linux.
+class VisualizerEnvelope {
+  /// Time constant while a band rises.
+  final Duration attack;
+
+  /// Time constant while a band falls.
+  final Duration release;
+
+  /// How long a peak stays before it falls.
+  final Duration peakHold;
+
+  /// How fast peaks fall after [peakHold], in full scale per second.
+  final double peakFallPerSecond;
+
+  /// Frames per second to emit, at most one per audio callback (100). Each
+  /// frame follows the loudest bands since the previous one. 0 emits a frame
+  /// per audio callback.
+  final int frameRate;
+
+  const VisualizerEnvelope({
+    this.attack = const Duration(milliseconds: 20),
+    this.release = const Duration(milliseconds: 250),
+    this.peakHold = const Duration(milliseconds: 500),
+    this.peakFallPerSecond = 1.0,
+    this.frameRate = 60,
+  });
+}
+
 class AudioVisualizerOptions {
   final bool centeredBands;
   final int barCount;
   final bool smoothTransition;
+
+  /// Computes bands even while no event listener is attached, so they can be
+  /// pulled with `LatestBandsReader` instead.
+  final bool publishLatest;
+
+  /// How long native analysis buffers are kept after the last event listener
+  /// cancels, so that a visualizer scrolled out of view and back does not
+  /// reallocate them. They are allocated again on the next listen. Uses the
+  /// native default of 5 seconds when null.
+  final Duration? idleRelease;
+
+  /// Smooths bands natively instead of sending them raw.
+  final VisualizerEnvelope? envelope;
   const AudioVisualizerOptions({
     this.centeredBands = true,
     this.barCount = 7,
     this.smoothTransition = true,
+    this.publishLatest = false,
+    this.idleRelease,
+    this.envelope,
   });
 }
 
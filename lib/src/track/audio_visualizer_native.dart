@@ -5,6 +5,7 @@ import 'package:flutter/services.dart';
 import 'package:flutter_webrtc/flutter_webrtc.dart';
 
 import '../events.dart' show AudioVisualizerEvent;
+import '../support/codec.dart';
 import '../support/native.dart' show Native;
 import '../track/local/local.dart';
 import 'audio_visualizer.dart';
@@ -36,13 +37,22 @@ class AudioVisualizerNative extends AudioVisualizer {
       barCount: visualizerOptions.barCount,
       visualizerId: visualizerId,
       smoothTransition: visualizerOptions.smoothTransition,
+      publishLatest: visualizerOptions.publishLatest,
+      idleReleaseMs: visualizerOptions.idleRelease?.inMilliseconds,
+      envelope: visualizerOptions.envelope,
     );
 
-    _eventChannel = EventChannel('io.livekit.audio.visualizer/eventChannel-${mediaStreamTrack.id}-$visualizerId');
+    _eventChannel = EventChannel(
+      'io.livekit.audio.visualizer/eventChannel-${mediaStreamTrack.id}-$visualizerId',
+      livekitMethodCodec,
+    );
     _streamSubscription = _eventChannel?.receiveBroadcastStream().listen((event) {
+      // Linux sends typed BandFrames, other platforms plain lists.
+      final frame = event is BandFrame ? event : null;
       events.emit(AudioVisualizerEvent(
         track: _audioTrack!,
-        event: event,
+        event: frame?.bands ?? event,
+        frame: frame,
       ));
     });
   }
@@ -53,10 +63,12 @@ class AudioVisualizerNative extends AudioVisualizer {
       return;
     }
 
-    await Native.stopVisualizer(mediaStreamTrack.id!, visualizerId: visualizerId);
-
+    // Cancel while the native event channel still exists; stopping
+    // unregisters it.
     await _streamSubscription?.cancel();
     _streamSubscription = null;
+
+    await Native.stopVisualizer(mediaStreamTrack.id!, visualizerId: visualizerId);
     _eventChannel = null;
   }
 }
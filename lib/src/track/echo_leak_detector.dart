@@ -0,0 +1,151 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:async';
+
+import 'package:flutter/services.dart';
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/audio.dart';
+import 'remote/audio.dart';
+
+final _uuid = uuid.Uuid();
+
+/// Emitted by [EchoLeakDetector] when echo starts or stops being detected.
+class EchoLeakAlert {
+  /// Whether remote audio is currently leaking into the microphone.
+  final bool echoDetected;
+
+  /// The remote track whose audio was found in the microphone signal.
+  final RemoteAudioTrack remoteTrack;
+
+  /// Delay between the remote audio being received and it reaching the
+  /// microphone.
+  final Duration delay;
+
+  /// Level of the leaked audio relative to the remote audio, in dB.
+  final double couplingDb;
+
+  /// Normalized correlation between the remote audio and the microphone
+  /// signal, from 0 to 1.
+  final double coherence;
+
+  const EchoLeakAlert({
+    required this.echoDetected,
+    required this.remoteTrack,
+    required this.delay,
+    required this.couplingDb,
+    required this.coherence,
+  });
+
+  @override
+  String toString() => '${runtimeType}(echoDetected: $echoDetected, '
+      'remoteTrack: ${remoteTrack.sid}, delay: $delay, '
+      'couplingDb: ${couplingDb.toStringAsFixed(1)}, '
+      'coherence: ${coherence.toStringAsFixed(2)})';
+}
+
+/// Detects remote participants' audio leaking from the speakers into the
+/// microphone of [localTrack], the usual reason remote participants hear
+/// themselves.
+///
+/// The microphone signal is correlated natively against [remoteTracks], so no
+/// audio is sent to Dart or to a server. [alerts] only emits when echo starts
+/// or stops being detected. Only supported on Linux.
+class EchoLeakDetector extends Disposable {
+  final LocalAudioTrack localTrack;
+  final List<RemoteAudioTrack> remoteTracks;
+
+  /// Correlation, from 0 to 1, above which remote audio counts as leaking.
+  /// Uses the native default when null.
+  final double? coherenceThreshold;
+
+  final String detectorId = _uuid.v4();
+
+  EventChannel? _eventChannel;
+  StreamSubscription? _subscription;
+  final _controller = StreamController<EchoLeakAlert>.broadcast();
+
+  Stream<EchoLeakAlert> get alerts => _controller.stream;
+
+  EchoLeakDetector(
+    this.localTrack, {
+    required this.remoteTracks,
+    this.coherenceThreshold,
+  }) {
+    onDispose(() async {
+      await stop();
+      await _controller.close();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_eventChannel != null) {
+      return true;
+    }
+    final trackId = localTrack.mediaStreamTrack.id;
+    final remoteTrackIds = remoteTracks.map((track) => track.mediaStreamTrack.id).whereType<String>().toList();
+    if (lkPlatformIs(PlatformType.web) ||
+        trackId == null ||
+        remoteTrackIds.isEmpty ||
+        remoteTrackIds.length != remoteTracks.length) {
+      return false;
+    }
+
+    final started = await Native.startEchoDetector(
+      trackId,
+      detectorId: detectorId,
+      remoteTrackIds: remoteTrackIds,
+      coherenceThreshold: coherenceThreshold,
+    );
+    if (!started) {
+      return false;
+    }
+
+    _eventChannel = EventChannel('io.livekit.audio.echo_detector/eventChannel-$trackId-$detectorId');
+    _subscription = _eventChannel?.receiveBroadcastStream().listen((event) {
+      if (event is! Map) {
+        return;
+      }
+      final index = remoteTrackIds.indexOf(event['remoteTrackId'] as String? ?? '');
+      if (index < 0) {
+        return;
+      }
+      _controller.add(EchoLeakAlert(
+        echoDetected: event['echoDetected'] == true,
+        remoteTrack: remoteTracks[index],
+        delay: Duration(microseconds: ((event['delayMs'] as num? ?? 0) * 1000).round()),
+        couplingDb: (event['couplingDb'] as num? ?? 0).toDouble(),
+        coherence: (event['coherence'] as num? ?? 0).toDouble(),
+      ));
+    });
+    return true;
+  }
+
+  Future<void> stop() async {
+    if (_eventChannel == null) {
+      return;
+    }
+
+    await _subscription?.cancel();
+    _subscription = null;
+
+    await Native.stopEchoDetector(detectorId: detectorId);
+    _eventChannel = null;
+  }
+}
@@ -0,0 +1,66 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+import 'dart:typed_data';
+
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'latest_bands_ffi.dart' if (dart.library.js_interop) 'latest_bands_ffi_web.dart';
+
+/// The most recent bands of a visualizer.
+class LatestBands {
+  /// Number of updates published so far. Equal versions mean equal bands, so
+  /// callers can skip repainting.
+  final int version;
+  final Float32List bands;
+
+  const LatestBands({required this.version, required this.bands});
+}
+
+/// Pulls the latest bands of running visualizers, for UIs that redraw on
+/// their own schedule rather than on every visualizer event.
+///
+/// Bands are published natively into a slot per visualizer, identified by
+/// `AudioVisualizer.visualizerId`, that readers copy without ever blocking
+/// the audio threads. Visualizers of the same track each keep their own
+/// bands. Start an `AudioVisualizer` with `publishLatest: true` to get bands
+/// without listening to its events. Only supported on Linux.
+class LatestBandsReader {
+  /// Maximum number of bands kept per visualizer.
+  static const int maxBands = 64;
+
+  /// Reads the bands of [visualizerIds] in one method call. Entries are null
+  /// for visualizers that are not running or have no bands yet.
+  static Future<List<LatestBands?>> read(List<String> visualizerIds) async {
+    if (lkPlatformIs(PlatformType.web) || visualizerIds.isEmpty) {
+      return List.filled(visualizerIds.length, null);
+    }
+    final result = await Native.getLatestBands(visualizerIds);
+    final versions = result?['versions'];
+    final bands = result?['bands'];
+    if (versions is! Int64List || bands is! List || bands.length != visualizerIds.length) {
+      return List.filled(visualizerIds.length, null);
+    }
+    return [
+      for (var i = 0; i < visualizerIds.length; i++)
+        bands[i] is Float32List ? LatestBands(version: versions[i], bands: bands[i] as Float32List) : null,
+    ];
+  }
+
+  /// Reads the bands of [visualizerIds] synchronously through FFI, cheap
+  /// enough to call from every frame callback. Returns null where FFI is
+  /// unavailable, in which case [read] still works.
+  static List<LatestBands?>? readSync(List<String> visualizerIds) => readLatestBandsSync(visualizerIds, maxBands);
+}
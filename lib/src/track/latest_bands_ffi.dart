@@ -0,0 +1,69 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+import 'latest_bands.dart' show LatestBands;
+
+typedef _GetLatestBandsC = Int32 Function(Pointer<Uint8> visualizerIds, Int32 visualizerCount, Pointer<Float> bands,
+    Int32 bandsPerVisualizer, Pointer<Int32> bandCounts, Pointer<Uint64> versions);
+typedef _GetLatestBandsDart = int Function(Pointer<Uint8> visualizerIds, int visualizerCount, Pointer<Float> bands,
+    int bandsPerVisualizer, Pointer<Int32> bandCounts, Pointer<Uint64> versions);
+
+// Declared in linux/include/livekit_client/live_kit_plugin.h. The plugin
+// library is linked into the runner, so its symbols resolve in the process.
+final _GetLatestBandsDart? _getLatestBands = () {
+  if (!Platform.isLinux) {
+    return null;
+  }
+  try {
+    return DynamicLibrary.process()
+        .lookupFunction<_GetLatestBandsC, _GetLatestBandsDart>('livekit_get_latest_bands', isLeaf: true);
+  } catch (_) {
+    return null;
+  }
+}();
+
+List<LatestBands?>? readLatestBandsSync(List<String> visualizerIds, int maxBands) {
+  final getLatestBands = _getLatestBands;
+  if (getLatestBands == null) {
+    return null;
+  }
+  final ids = BytesBuilder(copy: false);
+  for (final visualizerId in visualizerIds) {
+    ids
+      ..add(utf8.encode(visualizerId))
+      ..addByte(0);
+  }
+  // Typed data may be passed straight to leaf calls, so no native allocation
+  // is needed.
+  final idBytes = ids.takeBytes();
+  final bands = Float32List(visualizerIds.length * maxBands);
+  final bandCounts = Int32List(visualizerIds.length);
+  final versions = Uint64List(visualizerIds.length);
+  getLatestBands(idBytes.address, visualizerIds.length, bands.address, maxBands, bandCounts.address, versions.address);
+  return [
+    for (var i = 0; i < visualizerIds.length; i++)
+      bandCounts[i] >= 0 && versions[i] > 0
+          ? LatestBands(
+              version: versions[i],
+              bands: Float32List.sublistView(bands, i * maxBands, i * maxBands + bandCounts[i]),
+            )
+          : null,
+  ];
+}
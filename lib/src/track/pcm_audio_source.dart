@@ -0,0 +1,144 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+
+final _uuid = uuid.Uuid();
+
+/// Playout counters of a [PcmAudioSource].
+class PcmAudioSourceStats {
+  /// Audio delivered from what was added.
+  final Duration played;
+
+  /// Concealment and silence delivered because nothing was buffered,
+  /// including while waiting for the prebuffer.
+  final Duration concealed;
+
+  /// Number of times playback ran dry.
+  final int underruns;
+
+  /// Frames that did not fit into the buffer.
+  final int framesDropped;
+
+  /// Audio waiting to be played.
+  final Duration buffered;
+
+  const PcmAudioSourceStats({
+    required this.played,
+    required this.concealed,
+    required this.underruns,
+    required this.framesDropped,
+    required this.buffered,
+  });
+
+  factory PcmAudioSourceStats.fromMap(Map<Object?, Object?> map, int sampleRate) {
+    Duration frames(Object? value) =>
+        Duration(microseconds: (value as num? ?? 0).toInt() * Duration.microsecondsPerSecond ~/ sampleRate);
+    return PcmAudioSourceStats(
+      played: frames(map['framesPlayed']),
+      concealed: frames(map['framesConcealed']),
+      underruns: (map['underruns'] as num? ?? 0).toInt(),
+      framesDropped: (map['framesDropped'] as num? ?? 0).toInt(),
+      buffered: frames(map['bufferedFrames']),
+    );
+  }
+
+  @override
+  String toString() => '${runtimeType}(played: $played, concealed: $concealed, underruns: $underruns, '
+      'framesDropped: $framesDropped, buffered: $buffered)';
+}
+
+/// An audio track that plays PCM generated by the app, such as synthesized
+/// speech or a bot's replies.
+///
+/// Samples passed to [add] are copied straight into a native jitter buffer,
+/// from which a native clock delivers 10 ms frames to WebRTC, so playout stays
+/// smooth however bursty the app produces audio and no Dart code runs per
+/// frame. When the buffer runs dry the last frame fades out into silence, and
+/// playback resumes once the prebuffer given to [create] has filled again.
+///
+/// The track is registered with flutter_webrtc as a local track under
+/// [trackId]. Only supported on Linux.
+class PcmAudioSource extends Disposable {
+  final String sourceId;
+  final String trackId;
+  final int sampleRate;
+  final int channels;
+  final BasicMessageChannel<ByteData> _channel;
+
+  PcmAudioSource._(this.sourceId, this.trackId, String channelName, this.sampleRate, this.channels)
+      : _channel = BasicMessageChannel<ByteData>(channelName, const BinaryCodec()) {
+    onDispose(() => Native.disposePcmSource(sourceId: sourceId));
+  }
+
+  /// Creates a source of [channels] interleaved channels at [sampleRate].
+  /// Up to [buffer] of audio can be queued; playback starts once [prebuffer]
+  /// is. Returns null if not supported.
+  static Future<PcmAudioSource?> create({
+    int sampleRate = 48000,
+    int channels = 1,
+    Duration buffer = const Duration(seconds: 2),
+    Duration prebuffer = const Duration(milliseconds: 60),
+  }) async {
+    if (lkPlatformIs(PlatformType.web)) {
+      return null;
+    }
+    final sourceId = _uuid.v4();
+    final result = await Native.createPcmSource(
+      sourceId: sourceId,
+      sampleRate: sampleRate,
+      channels: channels,
+      bufferMs: buffer.inMilliseconds,
+      prebufferMs: prebuffer.inMilliseconds,
+    );
+    final trackId = result?['trackId'];
+    final channelName = result?['channel'];
+    if (trackId is! String || channelName is! String) {
+      return null;
+    }
+    return PcmAudioSource._(sourceId, trackId, channelName, sampleRate, channels);
+  }
+
+  /// Queues interleaved [samples] and returns the number of frames that fit
+  /// into the buffer. When fewer than all were accepted, wait for some to be
+  /// played and add the rest again.
+  Future<int> add(Int16List samples) async {
+    if (isDisposed || samples.isEmpty) {
+      return 0;
+    }
+    final reply = await _channel.send(samples.buffer.asByteData(samples.offsetInBytes, samples.lengthInBytes));
+    return reply == null || reply.lengthInBytes < 4 ? 0 : reply.getUint32(0, Endian.host);
+  }
+
+  /// Drops everything queued, e.g. when the user interrupts speech.
+  Future<void> clear() async {
+    if (!isDisposed) {
+      await _channel.send(ByteData(0));
+    }
+  }
+
+  /// Current playout counters, or null once disposed.
+  Future<PcmAudioSourceStats?> getStats() async {
+    final stats = await Native.getPcmSourceStats(sourceId: sourceId);
+    return stats == null || stats.isEmpty ? null : PcmAudioSourceStats.fromMap(stats, sampleRate);
+  }
+}
@@ -0,0 +1,152 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/local.dart' show AudioTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Sample format of the [Utterance]s emitted by an [UtteranceSegmenter].
+enum UtteranceFormat {
+  /// Samples in [-1, 1] in [Utterance.samples].
+  float32,
+
+  /// Little endian 16-bit PCM in [Utterance.pcm], as most speech-to-text
+  /// engines take it.
+  int16,
+}
+
+/// One utterance spoken on a track, mono at [sampleRate].
+class Utterance {
+  /// Time from the start of segmentation to the first sample.
+  final Duration start;
+  final int sampleRate;
+
+  /// Set for [UtteranceFormat.float32].
+  final Float32List? samples;
+
+  /// Set for [UtteranceFormat.int16].
+  final Uint8List? pcm;
+
+  const Utterance({
+    required this.start,
+    required this.sampleRate,
+    this.samples,
+    this.pcm,
+  });
+
+  int get sampleCount => samples?.length ?? (pcm?.lengthInBytes ?? 0) ~/ 2;
+
+  Duration get duration => Duration(microseconds: sampleCount * Duration.microsecondsPerSecond ~/ sampleRate);
+}
+
+/// Cuts the audio of an [AudioTrack] into utterances for on-device
+/// transcription.
+///
+/// Voice activity is detected natively. Each utterance includes [preRoll] of
+/// audio before the voice started and ends once no voice was heard for
+/// [hangover]. Utterances with less than [minSpeech] of voice are dropped and
+/// longer ones than [maxUtterance] are split. Audio is resampled to 16 kHz
+/// mono and only complete utterances cross to Dart, each as a single message.
+/// An utterance still in progress when [stop] is called is dropped.
+/// Only supported on Linux.
+class UtteranceSegmenter extends Disposable {
+  final AudioTrack track;
+  final UtteranceFormat format;
+  final Duration preRoll;
+  final Duration hangover;
+  final Duration minSpeech;
+  final Duration maxUtterance;
+
+  final String segmenterId = _uuid.v4();
+
+  EventChannel? _eventChannel;
+  StreamSubscription? _subscription;
+  final _controller = StreamController<Utterance>.broadcast();
+
+  Stream<Utterance> get utterances => _controller.stream;
+
+  UtteranceSegmenter(
+    this.track, {
+    this.format = UtteranceFormat.float32,
+    this.preRoll = const Duration(milliseconds: 300),
+    this.hangover = const Duration(milliseconds: 600),
+    this.minSpeech = const Duration(milliseconds: 250),
+    this.maxUtterance = const Duration(seconds: 20),
+  }) {
+    onDispose(() async {
+      await stop();
+      await _controller.close();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_eventChannel != null) {
+      return true;
+    }
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+
+    final started = await Native.startUtteranceSegmenter(
+      trackId,
+      segmenterId: segmenterId,
+      format: format.name,
+      preRollMs: preRoll.inMilliseconds,
+      hangoverMs: hangover.inMilliseconds,
+      minSpeechMs: minSpeech.inMilliseconds,
+      maxUtteranceMs: maxUtterance.inMilliseconds,
+    );
+    if (!started) {
+      return false;
+    }
+
+    _eventChannel = EventChannel('io.livekit.audio.utterances/eventChannel-$trackId-$segmenterId');
+    _subscription = _eventChannel?.receiveBroadcastStream().listen((event) {
+      if (event is! Map) {
+        return;
+      }
+      final samples = event['samples'];
+      _controller.add(Utterance(
+        start: Duration(microseconds: ((event['start'] as num) * Duration.microsecondsPerSecond).round()),
+        sampleRate: event['sampleRate'] as int,
+        samples: samples is Float32List ? samples : null,
+        pcm: samples is Uint8List ? samples : null,
+      ));
+    });
+    return true;
+  }
+
+  Future<void> stop() async {
+    if (_eventChannel == null) {
+      return;
+    }
+
+    await _subscription?.cancel();
+    _subscription = null;
+
+    await Native.stopUtteranceSegmenter(segmenterId: segmenterId);
+    _eventChannel = null;
+  }
+}
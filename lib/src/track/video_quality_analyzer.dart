@@ -0,0 +1,166 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/local.dart' show VideoTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Picture quality of a video track over one report interval, emitted by
+/// [VideoQualityAnalyzer].
+class VideoQualityReport {
+  final int width;
+  final int height;
+
+  /// Frames received per second.
+  final double frameRate;
+
+  /// Average brightness, from 0 to 1.
+  final double meanLuma;
+
+  /// Standard deviation of brightness, from 0 to 1. Low values mean a flat,
+  /// washed out or covered picture.
+  final double contrast;
+
+  /// Variance of the Laplacian of the picture. Sharp, detailed pictures score
+  /// in the hundreds or more; values below about 50 usually mean blur or an
+  /// out of focus camera.
+  final double blurScore;
+
+  /// Mean squared brightness change between analysed frames, in 8-bit units.
+  final double frameDifference;
+
+  /// Whether the picture has not changed for at least a second.
+  final bool frozen;
+
+  /// Fraction of the pixels in each of 32 brightness bins, darkest first.
+  final Float32List histogram;
+
+  const VideoQualityReport({
+    required this.width,
+    required this.height,
+    required this.frameRate,
+    required this.meanLuma,
+    required this.contrast,
+    required this.blurScore,
+    required this.frameDifference,
+    required this.frozen,
+    required this.histogram,
+  });
+
+  factory VideoQualityReport.fromMap(Map<Object?, Object?> map) => VideoQualityReport(
+        width: map['width'] as int? ?? 0,
+        height: map['height'] as int? ?? 0,
+        frameRate: (map['frameRate'] as num? ?? 0).toDouble(),
+        meanLuma: (map['meanLuma'] as num? ?? 0).toDouble(),
+        contrast: (map['contrast'] as num? ?? 0).toDouble(),
+        blurScore: (map['blurScore'] as num? ?? 0).toDouble(),
+        frameDifference: (map['frameDifference'] as num? ?? 0).toDouble(),
+        frozen: map['frozen'] == true,
+        histogram: map['histogram'] as Float32List? ?? Float32List(0),
+      );
+
+  @override
+  String toString() => '${runtimeType}(${width}x$height, '
+      'frameRate: ${frameRate.toStringAsFixed(1)}, '
+      'meanLuma: ${meanLuma.toStringAsFixed(2)}, '
+      'contrast: ${contrast.toStringAsFixed(2)}, '
+      'blurScore: ${blurScore.toStringAsFixed(0)}, '
+      'frozen: $frozen)';
+}
+
+/// Analyses the frames of a local or remote video track natively, for camera
+/// preflight checks and in-call diagnostics, and emits a
+/// [VideoQualityReport] per [reportInterval]. No frames are copied to Dart.
+/// Only supported on Linux.
+class VideoQualityAnalyzer extends Disposable {
+  final VideoTrack track;
+
+  /// How often a frame is analysed. Uses the native default of 250 ms when
+  /// null.
+  final Duration? analysisInterval;
+
+  /// How often reports are emitted. Uses the native default of 1 second when
+  /// null.
+  final Duration? reportInterval;
+
+  final String analyzerId = _uuid.v4();
+
+  EventChannel? _eventChannel;
+  StreamSubscription? _subscription;
+  final _controller = StreamController<VideoQualityReport>.broadcast();
+
+  Stream<VideoQualityReport> get reports => _controller.stream;
+
+  VideoQualityAnalyzer(
+    this.track, {
+    this.analysisInterval,
+    this.reportInterval,
+  }) {
+    onDispose(() async {
+      await stop();
+      await _controller.close();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_eventChannel != null) {
+      return true;
+    }
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+
+    final started = await Native.startVideoQualityAnalyzer(
+      trackId,
+      analyzerId: analyzerId,
+      analysisIntervalMs: analysisInterval?.inMilliseconds,
+      reportIntervalMs: reportInterval?.inMilliseconds,
+    );
+    if (!started) {
+      return false;
+    }
+
+    _eventChannel = EventChannel('io.livekit.video.quality/eventChannel-$trackId-$analyzerId');
+    _subscription = _eventChannel?.receiveBroadcastStream().listen((event) {
+      if (event is Map) {
+        _controller.add(VideoQualityReport.fromMap(event));
+      }
+    });
+    return true;
+  }
+
+  Future<void> stop() async {
+    if (_eventChannel == null) {
+      return;
+    }
+
+    await _subscription?.cancel();
+    _subscription = null;
+
+    await Native.stopVideoQualityAnalyzer(analyzerId: analyzerId);
+    _eventChannel = null;
+  }
+}
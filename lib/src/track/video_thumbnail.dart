@@ -0,0 +1,85 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import 'package:uuid/uuid.dart' as uuid;
+
+import '../support/disposable.dart';
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+import 'local/local.dart' show VideoTrack;
+
+final _uuid = uuid.Uuid();
+
+/// Renders a small, downscaled copy of a video track into a Flutter texture,
+/// for participant grids and previews that would otherwise render full
+/// resolution frames into small tiles. Frames are converted and scaled
+/// natively, center-cropped to [width] x [height]. Show the thumbnail with a
+/// `Texture(textureId: thumbnail.textureId!)` widget once [start] completed.
+/// Only supported on Linux.
+class VideoThumbnail extends Disposable {
+  final VideoTrack track;
+
+  /// Size of the texture in pixels.
+  final int width;
+  final int height;
+
+  /// Upper bound of texture updates per second. Uses the native default of
+  /// 15 when null.
+  final int? maxFrameRate;
+
+  final String thumbnailId = _uuid.v4();
+
+  int? _textureId;
+
+  /// Texture to render, or null while the thumbnail is not started.
+  int? get textureId => _textureId;
+
+  VideoThumbnail(
+    this.track, {
+    required this.width,
+    required this.height,
+    this.maxFrameRate,
+  }) {
+    onDispose(() async {
+      await stop();
+    });
+  }
+
+  Future<bool> start() async {
+    if (_textureId != null) {
+      return true;
+    }
+    final trackId = track.mediaStreamTrack.id;
+    if (lkPlatformIs(PlatformType.web) || trackId == null) {
+      return false;
+    }
+
+    _textureId = await Native.startThumbnail(
+      trackId,
+      thumbnailId: thumbnailId,
+      width: width,
+      height: height,
+      maxFps: maxFrameRate,
+    );
+    return _textureId != null;
+  }
+
+  Future<void> stop() async {
+    if (_textureId == null) {
+      return;
+    }
+    _textureId = null;
+    await Native.stopThumbnail(thumbnailId: thumbnailId);
+  }
+}
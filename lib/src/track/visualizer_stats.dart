@@ -0,0 +1,137 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+import '../support/native.dart' show Native;
+import '../support/platform.dart';
+
+/// Analysis engine settings to validate in shadow mode. Unset values keep the
+/// settings of the engine in use.
+class VisualizerCandidate {
+  /// Use the integer FFT pipeline instead of the float one.
+  final bool useFixedPoint;
+
+  /// FFT size, a power of two between 32 and 32768.
+  final int? fftSize;
+
+  /// Frequency range the bands are spread over.
+  final double? minFrequency;
+  final double? maxFrequency;
+
+  const VisualizerCandidate({
+    this.useFixedPoint = false,
+    this.fftSize,
+    this.minFrequency,
+    this.maxFrequency,
+  });
+}
+
+/// Native audio visualizer statistics of the process, see
+/// [getVisualizerStats].
+class VisualizerStats {
+  /// Live visualizer analyses, each shared by every visualizer of a track
+  /// with the same bar count and centering.
+  final int visualizers;
+
+  /// Live analyses running a shadow candidate.
+  final int shadowedVisualizers;
+
+  /// Analyses for which both the primary engine and the candidate produced
+  /// bands.
+  final int comparedAnalyses;
+
+  /// Compared analyses with a band differing by more than a tenth of the bar
+  /// height.
+  final int divergentAnalyses;
+
+  /// Mean and maximum difference of a band between the engines, on the
+  /// [0, 1] scale of the bars.
+  final double meanBandDifference;
+  final double maxBandDifference;
+
+  /// CPU time the engines spent on the compared analyses.
+  final Duration primaryTime;
+  final Duration candidateTime;
+
+  const VisualizerStats({
+    required this.visualizers,
+    required this.shadowedVisualizers,
+    required this.comparedAnalyses,
+    required this.divergentAnalyses,
+    required this.meanBandDifference,
+    required this.maxBandDifference,
+    required this.primaryTime,
+    required this.candidateTime,
+  });
+
+  factory VisualizerStats.fromMap(Map<Object?, Object?> map) {
+    int count(String key) => (map[key] as num? ?? 0).toInt();
+    double value(String key) => (map[key] as num? ?? 0).toDouble();
+    Duration seconds(String key) => Duration(microseconds: (value(key) * Duration.microsecondsPerSecond).round());
+    return VisualizerStats(
+      visualizers: count('visualizers'),
+      shadowedVisualizers: count('shadowedVisualizers'),
+      comparedAnalyses: count('comparedAnalyses'),
+      divergentAnalyses: count('divergentAnalyses'),
+      meanBandDifference: value('meanBandDifference'),
+      maxBandDifference: value('maxBandDifference'),
+      primaryTime: seconds('primarySeconds'),
+      candidateTime: seconds('candidateSeconds'),
+    );
+  }
+
+  /// Candidate processing time relative to the primary engine's, or null
+  /// before anything was compared.
+  double? get candidateTimeRatio =>
+      primaryTime > Duration.zero ? candidateTime.inMicroseconds / primaryTime.inMicroseconds : null;
+
+  @override
+  String toString() => '${runtimeType}(visualizers: $visualizers, shadowedVisualizers: $shadowedVisualizers, '
+      'comparedAnalyses: $comparedAnalyses, divergentAnalyses: $divergentAnalyses, '
+      'meanBandDifference: $meanBandDifference, maxBandDifference: $maxBandDifference, '
+      'primaryTime: $primaryTime, candidateTime: $candidateTime)';
+}
+
+/// Runs [candidate] alongside the analysis engine in use for [fraction] of
+/// the audio visualizers created from now on, on the same audio, to validate
+/// it in production before switching to it. Only the bands of the engine in
+/// use are sent to visualizers; the divergence between the two and their
+/// processing time are reported by [getVisualizerStats]. A [fraction] of 0
+/// turns shadow mode off for new visualizers. Setting the mode resets the
+/// statistics of destroyed visualizers.
+/// Only supported on Linux.
+Future<bool> setVisualizerShadowMode({
+  required double fraction,
+  VisualizerCandidate candidate = const VisualizerCandidate(),
+}) async {
+  if (!lkPlatformIs(PlatformType.linux)) {
+    return false;
+  }
+  return Native.setVisualizerShadowMode(
+    fraction: fraction,
+    useFixedPoint: candidate.useFixedPoint,
+    fftSize: candidate.fftSize,
+    minFrequency: candidate.minFrequency,
+    maxFrequency: candidate.maxFrequency,
+  );
+}
+
+/// Returns the visualizer and shadow mode statistics of the process, or null
+/// where unsupported.
+Future<VisualizerStats?> getVisualizerStats() async {
+  if (!lkPlatformIs(PlatformType.linux)) {
+    return null;
+  }
+  final map = await Native.getVisualizerStats();
+  return map != null ? VisualizerStats.fromMap(map) : null;
+}
@@ -0,0 +1,238 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "analysis_service.h"
+
+#include <algorithm>
+
+namespace livekit_client_plugin {
+
+SharedVisualizer::SharedVisualizer(
+    std::shared_ptr<AnalysisService> service,
+    std::string track_id,
+    int bar_count,
+    bool is_centered,
+    std::shared_ptr<const VisualizerShadow::Candidate> candidate)
+    : service_(std::move(service)),
+      track_id_(std::move(track_id)),
+      bar_count_(bar_count),
+      is_centered_(is_centered),
+      candidate_(std::move(candidate)),
+      engine_(std::make_shared<Engine>()) {}
+
+SharedVisualizer::~SharedVisualizer() {
+  connection_.reset();
+  if (candidate_) {
+    service_->AddRetiredShadowStats(GetShadowStats());
+  }
+}
+
+void SharedVisualizer::OnData(const void* audio_data,
+                              int bits_per_sample,
+                              int sample_rate,
+                              size_t number_of_channels,
+                              size_t number_of_frames) {
+  if (active_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  // Never wait for the main thread here; the engine is only contended while
+  // it is being allocated or released.
+  std::unique_lock<std::mutex> lock(engine_->mutex, std::try_to_lock);
+  if (!lock.owns_lock() || !engine_->audio_visualizer) {
+    return;
+  }
+  std::vector<float> bands;
+  const int16_t* samples = static_cast<const int16_t*>(audio_data);
+  const unsigned int frames = static_cast<unsigned int>(number_of_frames);
+  bool analysed =
+      engine_->shadow
+          ? engine_->shadow->Process(engine_->audio_visualizer.get(), samples,
+                                     frames, float(sample_rate), bands)
+          : engine_->audio_visualizer->Process(samples, frames,
+                                               float(sample_rate), bands);
+  if (!analysed) {
+    return;
+  }
+  lock.unlock();
+  std::lock_guard<std::mutex> subscribers_lock(subscribers_mutex_);
+  for (Subscriber* subscriber : subscribers_) {
+    subscriber->OnBands(bands, sample_rate, number_of_frames);
+  }
+}
+
+void SharedVisualizer::AddSubscriber(Subscriber* subscriber) {
+  std::lock_guard<std::mutex> lock(subscribers_mutex_);
+  subscribers_.push_back(subscriber);
+}
+
+void SharedVisualizer::RemoveSubscriber(Subscriber* subscriber) {
+  std::lock_guard<std::mutex> lock(subscribers_mutex_);
+  subscribers_.erase(
+      std::remove(subscribers_.begin(), subscribers_.end(), subscriber),
+      subscribers_.end());
+}
+
+void SharedVisualizer::Activate() {
+  ++engine_->generation;
+  if (active_.fetch_add(1, std::memory_order_relaxed) > 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(engine_->mutex);
+  if (!engine_->audio_visualizer) {
+    engine_->audio_visualizer =
+        std::make_unique<AudioVisualizer>(bar_count_, is_centered_);
+    if (candidate_) {
+      engine_->shadow = std::make_unique<VisualizerShadow>(
+          bar_count_, is_centered_, *candidate_);
+    }
+  }
+}
+
+void SharedVisualizer::Deactivate(int idle_release_ms) {
+  uint64_t generation = ++engine_->generation;
+  if (active_.fetch_sub(1, std::memory_order_relaxed) > 1) {
+    return;
+  }
+  if (idle_release_ms <= 0) {
+    Release(engine_);
+    return;
+  }
+  std::weak_ptr<Engine> weak_engine = engine_;
+  task_runner_.EnqueueDelayedTask(
+      [weak_engine, generation]() {
+        auto engine = weak_engine.lock();
+        if (engine && engine->generation == generation) {
+          Release(engine);
+        }
+      },
+      static_cast<unsigned int>(idle_release_ms));
+}
+
+// static
+void SharedVisualizer::Release(const std::shared_ptr<Engine>& engine) {
+  std::unique_ptr<AudioVisualizer> audio_visualizer;
+  std::unique_ptr<VisualizerShadow> shadow;
+  {
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    audio_visualizer = std::move(engine->audio_visualizer);
+    shadow = std::move(engine->shadow);
+    if (shadow) {
+      engine->released_shadow_stats.Add(shadow->stats());
+    }
+  }
+}
+
+VisualizerShadow::Stats SharedVisualizer::GetShadowStats() {
+  // May make the audio thread skip one analysis.
+  std::lock_guard<std::mutex> lock(engine_->mutex);
+  VisualizerShadow::Stats stats = engine_->released_shadow_stats;
+  if (engine_->shadow) {
+    stats.Add(engine_->shadow->stats());
+  }
+  return stats;
+}
+
+// static
+std::shared_ptr<AnalysisService> AnalysisService::Acquire() {
+  static std::mutex mutex;
+  static std::weak_ptr<AnalysisService> instance;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<AnalysisService> service = instance.lock();
+  if (!service) {
+    service.reset(new AnalysisService());
+    instance = service;
+  }
+  return service;
+}
+
+std::shared_ptr<SharedVisualizer> AnalysisService::AcquireVisualizer(
+    const std::string& track_id,
+    int bar_count,
+    bool is_centered,
+    const Connect& connect) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = visualizers_.begin(); it != visualizers_.end();) {
+    it = it->second.expired() ? visualizers_.erase(it) : std::next(it);
+  }
+  std::weak_ptr<SharedVisualizer>& entry =
+      visualizers_[std::make_tuple(track_id, bar_count, is_centered)];
+  std::shared_ptr<SharedVisualizer> visualizer = entry.lock();
+  if (!visualizer) {
+    std::shared_ptr<const VisualizerShadow::Candidate> candidate;
+    shadow_credit_ += shadow_fraction_;
+    if (shadow_credit_ >= 1) {
+      shadow_credit_ -= 1;
+      candidate = candidate_;
+    }
+    visualizer.reset(new SharedVisualizer(shared_from_this(), track_id,
+                                          bar_count, is_centered,
+                                          std::move(candidate)));
+    if (connect) {
+      visualizer->connection_ = connect(visualizer.get());
+    }
+    entry = visualizer;
+  }
+  return visualizer;
+}
+
+size_t AnalysisService::visualizer_count() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& entry : visualizers_) {
+    count += entry.second.expired() ? 0 : 1;
+  }
+  return count;
+}
+
+void AnalysisService::SetShadowMode(const ShadowMode& mode) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shadow_fraction_ = std::min(std::max(mode.fraction, 0.0), 1.0);
+  candidate_ = shadow_fraction_ > 0
+                   ? std::make_shared<const VisualizerShadow::Candidate>(
+                         mode.candidate)
+                   : nullptr;
+  shadow_credit_ = 0;
+  retired_shadow_stats_ = VisualizerShadow::Stats();
+}
+
+AnalysisService::VisualizerStats AnalysisService::GetVisualizerStats() {
+  VisualizerStats stats;
+  std::vector<std::shared_ptr<SharedVisualizer>> visualizers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.shadow = retired_shadow_stats_;
+    for (const auto& entry : visualizers_) {
+      if (auto visualizer = entry.second.lock()) {
+        visualizers.push_back(std::move(visualizer));
+      }
+    }
+  }
+  // Outside the lock: dropping the last reference to a visualizer here
+  // retires its statistics, which takes the lock.
+  stats.visualizers = visualizers.size();
+  for (const auto& visualizer : visualizers) {
+    if (visualizer->shadowed()) {
+      ++stats.shadowed_visualizers;
+      stats.shadow.Add(visualizer->GetShadowStats());
+    }
+  }
+  return stats;
+}
+
+void AnalysisService::AddRetiredShadowStats(
+    const VisualizerShadow::Stats& stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  retired_shadow_stats_.Add(stats);
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,199 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef LIVEKIT_CLIENT_LINUX_ANALYSIS_SERVICE_H_
+#define LIVEKIT_CLIENT_LINUX_ANALYSIS_SERVICE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "audio_visualizer.h"
+#include "task_runner_linux.h"
+#include "visualizer_shadow.h"
+
+namespace livekit_client_plugin {
+
+class AnalysisService;
+
+// Keeps an audio source connected to a SharedVisualizer. Destroyed, and so
+// disconnected, before the rest of the visualizer.
+class AudioSourceConnection {
+ public:
+  virtual ~AudioSourceConnection() = default;
+};
+
+// Visualizer analysis of one track, computed once for every subscriber
+// with the same bar count and centering, whichever engine it belongs to.
+//
+// The AudioVisualizer, with its FFT buffers, only exists while a subscriber
+// is active, and is released |idle_release_ms| after the last one becomes
+// inactive. A visualizer picked for shadow mode runs a VisualizerShadow
+// with it under the same rules.
+class SharedVisualizer {
+ public:
+  class Subscriber {
+   public:
+    virtual ~Subscriber() = default;
+    // Called on the audio thread with the bands of every analysed callback
+    // while any subscriber is active.
+    virtual void OnBands(const std::vector<float>& bands,
+                         int sample_rate,
+                         size_t number_of_frames) = 0;
+  };
+
+  ~SharedVisualizer();
+
+  // Prevent copying.
+  SharedVisualizer(SharedVisualizer const&) = delete;
+  SharedVisualizer& operator=(SharedVisualizer const&) = delete;
+
+  // Called on the audio thread with 16-bit interleaved audio.
+  void OnData(const void* audio_data,
+              int bits_per_sample,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames);
+
+  // Main thread only. Subscribers must be removed before they are destroyed.
+  void AddSubscriber(Subscriber* subscriber);
+  void RemoveSubscriber(Subscriber* subscriber);
+
+  // Main thread only. Each Activate() must be balanced by a Deactivate().
+  void Activate();
+  void Deactivate(int idle_release_ms);
+
+  const std::string& track_id() const { return track_id_; }
+
+  bool shadowed() const { return candidate_ != nullptr; }
+
+  // Comparison statistics of a shadowed visualizer so far. Main thread only.
+  VisualizerShadow::Stats GetShadowStats();
+
+ private:
+  friend class AnalysisService;
+
+  // Shared with pending release tasks, which may outlive the visualizer.
+  struct Engine {
+    std::mutex mutex;
+    std::unique_ptr<AudioVisualizer> audio_visualizer;
+    std::unique_ptr<VisualizerShadow> shadow;
+    // Statistics of the shadows released so far.
+    VisualizerShadow::Stats released_shadow_stats;
+    // Bumped on every activation and deactivation so that a release
+    // scheduled before the visualizer was activated again does nothing.
+    // Main thread only.
+    uint64_t generation = 0;
+  };
+
+  SharedVisualizer(
+      std::shared_ptr<AnalysisService> service,
+      std::string track_id,
+      int bar_count,
+      bool is_centered,
+      std::shared_ptr<const VisualizerShadow::Candidate> candidate);
+
+  static void Release(const std::shared_ptr<Engine>& engine);
+
+  std::shared_ptr<AnalysisService> service_;
+  std::string track_id_;
+  int bar_count_;
+  bool is_centered_;
+  // Set if the visualizer was picked for shadow mode.
+  std::shared_ptr<const VisualizerShadow::Candidate> candidate_;
+  // Written on the main thread, read on the audio thread.
+  std::atomic<int> active_{0};
+  std::shared_ptr<Engine> engine_;
+  TaskRunnerLinux task_runner_;
+  std::mutex subscribers_mutex_;
+  std::vector<Subscriber*> subscribers_;
+  // Reset first on destruction, so that audio stops arriving before anything
+  // else is destroyed.
+  std::unique_ptr<AudioSourceConnection> connection_;
+};
+
+// Process-wide owner of per-track analysis, shared by the plugin instances
+// of all Flutter engines (one per window in multi-window apps), so that
+// every window showing a track subscribes to one analysis instead of
+// running its own. Reference counted: it exists while a plugin instance or
+// an analysis holds it.
+class AnalysisService
+    : public std::enable_shared_from_this<AnalysisService> {
+ public:
+  // Function connecting a new SharedVisualizer to its track's audio.
+  using Connect = std::function<std::unique_ptr<AudioSourceConnection>(
+      SharedVisualizer* visualizer)>;
+
+  // Picks |fraction| of the visualizers created from now on to also run
+  // |candidate|, spread evenly over them.
+  struct ShadowMode {
+    double fraction = 0;
+    VisualizerShadow::Candidate candidate;
+  };
+
+  struct VisualizerStats {
+    size_t visualizers = 0;
+    size_t shadowed_visualizers = 0;
+    // Of the live shadowed visualizers and of those destroyed since the
+    // shadow mode was last set.
+    VisualizerShadow::Stats shadow;
+  };
+
+  // Returns the service, creating it if no one holds it.
+  static std::shared_ptr<AnalysisService> Acquire();
+
+  // Returns the visualizer analysis of |track_id| with |bar_count| bands,
+  // creating and connecting it with |connect| if it does not exist yet. It
+  // is destroyed with its last reference. Main thread only.
+  std::shared_ptr<SharedVisualizer> AcquireVisualizer(
+      const std::string& track_id,
+      int bar_count,
+      bool is_centered,
+      const Connect& connect);
+
+  // Number of live visualizer analyses.
+  size_t visualizer_count();
+
+  // Main thread only.
+  void SetShadowMode(const ShadowMode& mode);
+  VisualizerStats GetVisualizerStats();
+
+ private:
+  friend class SharedVisualizer;
+
+  AnalysisService() = default;
+
+  // Keeps the statistics of a shadowed visualizer being destroyed.
+  void AddRetiredShadowStats(const VisualizerShadow::Stats& stats);
+
+  std::mutex mutex_;
+  std::shared_ptr<const VisualizerShadow::Candidate> candidate_;
+  double shadow_fraction_ = 0;
+  // Accumulates |shadow_fraction_| per visualizer created; one is picked
+  // each time it reaches 1.
+  double shadow_credit_ = 0;
+  VisualizerShadow::Stats retired_shadow_stats_;
+  std::map<std::tuple<std::string, int, bool>, std::weak_ptr<SharedVisualizer>>
+      visualizers_;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_ANALYSIS_SERVICE_H_
@@ -0,0 +1,81 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "audio_frame_clock.h"
+
+#include <chrono>
+
+namespace livekit_client_plugin {
+
+// static
+std::shared_ptr<AudioFrameClock> AudioFrameClock::Acquire() {
+  static std::mutex mutex;
+  static std::weak_ptr<AudioFrameClock> instance;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<AudioFrameClock> clock = instance.lock();
+  if (!clock) {
+    clock.reset(new AudioFrameClock());
+    instance = clock;
+  }
+  return clock;
+}
+
+AudioFrameClock::AudioFrameClock()
+    : thread_(&AudioFrameClock::Run, this) {}
+
+AudioFrameClock::~AudioFrameClock() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  stop_condition_.notify_one();
+  thread_.join();
+}
+
+int AudioFrameClock::Add(Tick tick) {
+  std::lock_guard<std::mutex> lock(ticks_mutex_);
+  int id = next_id_++;
+  ticks_[id] = std::move(tick);
+  return id;
+}
+
+void AudioFrameClock::Remove(int id) {
+  std::lock_guard<std::mutex> lock(ticks_mutex_);
+  ticks_.erase(id);
+}
+
+void AudioFrameClock::Run() {
+  const auto interval = std::chrono::milliseconds(kTickMs);
+  const auto max_lag = std::chrono::milliseconds(kMaxLagMs);
+  auto next = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> ticks_lock(ticks_mutex_);
+      for (auto& entry : ticks_) {
+        entry.second();
+      }
+    }
+    next += interval;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - next > max_lag) {
+      next = now;
+    }
+    lock.lock();
+    stop_condition_.wait_until(lock, next, [this] { return stopped_; });
+  }
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,83 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_AUDIO_FRAME_CLOCK_H_
+#define LIVEKIT_CLIENT_LINUX_AUDIO_FRAME_CLOCK_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace livekit_client_plugin {
+
+// Receives one frame of interleaved 16-bit audio from a native source.
+using AudioFrameCallback = std::function<void(const int16_t* samples,
+                                              int sample_rate,
+                                              size_t channels,
+                                              size_t frames)>;
+
+// The 10 ms clock of the native audio sources. One thread ticks every
+// source of the process in turn, so dozens of sources cost a single wakeup
+// per tick rather than a thread each. The thread runs while anyone holds
+// the clock.
+//
+// When the thread falls behind, e.g. while the machine was suspended, it
+// catches up with back-to-back ticks for at most kMaxLagMs and skips the
+// rest.
+class AudioFrameClock {
+ public:
+  static constexpr int kTickMs = 10;
+  static constexpr int kMaxLagMs = 100;
+
+  using Tick = std::function<void()>;
+
+  static std::shared_ptr<AudioFrameClock> Acquire();
+
+  ~AudioFrameClock();
+
+  // Prevent copying.
+  AudioFrameClock(AudioFrameClock const&) = delete;
+  AudioFrameClock& operator=(AudioFrameClock const&) = delete;
+
+  // Runs |tick| on the clock thread every kTickMs from now on. Ticks must
+  // not add or remove ticks.
+  int Add(Tick tick);
+
+  // Once this returns, the tick added as |id| is not running and never runs
+  // again.
+  void Remove(int id);
+
+ private:
+  AudioFrameClock();
+
+  void Run();
+
+  std::mutex mutex_;
+  // Held while ticking, so that Remove() waits for a running tick.
+  std::mutex ticks_mutex_;
+  std::map<int, Tick> ticks_;
+  int next_id_ = 1;
+  std::condition_variable stop_condition_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_AUDIO_FRAME_CLOCK_H_
@@ -0,0 +1,112 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "audio_replay_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "task_runner_linux.h"
+
+namespace livekit_client_plugin {
+
+namespace {
+
+// Samples decoded per write.
+constexpr size_t kChunkSamples = 65536;
+
+void PutU16(uint8_t* p, uint16_t value) {
+  std::memcpy(p, &value, sizeof(value));
+}
+
+void PutU32(uint8_t* p, uint32_t value) {
+  std::memcpy(p, &value, sizeof(value));
+}
+
+// Writes |clip| to |path|, returning an error message on failure.
+std::string WriteWav(const AudioReplayBuffer::Clip& clip,
+                     const std::string& path) {
+  if (clip.samples.empty()) {
+    return "no audio buffered";
+  }
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    return path + ": " + std::strerror(errno);
+  }
+  const uint32_t data_size = uint32_t(clip.samples.size() * sizeof(int16_t));
+  uint8_t header[44];
+  std::memcpy(header, "RIFF", 4);
+  PutU32(header + 4, 36 + data_size);
+  std::memcpy(header + 8, "WAVEfmt ", 8);
+  PutU32(header + 16, 16);
+  PutU16(header + 20, 1);  // PCM
+  PutU16(header + 22, 1);  // Mono
+  PutU32(header + 24, uint32_t(clip.sample_rate));
+  PutU32(header + 28, uint32_t(clip.sample_rate) * sizeof(int16_t));
+  PutU16(header + 32, sizeof(int16_t));
+  PutU16(header + 34, 16);
+  std::memcpy(header + 36, "data", 4);
+  PutU32(header + 40, data_size);
+
+  bool ok = std::fwrite(header, sizeof(header), 1, file) == 1;
+  std::vector<int16_t> chunk(kChunkSamples);
+  for (size_t offset = 0; ok && offset < clip.samples.size();
+       offset += kChunkSamples) {
+    const size_t size =
+        std::min(kChunkSamples, clip.samples.size() - offset);
+    DecodeMuLaw(clip.samples.data() + offset, size, chunk.data());
+    ok = std::fwrite(chunk.data(), sizeof(int16_t), size, file) == size;
+  }
+  int write_errno = errno;
+  if (std::fclose(file) != 0 && ok) {
+    ok = false;
+    write_errno = errno;
+  }
+  if (!ok) {
+    std::remove(path.c_str());
+    return path + ": " + std::strerror(write_errno);
+  }
+  return std::string();
+}
+
+}  // namespace
+
+void SaveReplayAsync(std::shared_ptr<const AudioReplayBuffer> buffer,
+                     double seconds,
+                     std::string path,
+                     ReplaySaveCallback on_done) {
+  std::thread([buffer = std::move(buffer), seconds, path = std::move(path),
+               on_done = std::move(on_done)]() mutable {
+    AudioReplayBuffer::Clip clip = buffer->Snapshot(seconds);
+    buffer.reset();
+    std::string error = WriteWav(clip, path);
+    double duration = error.empty() ? double(clip.samples.size()) /
+                                          clip.sample_rate
+                                    : 0;
+    // Delayed tasks do not reference the runner, so it need not outlive
+    // this thread.
+    TaskRunnerLinux().EnqueueDelayedTask(
+        [on_done = std::move(on_done), duration, error]() {
+          on_done(duration, error);
+        },
+        0);
+  }).detach();
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,43 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_AUDIO_REPLAY_WRITER_H_
+#define LIVEKIT_CLIENT_LINUX_AUDIO_REPLAY_WRITER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "audio_replay_buffer.h"
+
+namespace livekit_client_plugin {
+
+// Receives the outcome of SaveReplayAsync(): the duration written, or an
+// error message.
+using ReplaySaveCallback =
+    std::function<void(double duration_seconds, const std::string& error)>;
+
+// Saves the last |seconds| of |buffer| to |path| as a 16-bit mono WAV file.
+// The snapshot, decoding and file writes run on a thread of their own, so
+// neither the audio thread nor the main loop waits for the disk; |on_done|
+// is called on the main loop. |buffer| is kept alive until the snapshot is
+// taken, and may be written to meanwhile.
+void SaveReplayAsync(std::shared_ptr<const AudioReplayBuffer> buffer,
+                     double seconds,
+                     std::string path,
+                     ReplaySaveCallback on_done);
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_AUDIO_REPLAY_WRITER_H_
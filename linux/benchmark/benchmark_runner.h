@@ -0,0 +1,321 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_PLUGIN_BENCHMARK_BENCHMARK_RUNNER_H_
+#define LIVEKIT_CLIENT_PLUGIN_BENCHMARK_BENCHMARK_RUNNER_H_
+
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/energy_meter.h"
+#include "benchmark/perf_counters.h"
+
+namespace livekit_client_plugin {
+namespace benchmark {
+
+// Minimal, dependency free benchmark runner for the native DSP code.
+//
+// Each case runs its body repeatedly for at least --min_time seconds and
+// reports the mean wall time per iteration. Cases that process audio declare
+// how many seconds of audio one iteration covers so that the report includes
+// a real-time factor. Results are printed as a table on stderr and, with
+// --json=<path> (or --json=- for stdout), as a JSON array.
+//
+// With --energy the CPU package energy of every case is read from the RAPL
+// counters, minus the idle power measured before the first case, and
+// reported per iteration and, for audio cases, per second of audio, i.e.
+// the average power one real-time track costs. Energy is skipped with a
+// note when the counters are unavailable. The counters update about every
+// millisecond and include everything else running on the machine, so use a
+// quiet machine and a longer --min_time.
+//
+// With --perf_counters the hardware events of PerfCounters (cycles,
+// instructions, cache and branch misses, L1D and LLC loads) are counted over
+// the timed loop and reported per iteration: the table shows instructions
+// per cycle, the JSON output every counter.
+class BenchmarkRunner {
+ public:
+  using Body = std::function<void()>;
+
+  struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_iteration = 0;
+    // Seconds of audio processed per second of wall time, 0 if not audio.
+    double realtime_factor = 0;
+    // Set with --energy when the counters are available.
+    bool has_energy = false;
+    double joules_per_iteration = 0;
+    // Joules per second of audio, i.e. watts per real-time track, 0 if not
+    // audio.
+    double joules_per_audio_second = 0;
+    // Set with --perf_counters, per iteration.
+    std::vector<PerfCounters::Value> counters;
+  };
+
+  // Registers a case. |audio_seconds| is the duration of audio processed by
+  // one call of |body|, or 0 for non-audio workloads.
+  void Add(const std::string& name, double audio_seconds, Body body) {
+    cases_.push_back({name, audio_seconds, std::move(body)});
+  }
+
+  int Run(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+      if (!ParseFlag(argv[i])) {
+        std::cerr << "Unknown flag: " << argv[i] << std::endl
+                  << "Flags: --filter=<substring> --min_time=<seconds> "
+                     "--json=<path|-> --energy --perf_counters"
+                  << std::endl;
+        return 1;
+      }
+    }
+    if (measure_energy_) {
+      StartEnergyMeasurement();
+    }
+    if (count_events_) {
+      perf_counters_ = std::make_unique<PerfCounters>();
+      if (!perf_counters_->Available()) {
+        std::cerr << "Skipping performance counters: "
+                  << perf_counters_->error() << std::endl;
+        perf_counters_.reset();
+      }
+    }
+
+    std::vector<Result> results;
+    for (const auto& benchmark_case : cases_) {
+      if (!filter_.empty() &&
+          benchmark_case.name.find(filter_) == std::string::npos) {
+        continue;
+      }
+      results.push_back(RunCase(benchmark_case));
+      PrintResult(results.back());
+    }
+
+    if (!json_path_.empty()) {
+      return WriteJson(results) ? 0 : 1;
+    }
+    return 0;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Case {
+    std::string name;
+    double audio_seconds;
+    Body body;
+  };
+
+  bool ParseFlag(const char* arg) {
+    if (std::strncmp(arg, "--filter=", 9) == 0) {
+      filter_ = arg + 9;
+    } else if (std::strncmp(arg, "--min_time=", 11) == 0) {
+      min_time_seconds_ = std::atof(arg + 11);
+    } else if (std::strncmp(arg, "--json=", 7) == 0) {
+      json_path_ = arg + 7;
+    } else if (std::strcmp(arg, "--energy") == 0) {
+      measure_energy_ = true;
+    } else if (std::strcmp(arg, "--perf_counters") == 0) {
+      count_events_ = true;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  void StartEnergyMeasurement() {
+    energy_meter_ = std::make_unique<EnergyMeter>();
+    if (!energy_meter_->Available()) {
+      std::cerr << "Skipping energy measurement: " << energy_meter_->error()
+                << std::endl;
+      energy_meter_.reset();
+      return;
+    }
+    constexpr double kIdleSeconds = 1.0;
+    auto sample = energy_meter_->Sample();
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(kIdleSeconds));
+    idle_watts_ = energy_meter_->JoulesSince(sample) /
+                  std::chrono::duration<double>(Clock::now() - start).count();
+    char line[128];
+    std::snprintf(line, sizeof(line), "Idle package power: %.2f W",
+                  idle_watts_);
+    std::cerr << line << std::endl;
+  }
+
+  Result RunCase(const Case& benchmark_case) {
+    // Warm up caches, lazily built tables and the branch predictor.
+    for (int i = 0; i < 16; ++i) {
+      benchmark_case.body();
+    }
+
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    std::vector<uint64_t> energy_start;
+    if (energy_meter_) {
+      energy_start = energy_meter_->Sample();
+    }
+    if (perf_counters_) {
+      perf_counters_->Start();
+    }
+    auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    auto min_time = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(min_time_seconds_));
+    while (elapsed < min_time) {
+      for (uint64_t i = 0; i < batch; ++i) {
+        benchmark_case.body();
+      }
+      iterations += batch;
+      batch *= 2;
+      elapsed = Clock::now() - start;
+    }
+    std::vector<PerfCounters::Value> counters;
+    if (perf_counters_) {
+      counters = perf_counters_->Stop();
+    }
+    double joules = 0;
+    if (energy_meter_) {
+      double seconds = std::chrono::duration<double>(elapsed).count();
+      joules = energy_meter_->JoulesSince(energy_start) - idle_watts_ * seconds;
+    }
+
+    Result result;
+    result.name = benchmark_case.name;
+    result.iterations = iterations;
+    result.ns_per_iteration =
+        std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    if (benchmark_case.audio_seconds > 0) {
+      result.realtime_factor =
+          benchmark_case.audio_seconds * 1e9 / result.ns_per_iteration;
+    }
+    for (PerfCounters::Value& counter : counters) {
+      counter.count /= iterations;
+    }
+    result.counters = std::move(counters);
+    if (energy_meter_) {
+      result.has_energy = true;
+      result.joules_per_iteration = std::max(joules, 0.0) / iterations;
+      if (benchmark_case.audio_seconds > 0) {
+        result.joules_per_audio_second =
+            result.joules_per_iteration / benchmark_case.audio_seconds;
+      }
+    }
+    return result;
+  }
+
+  void PrintResult(const Result& result) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-48s %12.1f ns/iter %10llu iters",
+                  result.name.c_str(), result.ns_per_iteration,
+                  static_cast<unsigned long long>(result.iterations));
+    std::cerr << line;
+    if (result.realtime_factor > 0) {
+      std::snprintf(line, sizeof(line), " %10.0fx realtime",
+                    result.realtime_factor);
+      std::cerr << line;
+    }
+    double cycles = Counter(result, "cycles");
+    double instructions = Counter(result, "instructions");
+    if (cycles > 0 && instructions > 0) {
+      std::snprintf(line, sizeof(line), " %6.2f IPC", instructions / cycles);
+      std::cerr << line;
+    }
+    if (result.has_energy) {
+      std::snprintf(line, sizeof(line), " %10.3f uJ/iter",
+                    result.joules_per_iteration * 1e6);
+      std::cerr << line;
+      if (result.joules_per_audio_second > 0) {
+        std::snprintf(line, sizeof(line), " %8.3f mW/track",
+                      result.joules_per_audio_second * 1e3);
+        std::cerr << line;
+      }
+    }
+    std::cerr << std::endl;
+  }
+
+  static double Counter(const Result& result, const std::string& name) {
+    for (const PerfCounters::Value& counter : result.counters) {
+      if (counter.name == name) {
+        return counter.count;
+      }
+    }
+    return 0;
+  }
+
+  bool WriteJson(const std::vector<Result>& results) {
+    FILE* out = json_path_ == "-" ? stdout : std::fopen(json_path_.c_str(), "w");
+    if (!out) {
+      std::cerr << "Failed to open " << json_path_ << std::endl;
+      return false;
+    }
+    std::fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+      const Result& result = results[i];
+      std::fprintf(out,
+                   "  {\"name\": \"%s\", \"iterations\": %llu, "
+                   "\"ns_per_iteration\": %.3f, \"realtime_factor\": %.3f",
+                   result.name.c_str(),
+                   static_cast<unsigned long long>(result.iterations),
+                   result.ns_per_iteration, result.realtime_factor);
+      if (result.has_energy) {
+        std::fprintf(out,
+                     ", \"joules_per_iteration\": %.9g, "
+                     "\"joules_per_audio_second\": %.9g",
+                     result.joules_per_iteration,
+                     result.joules_per_audio_second);
+      }
+      if (!result.counters.empty()) {
+        std::fprintf(out, ", \"counters\": {");
+        for (size_t j = 0; j < result.counters.size(); ++j) {
+          std::fprintf(out, "%s\"%s\": %.3f", j > 0 ? ", " : "",
+                       result.counters[j].name.c_str(),
+                       result.counters[j].count);
+        }
+        std::fprintf(out, "}");
+      }
+      std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "]\n");
+    if (out != stdout) {
+      std::fclose(out);
+    }
+    return true;
+  }
+
+  std::vector<Case> cases_;
+  std::string filter_;
+  std::string json_path_;
+  double min_time_seconds_ = 0.5;
+  bool measure_energy_ = false;
+  std::unique_ptr<EnergyMeter> energy_meter_;
+  double idle_watts_ = 0;
+  bool count_events_ = false;
+  std::unique_ptr<PerfCounters> perf_counters_;
+};
+
+}  // namespace benchmark
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_PLUGIN_BENCHMARK_BENCHMARK_RUNNER_H_
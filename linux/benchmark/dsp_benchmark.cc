@@ -0,0 +1,451 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for the shared_cpp analysis code. Build the example app with
+// include_livekit_benchmarks set and run, for instance:
+// $ build/linux/x64/release/plugins/livekit_client/livekit_dsp_benchmark
+//     --json=dsp.json
+// Add --energy, as root, to also report the energy each case costs, e.g. in
+// mW per real-time track for the audio cases.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "audio_replay_buffer.h"
+#include "audio_source_stats.h"
+#include "audio_visualizer.h"
+#include "band_envelope.h"
+#include "benchmark/benchmark_runner.h"
+#include "echo_leak_detector.h"
+#include "fft_processor.h"
+#include "fixed_point_fft.h"
+#include "flutter/byte_buffer_streams.h"
+#include "livekit_codec.h"
+#include "math_extras.h"
+#include "pcm_jitter_buffer.h"
+#include "sliding_dft.h"
+#include "utterance_segmenter.h"
+#include "video_quality_analyzer.h"
+#include "visualizer_shadow.h"
+#include "wav_playback.h"
+#include "yuv_scaler.h"
+
+namespace livekit_client_plugin {
+namespace benchmark {
+namespace {
+
+constexpr int kSampleRate = 48000;
+// One WebRTC audio callback worth of mono samples (10 ms).
+constexpr unsigned kFramesPerCallback = kSampleRate / 100;
+constexpr double kSecondsPerCallback = 0.01;
+
+// Deterministic speech-like test signal: a few partials plus noise.
+std::vector<int16_t> MakeSignal(size_t frames) {
+  std::vector<int16_t> samples(frames);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < frames; ++i) {
+    double t = static_cast<double>(i) / kSampleRate;
+    double value = 0.30 * std::sin(2 * M_PI * 220.0 * t) +
+                   0.15 * std::sin(2 * M_PI * 1250.0 * t) +
+                   0.05 * std::sin(2 * M_PI * 3900.0 * t);
+    seed = seed * 1664525u + 1013904223u;
+    value += 0.02 * (static_cast<double>(seed >> 8) / (1 << 24) - 0.5);
+    samples[i] = static_cast<int16_t>(std::lround(value * 32767));
+  }
+  return samples;
+}
+
+// Feeds successive 10 ms chunks of a looping signal.
+class SignalCursor {
+ public:
+  SignalCursor() : signal_(MakeSignal(kSampleRate)) {}
+
+  const int16_t* Next() {
+    const int16_t* chunk = signal_.data() + offset_;
+    offset_ += kFramesPerCallback;
+    if (offset_ + kFramesPerCallback > signal_.size()) {
+      offset_ = 0;
+    }
+    return chunk;
+  }
+
+ private:
+  std::vector<int16_t> signal_;
+  size_t offset_ = 0;
+};
+
+void AddFFTBenchmarks(BenchmarkRunner& runner) {
+  // Raw transform cost: every iteration writes one callback of input and
+  // forces a new analysis by advancing the analysis time.
+  for (unsigned fft_size : {512u, 2048u, 8192u}) {
+    auto cursor = std::make_shared<SignalCursor>();
+    auto processor = std::make_shared<FFTProcessor>(fft_size);
+    auto magnitudes = std::make_shared<std::vector<float>>(fft_size / 2);
+    auto time = std::make_shared<double>(0);
+    runner.Add("FFTProcessor/pffft_float/" + std::to_string(fft_size),
+               kSecondsPerCallback, [=]() {
+                 processor->WriteInput(cursor->Next(), kFramesPerCallback);
+                 *time += kSecondsPerCallback;
+                 processor->GetFloatFrequencyData(*magnitudes, *time);
+               });
+  }
+  for (unsigned fft_size : {512u, 2048u, 8192u}) {
+    auto cursor = std::make_shared<SignalCursor>();
+    auto processor = std::make_shared<FixedPointFFTProcessor>(fft_size);
+    auto log2s = std::make_shared<std::vector<int32_t>>(fft_size / 2);
+    auto time = std::make_shared<double>(0);
+    runner.Add("FixedPointFFTProcessor/q15/" + std::to_string(fft_size),
+               kSecondsPerCallback, [=]() {
+                 processor->WriteInput(cursor->Next(), kFramesPerCallback);
+                 *time += kSecondsPerCallback;
+                 processor->GetLog2FrequencyData(*log2s, *time);
+               });
+  }
+}
+
+void AddSlidingDFTBenchmarks(BenchmarkRunner& runner) {
+  // Per-sample cost scales with the number of bins, not the window size.
+  for (size_t bins : {4u, 8u, 32u}) {
+    std::vector<float> frequencies;
+    for (size_t i = 0; i < bins; ++i) {
+      frequencies.push_back(50.0f * (i + 1));
+    }
+    auto cursor = std::make_shared<SignalCursor>();
+    auto bank = std::make_shared<SlidingDFTBank>(frequencies, kSampleRate,
+                                                 kSampleRate / 10);
+    auto levels = std::make_shared<std::vector<float>>(bins);
+    runner.Add("SlidingDFTBank/" + std::to_string(bins), kSecondsPerCallback,
+               [=]() {
+                 bank->Process(cursor->Next(), kFramesPerCallback);
+                 bank->GetDecibels(levels->data());
+               });
+  }
+}
+
+void AddEchoLeakDetectorBenchmarks(BenchmarkRunner& runner) {
+  // One 10 ms callback of capture plus one of each reference; the
+  // correlation itself runs on every 25th iteration.
+  for (size_t references : {1u, 4u}) {
+    auto capture = std::make_shared<SignalCursor>();
+    auto reference = std::make_shared<SignalCursor>();
+    auto detector = std::make_shared<EchoLeakDetector>(references);
+    runner.Add("EchoLeakDetector/" + std::to_string(references),
+               kSecondsPerCallback, [=]() {
+                 for (size_t i = 0; i < references; ++i) {
+                   detector->ProcessReference(i, reference->Next(),
+                                              kFramesPerCallback, kSampleRate,
+                                              1);
+                 }
+                 EchoLeakDetector::Alert alert;
+                 detector->ProcessCapture(capture->Next(), kFramesPerCallback,
+                                          kSampleRate, 1, &alert);
+               });
+  }
+}
+
+void AddVisualizerBenchmarks(BenchmarkRunner& runner) {
+  // End to end cost of one OnData callback as seen by VisualizerSink. The
+  // visualizer uses wall-clock time, so back-to-back callbacks within the same
+  // millisecond reuse the previous analysis, as they would in production.
+  for (bool fixed_point : {false, true}) {
+    auto cursor = std::make_shared<SignalCursor>();
+    auto visualizer = std::make_shared<AudioVisualizer>(
+        AudioVisualizer::kDefaultBandsCount, true,
+        AudioVisualizer::kDefaultSmoothingTimeConstant,
+        AudioVisualizer::kDefaultMinFrequency,
+        AudioVisualizer::kDefaultMaxFrequency, AudioVisualizer::kDefaultMinDb,
+        AudioVisualizer::kDefaultMaxDb, fixed_point);
+    auto bands = std::make_shared<std::vector<float>>();
+    runner.Add(std::string("AudioVisualizer/") +
+                   (fixed_point ? "q15" : "pffft_float") + "/7",
+               kSecondsPerCallback, [=]() {
+                 visualizer->Process(cursor->Next(), kFramesPerCallback,
+                                     kSampleRate, *bands);
+               });
+  }
+
+  // The same callback in shadow mode, with a fixed point candidate using a
+  // 1024 point FFT: the cost of both engines plus the comparison.
+  {
+    auto cursor = std::make_shared<SignalCursor>();
+    auto visualizer = std::make_shared<AudioVisualizer>(
+        AudioVisualizer::kDefaultBandsCount, true);
+    VisualizerShadow::Candidate candidate;
+    candidate.use_fixed_point = true;
+    candidate.fft_size = 1024;
+    auto shadow = std::make_shared<VisualizerShadow>(
+        AudioVisualizer::kDefaultBandsCount, true, candidate);
+    auto bands = std::make_shared<std::vector<float>>();
+    runner.Add("AudioVisualizer/shadow_q15_1024/7", kSecondsPerCallback, [=]() {
+      shadow->Process(visualizer.get(), cursor->Next(), kFramesPerCallback,
+                      kSampleRate, *bands);
+    });
+  }
+
+  // One 60 fps frame of attack/release smoothing with peak hold.
+  auto envelope = std::make_shared<BandEnvelope>(BandEnvelope::Options());
+  auto targets = std::make_shared<std::vector<float>>(64);
+  auto frame = std::make_shared<int>(0);
+  runner.Add("BandEnvelope/64", 1.0 / 60, [=]() {
+    // Alternate between two shapes so that bands rise and fall.
+    float phase = (++*frame & 8) ? 1.0f : 0.2f;
+    for (size_t i = 0; i < targets->size(); ++i) {
+      (*targets)[i] = phase * float(i % 7) / 6;
+    }
+    envelope->Process(targets->data(), targets->size(), 1.0 / 60);
+  });
+}
+
+void AddPcmSourceBenchmarks(BenchmarkRunner& runner) {
+  // One 10 ms tick of a stereo PCM source: Dart's writes arrive in 100 ms
+  // bursts, and the clock thread reads one frame per tick.
+  constexpr size_t kChannels = 2;
+  auto buffer = std::make_shared<PcmJitterBuffer>(kChannels, kSampleRate,
+                                                  kFramesPerCallback * 6);
+  auto burst = std::make_shared<std::vector<int16_t>>(kFramesPerCallback * 10 *
+                                                      kChannels);
+  for (size_t i = 0; i < burst->size(); ++i) {
+    (*burst)[i] = int16_t((i * 37) % 2000 - 1000);
+  }
+  auto frame =
+      std::make_shared<std::vector<int16_t>>(kFramesPerCallback * kChannels);
+  auto tick = std::make_shared<int>(0);
+  runner.Add("PcmJitterBuffer/stereo", kSecondsPerCallback, [=]() {
+    if ((*tick)++ % 10 == 0) {
+      buffer->Write(burst->data(), burst->size() / kChannels);
+    }
+    buffer->Read(frame->data(), kFramesPerCallback);
+  });
+}
+
+void AddWavPlaybackBenchmarks(BenchmarkRunner& runner) {
+  // One 10 ms stereo frame at 48 kHz from a one second file image: copied
+  // from a 16-bit file at that rate, and converted and resampled from a
+  // 44.1 kHz float one.
+  for (bool resample : {false, true}) {
+    const int file_rate = resample ? 44100 : kSampleRate;
+    const size_t sample_size = resample ? sizeof(float) : sizeof(int16_t);
+    const size_t data_size = size_t(file_rate) * 2 * sample_size;
+    auto file = std::make_shared<std::vector<uint8_t>>(44 + data_size);
+    uint8_t* header = file->data();
+    auto put32 = [](uint8_t* p, uint32_t value) { std::memcpy(p, &value, 4); };
+    auto put16 = [](uint8_t* p, uint16_t value) { std::memcpy(p, &value, 2); };
+    std::memcpy(header, "RIFF", 4);
+    put32(header + 4, uint32_t(36 + data_size));
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, 16);
+    put16(header + 20, resample ? 3 : 1);
+    put16(header + 22, 2);
+    put32(header + 24, uint32_t(file_rate));
+    put32(header + 28, uint32_t(file_rate * 2 * sample_size));
+    put16(header + 32, uint16_t(2 * sample_size));
+    put16(header + 34, uint16_t(sample_size * 8));
+    std::memcpy(header + 36, "data", 4);
+    put32(header + 40, uint32_t(data_size));
+    for (size_t i = 0; i < size_t(file_rate) * 2; ++i) {
+      const double value = 0.5 * std::sin(2 * M_PI * 440 * double(i / 2) /
+                                          file_rate);
+      if (resample) {
+        float sample = float(value);
+        std::memcpy(header + 44 + i * 4, &sample, 4);
+      } else {
+        int16_t sample = int16_t(value * 32767);
+        std::memcpy(header + 44 + i * 2, &sample, 2);
+      }
+    }
+    WavFormat format;
+    std::string error;
+    ParseWav(file->data(), file->size(), &format, &error);
+    auto playback = std::make_shared<WavPlayback>(format, kSampleRate, 2, true);
+    auto frame =
+        std::make_shared<std::vector<int16_t>>(kFramesPerCallback * 2);
+    runner.Add(resample ? "WavPlayback/f32_44k1_to_48k" : "WavPlayback/copy",
+               kSecondsPerCallback, [=]() {
+                 // Keeps |file| alive with the playback reading it.
+                 (void)file;
+                 playback->Render(frame->data(), kFramesPerCallback);
+               });
+  }
+}
+
+void AddReplayBufferBenchmarks(BenchmarkRunner& runner) {
+  // One 10 ms stereo callback into a 60 second replay buffer: mixed to mono
+  // and mu-law encoded.
+  auto cursor = std::make_shared<SignalCursor>();
+  auto stereo =
+      std::make_shared<std::vector<int16_t>>(kFramesPerCallback * 2);
+  auto buffer = std::make_shared<AudioReplayBuffer>(60.0);
+  runner.Add("AudioReplayBuffer/stereo", kSecondsPerCallback, [=]() {
+    const int16_t* mono = cursor->Next();
+    for (size_t i = 0; i < kFramesPerCallback; ++i) {
+      (*stereo)[2 * i] = (*stereo)[2 * i + 1] = mono[i];
+    }
+    buffer->Write(stereo->data(), kFramesPerCallback, kSampleRate, 2);
+  });
+}
+
+void AddUtteranceSegmenterBenchmarks(BenchmarkRunner& runner) {
+  // One 10 ms callback of continuous speech at 48 kHz: resampled to 16 kHz,
+  // classified and buffered, with an utterance cut every 20 seconds.
+  auto cursor = std::make_shared<SignalCursor>();
+  auto emitted = std::make_shared<size_t>(0);
+  auto segmenter = std::make_shared<UtteranceSegmenter>(
+      UtteranceSegmenter::Options(),
+      [emitted](const float*, size_t size, double) { *emitted += size; });
+  runner.Add("UtteranceSegmenter/48k", kSecondsPerCallback, [=]() {
+    segmenter->Process(cursor->Next(), kFramesPerCallback, kSampleRate, 1);
+  });
+}
+
+void AddVideoQualityBenchmarks(BenchmarkRunner& runner) {
+  // One analysed 720p frame per iteration, i.e. per analysis interval; the
+  // frames in between only cost a clock comparison.
+  constexpr int kWidth = 1280;
+  constexpr int kHeight = 720;
+  constexpr double kAnalysisInterval = 0.25;
+  auto luma = std::make_shared<std::vector<uint8_t>>(kWidth * kHeight);
+  uint32_t seed = 1;
+  for (uint8_t& value : *luma) {
+    seed = seed * 1664525u + 1013904223u;
+    value = static_cast<uint8_t>(seed >> 24);
+  }
+  auto analyzer = std::make_shared<VideoQualityAnalyzer>(kAnalysisInterval);
+  auto now = std::make_shared<double>(0);
+  runner.Add("VideoQualityAnalyzer/720p", kAnalysisInterval, [=]() {
+    VideoQualityAnalyzer::Report report;
+    analyzer->Process(luma->data(), kWidth, kHeight, kWidth, *now, &report);
+    *now += kAnalysisInterval;
+  });
+}
+
+void AddThumbnailBenchmarks(BenchmarkRunner& runner) {
+  // One 720p frame converted to a 160x90 RGBA tile per iteration.
+  constexpr int kWidth = 1280;
+  constexpr int kHeight = 720;
+  constexpr int kTileWidth = 160;
+  constexpr int kTileHeight = 90;
+  auto planes =
+      std::make_shared<std::vector<uint8_t>>(kWidth * kHeight * 3 / 2);
+  uint32_t seed = 1;
+  for (uint8_t& value : *planes) {
+    seed = seed * 1664525u + 1013904223u;
+    value = static_cast<uint8_t>(seed >> 24);
+  }
+  auto scaler = std::make_shared<I420ToRGBAScaler>(kTileWidth, kTileHeight);
+  auto tile =
+      std::make_shared<std::vector<uint8_t>>(kTileWidth * kTileHeight * 4);
+  runner.Add("Thumbnail/720p_to_160x90", 0, [=]() {
+    const uint8_t* y = planes->data();
+    const uint8_t* u = y + kWidth * kHeight;
+    const uint8_t* v = u + kWidth * kHeight / 4;
+    scaler->Convert(y, kWidth, u, kWidth / 2, v, kWidth / 2, kWidth, kHeight,
+                    tile->data(), kTileWidth * 4);
+  });
+}
+
+void AddCodecBenchmarks(BenchmarkRunner& runner) {
+  // One visualizer event envelope, as a typed BandFrame and as the plain
+  // standard codec list it replaced.
+  constexpr size_t kBands = 64;
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto sequence = std::make_shared<uint32_t>(0);
+  runner.Add("Codec/BandFrame/64", 0, [=]() {
+    BandFrame frame;
+    frame.timestamp_us = 1000000;
+    frame.sequence = (*sequence)++;
+    frame.sample_rate = 48000;
+    frame.bands.assign(kBands, 0.5f);
+    flutter::EncodableValue value(
+        flutter::CustomEncodableValue(std::move(frame)));
+    *buffer = std::move(*LiveKitMethodCodec().EncodeSuccessEnvelope(&value));
+  });
+  // Decoding a truncated frame, which logs an invalid read per message. Only
+  // a few are written per second; the rest cost a rate limiter check.
+  auto truncated = std::make_shared<std::vector<uint8_t>>();
+  {
+    BandFrame frame;
+    frame.bands.assign(kBands, 0.5f);
+    flutter::EncodableValue value(
+        flutter::CustomEncodableValue(std::move(frame)));
+    *truncated = std::move(*LiveKitMethodCodec().EncodeSuccessEnvelope(&value));
+    truncated->resize(truncated->size() / 2);
+  }
+  runner.Add("Codec/TruncatedBandFrame/64", 0, [=]() {
+    flutter::ByteBufferStreamReader stream(truncated->data(),
+                                           truncated->size());
+    stream.ReadByte();
+    LiveKitCodecSerializer::GetInstance().ReadValue(&stream);
+  });
+  runner.Add("Codec/StandardList/64", 0, [=]() {
+    flutter::EncodableList bands(kBands, flutter::EncodableValue(0.5));
+    flutter::EncodableValue value(std::move(bands));
+    *buffer = std::move(
+        *flutter::StandardMethodCodec::GetInstance().EncodeSuccessEnvelope(
+            &value));
+  });
+}
+
+void AddMathBenchmarks(BenchmarkRunner& runner) {
+  // Decibel conversion of one 2048-point spectrum, libm vs math_extras.h.
+  auto magnitudes = std::make_shared<std::vector<float>>(1024);
+  for (size_t i = 0; i < magnitudes->size(); ++i) {
+    (*magnitudes)[i] = std::pow(10.0f, -6.0f * i / magnitudes->size());
+  }
+  auto decibels = std::make_shared<std::vector<float>>(magnitudes->size());
+  runner.Add("Math/log10f_db/1024", 0, [=]() {
+    for (size_t i = 0; i < magnitudes->size(); ++i) {
+      (*decibels)[i] = 20 * log10f((*magnitudes)[i]);
+    }
+  });
+  runner.Add("Math/FastLog2_db/1024", 0, [=]() {
+    FastMathTransform(magnitudes->data(), decibels->data(), magnitudes->size(),
+                      [](auto ops, auto linear) {
+                        using Ops = decltype(ops);
+                        return Ops::Mul(FastLog2<Ops>(linear),
+                                        Ops::Set(kLog2ToDecibels));
+                      });
+  });
+
+  // Level metering of one mono callback.
+  auto cursor = std::make_shared<SignalCursor>();
+  auto sum = std::make_shared<uint64_t>(0);
+  runner.Add("Math/SumOfSquaresS16/480", 0, [=]() {
+    *sum += SumOfSquaresS16(cursor->Next(), kFramesPerCallback);
+  });
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace livekit_client_plugin
+
+int main(int argc, char** argv) {
+  livekit_client_plugin::benchmark::BenchmarkRunner runner;
+  livekit_client_plugin::benchmark::AddFFTBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddSlidingDFTBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddEchoLeakDetectorBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddVisualizerBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddPcmSourceBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddWavPlaybackBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddReplayBufferBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddUtteranceSegmenterBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddVideoQualityBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddThumbnailBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddCodecBenchmarks(runner);
+  livekit_client_plugin::benchmark::AddMathBenchmarks(runner);
+  return runner.Run(argc, argv);
+}
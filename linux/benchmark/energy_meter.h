@@ -0,0 +1,133 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_PLUGIN_BENCHMARK_ENERGY_METER_H_
+#define LIVEKIT_CLIENT_PLUGIN_BENCHMARK_ENERGY_METER_H_
+
+#include <dirent.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace livekit_client_plugin {
+namespace benchmark {
+
+// Reads the CPU package energy counters that Linux exposes through the
+// powercap RAPL interface (Intel, and AMD Zen since 5.8 kernels).
+//
+// Only top-level package domains are summed: their subzones (cores, uncore,
+// dram) and the platform-wide psys domain overlap them. The counters cover
+// the whole package, so callers should subtract the idle baseline. Since
+// Linux 5.10 energy_uj is only readable by root; Available() is false then,
+// as on machines and VMs without RAPL.
+class EnergyMeter {
+ public:
+  explicit EnergyMeter(std::string root = "/sys/class/powercap") {
+    DIR* directory = opendir(root.c_str());
+    if (!directory) {
+      error_ = root + " not found";
+      return;
+    }
+    std::vector<Domain> packages;
+    std::vector<Domain> others;
+    while (dirent* entry = readdir(directory)) {
+      // Top-level zones are named intel-rapl:<n>, subzones
+      // intel-rapl:<n>:<m>.
+      std::string zone = entry->d_name;
+      if (zone.compare(0, 11, "intel-rapl:") != 0 ||
+          zone.find(':', 11) != std::string::npos) {
+        continue;
+      }
+      Domain domain;
+      domain.path = root + "/" + zone;
+      std::string name;
+      uint64_t energy;
+      if (!ReadLine(domain.path + "/name", &name) ||
+          !ReadCounter(domain.path + "/max_energy_range_uj",
+                       &domain.max_energy_range_uj) ||
+          !ReadCounter(domain.path + "/energy_uj", &energy)) {
+        error_ = domain.path + "/energy_uj is not readable (try as root)";
+        continue;
+      }
+      (name.compare(0, 7, "package") == 0 ? packages : others)
+          .push_back(domain);
+    }
+    closedir(directory);
+    domains_ = packages.empty() ? others : packages;
+    if (domains_.empty() && error_.empty()) {
+      error_ = "no RAPL domains in " + root;
+    }
+  }
+
+  bool Available() const { return !domains_.empty(); }
+
+  // Why Available() is false.
+  const std::string& error() const { return error_; }
+
+  // Raw counter values, to be passed to JoulesSince().
+  std::vector<uint64_t> Sample() const {
+    std::vector<uint64_t> sample(domains_.size());
+    for (size_t i = 0; i < domains_.size(); ++i) {
+      ReadCounter(domains_[i].path + "/energy_uj", &sample[i]);
+    }
+    return sample;
+  }
+
+  // Energy used by all domains since |start|, accounting for counters that
+  // wrapped around once.
+  double JoulesSince(const std::vector<uint64_t>& start) const {
+    std::vector<uint64_t> end = Sample();
+    double microjoules = 0;
+    for (size_t i = 0; i < domains_.size() && i < start.size(); ++i) {
+      if (end[i] >= start[i]) {
+        microjoules += double(end[i] - start[i]);
+      } else {
+        microjoules +=
+            double(domains_[i].max_energy_range_uj - start[i] + end[i]);
+      }
+    }
+    return microjoules * 1e-6;
+  }
+
+ private:
+  struct Domain {
+    std::string path;
+    uint64_t max_energy_range_uj = 0;
+  };
+
+  static bool ReadLine(const std::string& path, std::string* value) {
+    std::ifstream file(path);
+    return static_cast<bool>(std::getline(file, *value));
+  }
+
+  static bool ReadCounter(const std::string& path, uint64_t* value) {
+    std::ifstream file(path);
+    unsigned long long counter;
+    if (!(file >> counter)) {
+      return false;
+    }
+    *value = counter;
+    return true;
+  }
+
+  std::vector<Domain> domains_;
+  std::string error_;
+};
+
+}  // namespace benchmark
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_PLUGIN_BENCHMARK_ENERGY_METER_H_
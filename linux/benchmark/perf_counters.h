@@ -0,0 +1,139 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_PLUGIN_BENCHMARK_PERF_COUNTERS_H_
+#define LIVEKIT_CLIENT_PLUGIN_BENCHMARK_PERF_COUNTERS_H_
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace livekit_client_plugin {
+namespace benchmark {
+
+// Counts hardware events of the calling thread with perf_event_open.
+//
+// Every event is opened on its own rather than as a group, so that events
+// the CPU or hypervisor does not support are just left out and the others
+// still count. When more events are open than the PMU has counters, the
+// kernel multiplexes them; values are scaled by enabled over running time,
+// which is exact for steady loops such as benchmark bodies. Needs
+// kernel.perf_event_paranoid <= 2, the default on most distributions.
+class PerfCounters {
+ public:
+  struct Value {
+    std::string name;
+    double count = 0;
+  };
+
+  PerfCounters() {
+    const uint64_t l1d_read_access = PERF_COUNT_HW_CACHE_L1D |
+                                     (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+    const uint64_t llc_read_access = PERF_COUNT_HW_CACHE_LL |
+                                     (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+    Open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    Open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    Open("cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    Open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    Open("l1d_loads", PERF_TYPE_HW_CACHE, l1d_read_access);
+    Open("llc_loads", PERF_TYPE_HW_CACHE, llc_read_access);
+  }
+
+  ~PerfCounters() {
+    for (const Counter& counter : counters_) {
+      close(counter.fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  bool Available() const { return !counters_.empty(); }
+
+  // Why Available() is false.
+  const std::string& error() const { return error_; }
+
+  void Start() {
+    for (const Counter& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  // Stops counting and returns the events counted since Start(), in the
+  // order above, leaving out unsupported ones.
+  std::vector<Value> Stop() {
+    for (const Counter& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    std::vector<Value> values;
+    for (const Counter& counter : counters_) {
+      // value, time_enabled, time_running.
+      uint64_t data[3] = {};
+      if (read(counter.fd, data, sizeof(data)) != sizeof(data) ||
+          data[2] == 0) {
+        continue;
+      }
+      values.push_back({counter.name, double(data[0]) * double(data[1]) /
+                                          double(data[2])});
+    }
+    return values;
+  }
+
+ private:
+  struct Counter {
+    std::string name;
+    int fd;
+  };
+
+  void Open(const char* name, uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                -1 /* any cpu */, -1 /* no group */, 0));
+    if (fd < 0) {
+      if (error_.empty()) {
+        error_ = std::string("perf_event_open failed: ") + std::strerror(errno);
+      }
+      return;
+    }
+    counters_.push_back({name, fd});
+  }
+
+  std::vector<Counter> counters_;
+  std::string error_;
+};
+
+}  // namespace benchmark
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_PLUGIN_BENCHMARK_PERF_COUNTERS_H_
@@ -0,0 +1,411 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how long it takes from a startVisualizer call until the first
+// bands reach the event channel, stage by stage, without Flutter or
+// libwebrtc: the binary messenger is a stub that records messages, and the
+// track is synthetic audio fed to SharedVisualizer::OnData(). The stages are
+//   decode       decoding the startVisualizer method call and its arguments
+//   register     acquiring the shared analysis and registering the event
+//                channel's message handler
+//   construct    the rest of the VisualizerSink constructor
+//   listen       handling the Dart side's listen call, up to its reply
+//   first_event  from the first audio callback to the first event sent,
+//                including the hop through the main loop
+// With --sinks=N, N visualizers are started together, as when N remote
+// participants join at once: each stage runs for all of them before the next
+// one starts and audio is delivered round robin, so a stage's time is the
+// time until all N completed it. Run for instance:
+// $ build/linux/x64/release/plugins/livekit_client/livekit_startup_benchmark
+//     --sinks=1,4,16 --json=startup.json
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_call.h>
+#include <flutter/standard_method_codec.h>
+#include <glib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "analysis_service.h"
+#include "livekit_codec.h"
+#include "thread_safe_binary_messenger.h"
+#include "visualizer_sink.h"
+
+namespace livekit_client_plugin {
+namespace benchmark {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kSampleRate = 48000;
+constexpr size_t kFramesPerCallback = kSampleRate / 100;
+// Gives up on a visualizer that did not emit after this much audio.
+constexpr int kMaxCallbacks = 1000;
+
+const char* const kStages[] = {"decode", "register", "construct", "listen",
+                               "first_event"};
+constexpr size_t kStageCount = sizeof(kStages) / sizeof(kStages[0]);
+
+double Microseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Stands in for the engine's messenger: records when handlers are
+// registered and when the first message of every channel is sent.
+class StubMessenger : public flutter::BinaryMessenger {
+ public:
+  void Send(const std::string& channel,
+            const uint8_t* message,
+            size_t message_size,
+            flutter::BinaryReply reply) const override {
+    first_sent_.emplace(channel, Clock::now());
+  }
+
+  void SetMessageHandler(const std::string& channel,
+                         flutter::BinaryMessageHandler handler) override {
+    if (handler) {
+      registered_[channel] = Clock::now();
+      handlers_[channel] = std::move(handler);
+    } else {
+      handlers_.erase(channel);
+    }
+  }
+
+  // Delivers |message| as if sent by Dart and returns when it was replied
+  // to.
+  Clock::time_point Deliver(const std::string& channel,
+                            const std::vector<uint8_t>& message) {
+    Clock::time_point replied;
+    handlers_.at(channel)(message.data(), message.size(),
+                          [&replied](const uint8_t*, size_t) {
+                            replied = Clock::now();
+                          });
+    return replied;
+  }
+
+  Clock::time_point registered(const std::string& channel) const {
+    return registered_.at(channel);
+  }
+
+  bool Sent(const std::string& channel, Clock::time_point* time) const {
+    auto it = first_sent_.find(channel);
+    if (it == first_sent_.end()) {
+      return false;
+    }
+    *time = it->second;
+    return true;
+  }
+
+  void Reset() {
+    handlers_.clear();
+    registered_.clear();
+    first_sent_.clear();
+  }
+
+ private:
+  std::map<std::string, flutter::BinaryMessageHandler> handlers_;
+  std::map<std::string, Clock::time_point> registered_;
+  mutable std::map<std::string, Clock::time_point> first_sent_;
+};
+
+void RunMainLoop() {
+  while (g_main_context_iteration(g_main_context_default(), FALSE)) {
+  }
+}
+
+std::string FindString(const flutter::EncodableMap& map, const char* key) {
+  auto it = map.find(flutter::EncodableValue(key));
+  if (it != map.end()) {
+    if (auto* value = std::get_if<std::string>(&it->second)) {
+      return *value;
+    }
+  }
+  return std::string();
+}
+
+int FindInt(const flutter::EncodableMap& map, const char* key) {
+  auto it = map.find(flutter::EncodableValue(key));
+  if (it != map.end()) {
+    if (auto* value = std::get_if<int32_t>(&it->second)) {
+      return *value;
+    }
+  }
+  return -1;
+}
+
+struct Visualizer {
+  std::string track_id;
+  std::string visualizer_id;
+  std::string channel;
+  std::vector<uint8_t> start_call;
+  std::shared_ptr<SharedVisualizer> analysis;
+  std::unique_ptr<VisualizerSink> sink;
+  Clock::time_point sent;
+  bool done = false;
+};
+
+// Runs one start of |count| visualizers and returns the duration of every
+// stage in microseconds, or an empty vector if a visualizer never emitted.
+std::vector<double> RunStartup(StubMessenger* stub,
+                               ThreadSafeBinaryMessenger* messenger,
+                               AnalysisService* service,
+                               size_t count,
+                               int repetition,
+                               const std::vector<int16_t>& audio) {
+  const auto& codec = flutter::StandardMethodCodec::GetInstance();
+  std::vector<Visualizer> visualizers(count);
+  for (size_t i = 0; i < count; ++i) {
+    Visualizer& visualizer = visualizers[i];
+    visualizer.track_id =
+        "track-" + std::to_string(repetition) + "-" + std::to_string(i);
+    visualizer.visualizer_id = "visualizer-" + std::to_string(i);
+    flutter::EncodableMap arguments = {
+        {flutter::EncodableValue("trackId"),
+         flutter::EncodableValue(visualizer.track_id)},
+        {flutter::EncodableValue("visualizerId"),
+         flutter::EncodableValue(visualizer.visualizer_id)},
+        {flutter::EncodableValue("barCount"), flutter::EncodableValue(7)},
+        {flutter::EncodableValue("isCentered"), flutter::EncodableValue(true)},
+    };
+    visualizer.start_call = *codec.EncodeMethodCall(
+        flutter::MethodCall<flutter::EncodableValue>(
+            "startVisualizer", std::make_unique<flutter::EncodableValue>(
+                                   std::move(arguments))));
+  }
+  const std::vector<uint8_t> listen_call =
+      *LiveKitMethodCodec().EncodeMethodCall(
+          flutter::MethodCall<flutter::EncodableValue>("listen", nullptr));
+
+  std::vector<double> stages(kStageCount, 0);
+  stub->Reset();
+
+  struct Arguments {
+    std::string track_id;
+    std::string visualizer_id;
+    int bar_count;
+  };
+  std::vector<Arguments> decoded(count);
+  auto start = Clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    auto call = codec.DecodeMethodCall(visualizers[i].start_call);
+    const auto& arguments =
+        std::get<flutter::EncodableMap>(*call->arguments());
+    decoded[i] = {FindString(arguments, "trackId"),
+                  FindString(arguments, "visualizerId"),
+                  FindInt(arguments, "barCount")};
+  }
+  auto decoded_at = Clock::now();
+  stages[0] = Microseconds(decoded_at - start);
+
+  // Registration happens first in the constructor, so for every sink the
+  // time up to its handler registration is attributed to "register".
+  for (size_t i = 0; i < count; ++i) {
+    Visualizer& visualizer = visualizers[i];
+    visualizer.channel = "io.livekit.audio.visualizer/eventChannel-" +
+                         decoded[i].track_id + "-" + decoded[i].visualizer_id;
+    auto constructing = Clock::now();
+    visualizer.analysis = service->AcquireVisualizer(
+        decoded[i].track_id, decoded[i].bar_count, true, nullptr);
+    visualizer.sink = std::make_unique<VisualizerSink>(
+        messenger, visualizer.channel, decoded[i].visualizer_id,
+        visualizer.analysis);
+    auto constructed = Clock::now();
+    auto registered = stub->registered(visualizer.channel);
+    stages[1] += Microseconds(registered - constructing);
+    stages[2] += Microseconds(constructed - registered);
+  }
+
+  start = Clock::now();
+  for (Visualizer& visualizer : visualizers) {
+    stub->Deliver(visualizer.channel, listen_call);
+  }
+  stages[3] = Microseconds(Clock::now() - start);
+
+  start = Clock::now();
+  size_t remaining = count;
+  size_t offset = 0;
+  for (int callback = 0; callback < kMaxCallbacks && remaining > 0;
+       ++callback) {
+    for (Visualizer& visualizer : visualizers) {
+      if (visualizer.done) {
+        continue;
+      }
+      visualizer.analysis->OnData(audio.data() + offset, 16, kSampleRate, 1,
+                                  kFramesPerCallback);
+    }
+    RunMainLoop();
+    for (Visualizer& visualizer : visualizers) {
+      if (!visualizer.done &&
+          stub->Sent(visualizer.channel, &visualizer.sent)) {
+        visualizer.done = true;
+        --remaining;
+      }
+    }
+    offset =
+        (offset + kFramesPerCallback) % (audio.size() - kFramesPerCallback);
+  }
+  if (remaining > 0) {
+    return std::vector<double>();
+  }
+  Clock::time_point last = start;
+  for (const Visualizer& visualizer : visualizers) {
+    last = std::max(last, visualizer.sent);
+  }
+  stages[4] = Microseconds(last - start);
+
+  // Stopping is not measured.
+  visualizers.clear();
+  RunMainLoop();
+  return stages;
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+  std::sort(values.begin(), values.end());
+  size_t index = std::min(values.size() - 1,
+                          static_cast<size_t>(fraction * values.size()));
+  return values[index];
+}
+
+struct Result {
+  size_t sinks;
+  // Per stage and for the total.
+  std::vector<double> medians;
+  std::vector<double> p95s;
+};
+
+int Run(int argc, char** argv) {
+  std::vector<size_t> sink_counts = {1, 4, 16};
+  int repetitions = 200;
+  std::string json_path;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (std::strncmp(arg, "--sinks=", 8) == 0) {
+      sink_counts.clear();
+      for (const char* p = arg + 8; *p;) {
+        char* end;
+        long value = std::strtol(p, &end, 10);
+        if (end == p || value <= 0) {
+          break;
+        }
+        sink_counts.push_back(static_cast<size_t>(value));
+        p = *end == ',' ? end + 1 : end;
+      }
+    } else if (std::strncmp(arg, "--repetitions=", 14) == 0) {
+      repetitions = std::max(1, std::atoi(arg + 14));
+    } else if (std::strncmp(arg, "--json=", 7) == 0) {
+      json_path = arg + 7;
+    } else {
+      std::cerr << "Unknown flag: " << arg << std::endl
+                << "Flags: --sinks=<n,n,...> --repetitions=<n> "
+                   "--json=<path|->"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // One second of a 440 Hz tone.
+  std::vector<int16_t> audio(kSampleRate);
+  for (size_t i = 0; i < audio.size(); ++i) {
+    audio[i] = static_cast<int16_t>(
+        8000 * std::sin(2 * M_PI * 440 * double(i) / kSampleRate));
+  }
+
+  StubMessenger stub;
+  ThreadSafeBinaryMessenger messenger(&stub);
+  // Held for the whole run, as by the plugin.
+  std::shared_ptr<AnalysisService> service = AnalysisService::Acquire();
+  std::vector<Result> results;
+  for (size_t sinks : sink_counts) {
+    std::vector<std::vector<double>> samples(kStageCount + 1);
+    // Warm up allocators and lazily built FFT tables.
+    RunStartup(&stub, &messenger, service.get(), sinks, -1, audio);
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+      std::vector<double> stages =
+          RunStartup(&stub, &messenger, service.get(), sinks, repetition,
+                     audio);
+      if (stages.empty()) {
+        std::cerr << "No event after " << kMaxCallbacks << " callbacks"
+                  << std::endl;
+        return 1;
+      }
+      double total = 0;
+      for (size_t stage = 0; stage < kStageCount; ++stage) {
+        samples[stage].push_back(stages[stage]);
+        total += stages[stage];
+      }
+      samples[kStageCount].push_back(total);
+    }
+
+    Result result{sinks, {}, {}};
+    char line[256];
+    std::snprintf(line, sizeof(line), "Startup/%zu sinks (us, median / p95)",
+                  sinks);
+    std::cerr << line << std::endl;
+    for (size_t stage = 0; stage <= kStageCount; ++stage) {
+      result.medians.push_back(Percentile(samples[stage], 0.5));
+      result.p95s.push_back(Percentile(samples[stage], 0.95));
+      std::snprintf(line, sizeof(line), "  %-12s %10.1f %10.1f",
+                    stage < kStageCount ? kStages[stage] : "total",
+                    result.medians.back(), result.p95s.back());
+      std::cerr << line << std::endl;
+    }
+    results.push_back(std::move(result));
+  }
+
+  if (json_path.empty()) {
+    return 0;
+  }
+  FILE* out =
+      json_path == "-" ? stdout : std::fopen(json_path.c_str(), "w");
+  if (!out) {
+    std::cerr << "Failed to open " << json_path << std::endl;
+    return 1;
+  }
+  std::fprintf(out, "[\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    std::fprintf(out, "  {\"sinks\": %zu", result.sinks);
+    for (size_t stage = 0; stage <= kStageCount; ++stage) {
+      const char* name = stage < kStageCount ? kStages[stage] : "total";
+      std::fprintf(out, ", \"%s_us\": %.3f, \"%s_p95_us\": %.3f", name,
+                   result.medians[stage], name, result.p95s[stage]);
+    }
+    std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(out, "]\n");
+  if (out != stdout) {
+    std::fclose(out);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace livekit_client_plugin
+
+int main(int argc, char** argv) {
+  return livekit_client_plugin::benchmark::Run(argc, argv);
+}
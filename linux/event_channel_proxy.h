@@ -0,0 +1,133 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_EVENT_CHANNEL_PROXY_H_
+#define LIVEKIT_CLIENT_LINUX_EVENT_CHANNEL_PROXY_H_
+
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/event_stream_handler_functions.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "livekit_codec.h"
+#include "thread_safe_binary_messenger.h"
+
+namespace livekit_client_plugin {
+
+// Owns an EventChannel and sends events to its Dart listener from any thread.
+// |messenger| must be a ThreadSafeBinaryMessenger, so events are encoded on
+// the calling thread and the main thread only forwards the bytes. Events sent
+// before the stream is listened to are queued. |on_listen| and |on_cancel|,
+// when set, run on the main thread after the Dart side starts or stops
+// listening.
+class EventChannelProxy {
+ public:
+  EventChannelProxy(ThreadSafeBinaryMessenger* messenger,
+                    const std::string& event_channel_name,
+                    std::function<void()> on_listen = nullptr,
+                    std::function<void()> on_cancel = nullptr)
+      : on_listen_(std::move(on_listen)),
+        on_cancel_(std::move(on_cancel)),
+        channel_(
+            std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+                messenger,
+                event_channel_name,
+                &LiveKitMethodCodec())) {
+    auto handler = std::make_unique<
+        flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+        [&](const flutter::EncodableValue* arguments,
+            std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                events)
+            -> std::unique_ptr<
+                flutter::StreamHandlerError<flutter::EncodableValue>> {
+          std::atomic_store(
+              &sink_,
+              std::shared_ptr<flutter::EventSink<flutter::EncodableValue>>(
+                  std::move(events)));
+          if (on_listen_) {
+            on_listen_();
+          }
+          std::lock_guard<std::mutex> lock(queue_mutex_);
+          for (auto& event : event_queue_) {
+            PostEvent(event);
+          }
+          event_queue_.clear();
+          on_listen_called_ = true;
+          return nullptr;
+        },
+        [&](const flutter::EncodableValue* arguments)
+            -> std::unique_ptr<
+                flutter::StreamHandlerError<flutter::EncodableValue>> {
+          on_listen_called_ = false;
+          if (on_cancel_) {
+            on_cancel_();
+          }
+          return nullptr;
+        });
+
+    channel_->SetStreamHandler(std::move(handler));
+  }
+
+  // The handlers above capture |this|, so unregister them before the members
+  // they use go away. A listen or cancel arriving later gets no handler
+  // instead of reaching a destroyed proxy. Because handlers are registered by
+  // channel name, a proxy must be destroyed before another one is created for
+  // the same channel.
+  ~EventChannelProxy() { channel_->SetStreamHandler(nullptr); }
+
+  bool IsListening() const { return on_listen_called_; }
+
+  void Success(const flutter::EncodableValue& event, bool cache_event = true) {
+    if (on_listen_called_) {
+      PostEvent(event);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    // Re-check under the lock so an event can't slip in after the queue has
+    // been flushed by the listen handler.
+    if (on_listen_called_) {
+      PostEvent(event);
+    } else if (cache_event) {
+      event_queue_.push_back(event);
+    }
+  }
+
+ private:
+  void PostEvent(const flutter::EncodableValue& event) {
+    // The sink is replaced on the main thread when the stream is listened to
+    // again, while audio threads may be sending.
+    auto sink = std::atomic_load(&sink_);
+    if (sink) {
+      sink->Success(event);
+    }
+  }
+
+  std::function<void()> on_listen_;
+  std::function<void()> on_cancel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> channel_;
+  std::shared_ptr<flutter::EventSink<flutter::EncodableValue>> sink_;
+  std::mutex queue_mutex_;
+  std::list<flutter::EncodableValue> event_queue_;
+  std::atomic<bool> on_listen_called_{false};
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_EVENT_CHANNEL_PROXY_H_
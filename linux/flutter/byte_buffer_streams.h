@@ -8,10 +8,10 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
-#include <iostream>
 #include <vector>
 
 #include "include/flutter/byte_streams.h"
+#include "logger.h"
 
 namespace flutter {
 
@@ -28,7 +28,7 @@ class ByteBufferStreamReader : public ByteStreamReader {
   // |ByteStreamReader|
   uint8_t ReadByte() override {
     if (location_ >= size_) {
-      std::cerr << "Invalid read in StandardCodecByteStreamReader" << std::endl;
+      LIVEKIT_LOG_ERROR("Invalid read in StandardCodecByteStreamReader");
       return 0;
     }
     return bytes_[location_++];
@@ -37,7 +37,7 @@ class ByteBufferStreamReader : public ByteStreamReader {
   // |ByteStreamReader|
   void ReadBytes(uint8_t* buffer, size_t length) override {
     if (location_ + length > size_) {
-      std::cerr << "Invalid read in StandardCodecByteStreamReader" << std::endl;
+      LIVEKIT_LOG_ERROR("Invalid read in StandardCodecByteStreamReader");
       return;
     }
     std::memcpy(buffer, &bytes_[location_], length);
@@ -14,13 +14,15 @@
 // manually include files.
 
 #include <cassert>
-#include <iostream>
+#include <memory>
+#include <mutex>
 #include <variant>
 
 #include "binary_messenger_impl.h"
 #include "include/flutter/engine_method_result.h"
 #include "include/flutter/texture_registrar.h"
 #include "texture_registrar_impl.h"
+#include "logger.h"
 
 struct FlTextureProxy {
   FlPixelBufferTexture parent_instance;
@@ -92,9 +94,8 @@ static void ForwardToHandler(FlBinaryMessenger* messenger,
   BinaryReply reply_handler = [messenger, handler](const uint8_t* reply,
                                                    size_t reply_size) mutable {
     if (!handler) {
-      std::cerr << "Error: Response can be set only once. Ignoring "
-                   "duplicate response."
-                << std::endl;
+      LIVEKIT_LOG_ERROR(
+          "Response can be set only once. Ignoring duplicate response.");
       return;
     }
 
@@ -103,7 +104,8 @@ static void ForwardToHandler(FlBinaryMessenger* messenger,
     if (!fl_binary_messenger_send_response(
             messenger, (FlBinaryMessengerResponseHandle*)handler, response,
             &error)) {
-      g_warning("Failed to send binary response: %s", error->message);
+      LIVEKIT_LOG_WARNING("Failed to send binary response: %s",
+                          error->message);
     }
   };
 
@@ -111,7 +113,7 @@ static void ForwardToHandler(FlBinaryMessenger* messenger,
       *static_cast<BinaryMessageHandler*>(user_data);
 
   if (user_data == nullptr) {
-    std::cerr << "Error: user_data is null" << std::endl;
+    LIVEKIT_LOG_ERROR("user_data is null");
     return;
   }
 
@@ -191,19 +193,16 @@ ReplyManager::~ReplyManager() {
   if (reply_handler_) {
     // Warn, rather than send a not-implemented response, since the engine may
     // no longer be valid at this point.
-    std::cerr
-        << "Warning: Failed to respond to a message. This is a memory leak."
-        << std::endl;
+    LIVEKIT_LOG_WARNING(
+        "Failed to respond to a message. This is a memory leak.");
   }
 }
 
 void ReplyManager::SendResponseData(const std::vector<uint8_t>* data) {
   if (!reply_handler_) {
-    std::cerr
-        << "Error: Only one of Success, Error, or NotImplemented can be "
-           "called,"
-        << " and it can be called exactly once. Ignoring duplicate result."
-        << std::endl;
+    LIVEKIT_LOG_ERROR(
+        "Only one of Success, Error, or NotImplemented can be called, and it "
+        "can be called exactly once. Ignoring duplicate result.");
     return;
   }
 
@@ -219,39 +218,55 @@ void ReplyManager::SendResponseData(const std::vector<uint8_t>* data) {
 
 TextureRegistrarImpl::TextureRegistrarImpl(
     FlTextureRegistrar* texture_registrar_ref)
-    : texture_registrar_ref_(texture_registrar_ref) {}
+    : texture_registrar_ref_(texture_registrar_ref),
+      textures_(std::make_shared<const TextureMap>()) {}
 
 TextureRegistrarImpl::~TextureRegistrarImpl() = default;
 
 int64_t TextureRegistrarImpl::RegisterTexture(TextureVariant* texture) {
-  auto texture_proxy = fl_texture_proxy_new(texture);
+  // The map's reference is released when the last snapshot holding the
+  // texture goes away.
+  std::shared_ptr<FlTextureProxy> texture_proxy(
+      fl_texture_proxy_new(texture),
+      [](FlTextureProxy* proxy) { g_object_unref(proxy); });
   fl_texture_registrar_register_texture(texture_registrar_ref_,
-                                        FL_TEXTURE(texture_proxy));
-  int64_t texture_id = reinterpret_cast<int64_t>(texture_proxy);
-  textures_[texture_id] = texture_proxy;
+                                        FL_TEXTURE(texture_proxy.get()));
+  int64_t texture_id = reinterpret_cast<int64_t>(texture_proxy.get());
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto textures = std::make_shared<TextureMap>(*std::atomic_load(&textures_));
+  (*textures)[texture_id] = std::move(texture_proxy);
+  std::atomic_store(&textures_,
+                    std::shared_ptr<const TextureMap>(std::move(textures)));
   return texture_id;
 }
 
 bool TextureRegistrarImpl::MarkTextureFrameAvailable(int64_t texture_id) {
-  auto it = textures_.find(texture_id);
-  if (it != textures_.end()) {
+  std::shared_ptr<const TextureMap> textures = std::atomic_load(&textures_);
+  auto it = textures->find(texture_id);
+  if (it != textures->end()) {
     return fl_texture_registrar_mark_texture_frame_available(
-        texture_registrar_ref_, FL_TEXTURE(it->second));
+        texture_registrar_ref_, FL_TEXTURE(it->second.get()));
   }
   return false;
 }
 
 bool TextureRegistrarImpl::UnregisterTexture(int64_t texture_id) {
-  auto it = textures_.find(texture_id);
-  if (it != textures_.end()) {
-    auto texture = it->second;
-    textures_.erase(it);
-    bool success = fl_texture_registrar_unregister_texture(
-        texture_registrar_ref_, FL_TEXTURE(texture));
-    g_object_unref(texture);
-    return success;
+  std::shared_ptr<FlTextureProxy> texture;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const TextureMap> current = std::atomic_load(&textures_);
+    auto it = current->find(texture_id);
+    if (it == current->end()) {
+      return false;
+    }
+    texture = it->second;
+    auto textures = std::make_shared<TextureMap>(*current);
+    textures->erase(texture_id);
+    std::atomic_store(&textures_,
+                      std::shared_ptr<const TextureMap>(std::move(textures)));
   }
-  return false;
+  return fl_texture_registrar_unregister_texture(texture_registrar_ref_,
+                                                 FL_TEXTURE(texture.get()));
 }
 
 }  // namespace flutter
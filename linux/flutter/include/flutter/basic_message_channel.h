@@ -5,11 +5,11 @@
 #ifndef FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_BASIC_MESSAGE_CHANNEL_H_
 #define FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_BASIC_MESSAGE_CHANNEL_H_
 
-#include <iostream>
 #include <string>
 
 #include "binary_messenger.h"
 #include "message_codec.h"
+#include "logger.h"
 
 namespace flutter {
 
@@ -83,8 +83,8 @@ class BasicMessageChannel {
       std::unique_ptr<T> message =
           codec->DecodeMessage(binary_message, binary_message_size);
       if (!message) {
-        std::cerr << "Unable to decode message on channel " << channel_name
-                  << std::endl;
+        LIVEKIT_LOG_ERROR("Unable to decode message on channel %s",
+                          channel_name.c_str());
         binary_reply(nullptr, 0);
         return;
       }
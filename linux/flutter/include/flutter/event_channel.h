@@ -5,7 +5,6 @@
 #ifndef FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_EVENT_CHANNEL_H_
 #define FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_EVENT_CHANNEL_H_
 
-#include <iostream>
 #include <memory>
 #include <string>
 
@@ -13,6 +12,7 @@
 #include "engine_method_result.h"
 #include "event_sink.h"
 #include "event_stream_handler.h"
+#include "logger.h"
 
 namespace flutter {
 
@@ -72,8 +72,9 @@ class EventChannel {
       std::unique_ptr<MethodCall<T>> method_call =
           codec->DecodeMethodCall(message, message_size);
       if (!method_call) {
-        std::cerr << "Unable to construct method call from message on channel: "
-                  << channel_name << std::endl;
+        LIVEKIT_LOG_ERROR(
+            "Unable to construct method call from message on channel: %s",
+            channel_name.c_str());
         reply(nullptr, 0);
         return;
       }
@@ -84,9 +85,9 @@ class EventChannel {
           std::unique_ptr<StreamHandlerError<T>> error =
               shared_handler->OnCancel(nullptr);
           if (error) {
-            std::cerr << "Failed to cancel existing stream: "
-                      << (error->error_code) << ", " << (error->error_message)
-                      << ", " << (error->error_details);
+            LIVEKIT_LOG_ERROR("Failed to cancel existing stream: %s, %s",
+                              error->error_code.c_str(),
+                              error->error_message.c_str());
           }
         }
         is_listening_ = true;
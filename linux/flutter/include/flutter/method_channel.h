@@ -5,7 +5,6 @@
 #ifndef FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_METHOD_CHANNEL_H_
 #define FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_INCLUDE_FLUTTER_METHOD_CHANNEL_H_
 
-#include <iostream>
 #include <string>
 
 #include "binary_messenger.h"
@@ -13,6 +12,7 @@
 #include "method_call.h"
 #include "method_codec.h"
 #include "method_result.h"
+#include "logger.h"
 
 namespace flutter {
 
@@ -77,9 +77,9 @@ class MethodChannel {
       bool decoded = codec->DecodeAndProcessResponseEnvelope(
           reply, reply_size, shared_result.get());
       if (!decoded) {
-        std::cerr << "Unable to decode reply to method "
-                     "invocation on channel "
-                  << channel_name << std::endl;
+        LIVEKIT_LOG_ERROR(
+            "Unable to decode reply to method invocation on channel %s",
+            channel_name.c_str());
         shared_result->NotImplemented();
       }
     };
@@ -111,8 +111,9 @@ class MethodChannel {
       std::unique_ptr<MethodCall<T>> method_call =
           codec->DecodeMethodCall(message, message_size);
       if (!method_call) {
-        std::cerr << "Unable to construct method call from message on channel "
-                  << channel_name << std::endl;
+        LIVEKIT_LOG_ERROR(
+            "Unable to construct method call from message on channel %s",
+            channel_name.c_str());
         result->NotImplemented();
         return;
       }
@@ -17,7 +17,9 @@ namespace flutter {
 // ===== PluginRegistrar =====
 
 PluginRegistrar::PluginRegistrar(FlPluginRegistrar* registrar)
-    : registrar_(registrar) {
+    : registrar_(FL_PLUGIN_REGISTRAR(g_object_ref(registrar))) {
+  // The registrar holds references to the messenger and texture registrar
+  // wrapped below, so holding it keeps them valid for as long as this does.
   auto core_messenger = fl_plugin_registrar_get_messenger(registrar);
   messenger_ = std::make_unique<BinaryMessengerImpl>(core_messenger);
   auto texture_registrar = fl_plugin_registrar_get_texture_registrar(registrar);
@@ -31,6 +33,8 @@ PluginRegistrar::~PluginRegistrar() {
 
   // Explicitly cleared to facilitate testing of destruction order.
   messenger_.reset();
+  texture_registrar_.reset();
+  g_object_unref(registrar_);
 }
 
 void PluginRegistrar::AddPlugin(std::unique_ptr<Plugin> plugin) {
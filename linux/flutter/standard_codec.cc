@@ -9,7 +9,6 @@
 
 #include <cassert>
 #include <cstring>
-#include <iostream>
 #include <map>
 #include <string>
 #include <vector>
@@ -18,6 +17,7 @@
 #include "include/flutter/standard_codec_serializer.h"
 #include "include/flutter/standard_message_codec.h"
 #include "include/flutter/standard_method_codec.h"
+#include "logger.h"
 
 namespace flutter {
 
@@ -154,9 +154,9 @@ void StandardCodecSerializer::WriteValue(const EncodableValue& value,
       break;
     }
     case 12:
-      std::cerr
-          << "Unhandled custom type in StandardCodecSerializer::WriteValue. "
-          << "Custom types require codec extensions." << std::endl;
+      LIVEKIT_LOG_ERROR(
+          "Unhandled custom type in StandardCodecSerializer::WriteValue. "
+          "Custom types require codec extensions.");
       break;
     case 13: {
       WriteVector(std::get<std::vector<float>>(value), stream);
@@ -221,8 +221,9 @@ EncodableValue StandardCodecSerializer::ReadValueOfType(
       return ReadVector<float>(stream);
     }
   }
-  std::cerr << "Unknown type in StandardCodecSerializer::ReadValueOfType: "
-            << static_cast<int>(type) << std::endl;
+  LIVEKIT_LOG_ERROR(
+      "Unknown type in StandardCodecSerializer::ReadValueOfType: %d",
+      static_cast<int>(type));
   return EncodableValue();
 }
 
@@ -369,8 +370,7 @@ StandardMethodCodec::DecodeMethodCallInternal(const uint8_t* message,
   EncodableValue method_name_value = serializer_->ReadValue(&stream);
   const auto* method_name = std::get_if<std::string>(&method_name_value);
   if (!method_name) {
-    std::cerr << "Invalid method call; method name is not a string."
-              << std::endl;
+    LIVEKIT_LOG_ERROR("Invalid method call; method name is not a string.");
     return nullptr;
   }
   auto arguments =
@@ -5,6 +5,10 @@
 #ifndef FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_TEXTURE_REGISTRAR_IMPL_H_
 #define FLUTTER_SHELL_PLATFORM_COMMON_CLIENT_WRAPPER_TEXTURE_REGISTRAR_IMPL_H_
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include "include/flutter/texture_registrar.h"
 
 struct FlTextureProxy;
@@ -13,6 +17,14 @@ namespace flutter {
 
 // Wrapper around a FlTextureRegistrar that implements the
 // TextureRegistrar API.
+//
+// MarkTextureFrameAvailable() may be called from any thread, so producers
+// can signal frames from the thread that rendered them instead of posting a
+// task to the main loop per frame. It looks textures up in an immutable
+// snapshot of the registered textures, which registering and unregistering
+// replace, so lookups never wait for them. A snapshot holds a reference to
+// each of its textures, keeping one alive while it is being signalled even
+// if it is unregistered meanwhile.
 class TextureRegistrarImpl : public TextureRegistrar {
  public:
   explicit TextureRegistrarImpl(FlTextureRegistrar* texture_registrar_ref);
@@ -32,9 +44,14 @@ class TextureRegistrarImpl : public TextureRegistrar {
   bool UnregisterTexture(int64_t texture_id) override;
 
  private:
+  using TextureMap = std::map<int64_t, std::shared_ptr<FlTextureProxy>>;
+
   // Handle for interacting with the C API.
   FlTextureRegistrar* texture_registrar_ref_;
-  std::map<int64_t, FlTextureProxy*> textures_;
+  // Serializes registering and unregistering.
+  std::mutex mutex_;
+  // Read and replaced with std::atomic_load() and std::atomic_store().
+  std::shared_ptr<const TextureMap> textures_;
 };
 
 }  // namespace flutter
@@ -19,6 +19,44 @@ typedef struct {
 FLUTTER_PLUGIN_EXPORT void live_kit_plugin_register_with_registrar(
     FlPluginRegistrar* registrar);
 
+// Reads the latest bands of |visualizer_count| visualizers without blocking
+// the audio threads, for Dart FFI callers polling once per frame.
+//
+// |visualizer_ids| holds the NUL terminated visualizer ids back to back. The
+// bands of visualizer i are written to |bands| + i * |bands_per_visualizer|,
+// their number to |band_counts|[i] (-1 when no such visualizer is running)
+// and the number of updates published so far to |versions|[i]; an unchanged
+// version means unchanged bands. Returns the number of visualizers found.
+FLUTTER_PLUGIN_EXPORT int32_t livekit_get_latest_bands(
+    const char* visualizer_ids, int32_t visualizer_count, float* bands,
+    int32_t bands_per_visualizer, int32_t* band_counts, uint64_t* versions);
+
+// Streaming zlib (RFC 1950) compression for data stream payloads, on caller
+// provided buffers so that Dart can pass typed data to leaf FFI calls.
+//
+// livekit_zlib_stream_new() creates a compressor when |compress| is
+// non-zero, at zlib |level| (0-9, -1 for the default), or a decompressor,
+// and returns NULL on failure. livekit_zlib_stream_process() consumes up to
+// |input_size| bytes, stores how many in |input_consumed| and returns the
+// number of bytes written to |output|, or -1 on corrupt input. |flush| is 0
+// to buffer, 1 to make everything consumed so far decodable (end of a
+// chunk) or 2 to finish the stream; it is ignored when decompressing. While
+// the result equals |output_capacity| more output may be pending, so call
+// again with the rest of the input, or none, and the same |flush|. Use an
+// output capacity of the data stream chunk size to get ready to send
+// chunks.
+typedef struct LiveKitZlibStream LiveKitZlibStream;
+
+FLUTTER_PLUGIN_EXPORT LiveKitZlibStream* livekit_zlib_stream_new(
+    int32_t compress, int32_t level);
+
+FLUTTER_PLUGIN_EXPORT int32_t livekit_zlib_stream_process(
+    LiveKitZlibStream* stream, const uint8_t* input, int32_t input_size,
+    int32_t* input_consumed, uint8_t* output, int32_t output_capacity,
+    int32_t flush);
+
+FLUTTER_PLUGIN_EXPORT void livekit_zlib_stream_free(LiveKitZlibStream* stream);
+
 G_END_DECLS
 
 #endif  // FLUTTER_PLUGIN_LIVEKIT_PLUGIN_H_
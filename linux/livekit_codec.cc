@@ -0,0 +1,127 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "livekit_codec.h"
+
+#include "logger.h"
+
+namespace livekit_client_plugin {
+
+// static
+const LiveKitCodecSerializer& LiveKitCodecSerializer::GetInstance() {
+  static const LiveKitCodecSerializer* instance = [] {
+    auto* serializer = new LiveKitCodecSerializer();
+    serializer->Register(std::make_unique<FixedLayoutExtension<BandFrame>>());
+    return serializer;
+  }();
+  return *instance;
+}
+
+LiveKitCodecSerializer::LiveKitCodecSerializer() = default;
+
+LiveKitCodecSerializer::~LiveKitCodecSerializer() = default;
+
+void LiveKitCodecSerializer::Register(
+    std::unique_ptr<StandardCodecExtension> extension) {
+  uint8_t type = extension->type();
+  if (type < StandardCodecExtension::kMinType ||
+      extensions_by_type_[type - StandardCodecExtension::kMinType]) {
+    LIVEKIT_LOG_ERROR(
+        "Ignoring codec extension with reserved or duplicate type %d",
+        static_cast<int>(type));
+    return;
+  }
+  extensions_by_type_[type - StandardCodecExtension::kMinType] =
+      extension.get();
+  extensions_.push_back(std::move(extension));
+}
+
+void LiveKitCodecSerializer::WriteValue(
+    const flutter::EncodableValue& value,
+    flutter::ByteStreamWriter* stream) const {
+  if (const auto* custom =
+          std::get_if<flutter::CustomEncodableValue>(&value)) {
+    for (const auto& extension : extensions_) {
+      if (extension->WriteValue(*custom, *this, stream)) {
+        return;
+      }
+    }
+  }
+  flutter::StandardCodecSerializer::WriteValue(value, stream);
+}
+
+flutter::EncodableValue LiveKitCodecSerializer::ReadValueOfType(
+    uint8_t type,
+    flutter::ByteStreamReader* stream) const {
+  if (type >= StandardCodecExtension::kMinType) {
+    const StandardCodecExtension* extension =
+        extensions_by_type_[type - StandardCodecExtension::kMinType];
+    if (extension) {
+      return extension->ReadValue(*this, stream);
+    }
+  }
+  return flutter::StandardCodecSerializer::ReadValueOfType(type, stream);
+}
+
+const flutter::StandardMethodCodec& LiveKitMethodCodec() {
+  return flutter::StandardMethodCodec::GetInstance(
+      &LiveKitCodecSerializer::GetInstance());
+}
+
+void BandFrame::Write(const LiveKitCodecSerializer& serializer,
+                      flutter::ByteStreamWriter* stream) const {
+  serializer.WriteSize(bands.size(), stream);
+  stream->WriteInt64(timestamp_us);
+  stream->WriteInt32(static_cast<int32_t>(sequence));
+  stream->WriteInt32(sample_rate);
+  stream->WriteAlignment(4);
+  // The writer asserts on empty writes.
+  if (!bands.empty()) {
+    stream->WriteBytes(reinterpret_cast<const uint8_t*>(bands.data()),
+                       bands.size() * sizeof(float));
+  }
+  serializer.WriteSize(peaks.size(), stream);
+  // Aligned even when empty, as the Dart side always reads it aligned.
+  stream->WriteAlignment(4);
+  if (!peaks.empty()) {
+    stream->WriteBytes(reinterpret_cast<const uint8_t*>(peaks.data()),
+                       peaks.size() * sizeof(float));
+  }
+}
+
+// static
+BandFrame BandFrame::Read(const LiveKitCodecSerializer& serializer,
+                          flutter::ByteStreamReader* stream) {
+  BandFrame frame;
+  frame.bands.resize(serializer.ReadSize(stream));
+  frame.timestamp_us = stream->ReadInt64();
+  frame.sequence = static_cast<uint32_t>(stream->ReadInt32());
+  frame.sample_rate = stream->ReadInt32();
+  stream->ReadAlignment(4);
+  // An empty vector has no buffer to copy into.
+  if (!frame.bands.empty()) {
+    stream->ReadBytes(reinterpret_cast<uint8_t*>(frame.bands.data()),
+                      frame.bands.size() * sizeof(float));
+  }
+  frame.peaks.resize(serializer.ReadSize(stream));
+  stream->ReadAlignment(4);
+  if (!frame.peaks.empty()) {
+    stream->ReadBytes(reinterpret_cast<uint8_t*>(frame.peaks.data()),
+                      frame.peaks.size() * sizeof(float));
+  }
+  return frame;
+}
+
+}  // namespace livekit_client_plugin
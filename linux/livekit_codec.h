@@ -0,0 +1,148 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef LIVEKIT_CLIENT_LINUX_LIVEKIT_CODEC_H_
+#define LIVEKIT_CLIENT_LINUX_LIVEKIT_CODEC_H_
+
+#include <flutter/encodable_value.h>
+#include <flutter/standard_codec_serializer.h>
+#include <flutter/standard_method_codec.h>
+
+#include <any>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace livekit_client_plugin {
+
+class LiveKitCodecSerializer;
+
+// Encodes one custom type of the LiveKit codec as its type byte followed by
+// a binary layout of its own, so typed records cost about as much as typed
+// lists instead of a map keyed by strings. Must match a CodecExtension of
+// the same type in lib/src/support/codec.dart.
+class StandardCodecExtension {
+ public:
+  // Types 0 to 127 are reserved for the standard codec.
+  static constexpr uint8_t kMinType = 128;
+
+  virtual ~StandardCodecExtension() = default;
+
+  virtual uint8_t type() const = 0;
+
+  // Writes the type byte and the payload of |value| and returns true, or
+  // returns false if |value| is not of this extension's type.
+  virtual bool WriteValue(const flutter::CustomEncodableValue& value,
+                          const LiveKitCodecSerializer& serializer,
+                          flutter::ByteStreamWriter* stream) const = 0;
+
+  // Reads a payload whose type byte was already read.
+  virtual flutter::EncodableValue ReadValue(
+      const LiveKitCodecSerializer& serializer,
+      flutter::ByteStreamReader* stream) const = 0;
+};
+
+// Extension for a record type T sent as CustomEncodableValue(T). T provides
+//   static constexpr uint8_t kType;
+//   void Write(const LiveKitCodecSerializer&, flutter::ByteStreamWriter*) const;
+//   static T Read(const LiveKitCodecSerializer&, flutter::ByteStreamReader*);
+template <typename T>
+class FixedLayoutExtension : public StandardCodecExtension {
+ public:
+  static_assert(T::kType >= kMinType, "type is reserved");
+
+  uint8_t type() const override { return T::kType; }
+
+  bool WriteValue(const flutter::CustomEncodableValue& value,
+                  const LiveKitCodecSerializer& serializer,
+                  flutter::ByteStreamWriter* stream) const override {
+    const T* record = std::any_cast<T>(&static_cast<const std::any&>(value));
+    if (!record) {
+      return false;
+    }
+    stream->WriteByte(T::kType);
+    record->Write(serializer, stream);
+    return true;
+  }
+
+  flutter::EncodableValue ReadValue(
+      const LiveKitCodecSerializer& serializer,
+      flutter::ByteStreamReader* stream) const override {
+    return flutter::CustomEncodableValue(T::Read(serializer, stream));
+  }
+};
+
+// StandardCodecSerializer with registered extensions for custom values.
+// Values without an extension are encoded as by the standard codec.
+class LiveKitCodecSerializer : public flutter::StandardCodecSerializer {
+ public:
+  // Shared instance with every LiveKit record type registered.
+  static const LiveKitCodecSerializer& GetInstance();
+
+  LiveKitCodecSerializer();
+  ~LiveKitCodecSerializer() override;
+
+  // Not thread safe; register all extensions before first use.
+  void Register(std::unique_ptr<StandardCodecExtension> extension);
+
+  void WriteValue(const flutter::EncodableValue& value,
+                  flutter::ByteStreamWriter* stream) const override;
+
+  // For extensions encoding variable length payloads.
+  using flutter::StandardCodecSerializer::ReadSize;
+  using flutter::StandardCodecSerializer::WriteSize;
+
+ protected:
+  flutter::EncodableValue ReadValueOfType(
+      uint8_t type,
+      flutter::ByteStreamReader* stream) const override;
+
+ private:
+  std::vector<std::unique_ptr<StandardCodecExtension>> extensions_;
+  // Indexed by type - kMinType.
+  std::array<const StandardCodecExtension*, 128> extensions_by_type_{};
+};
+
+// Method codec of all LiveKit event channels.
+const flutter::StandardMethodCodec& LiveKitMethodCodec();
+
+// Visualizer bands with the metadata needed to order and time them. Layout:
+//   size     band count, in the standard codec's size encoding
+//   int64    timestamp in microseconds of a monotonic clock
+//   uint32   sequence number, counting from 0 per visualizer
+//   int32    sample rate of the analysed audio
+//   float32  bands, aligned to 4 bytes
+//   size     peak count, 0 unless the visualizer has an envelope
+//   float32  peaks, aligned to 4 bytes
+struct BandFrame {
+  static constexpr uint8_t kType = 128;
+
+  int64_t timestamp_us = 0;
+  uint32_t sequence = 0;
+  int32_t sample_rate = 0;
+  std::vector<float> bands;
+  // Peak hold values of the bands, when smoothed by a BandEnvelope.
+  std::vector<float> peaks;
+
+  void Write(const LiveKitCodecSerializer& serializer,
+             flutter::ByteStreamWriter* stream) const;
+  static BandFrame Read(const LiveKitCodecSerializer& serializer,
+                        flutter::ByteStreamReader* stream);
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_LIVEKIT_CODEC_H_
@@ -27,15 +27,40 @@
 #include <flutter_webrtc/flutter_web_r_t_c_plugin.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
 #include <sstream>
 
+#include "audio_replay_buffer.h"
+#include "audio_source_stats.h"
 #include "audio_visualizer.h"
+#include "band_envelope.h"
+#include "echo_leak_detector.h"
+#include "latest_bands.h"
+#include "pcm_jitter_buffer.h"
+#include "sliding_dft.h"
+#include "talk_stats.h"
+#include "utterance_segmenter.h"
+#include "video_quality_analyzer.h"
+#include "wav_playback.h"
+#include "yuv_scaler.h"
 
-#include "task_runner_linux.h"
+#include "analysis_service.h"
+#include "audio_frame_clock.h"
+#include "audio_replay_writer.h"
+#include "event_channel_proxy.h"
+#include "livekit_codec.h"
+#include "pcm_injection_source.h"
+#include "thread_safe_binary_messenger.h"
+#include "visualizer_sink.h"
+#include "wav_file_source.h"
+#include "zlib_stream.h"
 
 namespace livekit_client_plugin {
 
@@ -60,110 +85,684 @@ std::vector<float> centerBands(const std::vector<float> &sortedBands) {
   return centeredBands;
 }
 
-class VisualizerSink : public libwebrtc::AudioTrackSink {
+// Feeds the audio callbacks of a track to a SharedVisualizer, which does not
+// depend on libwebrtc, for as long as it exists.
+class AudioTrackConnection : public AudioSourceConnection,
+                             public libwebrtc::AudioTrackSink {
 public:
-  VisualizerSink(BinaryMessenger *messenger, std::string event_channel_name,
-                 libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
-                 bool is_centered = false, int bar_count = 7)
-      : channel_(
-            std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
-                messenger, event_channel_name,
-                &flutter::StandardMethodCodec::GetInstance())),
-        media_track_(media_track), is_centered_(is_centered),
-        bar_count_(bar_count) {
-    task_runner_ = std::make_unique<livekit_client_plugin::TaskRunnerLinux>();
-    auto handler = std::make_unique<
-        flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
-        [&](const flutter::EncodableValue *arguments,
-            std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>
-                &&events)
-            -> std::unique_ptr<
-                flutter::StreamHandlerError<flutter::EncodableValue>> {
-          sink_ = std::move(events);
-          std::weak_ptr<flutter::EventSink<flutter::EncodableValue>> weak_sink =
-              sink_;
-          for (auto &event : event_queue_) {
-            PostEvent(event);
-          }
-          event_queue_.clear();
-          on_listen_called_ = true;
-          return nullptr;
-        },
-        [&](const flutter::EncodableValue *arguments)
-            -> std::unique_ptr<
-                flutter::StreamHandlerError<flutter::EncodableValue>> {
-          on_listen_called_ = false;
-          return nullptr;
-        });
-
-    channel_->SetStreamHandler(std::move(handler));
-    audio_visualizer_ =
-        std::make_unique<AudioVisualizer>(bar_count_, is_centered_);
+  AudioTrackConnection(
+      libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+      SharedVisualizer *visualizer)
+      : media_track_(media_track), visualizer_(visualizer) {
     ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
   }
-  ~VisualizerSink() override {}
 
+  ~AudioTrackConnection() override {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
+  }
+
+  void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+              size_t number_of_channels, size_t number_of_frames) override {
+    visualizer_->OnData(audio_data, bits_per_sample, sample_rate,
+                        number_of_channels, number_of_frames);
+  }
+
+private:
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  SharedVisualizer *visualizer_;
+};
+
+// Reports the level of a few fixed frequencies using a sliding DFT bank, a
+// cheap alternative to VisualizerSink when only K frequencies matter.
+class FrequencyMonitorSink : public libwebrtc::AudioTrackSink {
 public:
+  static constexpr int kDefaultWindowMs = 100;
+  static constexpr int kDefaultIntervalMs = 50;
+
+  FrequencyMonitorSink(
+      ThreadSafeBinaryMessenger *messenger, std::string event_channel_name,
+      libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+      std::vector<float> frequencies, int window_ms = kDefaultWindowMs,
+      int interval_ms = kDefaultIntervalMs)
+      : events_(messenger, event_channel_name), media_track_(media_track),
+        frequencies_(std::move(frequencies)), window_ms_(window_ms),
+        interval_ms_(interval_ms) {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
+  }
+  ~FrequencyMonitorSink() override {}
+
   void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
               size_t number_of_channels, size_t number_of_frames) override {
-    if (!on_listen_called_) {
+    if (!events_.IsListening() || bits_per_sample != 16 || sample_rate <= 0) {
       return;
     }
-    std::vector<float> bands;
-    if (audio_visualizer_->Process((const int16_t *)audio_data,
-                                   (unsigned int)number_of_frames,
-                                   float(sample_rate), bands)) {
-      // Post the processed data to the event sink
-      EncodableList bands_list = EncodableList(bands.begin(), bands.end());
-      Success(EncodableValue(bands_list));
+    // The bank is sized for one sample rate; rebuild it if the track's rate
+    // changes, which only happens when the audio device is reconfigured.
+    if (!bank_ || bank_->sample_rate() != float(sample_rate)) {
+      unsigned window_size =
+          std::max(1, int(int64_t(sample_rate) * window_ms_ / 1000));
+      bank_ = std::make_unique<SlidingDFTBank>(frequencies_,
+                                               float(sample_rate), window_size);
+      frames_per_event_ = std::max<size_t>(
+          1, size_t(int64_t(sample_rate) * interval_ms_ / 1000));
+      pending_frames_ = 0;
+    }
+
+    // Analyse the first channel of interleaved input.
+    bank_->Process((const int16_t *)audio_data, number_of_frames,
+                   std::max<size_t>(number_of_channels, 1));
+    pending_frames_ += number_of_frames;
+    if (pending_frames_ >= frames_per_event_) {
+      pending_frames_ = 0;
+      std::vector<float> levels(bank_->size());
+      bank_->GetDecibels(levels.data());
+      events_.Success(EncodableValue(levels), false);
+    }
+  }
+
+  void RemoveSink() {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
+  }
+
+private:
+  EventChannelProxy events_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  std::vector<float> frequencies_;
+  int window_ms_;
+  int interval_ms_;
+  std::unique_ptr<SlidingDFTBank> bank_;
+  size_t frames_per_event_ = 0;
+  size_t pending_frames_ = 0;
+};
+
+// Sends each utterance spoken on an audio track as a single event, mono at
+// UtteranceSegmenter::kSampleRate, for on-device transcription. Samples are
+// sent as a Float32List, or as little endian 16-bit PCM in a Uint8List for
+// transcribers that take raw PCM.
+class UtteranceSink : public libwebrtc::AudioTrackSink {
+public:
+  UtteranceSink(ThreadSafeBinaryMessenger *messenger,
+                std::string event_channel_name,
+                libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+                const UtteranceSegmenter::Options &options, bool int16)
+      : events_(messenger, event_channel_name), media_track_(media_track),
+        int16_(int16),
+        segmenter_(options, [this](const float *samples, size_t size,
+                                   double start_seconds) {
+          Send(samples, size, start_seconds);
+        }) {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
+  }
+  ~UtteranceSink() override {}
+
+  void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+              size_t number_of_channels, size_t number_of_frames) override {
+    if (!events_.IsListening() || bits_per_sample != 16) {
+      return;
     }
+    segmenter_.Process((const int16_t *)audio_data, number_of_frames,
+                       sample_rate, number_of_channels);
+  }
+
+  void RemoveSink() {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
   }
 
-  void Success(const flutter::EncodableValue &event, bool cache_event = true) {
-    if (on_listen_called_) {
-      PostEvent(event);
+private:
+  void Send(const float *samples, size_t size, double start_seconds) {
+    EncodableMap map;
+    map[EncodableValue("start")] = EncodableValue(start_seconds);
+    map[EncodableValue("sampleRate")] =
+        EncodableValue(UtteranceSegmenter::kSampleRate);
+    if (int16_) {
+      std::vector<uint8_t> bytes(size * sizeof(int16_t));
+      FloatToS16(samples, size, reinterpret_cast<int16_t *>(bytes.data()));
+      map[EncodableValue("samples")] = EncodableValue(std::move(bytes));
     } else {
-      if (cache_event) {
-        event_queue_.push_back(event);
+      map[EncodableValue("samples")] =
+          EncodableValue(std::vector<float>(samples, samples + size));
+    }
+    events_.Success(EncodableValue(map), false);
+  }
+
+  EventChannelProxy events_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  const bool int16_;
+  UtteranceSegmenter segmenter_;
+};
+
+// Reports brightness, contrast, blur and frozen frames of a video track a few
+// times per second, analysing subsampled luma natively so that no frames are
+// copied to Dart.
+class VideoQualitySink
+    : public libwebrtc::RTCVideoRenderer<
+          libwebrtc::scoped_refptr<libwebrtc::RTCVideoFrame>> {
+public:
+  static constexpr int kDefaultAnalysisIntervalMs = 250;
+  static constexpr int kDefaultReportIntervalMs = 1000;
+
+  VideoQualitySink(
+      ThreadSafeBinaryMessenger *messenger, std::string event_channel_name,
+      libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+      int analysis_interval_ms = kDefaultAnalysisIntervalMs,
+      int report_interval_ms = kDefaultReportIntervalMs)
+      : events_(messenger, event_channel_name), media_track_(media_track),
+        analyzer_(analysis_interval_ms / 1000.0, report_interval_ms / 1000.0) {
+    ((libwebrtc::RTCVideoTrack *)media_track_.get())->AddRenderer(this);
+  }
+  ~VideoQualitySink() override {}
+
+  void OnFrame(
+      libwebrtc::scoped_refptr<libwebrtc::RTCVideoFrame> frame) override {
+    if (!events_.IsListening() || !frame) {
+      return;
+    }
+    double now = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+    VideoQualityAnalyzer::Report report;
+    if (!analyzer_.Process(frame->DataY(), frame->width(), frame->height(),
+                           frame->StrideY(), now, &report)) {
+      return;
+    }
+    EncodableMap map;
+    map[EncodableValue("width")] = EncodableValue(report.width);
+    map[EncodableValue("height")] = EncodableValue(report.height);
+    map[EncodableValue("frameRate")] = EncodableValue(report.frame_rate);
+    map[EncodableValue("meanLuma")] = EncodableValue(report.mean_luma);
+    map[EncodableValue("contrast")] = EncodableValue(report.contrast);
+    map[EncodableValue("blurScore")] = EncodableValue(report.blur_score);
+    map[EncodableValue("frameDifference")] =
+        EncodableValue(report.frame_difference);
+    map[EncodableValue("frozen")] = EncodableValue(report.frozen);
+    map[EncodableValue("histogram")] = EncodableValue(std::vector<float>(
+        report.histogram.begin(), report.histogram.end()));
+    events_.Success(EncodableValue(map), false);
+  }
+
+  void RemoveSink() {
+    ((libwebrtc::RTCVideoTrack *)media_track_.get())->RemoveRenderer(this);
+  }
+
+private:
+  EventChannelProxy events_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  VideoQualityAnalyzer analyzer_;
+};
+
+// Renders a downscaled RGBA copy of a video track into a Flutter texture,
+// for participant tiles and previews that would otherwise decode full frames
+// into much smaller widgets. Frames are converted and scaled in one pass at
+// most |max_fps| times per second into a pair of buffers: the engine reads
+// the front one while the next frame is written to the back one. Rotation
+// is not applied.
+class ThumbnailSink
+    : public libwebrtc::RTCVideoRenderer<
+          libwebrtc::scoped_refptr<libwebrtc::RTCVideoFrame>> {
+public:
+  static constexpr int kDefaultMaxFps = 15;
+
+  ThumbnailSink(flutter::TextureRegistrar *texture_registrar,
+                libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+                int width, int height, int max_fps = kDefaultMaxFps)
+      : texture_registrar_(texture_registrar), media_track_(media_track),
+        scaler_(width, height),
+        min_frame_interval_(max_fps > 0 ? 1.0 / max_fps : 0),
+        texture_(flutter::PixelBufferTexture(
+            [this](size_t, size_t) { return CopyPixelBuffer(); })) {
+    const size_t stride = size_t(scaler_.destination_width()) * 4;
+    for (int i = 0; i < 2; ++i) {
+      pixels_[i].assign(stride * scaler_.destination_height(), 0);
+      pixel_buffers_[i].buffer = pixels_[i].data();
+      pixel_buffers_[i].width = scaler_.destination_width();
+      pixel_buffers_[i].height = scaler_.destination_height();
+      pixel_buffers_[i].release_callback = nullptr;
+      pixel_buffers_[i].release_context = nullptr;
+    }
+    texture_id_ = texture_registrar_->RegisterTexture(&texture_);
+    ((libwebrtc::RTCVideoTrack *)media_track_.get())->AddRenderer(this);
+  }
+  ~ThumbnailSink() override {}
+
+  int64_t texture_id() const { return texture_id_; }
+
+  void OnFrame(
+      libwebrtc::scoped_refptr<libwebrtc::RTCVideoFrame> frame) override {
+    if (!frame) {
+      return;
+    }
+    double now = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+    if (now - last_frame_time_ < min_frame_interval_) {
+      return;
+    }
+    int back;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      back = 1 - front_;
+      // The engine may still be uploading the buffer it got last; wait for
+      // it to pick up the front one first.
+      if (back == handed_out_) {
+        return;
       }
     }
+    last_frame_time_ = now;
+    scaler_.Convert(frame->DataY(), frame->StrideY(), frame->DataU(),
+                    frame->StrideU(), frame->DataV(), frame->StrideV(),
+                    frame->width(), frame->height(), pixels_[back].data(),
+                    scaler_.destination_width() * 4);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      front_ = back;
+    }
+    texture_registrar_->MarkTextureFrameAvailable(texture_id_);
   }
 
-  void PostEvent(const flutter::EncodableValue &event) {
-    if (task_runner_) {
-      std::weak_ptr<flutter::EventSink<EncodableValue>> weak_sink = sink_;
-      task_runner_->EnqueueTask([weak_sink, event]() {
-        auto sink = weak_sink.lock();
-        if (sink) {
-          sink->Success(event);
-        }
-      });
-    } else {
-      sink_->Success(event);
+  void RemoveSink() {
+    ((libwebrtc::RTCVideoTrack *)media_track_.get())->RemoveRenderer(this);
+    texture_registrar_->UnregisterTexture(texture_id_);
+  }
+
+private:
+  // Called on the raster thread. The returned buffer is read after this
+  // returns, so it is not written again until the next call.
+  const FlutterDesktopPixelBuffer *CopyPixelBuffer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handed_out_ = front_;
+    return &pixel_buffers_[front_];
+  }
+
+  flutter::TextureRegistrar *texture_registrar_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  I420ToRGBAScaler scaler_;
+  double min_frame_interval_ = 0;
+  double last_frame_time_ = 0;
+  std::mutex mutex_;
+  std::vector<uint8_t> pixels_[2];
+  FlutterDesktopPixelBuffer pixel_buffers_[2];
+  int front_ = 0;
+  int handed_out_ = -1;
+  flutter::TextureVariant texture_;
+  int64_t texture_id_ = -1;
+};
+
+// Keeps the last seconds of an audio track in an AudioReplayBuffer, so they
+// can be saved after the fact.
+class ReplayBufferSink : public libwebrtc::AudioTrackSink {
+public:
+  ReplayBufferSink(
+      libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track,
+      double seconds)
+      : media_track_(media_track),
+        buffer_(std::make_shared<AudioReplayBuffer>(seconds)) {
+    ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
+  }
+  ~ReplayBufferSink() override {}
+
+  void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+              size_t number_of_channels, size_t number_of_frames) override {
+    if (bits_per_sample != 16) {
+      return;
     }
+    buffer_->Write((const int16_t *)audio_data, number_of_frames, sample_rate,
+                   number_of_channels);
   }
 
   void RemoveSink() {
     ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
   }
 
+  // Shared with saves in progress, which may outlive the sink.
+  std::shared_ptr<const AudioReplayBuffer> buffer() const { return buffer_; }
+
 private:
-  std::unique_ptr<AudioVisualizer> audio_visualizer_;
-  std::unique_ptr<livekit_client_plugin::TaskRunnerLinux> task_runner_;
-  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> channel_;
-  std::shared_ptr<flutter::EventSink<flutter::EncodableValue>> sink_;
-  std::list<flutter::EncodableValue> event_queue_;
-  bool on_listen_called_ = false;
   libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
-  bool is_centered_ = false;
-  int bar_count_ = 7;
+  std::shared_ptr<AudioReplayBuffer> buffer_;
+};
+
+// Watches a local capture track for audio of remote tracks leaking from the
+// speakers into the microphone and emits an event whenever echo starts or
+// stops being detected. Audio never leaves the process.
+class EchoDetectorSink : public libwebrtc::AudioTrackSink {
+public:
+  EchoDetectorSink(
+      ThreadSafeBinaryMessenger *messenger, std::string event_channel_name,
+      libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> capture_track,
+      std::vector<libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack>>
+          reference_tracks,
+      std::vector<std::string> reference_track_ids, float coherence_threshold)
+      : events_(messenger, event_channel_name), capture_track_(capture_track),
+        reference_track_ids_(std::move(reference_track_ids)),
+        detector_(reference_tracks.size(), coherence_threshold) {
+    for (size_t i = 0; i < reference_tracks.size(); ++i) {
+      reference_sinks_.push_back(
+          std::make_unique<ReferenceSink>(this, i, reference_tracks[i]));
+    }
+    ((libwebrtc::RTCAudioTrack *)capture_track_.get())->AddSink(this);
+  }
+  ~EchoDetectorSink() override {}
+
+  void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+              size_t number_of_channels, size_t number_of_frames) override {
+    if (!events_.IsListening() || bits_per_sample != 16) {
+      return;
+    }
+    EchoLeakDetector::Alert alert;
+    if (detector_.ProcessCapture((const int16_t *)audio_data,
+                                 number_of_frames, sample_rate,
+                                 number_of_channels, &alert)) {
+      EncodableMap event;
+      event[EncodableValue("echoDetected")] =
+          EncodableValue(alert.echo_detected);
+      event[EncodableValue("remoteTrackId")] =
+          EncodableValue(reference_track_ids_[alert.reference_index]);
+      event[EncodableValue("delayMs")] = EncodableValue(double(alert.delay_ms));
+      event[EncodableValue("couplingDb")] =
+          EncodableValue(double(alert.coupling_db));
+      event[EncodableValue("coherence")] =
+          EncodableValue(double(alert.coherence));
+      events_.Success(EncodableValue(event));
+    }
+  }
+
+  void RemoveSink() {
+    ((libwebrtc::RTCAudioTrack *)capture_track_.get())->RemoveSink(this);
+    for (auto &reference_sink : reference_sinks_) {
+      reference_sink->RemoveSink();
+    }
+  }
+
+private:
+  class ReferenceSink : public libwebrtc::AudioTrackSink {
+  public:
+    ReferenceSink(EchoDetectorSink *owner, size_t index,
+                  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> track)
+        : owner_(owner), index_(index), track_(track) {
+      ((libwebrtc::RTCAudioTrack *)track_.get())->AddSink(this);
+    }
+
+    void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+                size_t number_of_channels, size_t number_of_frames) override {
+      if (bits_per_sample != 16) {
+        return;
+      }
+      owner_->detector_.ProcessReference(index_, (const int16_t *)audio_data,
+                                         number_of_frames, sample_rate,
+                                         number_of_channels);
+    }
+
+    void RemoveSink() {
+      ((libwebrtc::RTCAudioTrack *)track_.get())->RemoveSink(this);
+    }
+
+  private:
+    EchoDetectorSink *owner_;
+    size_t index_;
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> track_;
+  };
+
+  EventChannelProxy events_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> capture_track_;
+  std::vector<std::string> reference_track_ids_;
+  EchoLeakDetector detector_;
+  std::vector<std::unique_ptr<ReferenceSink>> reference_sinks_;
+};
+
+// Talk time accounting for a group of tracks. Each track gets a sink that
+// feeds the shared tracker; nothing is sent to Dart until GetStats().
+class TalkStatsSession {
+public:
+  ~TalkStatsSession() { RemoveSinks(); }
+
+  void
+  AddTrack(const std::string &track_id,
+           libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track) {
+    if (sinks_.count(track_id)) {
+      return;
+    }
+    sinks_[track_id] = std::make_unique<Sink>(
+        &tracker_, tracker_.AddTrack(track_id), media_track);
+  }
+
+  void RemoveTrack(const std::string &track_id) {
+    auto it = sinks_.find(track_id);
+    if (it == sinks_.end()) {
+      return;
+    }
+    it->second->RemoveSink();
+    sinks_.erase(it);
+    tracker_.RemoveTrack(track_id);
+  }
+
+  bool empty() const { return sinks_.empty(); }
+
+  EncodableMap GetStats() const {
+    EncodableMap result;
+    for (const auto &entry : tracker_.GetStats()) {
+      const TalkStatsTracker::Stats &stats = entry.second;
+      EncodableMap map;
+      map[EncodableValue("totalTime")] = EncodableValue(stats.total_seconds);
+      map[EncodableValue("voicedTime")] = EncodableValue(stats.voiced_seconds);
+      map[EncodableValue("overlapTime")] =
+          EncodableValue(stats.overlap_seconds);
+      map[EncodableValue("energy")] = EncodableValue(stats.energy);
+      map[EncodableValue("talkSpurts")] =
+          EncodableValue(int32_t(stats.talk_spurts));
+      map[EncodableValue("interruptions")] =
+          EncodableValue(int32_t(stats.interruptions));
+      map[EncodableValue("speaking")] = EncodableValue(stats.voiced);
+      result[EncodableValue(entry.first)] = EncodableValue(map);
+    }
+    return result;
+  }
+
+  void RemoveSinks() {
+    for (auto &entry : sinks_) {
+      entry.second->RemoveSink();
+    }
+    sinks_.clear();
+  }
+
+private:
+  class Sink : public libwebrtc::AudioTrackSink {
+  public:
+    Sink(TalkStatsTracker *tracker, TalkStatsTracker::Track *track,
+         libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track)
+        : tracker_(tracker), track_(track), media_track_(media_track) {
+      ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
+    }
+
+    void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+                size_t number_of_channels, size_t number_of_frames) override {
+      if (bits_per_sample != 16) {
+        return;
+      }
+      double now = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+      tracker_->Process(track_, (const int16_t *)audio_data, number_of_frames,
+                        sample_rate, number_of_channels, now);
+    }
+
+    void RemoveSink() {
+      ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
+    }
+
+  private:
+    TalkStatsTracker *tracker_;
+    TalkStatsTracker::Track *track_;
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  };
+
+  TalkStatsTracker tracker_;
+  std::map<std::string, std::unique_ptr<Sink>> sinks_;
+};
+
+// Native RTCAudioSourceStats counters for a group of tracks, read in one
+// call without going through getStats().
+class AudioSourceStatsSession {
+public:
+  ~AudioSourceStatsSession() { RemoveSinks(); }
+
+  void
+  AddTrack(const std::string &track_id,
+           libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track) {
+    auto &sink = sinks_[track_id];
+    if (!sink) {
+      sink = std::make_unique<Sink>(media_track);
+    }
+  }
+
+  void RemoveTrack(const std::string &track_id) {
+    auto it = sinks_.find(track_id);
+    if (it != sinks_.end()) {
+      it->second->RemoveSink();
+      sinks_.erase(it);
+    }
+  }
+
+  bool empty() const { return sinks_.empty(); }
+
+  // Appends audioLevel, totalAudioEnergy and totalSamplesDuration of
+  // |track_id| to |values|, or NaNs if it is not tracked.
+  void AppendStats(const std::string &track_id,
+                   std::vector<double> &values) const {
+    auto it = sinks_.find(track_id);
+    if (it == sinks_.end()) {
+      values.insert(values.end(), 3, std::nan(""));
+      return;
+    }
+    AudioSourceStatsAccumulator::Snapshot snapshot =
+        it->second->accumulator.GetSnapshot();
+    values.push_back(snapshot.audio_level);
+    values.push_back(snapshot.total_audio_energy);
+    values.push_back(snapshot.total_duration);
+  }
+
+  void RemoveSinks() {
+    for (auto &entry : sinks_) {
+      entry.second->RemoveSink();
+    }
+    sinks_.clear();
+  }
+
+private:
+  class Sink : public libwebrtc::AudioTrackSink {
+  public:
+    explicit Sink(
+        libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track)
+        : media_track_(media_track) {
+      ((libwebrtc::RTCAudioTrack *)media_track_.get())->AddSink(this);
+    }
+
+    void OnData(const void *audio_data, int bits_per_sample, int sample_rate,
+                size_t number_of_channels, size_t number_of_frames) override {
+      if (bits_per_sample != 16) {
+        return;
+      }
+      accumulator.Process((const int16_t *)audio_data, number_of_frames,
+                          sample_rate, number_of_channels);
+    }
+
+    void RemoveSink() {
+      ((libwebrtc::RTCAudioTrack *)media_track_.get())->RemoveSink(this);
+    }
+
+    AudioSourceStatsAccumulator accumulator;
+
+  private:
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track_;
+  };
+
+  std::map<std::string, std::unique_ptr<Sink>> sinks_;
+};
+
+// A local audio track whose frames are produced natively, registered with
+// flutter_webrtc like a microphone track so that it can be published and
+// looked up by its id.
+class CustomAudioTrack {
+public:
+  // Returns null if the peer connection factory is not initialized.
+  static std::unique_ptr<CustomAudioTrack>
+  Create(flutter_webrtc_plugin::FlutterWebRTC *webrtc,
+         const std::string &track_id) {
+    libwebrtc::scoped_refptr<libwebrtc::RTCPeerConnectionFactory> factory =
+        webrtc->PeerConnectionFactory();
+    if (!factory) {
+      return nullptr;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCAudioSource> source =
+        factory->CreateAudioSource(
+            libwebrtc::string("livekit_custom_" + track_id),
+            libwebrtc::RTCAudioSource::SourceType::kCustom);
+    if (!source) {
+      return nullptr;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCAudioTrack> track =
+        factory->CreateAudioTrack(source, libwebrtc::string(track_id));
+    if (!track) {
+      return nullptr;
+    }
+    return std::unique_ptr<CustomAudioTrack>(
+        new CustomAudioTrack(webrtc, track_id, source, track));
+  }
+
+  ~CustomAudioTrack() { webrtc_->RemoveMediaTrackForId(track_id_); }
+
+  // Forwards frames to the source; may be called from any thread as long as
+  // the track is alive.
+  AudioFrameCallback frame_callback() const {
+    libwebrtc::scoped_refptr<libwebrtc::RTCAudioSource> source = source_;
+    return [source](const int16_t *samples, int sample_rate, size_t channels,
+                    size_t frames) {
+      source->CaptureFrame(samples, 16, sample_rate, channels, frames);
+    };
+  }
+
+private:
+  CustomAudioTrack(flutter_webrtc_plugin::FlutterWebRTC *webrtc,
+                   std::string track_id,
+                   libwebrtc::scoped_refptr<libwebrtc::RTCAudioSource> source,
+                   libwebrtc::scoped_refptr<libwebrtc::RTCAudioTrack> track)
+      : webrtc_(webrtc), track_id_(std::move(track_id)), source_(source),
+        track_(track) {
+    webrtc_->AddLocalTrack(track_);
+  }
+
+  flutter_webrtc_plugin::FlutterWebRTC *webrtc_;
+  std::string track_id_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCAudioSource> source_;
+  libwebrtc::scoped_refptr<libwebrtc::RTCAudioTrack> track_;
 };
 
+// A custom audio track and the native producer feeding it.
+template <typename Producer> struct CustomAudioSession {
+  std::unique_ptr<CustomAudioTrack> track;
+  // Declared last so that it stops producing before the track goes away.
+  std::unique_ptr<Producer> producer;
+};
+
+EncodableMap PcmSourceStatsToMap(const PcmJitterBuffer::Stats &stats) {
+  EncodableMap map;
+  map[EncodableValue("framesPlayed")] =
+      EncodableValue(int64_t(stats.frames_played));
+  map[EncodableValue("framesConcealed")] =
+      EncodableValue(int64_t(stats.frames_concealed));
+  map[EncodableValue("underruns")] = EncodableValue(int64_t(stats.underruns));
+  map[EncodableValue("framesDropped")] =
+      EncodableValue(int64_t(stats.frames_dropped));
+  map[EncodableValue("bufferedFrames")] =
+      EncodableValue(int64_t(stats.buffered_frames));
+  return map;
+}
+
 class LiveKitPlugin : public flutter::Plugin {
 public:
   static void RegisterWithRegistrar(flutter::PluginRegistrar *registrar);
 
-  LiveKitPlugin(BinaryMessenger *messenger);
+  LiveKitPlugin(BinaryMessenger *messenger,
+                flutter::TextureRegistrar *texture_registrar);
 
   virtual ~LiveKitPlugin();
 
@@ -175,8 +774,33 @@ private:
 
 private:
   flutter_webrtc_plugin::FlutterWebRTC *webrtc_instance_ = nullptr;
-  std::unordered_map<std::string, std::unique_ptr<VisualizerSink>> visualizers_;
-  BinaryMessenger *messenger_ = nullptr;
+  flutter::TextureRegistrar *texture_registrar_ = nullptr;
+  // Shared by all event channels so that sinks can send from audio threads.
+  // Declared first so that it outlives them.
+  std::unique_ptr<ThreadSafeBinaryMessenger> messenger_;
+  // Shared with the plugin instances of other engines.
+  std::shared_ptr<AnalysisService> analysis_service_;
+  std::unordered_map<std::string, std::unique_ptr<VisualizerSink>>
+      visualizers_;
+  std::unordered_map<std::string, std::unique_ptr<FrequencyMonitorSink>>
+      frequency_monitors_;
+  std::unordered_map<std::string, std::unique_ptr<UtteranceSink>>
+      utterance_segmenters_;
+  std::unordered_map<std::string, std::unique_ptr<VideoQualitySink>>
+      video_quality_analyzers_;
+  std::unordered_map<std::string, std::unique_ptr<ThumbnailSink>> thumbnails_;
+  std::unordered_map<std::string, std::unique_ptr<ReplayBufferSink>>
+      replay_buffers_;
+  std::unordered_map<std::string, std::unique_ptr<EchoDetectorSink>>
+      echo_detectors_;
+  std::unordered_map<std::string, std::unique_ptr<TalkStatsSession>>
+      talk_stats_;
+  std::unordered_map<std::string, std::unique_ptr<AudioSourceStatsSession>>
+      audio_source_stats_;
+  std::unordered_map<std::string, CustomAudioSession<PcmInjectionSource>>
+      pcm_sources_;
+  std::unordered_map<std::string, CustomAudioSession<WavFileSource>>
+      file_sources_;
   mutable std::mutex mutex_;
 };
 
@@ -187,7 +811,8 @@ void LiveKitPlugin::RegisterWithRegistrar(flutter::PluginRegistrar *registrar) {
           registrar->messenger(), "livekit_client",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<LiveKitPlugin>(registrar->messenger());
+  auto plugin = std::make_unique<LiveKitPlugin>(
+      registrar->messenger(), registrar->texture_registrar());
 
   channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto &call, auto result) {
@@ -197,12 +822,45 @@ void LiveKitPlugin::RegisterWithRegistrar(flutter::PluginRegistrar *registrar) {
   registrar->AddPlugin(std::move(plugin));
 }
 
-LiveKitPlugin::LiveKitPlugin(BinaryMessenger *messenger)
-    : messenger_(messenger) {
+LiveKitPlugin::LiveKitPlugin(BinaryMessenger *messenger,
+                             flutter::TextureRegistrar *texture_registrar)
+    : texture_registrar_(texture_registrar),
+      messenger_(std::make_unique<ThreadSafeBinaryMessenger>(messenger)),
+      analysis_service_(AnalysisService::Acquire()) {
   webrtc_instance_ = flutter_webrtc_plugin_get_shared_instance();
 }
 
-LiveKitPlugin::~LiveKitPlugin() {}
+LiveKitPlugin::~LiveKitPlugin() {
+  // The engine is going away, but its tracks may not: detach every sink
+  // before it is freed, and stop the custom sources while their event
+  // channels and the messenger are still there.
+  messenger_->SetMessageHandler("livekit_client", nullptr);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &entry : frequency_monitors_) {
+    entry.second->RemoveSink();
+  }
+  for (auto &entry : utterance_segmenters_) {
+    entry.second->RemoveSink();
+  }
+  for (auto &entry : video_quality_analyzers_) {
+    entry.second->RemoveSink();
+  }
+  for (auto &entry : thumbnails_) {
+    entry.second->RemoveSink();
+  }
+  for (auto &entry : replay_buffers_) {
+    entry.second->RemoveSink();
+  }
+  for (auto &entry : echo_detectors_) {
+    entry.second->RemoveSink();
+  }
+  // These detach in their destructors.
+  visualizers_.clear();
+  talk_stats_.clear();
+  audio_source_stats_.clear();
+  pcm_sources_.clear();
+  file_sources_.clear();
+}
 
 void LiveKitPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
@@ -218,6 +876,27 @@ void LiveKitPlugin::HandleMethodCall(
     std::string visualizerId = findString(params, "visualizerId");
     int barCount = findInt(params, "barCount");
     bool isCentered = findBoolean(params, "isCentered");
+    bool publishLatest = findBoolean(params, "publishLatest");
+    int idleReleaseMs = findInt(params, "idleReleaseMs");
+    bool useEnvelope = findBoolean(params, "envelope");
+    BandEnvelope::Options envelope;
+    int attackMs = findInt(params, "attackMs");
+    int releaseMs = findInt(params, "releaseMs");
+    int peakHoldMs = findInt(params, "peakHoldMs");
+    double peakFallPerSecond = findDouble(params, "peakFallPerSecond");
+    int frameRate = findInt(params, "frameRate");
+    if (attackMs >= 0) {
+      envelope.attack_ms = float(attackMs);
+    }
+    if (releaseMs >= 0) {
+      envelope.release_ms = float(releaseMs);
+    }
+    if (peakHoldMs >= 0) {
+      envelope.peak_hold_ms = float(peakHoldMs);
+    }
+    if (peakFallPerSecond > 0) {
+      envelope.peak_fall_per_second = float(peakFallPerSecond);
+    }
     if (trackId.empty() || visualizerId.empty()) {
       result->Error("Invalid Arguments",
                     "trackId and visualizerId are required");
@@ -233,9 +912,29 @@ void LiveKitPlugin::HandleMethodCall(
     oss << "io.livekit.audio.visualizer/eventChannel-" << trackId << "-"
         << visualizerId;
 
+    // Drop a visualizer started with the same id first: its event channel
+    // has the same name and unregisters it when destroyed.
+    mutex_.lock();
+    auto previous = std::move(visualizers_[visualizerId]);
+    visualizers_.erase(visualizerId);
+    mutex_.unlock();
+    previous.reset();
+
+    std::shared_ptr<SharedVisualizer> visualizer =
+        analysis_service_->AcquireVisualizer(
+            trackId, barCount, isCentered,
+            [&media_track](SharedVisualizer *shared) {
+              return std::make_unique<AudioTrackConnection>(media_track,
+                                                            shared);
+            });
+
     mutex_.lock();
     visualizers_[visualizerId] = std::make_unique<VisualizerSink>(
-        messenger_, oss.str(), media_track, isCentered, barCount);
+        messenger_.get(), oss.str(), visualizerId, std::move(visualizer),
+        publishLatest,
+        idleReleaseMs >= 0 ? idleReleaseMs
+                           : VisualizerSink::kDefaultIdleReleaseMs,
+        useEnvelope ? &envelope : nullptr, std::max(frameRate, 0));
     mutex_.unlock();
 
     result->Success(flutter::EncodableValue(true));
@@ -263,7 +962,6 @@ void LiveKitPlugin::HandleMethodCall(
     mutex_.lock();
     auto it = visualizers_.find(visualizerId);
     if (it != visualizers_.end()) {
-      it->second->RemoveSink();
       visualizers_.erase(it);
       mutex_.unlock();
     } else {
@@ -274,14 +972,1046 @@ void LiveKitPlugin::HandleMethodCall(
     }
 
     result->Success();
-  } else {
-    result->NotImplemented();
-  }
-}
+  } else if (method_call.method_name().compare("setVisualizerShadowMode") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    AnalysisService::ShadowMode mode;
+    mode.fraction = findDouble(params, "fraction");
+    mode.candidate.use_fixed_point = findBoolean(params, "useFixedPoint");
+    int fftSize = findInt(params, "fftSize");
+    double minFrequency = findDouble(params, "minFrequency");
+    double maxFrequency = findDouble(params, "maxFrequency");
+    if (fftSize > 0) {
+      mode.candidate.fft_size = unsigned(fftSize);
+    }
+    if (minFrequency > 0) {
+      mode.candidate.min_frequency = float(minFrequency);
+    }
+    if (maxFrequency > 0) {
+      mode.candidate.max_frequency = float(maxFrequency);
+    }
+    const unsigned size = mode.candidate.fft_size;
+    if (mode.fraction < 0 || mode.fraction > 1 ||
+        size < FFTProcessor::kMinFFTSize || size > FFTProcessor::kMaxFFTSize ||
+        (size & (size - 1)) != 0 ||
+        mode.candidate.min_frequency >= mode.candidate.max_frequency) {
+      result->Error("Invalid Arguments",
+                    "fraction must be within [0, 1], fftSize a power of two "
+                    "and minFrequency below maxFrequency");
+      return;
+    }
 
-} // namespace livekit_client_plugin
+    analysis_service_->SetShadowMode(mode);
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("getVisualizerStats") == 0) {
+    AnalysisService::VisualizerStats stats =
+        analysis_service_->GetVisualizerStats();
+    const VisualizerShadow::Stats &shadow = stats.shadow;
+    EncodableMap map;
+    map[EncodableValue("visualizers")] =
+        EncodableValue(int64_t(stats.visualizers));
+    map[EncodableValue("shadowedVisualizers")] =
+        EncodableValue(int64_t(stats.shadowed_visualizers));
+    map[EncodableValue("comparedAnalyses")] =
+        EncodableValue(int64_t(shadow.compared));
+    map[EncodableValue("divergentAnalyses")] =
+        EncodableValue(int64_t(shadow.divergent));
+    map[EncodableValue("meanBandDifference")] = EncodableValue(
+        shadow.bands_compared > 0
+            ? shadow.total_difference / double(shadow.bands_compared)
+            : 0.0);
+    map[EncodableValue("maxBandDifference")] =
+        EncodableValue(double(shadow.max_difference));
+    map[EncodableValue("primarySeconds")] =
+        EncodableValue(shadow.primary_seconds);
+    map[EncodableValue("candidateSeconds")] =
+        EncodableValue(shadow.candidate_seconds);
+    result->Success(EncodableValue(map));
+  } else if (method_call.method_name().compare("startFrequencyMonitor") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string monitorId = findString(params, "monitorId");
+    int windowMs = findInt(params, "windowMs");
+    int intervalMs = findInt(params, "intervalMs");
+    std::vector<float> frequencies;
+    auto it = params.find(EncodableValue("frequencies"));
+    if (it != params.end()) {
+      if (auto *list = std::get_if<std::vector<double>>(&it->second)) {
+        frequencies.assign(list->begin(), list->end());
+      } else if (auto *list = std::get_if<EncodableList>(&it->second)) {
+        for (const auto &value : *list) {
+          if (auto *frequency = std::get_if<double>(&value)) {
+            frequencies.push_back(float(*frequency));
+          }
+        }
+      }
+    }
+    if (trackId.empty() || monitorId.empty() || frequencies.empty()) {
+      result->Error("Invalid Arguments",
+                    "trackId, monitorId and frequencies are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "audio") {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+    std::ostringstream oss;
+    oss << "io.livekit.audio.frequency_monitor/eventChannel-" << trackId << "-"
+        << monitorId;
 
-void live_kit_plugin_register_with_registrar(FlPluginRegistrar *registrar) {
-  static auto *plugin_registrar = new flutter::PluginRegistrar(registrar);
-  livekit_client_plugin::LiveKitPlugin::RegisterWithRegistrar(plugin_registrar);
+    // Detach a monitor started with the same id before creating the new one,
+    // whose event channel has the same name.
+    mutex_.lock();
+    auto previous = std::move(frequency_monitors_[monitorId]);
+    frequency_monitors_.erase(monitorId);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+      previous.reset();
+    }
+
+    mutex_.lock();
+    frequency_monitors_[monitorId] = std::make_unique<FrequencyMonitorSink>(
+        messenger_.get(), oss.str(), media_track, std::move(frequencies),
+        windowMs > 0 ? windowMs : FrequencyMonitorSink::kDefaultWindowMs,
+        intervalMs > 0 ? intervalMs : FrequencyMonitorSink::kDefaultIntervalMs);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopFrequencyMonitor") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string monitorId = findString(args, "monitorId");
+    if (monitorId.empty()) {
+      result->Error("Invalid Arguments", "monitorId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = frequency_monitors_.find(monitorId);
+    if (it != frequency_monitors_.end()) {
+      it->second->RemoveSink();
+      frequency_monitors_.erase(it);
+      mutex_.unlock();
+    } else {
+      mutex_.unlock();
+      result->Error("Frequency Monitor Not Found",
+                    "No frequency monitor found for the given monitorId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("startUtteranceSegmenter") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string segmenterId = findString(params, "segmenterId");
+    std::string format = findString(params, "format");
+    UtteranceSegmenter::Options options;
+    int preRollMs = findInt(params, "preRollMs");
+    int hangoverMs = findInt(params, "hangoverMs");
+    int minSpeechMs = findInt(params, "minSpeechMs");
+    int maxUtteranceMs = findInt(params, "maxUtteranceMs");
+    if (preRollMs >= 0) {
+      options.pre_roll_ms = preRollMs;
+    }
+    if (hangoverMs > 0) {
+      options.hangover_ms = hangoverMs;
+    }
+    if (minSpeechMs >= 0) {
+      options.min_speech_ms = minSpeechMs;
+    }
+    if (maxUtteranceMs > 0) {
+      options.max_utterance_ms = maxUtteranceMs;
+    }
+    if (trackId.empty() || segmenterId.empty() ||
+        (format != "float32" && format != "int16")) {
+      result->Error("Invalid Arguments",
+                    "trackId, segmenterId and a format of float32 or int16 "
+                    "are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "audio") {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+    std::ostringstream oss;
+    oss << "io.livekit.audio.utterances/eventChannel-" << trackId << "-"
+        << segmenterId;
+
+    // Stop a segmenter started with the same id before creating the new one,
+    // whose event channel has the same name.
+    mutex_.lock();
+    auto previous = std::move(utterance_segmenters_[segmenterId]);
+    utterance_segmenters_.erase(segmenterId);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+      previous.reset();
+    }
+
+    auto segmenter = std::make_unique<UtteranceSink>(
+        messenger_.get(), oss.str(), media_track, options, format == "int16");
+    mutex_.lock();
+    utterance_segmenters_[segmenterId] = std::move(segmenter);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopUtteranceSegmenter") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string segmenterId = findString(args, "segmenterId");
+    if (segmenterId.empty()) {
+      result->Error("Invalid Arguments", "segmenterId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = utterance_segmenters_.find(segmenterId);
+    if (it == utterance_segmenters_.end()) {
+      mutex_.unlock();
+      result->Error("Utterance Segmenter Not Found",
+                    "No utterance segmenter found for the given segmenterId");
+      return;
+    }
+    it->second->RemoveSink();
+    utterance_segmenters_.erase(it);
+    mutex_.unlock();
+
+    result->Success();
+  } else if (method_call.method_name().compare("startVideoQualityAnalyzer") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string analyzerId = findString(params, "analyzerId");
+    int analysisIntervalMs = findInt(params, "analysisIntervalMs");
+    int reportIntervalMs = findInt(params, "reportIntervalMs");
+    if (trackId.empty() || analyzerId.empty()) {
+      result->Error("Invalid Arguments",
+                    "trackId and analyzerId are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "video") {
+      result->Error("Track Not Found", "No video track found for the given ID");
+      return;
+    }
+    std::ostringstream oss;
+    oss << "io.livekit.video.quality/eventChannel-" << trackId << "-"
+        << analyzerId;
+
+    // Remove the renderer of an analyzer started with the same id before
+    // creating the new one, whose event channel has the same name.
+    mutex_.lock();
+    auto previous = std::move(video_quality_analyzers_[analyzerId]);
+    video_quality_analyzers_.erase(analyzerId);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+      previous.reset();
+    }
+
+    mutex_.lock();
+    video_quality_analyzers_[analyzerId] = std::make_unique<VideoQualitySink>(
+        messenger_.get(), oss.str(), media_track,
+        analysisIntervalMs > 0 ? analysisIntervalMs
+                               : VideoQualitySink::kDefaultAnalysisIntervalMs,
+        reportIntervalMs > 0 ? reportIntervalMs
+                             : VideoQualitySink::kDefaultReportIntervalMs);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopVideoQualityAnalyzer") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string analyzerId = findString(args, "analyzerId");
+    if (analyzerId.empty()) {
+      result->Error("Invalid Arguments", "analyzerId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = video_quality_analyzers_.find(analyzerId);
+    if (it != video_quality_analyzers_.end()) {
+      it->second->RemoveSink();
+      video_quality_analyzers_.erase(it);
+      mutex_.unlock();
+    } else {
+      mutex_.unlock();
+      result->Error("Video Quality Analyzer Not Found",
+                    "No video quality analyzer found for the given analyzerId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("startThumbnail") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string thumbnailId = findString(params, "thumbnailId");
+    int width = findInt(params, "width");
+    int height = findInt(params, "height");
+    int maxFps = findInt(params, "maxFps");
+    if (trackId.empty() || thumbnailId.empty() || width <= 0 || height <= 0) {
+      result->Error("Invalid Arguments",
+                    "trackId, thumbnailId, width and height are required");
+      return;
+    }
+    if (!texture_registrar_) {
+      result->Error("Textures Unavailable", "No texture registrar available");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "video") {
+      result->Error("Track Not Found", "No video track found for the given ID");
+      return;
+    }
+
+    auto thumbnail = std::make_unique<ThumbnailSink>(
+        texture_registrar_, media_track, width, height,
+        maxFps > 0 ? maxFps : ThumbnailSink::kDefaultMaxFps);
+    int64_t textureId = thumbnail->texture_id();
+    mutex_.lock();
+    auto previous = std::move(thumbnails_[thumbnailId]);
+    thumbnails_[thumbnailId] = std::move(thumbnail);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+    }
+
+    result->Success(flutter::EncodableValue(textureId));
+  } else if (method_call.method_name().compare("stopThumbnail") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string thumbnailId = findString(args, "thumbnailId");
+    if (thumbnailId.empty()) {
+      result->Error("Invalid Arguments", "thumbnailId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = thumbnails_.find(thumbnailId);
+    if (it != thumbnails_.end()) {
+      it->second->RemoveSink();
+      thumbnails_.erase(it);
+      mutex_.unlock();
+    } else {
+      mutex_.unlock();
+      result->Error("Thumbnail Not Found",
+                    "No thumbnail found for the given thumbnailId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("startReplayBuffer") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string bufferId = findString(params, "bufferId");
+    double seconds = findDouble(params, "seconds");
+    if (trackId.empty() || bufferId.empty() || seconds <= 0) {
+      result->Error("Invalid Arguments",
+                    "trackId, bufferId and seconds are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "audio") {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+
+    auto buffer = std::make_unique<ReplayBufferSink>(media_track, seconds);
+    mutex_.lock();
+    auto previous = std::move(replay_buffers_[bufferId]);
+    replay_buffers_[bufferId] = std::move(buffer);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+    }
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("saveReplayBuffer") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string bufferId = findString(args, "bufferId");
+    std::string path = findString(args, "path");
+    double seconds = findDouble(args, "seconds");
+    if (bufferId.empty() || path.empty()) {
+      result->Error("Invalid Arguments", "bufferId and path are required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = replay_buffers_.find(bufferId);
+    std::shared_ptr<const AudioReplayBuffer> buffer;
+    if (it != replay_buffers_.end()) {
+      buffer = it->second->buffer();
+    }
+    mutex_.unlock();
+    if (!buffer) {
+      result->Error("Replay Buffer Not Found",
+                    "No replay buffer found for the given bufferId");
+      return;
+    }
+
+    // Replied to from the main loop once the file is written.
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> reply =
+        std::move(result);
+    SaveReplayAsync(std::move(buffer), seconds, path,
+                    [reply](double duration, const std::string &error) {
+                      if (!error.empty()) {
+                        reply->Error("Save Failed", error);
+                        return;
+                      }
+                      reply->Success(EncodableValue(duration));
+                    });
+  } else if (method_call.method_name().compare("stopReplayBuffer") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string bufferId = findString(args, "bufferId");
+    if (bufferId.empty()) {
+      result->Error("Invalid Arguments", "bufferId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = replay_buffers_.find(bufferId);
+    if (it != replay_buffers_.end()) {
+      it->second->RemoveSink();
+      replay_buffers_.erase(it);
+      mutex_.unlock();
+    } else {
+      mutex_.unlock();
+      result->Error("Replay Buffer Not Found",
+                    "No replay buffer found for the given bufferId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("startEchoDetector") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string detectorId = findString(params, "detectorId");
+    double coherenceThreshold = findDouble(params, "coherenceThreshold");
+    std::vector<std::string> remoteTrackIds;
+    for (const auto &value : findList(params, "remoteTrackIds")) {
+      if (auto *id = std::get_if<std::string>(&value)) {
+        remoteTrackIds.push_back(*id);
+      }
+    }
+    if (trackId.empty() || detectorId.empty() || remoteTrackIds.empty()) {
+      result->Error("Invalid Arguments",
+                    "trackId, detectorId and remoteTrackIds are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    std::vector<libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack>>
+        remote_tracks;
+    for (const auto &remoteTrackId : remoteTrackIds) {
+      auto remote_track = webrtc_instance_->MediaTrackForId(remoteTrackId);
+      if (!remote_track || remote_track->kind().std_string() != "audio") {
+        break;
+      }
+      remote_tracks.push_back(remote_track);
+    }
+    if (!media_track || media_track->kind().std_string() != "audio" ||
+        remote_tracks.size() != remoteTrackIds.size()) {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+    std::ostringstream oss;
+    oss << "io.livekit.audio.echo_detector/eventChannel-" << trackId << "-"
+        << detectorId;
+
+    // Detach a detector started with the same id before creating the new
+    // one, whose event channel has the same name.
+    mutex_.lock();
+    auto previous = std::move(echo_detectors_[detectorId]);
+    echo_detectors_.erase(detectorId);
+    mutex_.unlock();
+    if (previous) {
+      previous->RemoveSink();
+      previous.reset();
+    }
+
+    mutex_.lock();
+    echo_detectors_[detectorId] = std::make_unique<EchoDetectorSink>(
+        messenger_.get(), oss.str(), media_track, std::move(remote_tracks),
+        std::move(remoteTrackIds),
+        coherenceThreshold > 0
+            ? float(coherenceThreshold)
+            : EchoLeakDetector::kDefaultCoherenceThreshold);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopEchoDetector") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string detectorId = findString(args, "detectorId");
+    if (detectorId.empty()) {
+      result->Error("Invalid Arguments", "detectorId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = echo_detectors_.find(detectorId);
+    if (it != echo_detectors_.end()) {
+      it->second->RemoveSink();
+      echo_detectors_.erase(it);
+      mutex_.unlock();
+    } else {
+      mutex_.unlock();
+      result->Error("Echo Detector Not Found",
+                    "No echo detector found for the given detectorId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("startTalkStats") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string collectorId = findString(params, "collectorId");
+    if (trackId.empty() || collectorId.empty()) {
+      result->Error("Invalid Arguments",
+                    "trackId and collectorId are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "audio") {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+
+    mutex_.lock();
+    auto &session = talk_stats_[collectorId];
+    if (!session) {
+      session = std::make_unique<TalkStatsSession>();
+    }
+    session->AddTrack(trackId, media_track);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopTalkStats") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string collectorId = findString(args, "collectorId");
+    // Without a trackId the whole collector is stopped.
+    std::string trackId = findString(args, "trackId");
+    if (collectorId.empty()) {
+      result->Error("Invalid Arguments", "collectorId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = talk_stats_.find(collectorId);
+    if (it != talk_stats_.end()) {
+      if (!trackId.empty()) {
+        it->second->RemoveTrack(trackId);
+      }
+      if (trackId.empty() || it->second->empty()) {
+        talk_stats_.erase(it);
+      }
+    }
+    mutex_.unlock();
+
+    result->Success();
+  } else if (method_call.method_name().compare("getTalkStats") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string collectorId = findString(args, "collectorId");
+
+    EncodableMap stats;
+    mutex_.lock();
+    auto it = talk_stats_.find(collectorId);
+    if (it != talk_stats_.end()) {
+      stats = it->second->GetStats();
+    }
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(stats));
+  } else if (method_call.method_name().compare("startAudioSourceStats") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string trackId = findString(params, "trackId");
+    std::string collectorId = findString(params, "collectorId");
+    if (trackId.empty() || collectorId.empty()) {
+      result->Error("Invalid Arguments",
+                    "trackId and collectorId are required");
+      return;
+    }
+    libwebrtc::scoped_refptr<libwebrtc::RTCMediaTrack> media_track =
+        webrtc_instance_->MediaTrackForId(trackId);
+    if (!media_track || media_track->kind().std_string() != "audio") {
+      result->Error("Track Not Found", "No audio track found for the given ID");
+      return;
+    }
+
+    mutex_.lock();
+    auto &session = audio_source_stats_[collectorId];
+    if (!session) {
+      session = std::make_unique<AudioSourceStatsSession>();
+    }
+    session->AddTrack(trackId, media_track);
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name().compare("stopAudioSourceStats") ==
+             0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string collectorId = findString(args, "collectorId");
+    // Without a trackId the whole collector is stopped.
+    std::string trackId = findString(args, "trackId");
+    if (collectorId.empty()) {
+      result->Error("Invalid Arguments", "collectorId is required");
+      return;
+    }
+
+    mutex_.lock();
+    auto it = audio_source_stats_.find(collectorId);
+    if (it != audio_source_stats_.end()) {
+      if (!trackId.empty()) {
+        it->second->RemoveTrack(trackId);
+      }
+      if (trackId.empty() || it->second->empty()) {
+        audio_source_stats_.erase(it);
+      }
+    }
+    mutex_.unlock();
+
+    result->Success();
+  } else if (method_call.method_name().compare("getAudioSourceStats") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string collectorId = findString(args, "collectorId");
+    EncodableList trackIds = findList(args, "trackIds");
+
+    // Three values per requested track, in request order, sent as a single
+    // Float64List.
+    std::vector<double> values;
+    values.reserve(trackIds.size() * 3);
+    mutex_.lock();
+    auto it = audio_source_stats_.find(collectorId);
+    for (const auto &value : trackIds) {
+      const std::string *trackId = std::get_if<std::string>(&value);
+      if (it != audio_source_stats_.end() && trackId) {
+        it->second->AppendStats(*trackId, values);
+      } else {
+        values.insert(values.end(), 3, std::nan(""));
+      }
+    }
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(values));
+  } else if (method_call.method_name().compare("createPcmSource") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(params, "sourceId");
+    int sampleRate = findInt(params, "sampleRate");
+    int channels = findInt(params, "channels");
+    int bufferMs = findInt(params, "bufferMs");
+    int prebufferMs = findInt(params, "prebufferMs");
+    if (sourceId.empty() || sampleRate < 8000 || sampleRate % 100 != 0 ||
+        channels < 1 || channels > 2) {
+      result->Error("Invalid Arguments",
+                    "sourceId, sampleRate (a multiple of 100) and channels "
+                    "(1 or 2) are required");
+      return;
+    }
+    mutex_.lock();
+    bool exists = pcm_sources_.count(sourceId) > 0;
+    mutex_.unlock();
+    if (exists) {
+      result->Error("Invalid Arguments", "sourceId is already in use");
+      return;
+    }
+    CustomAudioSession<PcmInjectionSource> session;
+    session.track = CustomAudioTrack::Create(webrtc_instance_, sourceId);
+    if (!session.track) {
+      result->Error("Source Unavailable", "Could not create a custom source");
+      return;
+    }
+    std::ostringstream oss;
+    oss << "io.livekit.audio.pcm_source/channel-" << sourceId;
+    session.producer = std::make_unique<PcmInjectionSource>(
+        messenger_.get(), oss.str(), sampleRate, size_t(channels),
+        bufferMs > 0 ? bufferMs : PcmInjectionSource::kDefaultBufferMs,
+        prebufferMs >= 0 ? prebufferMs
+                         : PcmInjectionSource::kDefaultPrebufferMs,
+        session.track->frame_callback());
+
+    mutex_.lock();
+    pcm_sources_[sourceId] = std::move(session);
+    mutex_.unlock();
+
+    EncodableMap map;
+    map[EncodableValue("trackId")] = EncodableValue(sourceId);
+    map[EncodableValue("channel")] = EncodableValue(oss.str());
+    result->Success(EncodableValue(map));
+  } else if (method_call.method_name().compare("disposePcmSource") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(args, "sourceId");
+    if (sourceId.empty()) {
+      result->Error("Invalid Arguments", "sourceId is required");
+      return;
+    }
+
+    CustomAudioSession<PcmInjectionSource> session;
+    mutex_.lock();
+    auto it = pcm_sources_.find(sourceId);
+    if (it != pcm_sources_.end()) {
+      session = std::move(it->second);
+      pcm_sources_.erase(it);
+    }
+    mutex_.unlock();
+    if (!session.track) {
+      result->Error("PCM Source Not Found",
+                    "No PCM source found for the given sourceId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("getPcmSourceStats") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(args, "sourceId");
+
+    EncodableMap stats;
+    mutex_.lock();
+    auto it = pcm_sources_.find(sourceId);
+    if (it != pcm_sources_.end()) {
+      stats = PcmSourceStatsToMap(it->second.producer->GetStats());
+    }
+    mutex_.unlock();
+
+    result->Success(flutter::EncodableValue(stats));
+  } else if (method_call.method_name().compare("createFileSource") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap params =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(params, "sourceId");
+    std::string path = findString(params, "path");
+    int sampleRate = findInt(params, "sampleRate");
+    int channels = findInt(params, "channels");
+    bool loop = findBoolean(params, "loop");
+    if (sourceId.empty() || path.empty() ||
+        (sampleRate > 0 && (sampleRate < 8000 || sampleRate % 100 != 0)) ||
+        channels > 2) {
+      result->Error("Invalid Arguments",
+                    "sourceId and path are required, sampleRate must be a "
+                    "multiple of 100 and channels at most 2");
+      return;
+    }
+    mutex_.lock();
+    bool exists = file_sources_.count(sourceId) > 0;
+    mutex_.unlock();
+    if (exists) {
+      result->Error("Invalid Arguments", "sourceId is already in use");
+      return;
+    }
+    CustomAudioSession<WavFileSource> session;
+    session.track = CustomAudioTrack::Create(webrtc_instance_, sourceId);
+    if (!session.track) {
+      result->Error("Source Unavailable", "Could not create a custom source");
+      return;
+    }
+    std::string error;
+    session.producer = WavFileSource::Open(
+        path, std::max(sampleRate, 0), size_t(std::max(channels, 0)), loop,
+        session.track->frame_callback(), &error);
+    if (!session.producer) {
+      result->Error("File Unavailable", error);
+      return;
+    }
+    double duration = session.producer->duration_seconds();
+
+    mutex_.lock();
+    file_sources_[sourceId] = std::move(session);
+    mutex_.unlock();
+
+    EncodableMap map;
+    map[EncodableValue("trackId")] = EncodableValue(sourceId);
+    map[EncodableValue("duration")] = EncodableValue(duration);
+    result->Success(EncodableValue(map));
+  } else if (method_call.method_name().compare("seekFileSource") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(args, "sourceId");
+    double position = findDouble(args, "position");
+
+    mutex_.lock();
+    auto it = file_sources_.find(sourceId);
+    bool found = it != file_sources_.end();
+    if (found) {
+      it->second.producer->Seek(position);
+    }
+    mutex_.unlock();
+    if (!found) {
+      result->Error("File Source Not Found",
+                    "No file source found for the given sourceId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("disposeFileSource") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    std::string sourceId = findString(args, "sourceId");
+    if (sourceId.empty()) {
+      result->Error("Invalid Arguments", "sourceId is required");
+      return;
+    }
+
+    CustomAudioSession<WavFileSource> session;
+    mutex_.lock();
+    auto it = file_sources_.find(sourceId);
+    if (it != file_sources_.end()) {
+      session = std::move(it->second);
+      file_sources_.erase(it);
+    }
+    mutex_.unlock();
+    if (!session.track) {
+      result->Error("File Source Not Found",
+                    "No file source found for the given sourceId");
+      return;
+    }
+
+    result->Success();
+  } else if (method_call.method_name().compare("getLatestBands") == 0) {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null arguments received");
+      return;
+    }
+    flutter::EncodableMap args =
+        GetValue<flutter::EncodableMap>(*method_call.arguments());
+    EncodableList visualizerIds = findList(args, "visualizerIds");
+
+    // Reads never wait for the audio threads, so no plugin lock is needed.
+    std::vector<int64_t> versions;
+    EncodableList bands;
+    float buffer[LatestBandsRegistry::kMaxBands];
+    for (const auto &value : visualizerIds) {
+      const std::string *visualizerId = std::get_if<std::string>(&value);
+      size_t count = 0;
+      uint64_t version = 0;
+      if (visualizerId &&
+          LatestBandsRegistry::Instance().Read(
+              *visualizerId, buffer, LatestBandsRegistry::kMaxBands, &count,
+              &version) &&
+          version > 0) {
+        versions.push_back(int64_t(version));
+        bands.push_back(
+            EncodableValue(std::vector<float>(buffer, buffer + count)));
+      } else {
+        versions.push_back(0);
+        bands.push_back(EncodableValue());
+      }
+    }
+
+    EncodableMap map;
+    map[EncodableValue("versions")] = EncodableValue(versions);
+    map[EncodableValue("bands")] = EncodableValue(bands);
+    result->Success(EncodableValue(map));
+  } else {
+    result->NotImplemented();
+  }
+}
+
+} // namespace livekit_client_plugin
+
+int32_t livekit_get_latest_bands(const char *visualizer_ids,
+                                 int32_t visualizer_count, float *bands,
+                                 int32_t bands_per_visualizer,
+                                 int32_t *band_counts, uint64_t *versions) {
+  LatestBandsRegistry &registry = LatestBandsRegistry::Instance();
+  const size_t capacity = size_t(std::max(bands_per_visualizer, 0));
+  int32_t found = 0;
+  for (int32_t i = 0; i < visualizer_count; ++i) {
+    std::string visualizer_id(visualizer_ids);
+    visualizer_ids += visualizer_id.size() + 1;
+    size_t count = 0;
+    uint64_t version = 0;
+    if (registry.Read(visualizer_id, bands + i * capacity, capacity, &count,
+                      &version)) {
+      ++found;
+      band_counts[i] = int32_t(count);
+    } else {
+      band_counts[i] = -1;
+    }
+    versions[i] = version;
+  }
+  return found;
+}
+
+LiveKitZlibStream *livekit_zlib_stream_new(int32_t compress, int32_t level) {
+  using livekit_client_plugin::ZlibStream;
+  auto *stream = new ZlibStream(
+      compress ? ZlibStream::Mode::kDeflate : ZlibStream::Mode::kInflate,
+      level);
+  if (!stream->ok()) {
+    delete stream;
+    return nullptr;
+  }
+  return reinterpret_cast<LiveKitZlibStream *>(stream);
+}
+
+int32_t livekit_zlib_stream_process(LiveKitZlibStream *stream,
+                                    const uint8_t *input, int32_t input_size,
+                                    int32_t *input_consumed, uint8_t *output,
+                                    int32_t output_capacity, int32_t flush) {
+  using livekit_client_plugin::ZlibStream;
+  size_t consumed = 0;
+  int64_t written = -1;
+  if (stream && input_size >= 0 && output_capacity >= 0 && flush >= 0 &&
+      flush <= 2) {
+    written = reinterpret_cast<ZlibStream *>(stream)->Process(
+        input, size_t(input_size), &consumed, output, size_t(output_capacity),
+        static_cast<ZlibStream::Flush>(flush));
+  }
+  *input_consumed = int32_t(consumed);
+  return int32_t(written);
+}
+
+void livekit_zlib_stream_free(LiveKitZlibStream *stream) {
+  delete reinterpret_cast<livekit_client_plugin::ZlibStream *>(stream);
+}
+
+static void OnViewDestroyed(gpointer data, GObject *view) {
+  delete static_cast<flutter::PluginRegistrar *>(data);
+}
+
+void live_kit_plugin_register_with_registrar(FlPluginRegistrar *registrar) {
+  // One registrar, and so one plugin instance, per engine: each window of a
+  // multi-window app has its own. The FlPluginRegistrar is released as soon
+  // as registration returns, so both go with the view that owns the engine
+  // instead; a headless engine has no view and keeps them until exit.
+  auto *plugin_registrar = new flutter::PluginRegistrar(registrar);
+  livekit_client_plugin::LiveKitPlugin::RegisterWithRegistrar(plugin_registrar);
+  FlView *view = fl_plugin_registrar_get_view(registrar);
+  if (view != nullptr) {
+    g_object_weak_ref(G_OBJECT(view), OnViewDestroyed, plugin_registrar);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,206 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "logger.h"
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace livekit_client_plugin {
+
+namespace {
+
+// The coarse clock is read from the vDSO without a syscall or TSC read; its
+// few milliseconds of resolution are plenty for rate limiting.
+int64_t NowMs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+  return int64_t(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+char LevelLetter(LogLevel level) {
+  switch (level) {
+    case LogLevel::kVerbose:
+      return 'V';
+    case LogLevel::kInfo:
+      return 'I';
+    case LogLevel::kWarning:
+      return 'W';
+    case LogLevel::kError:
+      return 'E';
+  }
+  return '?';
+}
+
+const char* BaseName(const char* path) {
+  const char* slash = std::strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+}  // namespace
+
+bool LogSite::Admit(int64_t now_ms, uint32_t* suppressed) {
+  int64_t window_start = window_start_ms_.load(std::memory_order_relaxed);
+  if (now_ms - window_start >= kWindowMs &&
+      window_start_ms_.compare_exchange_strong(window_start, now_ms,
+                                               std::memory_order_relaxed)) {
+    count_.store(0, std::memory_order_relaxed);
+  }
+  if (count_.fetch_add(1, std::memory_order_relaxed) >= kMaxPerWindow) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
+// A queue slot. |sequence| equals the slot's position while it is free for
+// that position, and the position plus one once a message was written to it
+// (a bounded MPMC queue as described by Dmitry Vyukov).
+struct Logger::Entry {
+  std::atomic<size_t> sequence{0};
+  LogLevel level = LogLevel::kInfo;
+  const LogSite* site = nullptr;
+  uint32_t suppressed = 0;
+  char text[kMaxMessageSize];
+};
+
+// static
+Logger& Logger::Instance() {
+  static Logger* instance = [] {
+    Logger* logger = new Logger();
+    std::atexit([] { Instance().Flush(); });
+    return logger;
+  }();
+  return *instance;
+}
+
+Logger::Logger() : entries_(new Entry[kQueueSize]) {
+  for (size_t i = 0; i < kQueueSize; ++i) {
+    entries_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  thread_ = std::thread([this]() { Run(); });
+  thread_.detach();
+}
+
+void Logger::Log(LogLevel level, LogSite* site, const char* format, ...) {
+  uint32_t suppressed = 0;
+  if (!site->Admit(NowMs(), &suppressed)) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  bool queued = Push(level, site, suppressed, format, args);
+  va_end(args);
+  if (!queued) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // The writer only waits on |wake_mutex_| briefly, never while writing, so
+  // taking it here does not block on the terminal.
+  if (!pending_.exchange(true, std::memory_order_acq_rel)) {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_.notify_one();
+  }
+}
+
+void Logger::Flush() {
+  std::lock_guard<std::mutex> lock(drain_mutex_);
+  Drain();
+}
+
+bool Logger::Push(LogLevel level,
+                  const LogSite* site,
+                  uint32_t suppressed,
+                  const char* format,
+                  va_list args) {
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Entry* entry;
+  while (true) {
+    entry = &entries_[position % kQueueSize];
+    size_t sequence = entry->sequence.load(std::memory_order_acquire);
+    intptr_t difference = intptr_t(sequence) - intptr_t(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // Full: the writer has not consumed this slot's previous message yet.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  entry->level = level;
+  entry->site = site;
+  entry->suppressed = suppressed;
+  std::vsnprintf(entry->text, kMaxMessageSize, format, args);
+  entry->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+void Logger::Run() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_.wait(lock, [this]() {
+        return pending_.load(std::memory_order_relaxed);
+      });
+    }
+    // Let the rest of a burst join the batch.
+    std::this_thread::sleep_for(std::chrono::milliseconds(kFlushIntervalMs));
+    // Messages queued from here on set |pending_| again. The exchange
+    // synchronizes with the producers that found it set, so their messages
+    // are visible to Drain().
+    pending_.exchange(false, std::memory_order_acq_rel);
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    Drain();
+  }
+}
+
+size_t Logger::Drain() {
+  size_t written = 0;
+  size_t position = dequeue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    Entry& entry = entries_[position % kQueueSize];
+    if (entry.sequence.load(std::memory_order_acquire) != position + 1) {
+      break;
+    }
+    std::fprintf(stderr, "[livekit] %c %s:%d %s", LevelLetter(entry.level),
+                 BaseName(entry.site->file()), entry.site->line(), entry.text);
+    if (entry.suppressed) {
+      std::fprintf(stderr, " (%u similar messages suppressed)",
+                   entry.suppressed);
+    }
+    std::fputc('\n', stderr);
+    entry.sequence.store(position + kQueueSize, std::memory_order_release);
+    ++position;
+    ++written;
+  }
+  dequeue_position_.store(position, std::memory_order_relaxed);
+  uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped) {
+    std::fprintf(stderr, "[livekit] W %llu log messages dropped\n",
+                 static_cast<unsigned long long>(dropped));
+  }
+  if (written || dropped) {
+    std::fflush(stderr);
+  }
+  return written;
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,144 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef LIVEKIT_CLIENT_LINUX_LOGGER_H_
+#define LIVEKIT_CLIENT_LINUX_LOGGER_H_
+
+#include <atomic>
+#include <cstdarg>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Messages below this level are compiled out. Set with the LIVEKIT_LOG_LEVEL
+// CMake option: 0 verbose, 1 info, 2 warning, 3 error, 4 none.
+#ifndef LIVEKIT_MIN_LOG_LEVEL
+#define LIVEKIT_MIN_LOG_LEVEL 1
+#endif
+
+namespace livekit_client_plugin {
+
+enum class LogLevel : int {
+  kVerbose = 0,
+  kInfo = 1,
+  kWarning = 2,
+  kError = 3,
+};
+
+// State of one LIVEKIT_LOG call site: lets through at most kMaxPerWindow
+// messages per kWindowMs and counts the rest, so a condition repeating for
+// every message costs a clock read and a few atomics instead of a write.
+class LogSite {
+ public:
+  static constexpr int64_t kWindowMs = 1000;
+  static constexpr uint32_t kMaxPerWindow = 5;
+
+  constexpr LogSite(const char* file, int line) : file_(file), line_(line) {}
+
+  // Returns whether a message may be logged at |now_ms|, and then how many
+  // were suppressed since the last one in |suppressed|.
+  bool Admit(int64_t now_ms, uint32_t* suppressed);
+
+  const char* file() const { return file_; }
+  int line() const { return line_; }
+
+ private:
+  const char* file_;
+  int line_;
+  std::atomic<int64_t> window_start_ms_{INT64_MIN / 2};
+  std::atomic<uint32_t> count_{0};
+  std::atomic<uint32_t> suppressed_{0};
+};
+
+// Process-wide asynchronous logger writing to stderr.
+//
+// Log() formats into a slot of a bounded lock-free queue and returns; a
+// background thread, started with the first message, writes queued messages
+// in batches with one flush each. Messages are dropped, and counted, when
+// the queue is full, so callers never block on the terminal or on another
+// thread. The thread sleeps until a message is queued, then waits up to
+// kFlushIntervalMs for more to join the batch. Use the LIVEKIT_LOG_* macros
+// rather than calling Log() directly.
+class Logger {
+ public:
+  static constexpr size_t kQueueSize = 256;
+  static constexpr size_t kMaxMessageSize = 240;
+  static constexpr int kFlushIntervalMs = 50;
+
+  // Never destroyed, so threads still logging during exit do not reach a
+  // destroyed logger. Queued messages are written at exit.
+  static Logger& Instance();
+
+  ~Logger() = delete;
+
+  // Prevent copying.
+  Logger(Logger const&) = delete;
+  Logger& operator=(Logger const&) = delete;
+
+  void Log(LogLevel level, LogSite* site, const char* format, ...)
+      __attribute__((format(printf, 4, 5)));
+
+  // Writes all queued messages before returning.
+  void Flush();
+
+ private:
+  struct Entry;
+
+  Logger();
+
+  bool Push(LogLevel level, const LogSite* site, uint32_t suppressed,
+            const char* format, va_list args);
+  void Run();
+  // Writes queued messages; returns how many. Callers hold |drain_mutex_|.
+  size_t Drain();
+
+  std::unique_ptr<Entry[]> entries_;
+  alignas(64) std::atomic<size_t> enqueue_position_{0};
+  alignas(64) std::atomic<size_t> dequeue_position_{0};
+  std::atomic<uint64_t> dropped_{0};
+
+  // Set by the first message queued after the writer took the previous
+  // batch; only that message wakes the writer.
+  std::atomic<bool> pending_{false};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  // Serializes writers: the background thread and Flush().
+  std::mutex drain_mutex_;
+  std::thread thread_;
+};
+
+}  // namespace livekit_client_plugin
+
+#define LIVEKIT_LOG(level, ...)                                         \
+  do {                                                                  \
+    if constexpr (static_cast<int>(level) >= LIVEKIT_MIN_LOG_LEVEL) {   \
+      static ::livekit_client_plugin::LogSite livekit_log_site(__FILE__, \
+                                                               __LINE__); \
+      ::livekit_client_plugin::Logger::Instance().Log(                  \
+          level, &livekit_log_site, __VA_ARGS__);                       \
+    }                                                                   \
+  } while (0)
+
+#define LIVEKIT_LOG_VERBOSE(...) \
+  LIVEKIT_LOG(::livekit_client_plugin::LogLevel::kVerbose, __VA_ARGS__)
+#define LIVEKIT_LOG_INFO(...) \
+  LIVEKIT_LOG(::livekit_client_plugin::LogLevel::kInfo, __VA_ARGS__)
+#define LIVEKIT_LOG_WARNING(...) \
+  LIVEKIT_LOG(::livekit_client_plugin::LogLevel::kWarning, __VA_ARGS__)
+#define LIVEKIT_LOG_ERROR(...) \
+  LIVEKIT_LOG(::livekit_client_plugin::LogLevel::kError, __VA_ARGS__)
+
+#endif  // LIVEKIT_CLIENT_LINUX_LOGGER_H_
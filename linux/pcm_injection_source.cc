@@ -0,0 +1,83 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pcm_injection_source.h"
+
+#include <algorithm>
+
+namespace livekit_client_plugin {
+
+namespace {
+
+size_t FramesForMs(int sample_rate, int ms) {
+  return size_t(std::max(sample_rate, 0)) * size_t(std::max(ms, 0)) / 1000;
+}
+
+}  // namespace
+
+PcmInjectionSource::PcmInjectionSource(flutter::BinaryMessenger* messenger,
+                                       std::string channel_name,
+                                       int sample_rate,
+                                       size_t channels,
+                                       int buffer_ms,
+                                       int prebuffer_ms,
+                                       AudioFrameCallback on_frame)
+    : messenger_(messenger),
+      channel_name_(std::move(channel_name)),
+      sample_rate_(sample_rate),
+      frames_per_tick_(FramesForMs(sample_rate, AudioFrameClock::kTickMs)),
+      on_frame_(std::move(on_frame)),
+      buffer_(channels,
+              std::max(FramesForMs(sample_rate, buffer_ms), frames_per_tick_),
+              FramesForMs(sample_rate, prebuffer_ms)),
+      frame_(frames_per_tick_ * buffer_.channels()),
+      clock_(AudioFrameClock::Acquire()) {
+  messenger_->SetMessageHandler(
+      channel_name_, [this](const uint8_t* message, size_t message_size,
+                            flutter::BinaryReply reply) {
+        OnMessage(message, message_size, std::move(reply));
+      });
+  tick_id_ = clock_->Add([this] { Tick(); });
+}
+
+PcmInjectionSource::~PcmInjectionSource() {
+  messenger_->SetMessageHandler(channel_name_, nullptr);
+  clock_->Remove(tick_id_);
+}
+
+void PcmInjectionSource::OnMessage(const uint8_t* message,
+                                   size_t message_size,
+                                   flutter::BinaryReply reply) {
+  uint32_t accepted = 0;
+  if (message_size == 0) {
+    clear_requested_.store(true, std::memory_order_relaxed);
+  } else {
+    const size_t frame_size = buffer_.channels() * sizeof(int16_t);
+    accepted = static_cast<uint32_t>(
+        buffer_.Write(message, message_size / frame_size));
+  }
+  if (reply) {
+    reply(reinterpret_cast<const uint8_t*>(&accepted), sizeof(accepted));
+  }
+}
+
+void PcmInjectionSource::Tick() {
+  if (clear_requested_.exchange(false, std::memory_order_relaxed)) {
+    buffer_.Clear();
+  }
+  buffer_.Read(frame_.data(), frames_per_tick_);
+  on_frame_(frame_.data(), sample_rate_, buffer_.channels(), frames_per_tick_);
+}
+
+}  // namespace livekit_client_plugin
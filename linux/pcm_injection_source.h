@@ -0,0 +1,97 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_PCM_INJECTION_SOURCE_H_
+#define LIVEKIT_CLIENT_LINUX_PCM_INJECTION_SOURCE_H_
+
+#include <flutter/binary_messenger.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "audio_frame_clock.h"
+#include "pcm_jitter_buffer.h"
+
+namespace livekit_client_plugin {
+
+// Plays PCM pushed from Dart into an audio source on the native clock.
+//
+// Dart sends interleaved native-endian int16 PCM as raw bytes on
+// |channel_name| (a BasicMessageChannel with a BinaryCodec); each message is
+// answered with the uint32 number of frames that fit into the jitter buffer,
+// so the app can apply backpressure, and an empty message drops everything
+// queued, e.g. when speech is interrupted. Every tick of the AudioFrameClock
+// takes exactly 10 ms from the buffer and hands them to |on_frame|, playing
+// concealment and silence when Dart falls behind, so delivery neither
+// involves Dart nor depends on when its messages arrive. |sample_rate| must
+// be a multiple of 100 for frames to be exactly 10 ms.
+//
+// Independent of libwebrtc: the plugin forwards frames to a custom
+// RTCAudioSource.
+class PcmInjectionSource {
+ public:
+  // Buffer sizes used when a request leaves them out, the defaults of
+  // PcmAudioSource.create() in Dart.
+  static constexpr int kDefaultBufferMs = 2000;
+  static constexpr int kDefaultPrebufferMs = 60;
+
+  // Must be created and destroyed on the main thread, which |messenger|
+  // belongs to. |on_frame| is called on the clock thread.
+  PcmInjectionSource(flutter::BinaryMessenger* messenger,
+                     std::string channel_name,
+                     int sample_rate,
+                     size_t channels,
+                     int buffer_ms,
+                     int prebuffer_ms,
+                     AudioFrameCallback on_frame);
+  ~PcmInjectionSource();
+
+  // Prevent copying.
+  PcmInjectionSource(PcmInjectionSource const&) = delete;
+  PcmInjectionSource& operator=(PcmInjectionSource const&) = delete;
+
+  const std::string& channel_name() const { return channel_name_; }
+
+  // May be called from any thread.
+  PcmJitterBuffer::Stats GetStats() const { return buffer_.GetStats(); }
+
+ private:
+  // Main thread; the only producer of |buffer_|.
+  void OnMessage(const uint8_t* message,
+                 size_t message_size,
+                 flutter::BinaryReply reply);
+
+  // Clock thread; the only consumer of |buffer_|.
+  void Tick();
+
+  flutter::BinaryMessenger* messenger_;
+  const std::string channel_name_;
+  const int sample_rate_;
+  const size_t frames_per_tick_;
+  AudioFrameCallback on_frame_;
+  PcmJitterBuffer buffer_;
+  std::atomic<bool> clear_requested_{false};
+  // Clock thread only.
+  std::vector<int16_t> frame_;
+  std::shared_ptr<AudioFrameClock> clock_;
+  int tick_id_ = 0;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_PCM_INJECTION_SOURCE_H_
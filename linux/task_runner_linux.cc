@@ -28,4 +28,16 @@ void TaskRunnerLinux::EnqueueTask(TaskClosure task) {
   }
 }
 
+void TaskRunnerLinux::EnqueueDelayedTask(TaskClosure task,
+                                         unsigned int delay_ms) {
+  g_timeout_add_full(
+      G_PRIORITY_DEFAULT, delay_ms,
+      [](gpointer user_data) -> gboolean {
+        (*static_cast<TaskClosure*>(user_data))();
+        return G_SOURCE_REMOVE;
+      },
+      new TaskClosure(std::move(task)),
+      [](gpointer user_data) { delete static_cast<TaskClosure*>(user_data); });
+}
+
 }  // namespace livekit_client_plugin
@@ -18,6 +18,10 @@ class TaskRunnerLinux {
   // TaskRunner implementation.
   void EnqueueTask(TaskClosure task);
 
+  // Runs |task| on the main loop after |delay_ms|. The task does not
+  // reference the runner, so it may outlive it.
+  void EnqueueDelayedTask(TaskClosure task, unsigned int delay_ms);
+
  private:
   std::mutex tasks_mutex_;
   std::queue<TaskClosure> tasks_;
@@ -0,0 +1,1419 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Correctness tests for the shared_cpp analysis code measured by
+// benchmark/dsp_benchmark.cc. Build the example app with include_livekit_tests
+// set and run, for instance:
+// $ build/linux/x64/debug/plugins/livekit_client/livekit_dsp_test
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_replay_buffer.h"
+#include "audio_source_stats.h"
+#include "band_envelope.h"
+#include "echo_leak_detector.h"
+#include "fft_processor.h"
+#include "fixed_point_fft.h"
+#include "flutter/byte_buffer_streams.h"
+#include "latest_bands.h"
+#include "livekit_codec.h"
+#include "pcm_jitter_buffer.h"
+#include "sliding_dft.h"
+#include "talk_stats.h"
+#include "utterance_segmenter.h"
+#include "video_quality_analyzer.h"
+#include "visualizer_shadow.h"
+#include "wav_playback.h"
+#include "yuv_scaler.h"
+#include "zlib_stream.h"
+
+namespace livekit_client_plugin {
+namespace test {
+namespace {
+
+constexpr int kSampleRate = 48000;
+
+// Sum of partials with the given amplitudes (full scale is 1) and
+// frequencies, as int16.
+std::vector<int16_t> MakeTones(size_t frames,
+                               const std::vector<double>& amplitudes,
+                               const std::vector<double>& frequencies) {
+  std::vector<int16_t> samples(frames);
+  for (size_t i = 0; i < frames; ++i) {
+    double t = static_cast<double>(i) / kSampleRate;
+    double value = 0;
+    for (size_t p = 0; p < amplitudes.size(); ++p) {
+      value += amplitudes[p] * std::sin(2 * M_PI * frequencies[p] * t);
+    }
+    samples[i] = static_cast<int16_t>(std::lround(value * 32767));
+  }
+  return samples;
+}
+
+TEST(FixedPointFFTProcessor, MatchesFloatProcessor) {
+  for (unsigned fft_size : {512u, 2048u}) {
+    std::vector<int16_t> input =
+        MakeTones(fft_size, {0.5, 0.1, 0.01}, {440.0, 2500.0, 9000.0});
+    FFTProcessor reference(fft_size);
+    FixedPointFFTProcessor processor(fft_size);
+    reference.WriteInput(input.data(), fft_size);
+    processor.WriteInput(input.data(), fft_size);
+
+    std::vector<float> expected_db(fft_size / 2);
+    std::vector<int32_t> log2s(fft_size / 2);
+    reference.GetFloatFrequencyData(expected_db, 1);
+    processor.GetLog2FrequencyData(log2s, 1);
+
+    // Only bins well above the Q15 rounding noise are comparable; the
+    // magnitude and log2 approximations stay within about 0.35 dB there.
+    size_t compared = 0;
+    for (size_t k = 0; k < fft_size / 2; ++k) {
+      if (expected_db[k] < -80) {
+        continue;
+      }
+      EXPECT_NEAR(FixedPointFFTProcessor::Log2ToDecibels(log2s[k]),
+                  expected_db[k], 0.5)
+          << "fft_size " << fft_size << " bin " << k;
+      ++compared;
+    }
+    EXPECT_GT(compared, 10u) << "fft_size " << fft_size;
+  }
+}
+
+TEST(FixedPointFFTProcessor, ReportsSilence) {
+  std::vector<int16_t> input(512, 0);
+  FixedPointFFTProcessor processor(512);
+  processor.WriteInput(input.data(), input.size());
+  std::vector<int32_t> log2s(256);
+  processor.GetLog2FrequencyData(log2s, 1);
+  for (int32_t value : log2s) {
+    EXPECT_EQ(value, FixedPointFFTProcessor::kSilenceLog2);
+  }
+}
+
+TEST(SlidingDFTBank, MatchesDirectDFT) {
+  constexpr unsigned kWindowSize = 480;
+  std::vector<int16_t> input =
+      MakeTones(kSampleRate, {0.25, 0.1, 0.02}, {1000.0, 3000.0, 1730.0});
+  SlidingDFTBank bank({0.0f, 130.0f, 1000.0f, 1500.0f, 1700.0f, 3000.0f},
+                      kSampleRate, kWindowSize);
+  bank.Process(input.data(), input.size());
+  std::vector<float> amplitudes(bank.size());
+  bank.GetAmplitudes(amplitudes.data());
+
+  // The damped DFT of the last window, with GetAmplitudes()' normalization.
+  const double r = SlidingDFTBank::kDampingFactor;
+  const double scale =
+      2.0 * (1.0 - r) / (1.0 - std::pow(r, static_cast<double>(kWindowSize)));
+  for (size_t k = 0; k < bank.size(); ++k) {
+    const double w = 2 * M_PI * bank.BinFrequency(k) / kSampleRate;
+    std::complex<double> sum = 0;
+    for (unsigned m = 0; m < kWindowSize; ++m) {
+      double x = input[input.size() - 1 - m] / 32768.0;
+      sum += std::polar(std::pow(r, static_cast<double>(m)), w * m) * x;
+    }
+    double expected = std::abs(sum) * scale;
+    if (bank.BinFrequency(k) == 0) {
+      expected *= 0.5;
+    }
+    EXPECT_NEAR(amplitudes[k], expected, 1e-4)
+        << "bin " << k << " at " << bank.BinFrequency(k) << " Hz";
+  }
+}
+
+TEST(SlidingDFTBank, SnapsAndReadsOnBinTones) {
+  SlidingDFTBank bank({130.0f, 1000.0f, 1500.0f}, kSampleRate, 480);
+  EXPECT_EQ(bank.BinFrequency(0), 100.0f);
+  EXPECT_EQ(bank.BinFrequency(1), 1000.0f);
+
+  std::vector<int16_t> input = MakeTones(kSampleRate / 2, {0.5}, {1000.0});
+  bank.Process(input.data(), input.size());
+  float decibels[3];
+  bank.GetDecibels(decibels);
+  EXPECT_NEAR(decibels[1], 20 * std::log10(0.5), 0.05);
+  // Other bins sit on zeros of the rectangular window's response.
+  EXPECT_LT(decibels[0], -60);
+  EXPECT_LT(decibels[2], -60);
+
+  bank.Reset();
+  bank.GetDecibels(decibels, -90.0f);
+  EXPECT_EQ(decibels[1], -90.0f);
+}
+
+// Gaussian noise at |rms| of full scale, as int16.
+std::vector<int16_t> MakeNoise(size_t frames, double rms, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::normal_distribution<double> distribution(0, rms * 32767);
+  std::vector<int16_t> samples(frames);
+  for (int16_t& sample : samples) {
+    sample = static_cast<int16_t>(
+        std::max(-32768.0, std::min(32767.0, distribution(generator))));
+  }
+  return samples;
+}
+
+// Feeds |reference| and |capture| to |detector| in 10 ms callbacks, the
+// reference first as the audio device does. Returns the alerts with the
+// capture frame at which each was raised.
+std::vector<std::pair<size_t, EchoLeakDetector::Alert>> RunEchoDetector(
+    EchoLeakDetector* detector,
+    const std::vector<int16_t>& reference,
+    const std::vector<int16_t>& capture) {
+  constexpr size_t kFrames = kSampleRate / 100;
+  std::vector<std::pair<size_t, EchoLeakDetector::Alert>> alerts;
+  for (size_t done = 0; done + kFrames <= capture.size(); done += kFrames) {
+    detector->ProcessReference(0, reference.data() + done, kFrames,
+                               kSampleRate, 1);
+    EchoLeakDetector::Alert alert;
+    if (detector->ProcessCapture(capture.data() + done, kFrames, kSampleRate,
+                                 1, &alert)) {
+      alerts.emplace_back(done + kFrames, alert);
+    }
+  }
+  return alerts;
+}
+
+TEST(EchoLeakDetector, ReportsDelayAndCouplingThenClears) {
+  constexpr size_t kEchoFrames = 5 * kSampleRate;
+  constexpr size_t kTotalFrames = 8 * kSampleRate;
+  constexpr size_t kDelayFrames = kSampleRate * 120 / 1000;
+  constexpr double kGain = 0.25;  // -12 dB
+  std::vector<int16_t> reference = MakeNoise(kTotalFrames, 0.2, 1);
+  std::vector<int16_t> capture = MakeNoise(kTotalFrames, 0.002, 2);
+  for (size_t i = kDelayFrames; i < kEchoFrames; ++i) {
+    const long echo = std::lround(kGain * reference[i - kDelayFrames]);
+    capture[i] = static_cast<int16_t>(capture[i] + echo);
+  }
+  // Then the local side talks over a silent speaker path.
+  std::vector<int16_t> talk = MakeNoise(kTotalFrames - kEchoFrames, 0.1, 3);
+  std::copy(talk.begin(), talk.end(), capture.begin() + kEchoFrames);
+
+  EchoLeakDetector detector(1);
+  auto alerts = RunEchoDetector(&detector, reference, capture);
+  ASSERT_EQ(alerts.size(), 2u);
+
+  const EchoLeakDetector::Alert& detected = alerts[0].second;
+  EXPECT_TRUE(detected.echo_detected);
+  EXPECT_EQ(detected.reference_index, 0u);
+  EXPECT_NEAR(detected.delay_ms, 120.0f, 1.0f);
+  EXPECT_NEAR(detected.coupling_db, 20 * std::log10(kGain), 1.0);
+  EXPECT_GE(detected.coherence, EchoLeakDetector::kDefaultCoherenceThreshold);
+  EXPECT_LT(alerts[0].first, kEchoFrames);
+
+  // Cleared after kConfirmations analyses without echo, the first of which
+  // may still see some of it in its window.
+  const EchoLeakDetector::Alert& cleared = alerts[1].second;
+  EXPECT_FALSE(cleared.echo_detected);
+  constexpr size_t kHopFrames = kSampleRate /
+                                EchoLeakDetector::kAnalysisSampleRate *
+                                EchoLeakDetector::kHopSize;
+  constexpr size_t kWindowFrames = kSampleRate /
+                                   EchoLeakDetector::kAnalysisSampleRate *
+                                   EchoLeakDetector::kCaptureWindow;
+  EXPECT_GE(alerts[1].first,
+            kEchoFrames + (EchoLeakDetector::kConfirmations - 1) * kHopFrames);
+  EXPECT_LE(alerts[1].first, kEchoFrames + kWindowFrames +
+                                 EchoLeakDetector::kConfirmations * kHopFrames);
+  EXPECT_FALSE(detector.echo_detected());
+}
+
+TEST(EchoLeakDetector, IgnoresUncorrelatedCapture) {
+  constexpr size_t kFrames = 6 * kSampleRate;
+  EchoLeakDetector detector(1);
+  auto alerts = RunEchoDetector(&detector, MakeNoise(kFrames, 0.2, 4),
+                                MakeNoise(kFrames, 0.1, 5));
+  EXPECT_TRUE(alerts.empty());
+  EXPECT_FALSE(detector.echo_detected());
+}
+
+uint64_t ReferenceSumOfSquares(const int16_t* samples, size_t size) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += static_cast<uint64_t>(int64_t(samples[i]) * samples[i]);
+  }
+  return sum;
+}
+
+TEST(SumOfSquaresS16, MatchesScalarAtEveryLengthAndOffset) {
+  std::vector<int16_t> samples = MakeNoise(100, 0.5, 6);
+  samples[7] = -32768;
+  samples[8] = -32768;
+  samples[40] = 32767;
+  for (size_t offset = 0; offset < 4; ++offset) {
+    for (size_t size = 0; size + offset <= 70; ++size) {
+      EXPECT_EQ(SumOfSquaresS16(samples.data() + offset, size),
+                ReferenceSumOfSquares(samples.data() + offset, size))
+          << "offset " << offset << " size " << size;
+    }
+  }
+  // Pairs of -32768 overflow a signed 32-bit lane.
+  std::vector<int16_t> loudest(4099, -32768);
+  EXPECT_EQ(SumOfSquaresS16(loudest.data(), loudest.size()),
+            uint64_t(4099) << 30);
+}
+
+TEST(AudioSourceStatsAccumulator, LevelAndEnergyOfOddLengthCallbacks) {
+  constexpr int kRate = 44100;
+  constexpr size_t kFrames = kRate / 100;  // 441
+  constexpr size_t kCallbacks = 25;
+  std::vector<int16_t> audio = MakeNoise(kFrames * kCallbacks * 2, 0.3, 7);
+  AudioSourceStatsAccumulator stats;
+  double energy = 0;
+  uint64_t window_sum = 0;
+  for (size_t i = 0; i < kCallbacks; ++i) {
+    const int16_t* data = audio.data() + i * kFrames * 2;
+    stats.Process(data, kFrames, kRate, 2);
+    const uint64_t sum = ReferenceSumOfSquares(data, kFrames * 2);
+    energy += sum / (kFrames * 2 * 32768.0 * 32768.0) * kFrames / kRate;
+    // The last complete window is the last 10 callbacks of the first 20.
+    if (i >= 10 && i < 20) {
+      window_sum += sum;
+    }
+  }
+  AudioSourceStatsAccumulator::Snapshot snapshot = stats.GetSnapshot();
+  EXPECT_NEAR(snapshot.total_duration, kCallbacks * 0.01, 1e-9);
+  EXPECT_NEAR(snapshot.total_audio_energy, energy, 1e-9);
+  EXPECT_NEAR(snapshot.audio_level,
+              std::sqrt(window_sum / (10 * kFrames * 2 * 32768.0 * 32768.0)),
+              1e-9);
+  EXPECT_NEAR(snapshot.audio_level, 0.3, 0.01);
+}
+
+TEST(LatestBandsRegistry, ReadersNeverSeeTornFrames) {
+  constexpr uint32_t kFrames = 200000;
+  constexpr size_t kBands = LatestBandsRegistry::kMaxBands;
+  LatestBandsRegistry& registry = LatestBandsRegistry::Instance();
+  std::shared_ptr<LatestBandsRegistry::Slot> slot =
+      registry.Acquire("torn-frames");
+
+  // Frame n holds 1 + n % kBands copies of n, so a mix of two frames shows
+  // in either the values or the count.
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0};
+  std::atomic<int> reads{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; ++r) {
+    readers.emplace_back([&]() {
+      float bands[kBands];
+      uint64_t last_version = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        size_t count = 0;
+        uint64_t version = 0;
+        if (!registry.Read("torn-frames", bands, kBands, &count, &version) ||
+            version == 0) {
+          continue;
+        }
+        bool whole = version >= last_version &&
+                     count == 1 + version % kBands &&
+                     std::all_of(bands, bands + count, [&](float band) {
+                       return band == static_cast<float>(version);
+                     });
+        if (!whole) {
+          ++torn;
+        }
+        last_version = version;
+        ++reads;
+      }
+    });
+  }
+  std::vector<float> frame(kBands);
+  for (uint32_t n = 1; n <= kFrames; ++n) {
+    std::fill(frame.begin(), frame.end(), static_cast<float>(n));
+    slot->Publish(frame.data(), 1 + n % kBands);
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_GT(reads.load(), 0);
+  EXPECT_EQ(torn.load(), 0);
+
+  float bands[kBands];
+  size_t count = 0;
+  uint64_t version = 0;
+  ASSERT_TRUE(registry.Read("torn-frames", bands, kBands, &count, &version));
+  EXPECT_EQ(version, kFrames);
+  registry.Release("torn-frames", slot);
+  EXPECT_FALSE(slot);
+  EXPECT_FALSE(registry.Read("torn-frames", bands, kBands, &count, &version));
+}
+
+// Luma plane with padded rows, a diagonal ramp moved by |shift| pixels.
+std::vector<uint8_t> MakeLuma(int width, int height, int stride, int shift) {
+  std::vector<uint8_t> luma(size_t(stride) * height, 0);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      luma[size_t(y) * stride + x] = static_cast<uint8_t>((x + y + shift) * 3);
+    }
+  }
+  return luma;
+}
+
+TEST(VideoQualityAnalyzer, ReportsFrozenPictureAndRecovers) {
+  constexpr int kWidth = 320;
+  constexpr int kHeight = 180;
+  constexpr int kStride = 336;
+  constexpr int kFps = 30;
+  VideoQualityAnalyzer analyzer;
+  std::vector<VideoQualityAnalyzer::Report> moving;
+  std::vector<VideoQualityAnalyzer::Report> still;
+  std::vector<VideoQualityAnalyzer::Report> resumed;
+  const std::vector<uint8_t> frozen_frame =
+      MakeLuma(kWidth, kHeight, kStride, 0);
+  for (int n = 0; n < 9 * kFps; ++n) {
+    const int second = n / kFps;
+    std::vector<uint8_t> frame =
+        second >= 3 && second < 6 ? frozen_frame
+                                  : MakeLuma(kWidth, kHeight, kStride, n * 7);
+    VideoQualityAnalyzer::Report report;
+    if (analyzer.Process(frame.data(), kWidth, kHeight, kStride,
+                         double(n) / kFps, &report)) {
+      (second < 3 ? moving : second < 6 ? still : resumed).push_back(report);
+    }
+  }
+  ASSERT_FALSE(moving.empty());
+  ASSERT_EQ(still.size(), 3u);
+  ASSERT_FALSE(resumed.empty());
+  for (const auto& report : moving) {
+    EXPECT_EQ(report.width, kWidth);
+    EXPECT_EQ(report.height, kHeight);
+    EXPECT_NEAR(report.frame_rate, kFps, 1.0f);
+    EXPECT_GT(report.frame_difference,
+              VideoQualityAnalyzer::kFrozenDifference);
+    EXPECT_FALSE(report.frozen);
+  }
+  // Frozen once the picture stood still for kFrozenSeconds, and no longer
+  // after the first analysis of a moving picture.
+  EXPECT_FALSE(still.front().frozen);
+  EXPECT_TRUE(still.back().frozen);
+  EXPECT_EQ(still.back().frame_difference, 0.0f);
+  EXPECT_FALSE(resumed.back().frozen);
+}
+
+TEST(VideoQualityAnalyzer, SummarizesAFlatFrame) {
+  constexpr int kWidth = 641;  // Subsampled with a step of 5.
+  constexpr int kHeight = 9;
+  std::vector<uint8_t> luma(kWidth * kHeight, 128);
+  VideoQualityAnalyzer analyzer(0.25, 1.0);
+  VideoQualityAnalyzer::Report report;
+  ASSERT_FALSE(
+      analyzer.Process(luma.data(), kWidth, kHeight, kWidth, 0.0, &report));
+  ASSERT_TRUE(
+      analyzer.Process(luma.data(), kWidth, kHeight, kWidth, 1.0, &report));
+  EXPECT_NEAR(report.mean_luma, 128.0f / 255, 1e-6f);
+  EXPECT_EQ(report.contrast, 0.0f);
+  EXPECT_EQ(report.blur_score, 0.0f);
+  EXPECT_EQ(report.frame_difference, 0.0f);
+  EXPECT_EQ(report.histogram[128 * VideoQualityAnalyzer::kHistogramBins / 256],
+            1.0f);
+}
+
+// An I420 frame with planes of odd size rounded up, as WebRTC allocates
+// them.
+struct I420Frame {
+  I420Frame(int width, int height)
+      : width(width),
+        height(height),
+        chroma_width((width + 1) / 2),
+        chroma_height((height + 1) / 2),
+        y(size_t(width) * height),
+        u(size_t(chroma_width) * chroma_height),
+        v(size_t(chroma_width) * chroma_height) {}
+
+  int width;
+  int height;
+  int chroma_width;
+  int chroma_height;
+  std::vector<uint8_t> y;
+  std::vector<uint8_t> u;
+  std::vector<uint8_t> v;
+};
+
+// BT.601 limited range conversion of one pixel, in double precision.
+std::array<int, 3> ReferenceRGB(double y, double u, double v) {
+  const double luma = 1.164 * (y - 16);
+  const double red = luma + 1.596 * (v - 128);
+  const double green = luma - 0.392 * (u - 128) - 0.813 * (v - 128);
+  const double blue = luma + 2.017 * (u - 128);
+  auto channel = [](double value) {
+    return static_cast<int>(std::lround(std::min(std::max(value, 0.0), 255.0)));
+  };
+  return {channel(red), channel(green), channel(blue)};
+}
+
+// Converts |frame| to |width| x |height| RGBA with padded rows, checking
+// that the padding is left alone.
+std::vector<uint8_t> ScaleFrame(const I420Frame& frame, int width, int height) {
+  const int stride = width * 4 + 12;
+  std::vector<uint8_t> rgba(size_t(stride) * height, 0xab);
+  I420ToRGBAScaler scaler(width, height);
+  scaler.Convert(frame.y.data(), frame.width, frame.u.data(),
+                 frame.chroma_width, frame.v.data(), frame.chroma_width,
+                 frame.width, frame.height, rgba.data(), stride);
+  std::vector<uint8_t> pixels;
+  for (int row = 0; row < height; ++row) {
+    const uint8_t* begin = rgba.data() + size_t(row) * stride;
+    pixels.insert(pixels.end(), begin, begin + width * 4);
+    EXPECT_TRUE(std::all_of(begin + width * 4, begin + stride,
+                            [](uint8_t byte) { return byte == 0xab; }));
+  }
+  return pixels;
+}
+
+TEST(I420ToRGBAScaler, AveragesBoxesOfAnOddSizedCheckerboard) {
+  // 9:1 in both directions, to a width that leaves a tail after the vector
+  // loop.
+  constexpr int kScale = 9;
+  constexpr int kWidth = 37;
+  constexpr int kHeight = 21;
+  I420Frame frame(kWidth * kScale, kHeight * kScale);
+  for (int y = 0; y < frame.height; ++y) {
+    for (int x = 0; x < frame.width; ++x) {
+      frame.y[size_t(y) * frame.width + x] = (x / 2 + y / 2) % 2 ? 200 : 40;
+    }
+  }
+  for (int y = 0; y < frame.chroma_height; ++y) {
+    for (int x = 0; x < frame.chroma_width; ++x) {
+      frame.u[size_t(y) * frame.chroma_width + x] = 60 + x * 3 % 130;
+      frame.v[size_t(y) * frame.chroma_width + x] = 60 + (y * 5 + x) % 130;
+    }
+  }
+  std::vector<uint8_t> pixels = ScaleFrame(frame, kWidth, kHeight);
+
+  auto average = [](const std::vector<uint8_t>& plane, int stride, int left,
+                    int top, int columns, int rows) {
+    double sum = 0;
+    for (int y = top; y < top + rows; ++y) {
+      for (int x = left; x < left + columns; ++x) {
+        sum += plane[size_t(y) * stride + x];
+      }
+    }
+    return sum / (columns * rows);
+  };
+  // Chroma pixels overlapping the luma box [begin, begin + kScale).
+  auto chroma_box = [](int begin, int* chroma_begin) {
+    *chroma_begin = begin / 2;
+    return (begin + kScale - 1) / 2 - begin / 2 + 1;
+  };
+  for (int row = 0; row < kHeight; ++row) {
+    for (int column = 0; column < kWidth; ++column) {
+      int chroma_left = 0;
+      int chroma_top = 0;
+      const int chroma_columns = chroma_box(column * kScale, &chroma_left);
+      const int chroma_rows = chroma_box(row * kScale, &chroma_top);
+      std::array<int, 3> expected = ReferenceRGB(
+          average(frame.y, frame.width, column * kScale, row * kScale, kScale,
+                  kScale),
+          average(frame.u, frame.chroma_width, chroma_left, chroma_top,
+                  chroma_columns, chroma_rows),
+          average(frame.v, frame.chroma_width, chroma_left, chroma_top,
+                  chroma_columns, chroma_rows));
+      const uint8_t* pixel = &pixels[(size_t(row) * kWidth + column) * 4];
+      for (int channel = 0; channel < 3; ++channel) {
+        EXPECT_NEAR(pixel[channel], expected[channel], 1)
+            << "row " << row << " column " << column << " channel "
+            << channel;
+      }
+      EXPECT_EQ(pixel[3], 255);
+    }
+  }
+}
+
+TEST(I420ToRGBAScaler, KeepsAFlatColorAtAnyRatio) {
+  // Odd source, cropped to the destination's aspect ratio, down and up.
+  I420Frame frame(333, 187);
+  std::fill(frame.y.begin(), frame.y.end(), 81);
+  std::fill(frame.u.begin(), frame.u.end(), 90);
+  std::fill(frame.v.begin(), frame.v.end(), 240);
+  const std::array<int, 3> expected = ReferenceRGB(81, 90, 240);
+  for (const auto& size : {std::make_pair(50, 29), std::make_pair(7, 13),
+                           std::make_pair(401, 3)}) {
+    std::vector<uint8_t> pixels = ScaleFrame(frame, size.first, size.second);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+      for (int channel = 0; channel < 3; ++channel) {
+        EXPECT_NEAR(pixels[i + channel], expected[channel], 1) << i;
+      }
+    }
+  }
+}
+
+flutter::EncodableValue RoundTrip(const flutter::EncodableValue& value,
+                                  std::vector<uint8_t>* buffer) {
+  const LiveKitCodecSerializer& serializer =
+      LiveKitCodecSerializer::GetInstance();
+  flutter::ByteBufferStreamWriter writer(buffer);
+  serializer.WriteValue(value, &writer);
+  flutter::ByteBufferStreamReader reader(buffer->data(), buffer->size());
+  return serializer.ReadValue(&reader);
+}
+
+const BandFrame* AsBandFrame(const flutter::EncodableValue& value) {
+  const auto* custom = std::get_if<flutter::CustomEncodableValue>(&value);
+  return custom ? std::any_cast<BandFrame>(&static_cast<const std::any&>(
+                      *custom))
+                : nullptr;
+}
+
+TEST(LiveKitCodec, BandFrameLayout) {
+  BandFrame frame;
+  frame.timestamp_us = 1234567;
+  frame.sequence = 42;
+  frame.sample_rate = 48000;
+  frame.bands = {0.25f, -1.5f};
+  std::vector<uint8_t> buffer;
+  flutter::EncodableValue decoded =
+      RoundTrip(flutter::CustomEncodableValue(frame), &buffer);
+
+  // Type, size, int64, uint32, int32, bands aligned to 4, peak size aligned
+  // to 4; the Dart reader relies on this layout.
+  ASSERT_EQ(buffer.size(), 32u);
+  EXPECT_EQ(buffer[0], BandFrame::kType);
+  EXPECT_EQ(buffer[1], 2);
+  float bands[2];
+  std::memcpy(bands, &buffer[20], sizeof(bands));
+  EXPECT_EQ(bands[0], 0.25f);
+  EXPECT_EQ(bands[1], -1.5f);
+  EXPECT_EQ(buffer[28], 0);
+
+  const BandFrame* result = AsBandFrame(decoded);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->timestamp_us, frame.timestamp_us);
+  EXPECT_EQ(result->sequence, frame.sequence);
+  EXPECT_EQ(result->sample_rate, frame.sample_rate);
+  EXPECT_EQ(result->bands, frame.bands);
+  EXPECT_TRUE(result->peaks.empty());
+}
+
+TEST(LiveKitCodec, BandFrameRoundTripsInsideStandardValues) {
+  BandFrame frame;
+  frame.sequence = 0xfffffffe;
+  frame.bands.assign(300, 0.5f);
+  frame.peaks.assign(300, 0.75f);
+  BandFrame empty;
+  flutter::EncodableList list = {
+      flutter::EncodableValue("bands"),
+      flutter::EncodableValue(flutter::CustomEncodableValue(frame)),
+      flutter::EncodableValue(flutter::CustomEncodableValue(empty)),
+      flutter::EncodableValue(int32_t{7}),
+  };
+  std::vector<uint8_t> buffer;
+  flutter::EncodableValue decoded =
+      RoundTrip(flutter::EncodableValue(list), &buffer);
+
+  const auto* result = std::get_if<flutter::EncodableList>(&decoded);
+  ASSERT_NE(result, nullptr);
+  ASSERT_EQ(result->size(), 4u);
+  EXPECT_EQ((*result)[0], flutter::EncodableValue("bands"));
+  const BandFrame* first = AsBandFrame((*result)[1]);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->sequence, frame.sequence);
+  EXPECT_EQ(first->bands, frame.bands);
+  EXPECT_EQ(first->peaks, frame.peaks);
+  const BandFrame* second = AsBandFrame((*result)[2]);
+  ASSERT_NE(second, nullptr);
+  EXPECT_TRUE(second->bands.empty());
+  EXPECT_TRUE(second->peaks.empty());
+  EXPECT_EQ((*result)[3], flutter::EncodableValue(int32_t{7}));
+}
+
+TEST(LiveKitCodec, TruncatedBandFrameStaysInBounds) {
+  BandFrame frame;
+  frame.sequence = 3;
+  frame.bands.assign(64, 0.5f);
+  std::vector<uint8_t> buffer;
+  RoundTrip(flutter::CustomEncodableValue(frame), &buffer);
+  for (size_t size = 1; size < buffer.size(); size += 7) {
+    flutter::ByteBufferStreamReader reader(buffer.data(), size);
+    flutter::EncodableValue decoded =
+        LiveKitCodecSerializer::GetInstance().ReadValue(&reader);
+    EXPECT_NE(AsBandFrame(decoded), nullptr) << "size " << size;
+  }
+}
+
+// Runs |input| through |stream| with |flush|, draining the output in
+// pieces of at most |chunk| bytes into |pieces|. Returns false on an error.
+bool Drain(ZlibStream* stream,
+           const std::vector<uint8_t>& input,
+           ZlibStream::Flush flush,
+           size_t chunk,
+           std::vector<std::vector<uint8_t>>* pieces) {
+  size_t offset = 0;
+  while (true) {
+    std::vector<uint8_t> piece(chunk);
+    size_t consumed = 0;
+    int64_t written =
+        stream->Process(input.data() + offset, input.size() - offset,
+                        &consumed, piece.data(), piece.size(), flush);
+    if (written < 0) {
+      return false;
+    }
+    offset += consumed;
+    piece.resize(static_cast<size_t>(written));
+    if (!piece.empty()) {
+      pieces->push_back(std::move(piece));
+    }
+    if (static_cast<size_t>(written) < chunk && offset == input.size()) {
+      return true;
+    }
+  }
+}
+
+// Joins |pieces| from |first| up to, not including, |last|.
+std::vector<uint8_t> Concatenate(
+    const std::vector<std::vector<uint8_t>>& pieces,
+    size_t first,
+    size_t last) {
+  std::vector<uint8_t> bytes;
+  for (size_t i = first; i < last; ++i) {
+    bytes.insert(bytes.end(), pieces[i].begin(), pieces[i].end());
+  }
+  return bytes;
+}
+
+TEST(ZlibStream, RoundTripsInChunkSizedPieces) {
+  constexpr size_t kChunk = 256;
+  // Repetitive enough to compress, varied enough to need several chunks.
+  std::vector<uint8_t> first(20000);
+  std::vector<uint8_t> second(30000);
+  for (size_t i = 0; i < first.size(); ++i) {
+    first[i] = static_cast<uint8_t>((i * i) % 251 / 8);
+  }
+  for (size_t i = 0; i < second.size(); ++i) {
+    second[i] = static_cast<uint8_t>((i * 7) % 253 / 4);
+  }
+
+  ZlibStream deflater(ZlibStream::Mode::kDeflate, Z_DEFAULT_COMPRESSION);
+  ASSERT_TRUE(deflater.ok());
+  std::vector<std::vector<uint8_t>> pieces;
+  ASSERT_TRUE(
+      Drain(&deflater, first, ZlibStream::Flush::kSync, kChunk, &pieces));
+  const size_t synced_pieces = pieces.size();
+  ASSERT_TRUE(
+      Drain(&deflater, second, ZlibStream::Flush::kFinish, kChunk, &pieces));
+  ASSERT_GT(synced_pieces, 1u);
+  ASSERT_GT(pieces.size(), synced_pieces + 1);
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    // Only the last piece of each flush may be short.
+    if (i + 1 != synced_pieces && i + 1 != pieces.size()) {
+      EXPECT_EQ(pieces[i].size(), kChunk) << i;
+    }
+  }
+
+  // Everything up to the sync flush decodes on its own.
+  ZlibStream inflater(ZlibStream::Mode::kInflate, 0);
+  ASSERT_TRUE(inflater.ok());
+  std::vector<std::vector<uint8_t>> decoded;
+  std::vector<uint8_t> compressed = Concatenate(pieces, 0, synced_pieces);
+  ASSERT_TRUE(
+      Drain(&inflater, compressed, ZlibStream::Flush::kNone, kChunk, &decoded));
+  EXPECT_EQ(Concatenate(decoded, 0, decoded.size()), first);
+
+  compressed = Concatenate(pieces, synced_pieces, pieces.size());
+  ASSERT_TRUE(
+      Drain(&inflater, compressed, ZlibStream::Flush::kNone, kChunk, &decoded));
+  std::vector<uint8_t> expected = first;
+  expected.insert(expected.end(), second.begin(), second.end());
+  EXPECT_EQ(Concatenate(decoded, 0, decoded.size()), expected);
+
+  // Nothing may follow the end of the stream.
+  size_t consumed = 0;
+  uint8_t output[kChunk];
+  EXPECT_EQ(inflater.Process(expected.data(), 1, &consumed, output, kChunk,
+                             ZlibStream::Flush::kNone),
+            -1);
+}
+
+TEST(ZlibStream, RejectsCorruptInput) {
+  ZlibStream deflater(ZlibStream::Mode::kDeflate, 6);
+  std::vector<uint8_t> input(1000, 'a');
+  std::vector<std::vector<uint8_t>> pieces;
+  ASSERT_TRUE(
+      Drain(&deflater, input, ZlibStream::Flush::kFinish, 4096, &pieces));
+  std::vector<uint8_t> compressed = Concatenate(pieces, 0, pieces.size());
+  // Break the header check bits.
+  compressed[1] ^= 0x01;
+
+  ZlibStream inflater(ZlibStream::Mode::kInflate, 0);
+  std::vector<uint8_t> output(4096);
+  size_t consumed = 0;
+  EXPECT_EQ(inflater.Process(compressed.data(), compressed.size(), &consumed,
+                             output.data(), output.size(),
+                             ZlibStream::Flush::kNone),
+            -1);
+}
+
+// Advances |envelope| towards |target| for |seconds| in steps of |step|.
+void Advance(BandEnvelope* envelope, float target, double seconds,
+             double step) {
+  for (double done = 0; done + step / 2 < seconds; done += step) {
+    envelope->Process(&target, 1, step);
+  }
+}
+
+TEST(BandEnvelope, AttacksAndReleasesWithTheirTimeConstants) {
+  BandEnvelope::Options options;
+  options.attack_ms = 20;
+  options.release_ms = 250;
+  BandEnvelope envelope(options);
+  Advance(&envelope, 0.0f, 0.1, 0.01);
+  ASSERT_EQ(envelope.values().size(), 1u);
+  EXPECT_EQ(envelope.values()[0], 0.0f);
+
+  // One time constant covers 1 - 1/e of a step, whatever the frame rate.
+  Advance(&envelope, 1.0f, 0.02, 0.005);
+  EXPECT_NEAR(envelope.values()[0], 1 - std::exp(-1.0), 1e-5);
+  Advance(&envelope, 1.0f, 0.1, 1.0 / 60);
+  EXPECT_NEAR(envelope.values()[0], 1 - std::exp(-6.0), 1e-5);
+
+  const float top = envelope.values()[0];
+  Advance(&envelope, 0.0f, 0.25, 1.0 / 120);
+  EXPECT_NEAR(envelope.values()[0], top * std::exp(-1.0), 1e-5);
+}
+
+TEST(BandEnvelope, HoldsPeaksThenLetsThemFall) {
+  BandEnvelope::Options options;
+  options.attack_ms = 0;
+  options.release_ms = 0;
+  options.peak_hold_ms = 500;
+  options.peak_fall_per_second = 1.0f;
+  BandEnvelope envelope(options);
+  Advance(&envelope, 0.0f, 0.01, 0.01);
+  Advance(&envelope, 1.0f, 0.01, 0.01);
+  EXPECT_EQ(envelope.values()[0], 1.0f);
+  EXPECT_EQ(envelope.peaks()[0], 1.0f);
+
+  // Without a time constant the value drops at once; the peak stays for the
+  // hold time and then falls at one full scale per second.
+  Advance(&envelope, 0.2f, 0.49, 0.01);
+  EXPECT_EQ(envelope.values()[0], 0.2f);
+  EXPECT_EQ(envelope.peaks()[0], 1.0f);
+  Advance(&envelope, 0.2f, 0.31, 0.01);
+  EXPECT_NEAR(envelope.peaks()[0], 0.7f, 0.015f);
+  // It never falls below the value, and a new high restarts the hold.
+  Advance(&envelope, 0.2f, 1.0, 0.01);
+  EXPECT_EQ(envelope.peaks()[0], 0.2f);
+  Advance(&envelope, 0.5f, 0.01, 0.01);
+  Advance(&envelope, 0.3f, 0.4, 0.01);
+  EXPECT_EQ(envelope.peaks()[0], 0.5f);
+}
+
+TEST(PcmJitterBuffer, PlaysInOrderAcrossWrapAround) {
+  // Stereo, 8 frames of capacity, playback after 4.
+  PcmJitterBuffer buffer(2, 8, 4);
+  int16_t next_written = 0;
+  int16_t next_read = 0;
+  int16_t output[6];
+  auto write = [&](size_t frames) {
+    std::vector<int16_t> samples(frames * 2);
+    for (int16_t& sample : samples) {
+      sample = next_written++;
+    }
+    return buffer.Write(samples.data(), frames);
+  };
+
+  EXPECT_EQ(write(3), 3u);
+  EXPECT_FALSE(buffer.Read(output, 3));  // Still prebuffering.
+  for (int16_t sample : output) {
+    EXPECT_EQ(sample, 0);
+  }
+  // The first frame fades in from the prebuffering silence.
+  EXPECT_EQ(write(3), 3u);
+  ASSERT_TRUE(buffer.Read(output, 3));
+  EXPECT_EQ(output[0], 0);
+  EXPECT_EQ(output[4], 4 * 2 / 3);
+  next_read = 6;
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(write(3), 3u);
+    ASSERT_TRUE(buffer.Read(output, 3)) << "read " << i;
+    for (int16_t sample : output) {
+      EXPECT_EQ(sample, next_read++);
+    }
+  }
+  PcmJitterBuffer::Stats stats = buffer.GetStats();
+  EXPECT_EQ(stats.frames_played, 63u);
+  EXPECT_EQ(stats.frames_concealed, 3u);
+  EXPECT_EQ(stats.underruns, 0u);
+  EXPECT_EQ(stats.frames_dropped, 0u);
+  EXPECT_EQ(stats.buffered_frames, 3u);
+}
+
+TEST(PcmJitterBuffer, TruncatesWritesThatDoNotFit) {
+  PcmJitterBuffer buffer(1, 8, 2);
+  std::vector<int16_t> samples(12);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = static_cast<int16_t>(i + 1);
+  }
+  EXPECT_EQ(buffer.Write(samples.data(), 12), 8u);
+  EXPECT_EQ(buffer.Write(samples.data(), 1), 0u);
+  EXPECT_EQ(buffer.GetStats().frames_dropped, 5u);
+
+  // The queued audio is the start of the write; the overflow is gone.
+  int16_t output[8];
+  ASSERT_TRUE(buffer.Read(output, 8));
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(output[i], i + 1);
+  }
+  EXPECT_EQ(buffer.Write(samples.data() + 8, 4), 4u);
+  EXPECT_EQ(buffer.buffered_frames(), 4u);
+  buffer.Clear();
+  EXPECT_EQ(buffer.buffered_frames(), 0u);
+  EXPECT_FALSE(buffer.Read(output, 2));
+}
+
+TEST(PcmJitterBuffer, ConcealsUnderrunsAndFadesBackIn) {
+  constexpr size_t kFrames = 4;
+  PcmJitterBuffer buffer(1, 64, kFrames);
+  std::vector<int16_t> loud(kFrames, 16000);
+  int16_t output[kFrames];
+  buffer.Write(loud.data(), kFrames);
+  ASSERT_TRUE(buffer.Read(output, kFrames));
+  EXPECT_EQ(output[0], 16000);
+
+  // The last frame repeats with decaying gain, then silence follows.
+  int16_t previous_peak = 16000;
+  for (int i = 0; i < PcmJitterBuffer::kMaxConcealedFrames; ++i) {
+    EXPECT_FALSE(buffer.Read(output, kFrames));
+    int16_t peak = *std::max_element(output, output + kFrames);
+    EXPECT_LT(peak, previous_peak) << "concealed frame " << i;
+    previous_peak = peak;
+  }
+  EXPECT_EQ(output[kFrames - 1], 0);
+  EXPECT_FALSE(buffer.Read(output, kFrames));
+  EXPECT_EQ(*std::max_element(output, output + kFrames), 0);
+  EXPECT_EQ(buffer.GetStats().underruns, 1u);
+
+  // Playback resumes once the prebuffer refilled, ramping up from silence.
+  buffer.Write(loud.data(), kFrames);
+  ASSERT_TRUE(buffer.Read(output, kFrames));
+  EXPECT_EQ(output[0], 0);
+  for (size_t i = 1; i < kFrames; ++i) {
+    EXPECT_GT(output[i], output[i - 1]);
+  }
+  EXPECT_EQ(buffer.GetStats().frames_concealed,
+            (PcmJitterBuffer::kMaxConcealedFrames + 1) * kFrames);
+}
+
+void AppendU16(std::vector<uint8_t>* bytes, uint16_t value) {
+  bytes->push_back(static_cast<uint8_t>(value));
+  bytes->push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendU32(std::vector<uint8_t>* bytes, uint32_t value) {
+  AppendU16(bytes, static_cast<uint16_t>(value));
+  AppendU16(bytes, static_cast<uint16_t>(value >> 16));
+}
+
+// Appends a chunk whose header claims |declared_size| bytes, with |body| and
+// the padding byte of odd sizes.
+void AppendChunk(std::vector<uint8_t>* bytes, const char* id,
+                 const std::vector<uint8_t>& body, uint32_t declared_size) {
+  bytes->insert(bytes->end(), id, id + 4);
+  AppendU32(bytes, declared_size);
+  bytes->insert(bytes->end(), body.begin(), body.end());
+  if (body.size() & 1) {
+    bytes->push_back(0);
+  }
+}
+
+void AppendChunk(std::vector<uint8_t>* bytes, const char* id,
+                 const std::vector<uint8_t>& body) {
+  AppendChunk(bytes, id, body, static_cast<uint32_t>(body.size()));
+}
+
+std::vector<uint8_t> MakeFormat(uint16_t tag, uint16_t channels,
+                                uint32_t sample_rate, uint16_t bits,
+                                uint16_t block_align) {
+  std::vector<uint8_t> body;
+  AppendU16(&body, tag);
+  AppendU16(&body, channels);
+  AppendU32(&body, sample_rate);
+  AppendU32(&body, sample_rate * block_align);
+  AppendU16(&body, block_align);
+  AppendU16(&body, bits);
+  return body;
+}
+
+std::vector<uint8_t> MakeFormat(uint16_t channels, uint16_t bits) {
+  return MakeFormat(1, channels, 16000, bits,
+                    static_cast<uint16_t>(channels * bits / 8));
+}
+
+std::vector<uint8_t> MakeRiff(const std::vector<uint8_t>& chunks) {
+  std::vector<uint8_t> file = {'R', 'I', 'F', 'F'};
+  AppendU32(&file, static_cast<uint32_t>(chunks.size() + 4));
+  file.insert(file.end(), {'W', 'A', 'V', 'E'});
+  file.insert(file.end(), chunks.begin(), chunks.end());
+  return file;
+}
+
+std::string ParseError(const std::vector<uint8_t>& file) {
+  WavFormat format;
+  std::string error;
+  EXPECT_FALSE(ParseWav(file.data(), file.size(), &format, &error));
+  return error;
+}
+
+TEST(ParseWav, SkipsUnknownAndOddSizedChunks) {
+  std::vector<uint8_t> chunks;
+  AppendChunk(&chunks, "LIST", {1, 2, 3});
+  AppendChunk(&chunks, "fmt ", MakeFormat(2, 16));
+  AppendChunk(&chunks, "fact", {0, 0, 0, 0});
+  AppendChunk(&chunks, "data", {1, 0, 2, 0, 3, 0, 4, 0});
+  std::vector<uint8_t> file = MakeRiff(chunks);
+
+  WavFormat format;
+  std::string error;
+  ASSERT_TRUE(ParseWav(file.data(), file.size(), &format, &error)) << error;
+  EXPECT_EQ(format.sample_rate, 16000);
+  EXPECT_EQ(format.channels, 2u);
+  EXPECT_EQ(format.bits_per_sample, 16);
+  EXPECT_FALSE(format.is_float);
+  EXPECT_EQ(format.block_align, 4u);
+  EXPECT_EQ(format.data, file.data() + file.size() - 8);
+  EXPECT_EQ(format.frame_count, 2u);
+}
+
+TEST(ParseWav, ReadsExtensibleFloatFormat) {
+  std::vector<uint8_t> body = MakeFormat(0xFFFE, 1, 48000, 32, 4);
+  AppendU16(&body, 22);      // Extension size.
+  AppendU16(&body, 32);      // Valid bits.
+  AppendU32(&body, 0x4);     // Channel mask.
+  AppendU16(&body, 3);       // Sub-format GUID, starting with the tag.
+  body.resize(40, 0);
+  std::vector<uint8_t> chunks;
+  AppendChunk(&chunks, "fmt ", body);
+  AppendChunk(&chunks, "data", std::vector<uint8_t>(12));
+  std::vector<uint8_t> file = MakeRiff(chunks);
+
+  WavFormat format;
+  std::string error;
+  ASSERT_TRUE(ParseWav(file.data(), file.size(), &format, &error)) << error;
+  EXPECT_TRUE(format.is_float);
+  EXPECT_EQ(format.frame_count, 3u);
+}
+
+TEST(ParseWav, TruncatesDataChunkToFile) {
+  std::vector<uint8_t> chunks;
+  AppendChunk(&chunks, "fmt ", MakeFormat(2, 16));
+  // Claims 4000 bytes but only 2.5 frames were written.
+  AppendChunk(&chunks, "data", std::vector<uint8_t>(10), 4000);
+  std::vector<uint8_t> file = MakeRiff(chunks);
+
+  WavFormat format;
+  std::string error;
+  ASSERT_TRUE(ParseWav(file.data(), file.size(), &format, &error)) << error;
+  EXPECT_EQ(format.frame_count, 2u);
+}
+
+TEST(ParseWav, RejectsMalformedFiles) {
+  std::vector<uint8_t> data;
+  AppendChunk(&data, "data", std::vector<uint8_t>(8));
+
+  EXPECT_EQ(ParseError({'R', 'I', 'F', 'F'}), "not a RIFF WAVE file");
+  std::vector<uint8_t> not_wave = MakeRiff(data);
+  not_wave[8] = 'A';
+  EXPECT_EQ(ParseError(not_wave), "not a RIFF WAVE file");
+
+  std::vector<uint8_t> chunks;
+  AppendChunk(&chunks, "fmt ", MakeFormat(1, 16));
+  EXPECT_EQ(ParseError(MakeRiff(chunks)), "no data chunk");
+  // A chunk header cut short by the end of the file.
+  chunks.insert(chunks.end(), {'d', 'a', 't', 'a', 8});
+  EXPECT_EQ(ParseError(MakeRiff(chunks)), "no data chunk");
+
+  EXPECT_EQ(ParseError(MakeRiff(data)), "no fmt chunk before the data");
+
+  // fmt chunks that are too short or run past the end of the file are
+  // ignored.
+  chunks.clear();
+  std::vector<uint8_t> short_format = MakeFormat(1, 16);
+  short_format.resize(14);
+  AppendChunk(&chunks, "fmt ", short_format);
+  chunks.insert(chunks.end(), data.begin(), data.end());
+  EXPECT_EQ(ParseError(MakeRiff(chunks)), "no fmt chunk before the data");
+  chunks.clear();
+  AppendChunk(&chunks, "fmt ", MakeFormat(1, 16), 0xFFFFFFF0);
+  chunks.insert(chunks.end(), data.begin(), data.end());
+  EXPECT_EQ(ParseError(MakeRiff(chunks)), "no fmt chunk before the data");
+
+  for (const std::vector<uint8_t>& format :
+       {MakeFormat(1, 12), MakeFormat(0, 16), MakeFormat(3, 1, 16000, 16, 2),
+        MakeFormat(1, 2, 16000, 16, 2), MakeFormat(1, 1, 0, 16, 2)}) {
+    chunks.clear();
+    AppendChunk(&chunks, "fmt ", format);
+    chunks.insert(chunks.end(), data.begin(), data.end());
+    EXPECT_EQ(ParseError(MakeRiff(chunks)), "unsupported sample format");
+  }
+}
+
+TEST(WavPlayback, MixesAndStopsAtTheEnd) {
+  std::vector<uint8_t> body;
+  for (int16_t sample : {1000, 3000, -2000, -4000, 500, 700}) {
+    AppendU16(&body, static_cast<uint16_t>(sample));
+  }
+  std::vector<uint8_t> chunks;
+  AppendChunk(&chunks, "fmt ", MakeFormat(2, 16));
+  AppendChunk(&chunks, "data", body);
+  std::vector<uint8_t> file = MakeRiff(chunks);
+  WavFormat format;
+  std::string error;
+  ASSERT_TRUE(ParseWav(file.data(), file.size(), &format, &error)) << error;
+
+  WavPlayback playback(format, 16000, 1, false);
+  int16_t output[4];
+  EXPECT_TRUE(playback.Render(output, 4));
+  // Channels are averaged; frames past the end are silent.
+  EXPECT_NEAR(output[0], 2000, 1);
+  EXPECT_NEAR(output[1], -3000, 1);
+  EXPECT_NEAR(output[2], 600, 1);
+  EXPECT_EQ(output[3], 0);
+  EXPECT_TRUE(playback.finished());
+  EXPECT_FALSE(playback.Render(output, 4));
+
+  // Same rate and layout is copied sample for sample, looping.
+  WavPlayback copy(format, 16000, 2, true);
+  int16_t stereo[8];
+  EXPECT_TRUE(copy.Render(stereo, 4));
+  EXPECT_EQ(stereo[0], 1000);
+  EXPECT_EQ(stereo[5], 700);
+  EXPECT_EQ(stereo[6], 1000);
+  EXPECT_FALSE(copy.finished());
+}
+
+TEST(NoiseFloorTracker, HoldsTheWindowedMinimum) {
+  NoiseFloorTracker tracker(8.0, -40.0f);
+  // Sustained signal shorter than the window does not lift the floor.
+  for (int i = 0; i < 600; ++i) {
+    EXPECT_EQ(tracker.Update(-10.0f, 0.01), -40.0f) << "update " << i;
+  }
+  // Once the window only saw the new level, the floor follows it.
+  for (int i = 0; i < 400; ++i) {
+    tracker.Update(-10.0f, 0.01);
+  }
+  EXPECT_EQ(tracker.floor_db(), -10.0f);
+  // A quieter level is taken right away.
+  EXPECT_EQ(tracker.Update(-70.0f, 0.01), -70.0f);
+}
+
+struct Utterance {
+  double start_seconds;
+  size_t size;
+};
+
+// Feeds 16 kHz mono audio in 10 ms callbacks and records the utterances.
+class SegmenterInput {
+ public:
+  explicit SegmenterInput(const UtteranceSegmenter::Options& options)
+      : segmenter_(options, [this](const float*, size_t size, double start) {
+          utterances_.push_back({start, size});
+        }) {}
+
+  // Uniform noise of |rms| relative to full scale.
+  void Noise(double seconds, double rms) {
+    Feed(seconds, [&](size_t) {
+      seed_ = seed_ * 1664525u + 1013904223u;
+      return rms * std::sqrt(3.0) *
+             (2 * static_cast<double>(seed_ >> 8) / (1 << 24) - 1);
+    });
+  }
+
+  void Tone(double seconds, double amplitude) {
+    Feed(seconds, [&](size_t i) {
+      return amplitude * std::sin(2 * M_PI * 300.0 * i / kRate);
+    });
+  }
+
+  void Flush() { segmenter_.Flush(); }
+
+  const std::vector<Utterance>& utterances() const { return utterances_; }
+
+ private:
+  static constexpr int kRate = UtteranceSegmenter::kSampleRate;
+
+  template <typename Generate>
+  void Feed(double seconds, Generate generate) {
+    constexpr size_t kFrames = kRate / 100;
+    int16_t block[kFrames];
+    size_t total = static_cast<size_t>(seconds * kRate);
+    for (size_t done = 0; done < total; done += kFrames) {
+      for (size_t i = 0; i < kFrames; ++i) {
+        block[i] =
+            static_cast<int16_t>(std::lround(generate(done + i) * 32767));
+      }
+      segmenter_.Process(block, kFrames, kRate, 1);
+    }
+  }
+
+  UtteranceSegmenter segmenter_;
+  std::vector<Utterance> utterances_;
+  uint32_t seed_ = 1;
+};
+
+TEST(UtteranceSegmenter, KeepsPreRollAndTrailingSilence) {
+  UtteranceSegmenter::Options options;
+  SegmenterInput input(options);
+  input.Noise(1.0, 0.001);
+  input.Tone(1.0, 0.1);
+  input.Noise(2.0, 0.001);
+  input.Flush();
+
+  ASSERT_EQ(input.utterances().size(), 1u);
+  EXPECT_DOUBLE_EQ(input.utterances()[0].start_seconds, 0.7);
+  // 300 ms of pre-roll, the tone and as much trailing silence.
+  EXPECT_EQ(input.utterances()[0].size, 16000u * 16 / 10);
+}
+
+TEST(UtteranceSegmenter, DropsClicksAndFlushesInProgress) {
+  UtteranceSegmenter::Options options;
+  SegmenterInput input(options);
+  input.Noise(0.5, 0.001);
+  input.Tone(0.1, 0.5);
+  input.Noise(1.0, 0.001);
+  EXPECT_TRUE(input.utterances().empty());
+
+  input.Tone(0.5, 0.1);
+  EXPECT_TRUE(input.utterances().empty());
+  input.Flush();
+  ASSERT_EQ(input.utterances().size(), 1u);
+  EXPECT_DOUBLE_EQ(input.utterances()[0].start_seconds, 1.3);
+  EXPECT_EQ(input.utterances()[0].size, 16000u * 8 / 10);
+}
+
+TEST(UtteranceSegmenter, SplitsLongSpeechWithoutGaps) {
+  UtteranceSegmenter::Options options;
+  options.max_utterance_ms = 1000;
+  SegmenterInput input(options);
+  input.Noise(1.0, 0.001);
+  input.Tone(3.5, 0.1);
+  input.Noise(2.0, 0.001);
+  input.Flush();
+
+  const std::vector<Utterance>& utterances = input.utterances();
+  ASSERT_EQ(utterances.size(), 4u);
+  double end = utterances[0].start_seconds;
+  size_t total = 0;
+  for (const Utterance& utterance : utterances) {
+    EXPECT_DOUBLE_EQ(utterance.start_seconds, end);
+    EXPECT_LE(utterance.size, 16000u);
+    end = utterance.start_seconds + utterance.size / 16000.0;
+    total += utterance.size;
+  }
+  EXPECT_DOUBLE_EQ(utterances[0].start_seconds, 0.7);
+  // The last part reaches the maximum length 200 ms into the silence.
+  EXPECT_EQ(total, 16000u * 40 / 10);
+}
+
+TEST(UtteranceSegmenter, NoiseFloorDoesNotRiseDuringSpeech) {
+  UtteranceSegmenter::Options options;
+  SegmenterInput input(options);
+  input.Noise(1.0, 0.001);
+  // Steady speech for most of the noise floor window stays one utterance.
+  input.Tone(6.0, 0.1);
+  input.Noise(2.0, 0.001);
+  input.Flush();
+
+  ASSERT_EQ(input.utterances().size(), 1u);
+  EXPECT_EQ(input.utterances()[0].size, 16000u * 66 / 10);
+}
+
+// G.711 mu-law as in the ITU reference code, with a bit scan for the
+// segment rather than EncodeMuLaw's float exponent trick.
+uint8_t ReferenceMuLaw(int16_t sample) {
+  int value = sample;
+  int sign = 0;
+  if (value < 0) {
+    value = -value;
+    sign = 0x80;
+  }
+  value = std::min(value, 32635) + 0x84;
+  int segment = 0;
+  while (segment < 7 && (value >> (segment + 8)) != 0) {
+    ++segment;
+  }
+  const int mantissa = (value >> (segment + 3)) & 0x0F;
+  return static_cast<uint8_t>(~(sign | segment << 4 | mantissa));
+}
+
+int16_t ReferenceMuLawDecode(uint8_t code) {
+  code = static_cast<uint8_t>(~code);
+  const int magnitude = (((code & 0x0F) << 3) + 0x84) << ((code >> 4) & 7);
+  return static_cast<int16_t>(code & 0x80 ? 0x84 - magnitude
+                                          : magnitude - 0x84);
+}
+
+TEST(MuLaw, EncodesEverySampleAsTheReference) {
+  std::vector<int16_t> input;
+  for (int value = -32768; value <= 32767; ++value) {
+    input.push_back(static_cast<int16_t>(value));
+  }
+  std::vector<uint8_t> output(input.size());
+  EncodeMuLaw(input.data(), input.size(), output.data());
+  for (size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(output[i], ReferenceMuLaw(input[i])) << "sample " << input[i];
+  }
+
+  // Unaligned starts and lengths mixing the vector loop and its tail.
+  for (size_t offset : {1u, 3u, 7u}) {
+    for (size_t size : {1u, 7u, 8u, 15u, 17u, 33u}) {
+      std::vector<uint8_t> part(size + 1, 0xAA);
+      EncodeMuLaw(input.data() + 1000 * offset + offset, size, part.data());
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(part[i], output[1000 * offset + offset + i])
+            << "offset " << offset << " size " << size << " index " << i;
+      }
+      EXPECT_EQ(part[size], 0xAA) << "wrote past " << size;
+    }
+  }
+}
+
+TEST(MuLaw, DecodesEveryCodeAsTheReference) {
+  std::vector<uint8_t> codes(256);
+  for (int code = 0; code < 256; ++code) {
+    codes[code] = static_cast<uint8_t>(code);
+  }
+  std::vector<int16_t> decoded(codes.size());
+  DecodeMuLaw(codes.data(), codes.size(), decoded.data());
+  for (int code = 0; code < 256; ++code) {
+    EXPECT_EQ(decoded[code], ReferenceMuLawDecode(codes[code]))
+        << "code " << code;
+  }
+  // Decoded values encode back to their code, except negative zero.
+  std::vector<uint8_t> encoded(codes.size());
+  EncodeMuLaw(decoded.data(), decoded.size(), encoded.data());
+  for (int code = 0; code < 256; ++code) {
+    EXPECT_EQ(encoded[code], code == 0x7F ? 0xFF : code) << "code " << code;
+  }
+}
+
+TEST(AudioReplayBuffer, SnapshotsTheLatestAudio) {
+  constexpr int kRate = 16000;
+  constexpr size_t kFrames = kRate / 100;
+  AudioReplayBuffer buffer(1.0, kRate);
+  std::vector<int16_t> mono;
+  int16_t stereo[kFrames * 2];
+  for (size_t done = 0; done < 3 * kRate; done += kFrames) {
+    for (size_t i = 0; i < kFrames; ++i) {
+      const int16_t value =
+          static_cast<int16_t>((done + i) * 37 % 20000 - 10000);
+      stereo[2 * i] = static_cast<int16_t>(value - 100);
+      stereo[2 * i + 1] = static_cast<int16_t>(value + 100);
+      mono.push_back(value);
+    }
+    buffer.Write(stereo, kFrames, kRate, 2);
+  }
+  std::vector<uint8_t> expected(mono.size());
+  EncodeMuLaw(mono.data(), mono.size(), expected.data());
+
+  AudioReplayBuffer::Clip clip = buffer.Snapshot(0.5);
+  EXPECT_EQ(clip.sample_rate, kRate);
+  ASSERT_EQ(clip.samples.size(), static_cast<size_t>(kRate / 2));
+  EXPECT_TRUE(std::equal(clip.samples.begin(), clip.samples.end(),
+                         expected.end() - kRate / 2));
+  // Everything kept: a second plus the block being overwritten.
+  clip = buffer.Snapshot(0);
+  ASSERT_EQ(clip.samples.size(), 5 * AudioReplayBuffer::kBlockSamples);
+  EXPECT_TRUE(std::equal(clip.samples.begin(), clip.samples.end(),
+                         expected.end() - clip.samples.size()));
+
+  // A rate change starts a new clip.
+  std::vector<int16_t> quiet(80, 1000);
+  buffer.Write(quiet.data(), quiet.size(), 8000, 1);
+  clip = buffer.Snapshot(10);
+  EXPECT_EQ(clip.sample_rate, 8000);
+  ASSERT_EQ(clip.samples.size(), quiet.size());
+  EXPECT_EQ(clip.samples[0], ReferenceMuLaw(1000));
+}
+
+TEST(AudioReplayBuffer, MixesDownCallbacksLongerThanABlock) {
+  constexpr size_t kFrames = 2 * AudioReplayBuffer::kBlockSamples + 123;
+  AudioReplayBuffer buffer(1.0, kSampleRate);
+  std::vector<int16_t> interleaved(kFrames * 3);
+  std::vector<int16_t> mono(kFrames);
+  for (size_t i = 0; i < kFrames; ++i) {
+    mono[i] = static_cast<int16_t>(i * 53 % 30000 - 15000);
+    interleaved[3 * i] = mono[i];
+    interleaved[3 * i + 1] = static_cast<int16_t>(mono[i] - 300);
+    interleaved[3 * i + 2] = static_cast<int16_t>(mono[i] + 300);
+  }
+  buffer.Write(interleaved.data(), kFrames, kSampleRate, 3);
+  std::vector<uint8_t> expected(kFrames);
+  EncodeMuLaw(mono.data(), kFrames, expected.data());
+
+  AudioReplayBuffer::Clip clip = buffer.Snapshot(0);
+  EXPECT_EQ(clip.sample_rate, kSampleRate);
+  EXPECT_EQ(clip.samples, expected);
+}
+
+// Runs 40 blocks of a 500 Hz tone through a visualizer shadowed by
+// |candidate|. Visualizers skip the analysis when their millisecond clock has
+// not advanced since the last one, so the blocks are a few milliseconds
+// apart as callbacks would be.
+VisualizerShadow::Stats RunShadow(
+    const VisualizerShadow::Candidate& candidate) {
+  constexpr int kBands = 12;
+  AudioVisualizer primary(kBands, false);
+  VisualizerShadow shadow(kBands, false, candidate);
+  const std::vector<int16_t> tone = MakeTones(1024, {0.5}, {500});
+  std::vector<float> bands;
+  for (int i = 0; i < 40; ++i) {
+    shadow.Process(&primary, tone.data(), tone.size(), kSampleRate, bands);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  EXPECT_EQ(bands.size(), static_cast<size_t>(kBands));
+  return shadow.stats();
+}
+
+TEST(VisualizerShadow, CountsDivergenceOnlyForADifferentEngine) {
+  VisualizerShadow::Stats same = RunShadow(VisualizerShadow::Candidate());
+  EXPECT_GT(same.compared, 30u);
+  EXPECT_EQ(same.divergent, 0u);
+  EXPECT_EQ(same.max_difference, 0.0f);
+  EXPECT_EQ(same.total_difference, 0.0);
+  EXPECT_EQ(same.bands_compared, same.compared * 12);
+  EXPECT_GT(same.primary_seconds, 0.0);
+  EXPECT_GT(same.candidate_seconds, 0.0);
+
+  // Bands above the tone see nothing of it.
+  VisualizerShadow::Candidate higher;
+  higher.min_frequency = 2000;
+  higher.max_frequency = 16000;
+  VisualizerShadow::Stats different = RunShadow(higher);
+  EXPECT_EQ(different.compared, same.compared);
+  EXPECT_EQ(different.divergent, different.compared);
+  EXPECT_GT(different.max_difference, VisualizerShadow::kDivergenceThreshold);
+
+  VisualizerShadow::Stats total = same;
+  total.Add(different);
+  EXPECT_EQ(total.compared, 2 * same.compared);
+  EXPECT_EQ(total.divergent, different.divergent);
+  EXPECT_EQ(total.max_difference, different.max_difference);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace livekit_client_plugin
@@ -0,0 +1,202 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Signals textures from worker threads while the main thread registers and
+// unregisters them, as ThumbnailSink does. Most useful in a build with
+// -fsanitize=thread, which reports any unsynchronized access on the way.
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "flutter/texture_registrar_impl.h"
+
+namespace livekit {
+namespace test {
+namespace {
+
+// What the fake registrar saw, shared with the threads of the test.
+struct TextureLog {
+  std::mutex mutex;
+  // Textures registered and not finalized yet.
+  std::set<FlTexture*> alive;
+  int registered = 0;
+  int finalized = 0;
+  std::atomic<int> marked{0};
+  std::atomic<int> marked_after_finalize{0};
+};
+
+void OnTextureFinalized(gpointer data, GObject* texture) {
+  TextureLog* log = static_cast<TextureLog*>(data);
+  std::lock_guard<std::mutex> lock(log->mutex);
+  log->alive.erase(reinterpret_cast<FlTexture*>(texture));
+  ++log->finalized;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace livekit
+
+// An FlTextureRegistrar that holds a reference to each registered texture,
+// as the engine's does, without rendering anything.
+struct FakeTextureRegistrar {
+  GObject parent_instance;
+  livekit::test::TextureLog* log;
+  GPtrArray* textures;
+};
+
+struct FakeTextureRegistrarClass {
+  GObjectClass parent_class;
+};
+
+static void fake_texture_registrar_iface_init(
+    FlTextureRegistrarInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(
+    FakeTextureRegistrar,
+    fake_texture_registrar,
+    G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(fl_texture_registrar_get_type(),
+                          fake_texture_registrar_iface_init))
+
+#define FAKE_TEXTURE_REGISTRAR(obj)                                     \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), fake_texture_registrar_get_type(), \
+                              FakeTextureRegistrar))
+
+static gboolean fake_texture_registrar_register_texture(
+    FlTextureRegistrar* registrar,
+    FlTexture* texture) {
+  FakeTextureRegistrar* self = FAKE_TEXTURE_REGISTRAR(registrar);
+  g_ptr_array_add(self->textures, g_object_ref(texture));
+  g_object_weak_ref(G_OBJECT(texture), livekit::test::OnTextureFinalized,
+                    self->log);
+  std::lock_guard<std::mutex> lock(self->log->mutex);
+  self->log->alive.insert(texture);
+  ++self->log->registered;
+  return TRUE;
+}
+
+static gboolean fake_texture_registrar_mark_texture_frame_available(
+    FlTextureRegistrar* registrar,
+    FlTexture* texture) {
+  livekit::test::TextureLog* log = FAKE_TEXTURE_REGISTRAR(registrar)->log;
+  std::lock_guard<std::mutex> lock(log->mutex);
+  if (log->alive.count(texture) == 0) {
+    ++log->marked_after_finalize;
+  }
+  ++log->marked;
+  return TRUE;
+}
+
+static gboolean fake_texture_registrar_unregister_texture(
+    FlTextureRegistrar* registrar,
+    FlTexture* texture) {
+  FakeTextureRegistrar* self = FAKE_TEXTURE_REGISTRAR(registrar);
+  return g_ptr_array_remove(self->textures, texture);
+}
+
+static void fake_texture_registrar_iface_init(
+    FlTextureRegistrarInterface* iface) {
+  iface->register_texture = fake_texture_registrar_register_texture;
+  iface->mark_texture_frame_available =
+      fake_texture_registrar_mark_texture_frame_available;
+  iface->unregister_texture = fake_texture_registrar_unregister_texture;
+}
+
+static void fake_texture_registrar_dispose(GObject* object) {
+  FakeTextureRegistrar* self = FAKE_TEXTURE_REGISTRAR(object);
+  g_clear_pointer(&self->textures, g_ptr_array_unref);
+  G_OBJECT_CLASS(fake_texture_registrar_parent_class)->dispose(object);
+}
+
+static void fake_texture_registrar_class_init(
+    FakeTextureRegistrarClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = fake_texture_registrar_dispose;
+}
+
+static void fake_texture_registrar_init(FakeTextureRegistrar* self) {
+  self->textures = g_ptr_array_new_with_free_func(g_object_unref);
+}
+
+namespace livekit {
+namespace test {
+
+TEST(TextureRegistrar, MarksFromWorkerThreadsWhileUnregistering) {
+  constexpr int kIterations = 20000;
+  constexpr int kThreads = 4;
+  constexpr size_t kSlots = 8;
+
+  TextureLog log;
+  FakeTextureRegistrar* fake = FAKE_TEXTURE_REGISTRAR(
+      g_object_new(fake_texture_registrar_get_type(), nullptr));
+  fake->log = &log;
+  auto registrar = std::make_unique<flutter::TextureRegistrarImpl>(
+      FL_TEXTURE_REGISTRAR(fake));
+
+  // The proxies only keep a pointer to their texture, which is never asked
+  // for pixels here.
+  std::deque<flutter::TextureVariant> textures;
+  std::array<std::atomic<int64_t>, kSlots> ids{};
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; !stop.load(std::memory_order_relaxed); ++i) {
+        int64_t id = ids[i % kSlots].load(std::memory_order_relaxed);
+        if (id != 0) {
+          registrar->MarkTextureFrameAvailable(id);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < kIterations; ++i) {
+    textures.emplace_back(flutter::PixelBufferTexture(
+        [](size_t, size_t) -> const FlutterDesktopPixelBuffer* {
+          return nullptr;
+        }));
+    int64_t id = registrar->RegisterTexture(&textures.back());
+    int64_t previous = ids[i % kSlots].exchange(id);
+    if (previous != 0) {
+      EXPECT_TRUE(registrar->UnregisterTexture(previous));
+    }
+  }
+  stop = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_GT(log.marked.load(), 0);
+  EXPECT_EQ(log.marked_after_finalize.load(), 0);
+  EXPECT_EQ(log.registered, kIterations);
+  EXPECT_EQ(log.finalized, kIterations - static_cast<int>(kSlots));
+
+  // The textures still registered are only held by the engine once the
+  // registrar is gone.
+  registrar.reset();
+  EXPECT_EQ(log.finalized, kIterations - static_cast<int>(kSlots));
+  g_object_unref(fake);
+  EXPECT_EQ(log.finalized, kIterations);
+  EXPECT_TRUE(log.alive.empty());
+}
+
+}  // namespace test
+}  // namespace livekit
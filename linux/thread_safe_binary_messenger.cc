@@ -0,0 +1,110 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_safe_binary_messenger.h"
+
+#include <glib.h>
+
+namespace livekit_client_plugin {
+
+ThreadSafeBinaryMessenger::Queue::~Queue() {
+  Message* message = head.exchange(nullptr);
+  while (message) {
+    Message* next = message->next;
+    delete message;
+    message = next;
+  }
+}
+
+ThreadSafeBinaryMessenger::ThreadSafeBinaryMessenger(
+    flutter::BinaryMessenger* messenger)
+    : queue_(std::make_shared<Queue>()) {
+  queue_->messenger = messenger;
+}
+
+ThreadSafeBinaryMessenger::~ThreadSafeBinaryMessenger() {
+  // Messages still queued are dropped with the last reference to the queue.
+  queue_->messenger = nullptr;
+}
+
+void ThreadSafeBinaryMessenger::Send(const std::string& channel,
+                                     const uint8_t* message,
+                                     size_t message_size,
+                                     flutter::BinaryReply reply) const {
+  Post(channel, std::vector<uint8_t>(message, message + message_size),
+       std::move(reply));
+}
+
+void ThreadSafeBinaryMessenger::SetMessageHandler(
+    const std::string& channel,
+    flutter::BinaryMessageHandler handler) {
+  queue_->messenger->SetMessageHandler(channel, std::move(handler));
+}
+
+void ThreadSafeBinaryMessenger::Post(std::string channel,
+                                     std::vector<uint8_t> message,
+                                     flutter::BinaryReply reply) const {
+  Message* node =
+      new Message{std::move(channel), std::move(message), std::move(reply)};
+  node->next = queue_->head.load(std::memory_order_relaxed);
+  while (!queue_->head.compare_exchange_weak(node->next, node)) {
+  }
+
+  // Only the first message after a flush schedules the next one; the others
+  // ride along in the same batch. The push, this exchange and the two
+  // operations at the start of Flush() are sequentially consistent, so a
+  // message is never left behind without a flush scheduled.
+  if (queue_->flush_scheduled.exchange(true)) {
+    return;
+  }
+  g_main_context_invoke_full(
+      g_main_context_default(), G_PRIORITY_DEFAULT,
+      [](gpointer user_data) -> gboolean {
+        Flush(static_cast<std::shared_ptr<Queue>*>(user_data)->get());
+        return G_SOURCE_REMOVE;
+      },
+      new std::shared_ptr<Queue>(queue_),
+      [](gpointer user_data) {
+        delete static_cast<std::shared_ptr<Queue>*>(user_data);
+      });
+}
+
+// static
+void ThreadSafeBinaryMessenger::Flush(Queue* queue) {
+  // Clear the flag before taking the messages, so that a message pushed after
+  // the exchange below always schedules another flush.
+  queue->flush_scheduled.store(false);
+  Message* message = queue->head.exchange(nullptr);
+
+  // The queue is a stack; reverse it to send in order.
+  Message* ordered = nullptr;
+  while (message) {
+    Message* next = message->next;
+    message->next = ordered;
+    ordered = message;
+    message = next;
+  }
+
+  while (ordered) {
+    if (queue->messenger) {
+      queue->messenger->Send(ordered->channel, ordered->data.data(),
+                             ordered->data.size(), std::move(ordered->reply));
+    }
+    Message* next = ordered->next;
+    delete ordered;
+    ordered = next;
+  }
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,87 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_THREAD_SAFE_BINARY_MESSENGER_H_
+#define LIVEKIT_CLIENT_LINUX_THREAD_SAFE_BINARY_MESSENGER_H_
+
+#include <flutter/binary_messenger.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace livekit_client_plugin {
+
+// A BinaryMessenger that can be sent to from any thread.
+//
+// The GTK messenger it wraps must only be used on the main thread, so Send()
+// copies the already encoded message into a lock-free queue and the main
+// loop forwards everything queued in one batch. Channels and event sinks
+// built on top of it therefore encode on the calling thread, and the main
+// thread only moves bytes. Messages keep their order across threads as far
+// as the sends are ordered.
+//
+// SetMessageHandler() must still be called on the main thread.
+class ThreadSafeBinaryMessenger : public flutter::BinaryMessenger {
+ public:
+  explicit ThreadSafeBinaryMessenger(flutter::BinaryMessenger* messenger);
+  ~ThreadSafeBinaryMessenger() override;
+
+  // Prevent copying.
+  ThreadSafeBinaryMessenger(ThreadSafeBinaryMessenger const&) = delete;
+  ThreadSafeBinaryMessenger& operator=(ThreadSafeBinaryMessenger const&) =
+      delete;
+
+  // flutter::BinaryMessenger. |reply| runs on the main thread.
+  void Send(const std::string& channel,
+            const uint8_t* message,
+            size_t message_size,
+            flutter::BinaryReply reply = nullptr) const override;
+  void SetMessageHandler(const std::string& channel,
+                         flutter::BinaryMessageHandler handler) override;
+
+  // Like Send(), but takes ownership of |message| instead of copying it.
+  void Post(std::string channel,
+            std::vector<uint8_t> message,
+            flutter::BinaryReply reply = nullptr) const;
+
+ private:
+  struct Message {
+    std::string channel;
+    std::vector<uint8_t> data;
+    flutter::BinaryReply reply;
+    Message* next = nullptr;
+  };
+
+  // Shared with scheduled flushes, which may run after destruction.
+  struct Queue {
+    ~Queue();
+
+    // Most recent message first.
+    std::atomic<Message*> head{nullptr};
+    std::atomic<bool> flush_scheduled{false};
+    // Main thread only; null once the facade is destroyed.
+    flutter::BinaryMessenger* messenger = nullptr;
+  };
+
+  static void Flush(Queue* queue);
+
+  std::shared_ptr<Queue> queue_;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_THREAD_SAFE_BINARY_MESSENGER_H_
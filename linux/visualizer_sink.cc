@@ -0,0 +1,132 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "visualizer_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "livekit_codec.h"
+
+namespace livekit_client_plugin {
+
+VisualizerSink::VisualizerSink(ThreadSafeBinaryMessenger* messenger,
+                               const std::string& event_channel_name,
+                               const std::string& visualizer_id,
+                               std::shared_ptr<SharedVisualizer> visualizer,
+                               bool publish_latest,
+                               int idle_release_ms,
+                               const BandEnvelope::Options* envelope,
+                               int frame_rate)
+    : events_(
+          messenger,
+          event_channel_name,
+          [this]() { OnListen(); },
+          [this]() { OnCancel(); }),
+      visualizer_id_(visualizer_id),
+      visualizer_(std::move(visualizer)),
+      publish_latest_(publish_latest),
+      idle_release_ms_(idle_release_ms),
+      envelope_(envelope ? std::make_unique<BandEnvelope>(*envelope)
+                         : nullptr),
+      frame_interval_seconds_(frame_rate > 0 ? 1.0 / frame_rate : 0) {
+  latest_bands_ = LatestBandsRegistry::Instance().Acquire(visualizer_id_);
+  visualizer_->AddSubscriber(this);
+  if (publish_latest_) {
+    active_ = true;
+    visualizer_->Activate();
+  }
+}
+
+VisualizerSink::~VisualizerSink() {
+  visualizer_->RemoveSubscriber(this);
+  if (active_) {
+    visualizer_->Deactivate(idle_release_ms_);
+  }
+  LatestBandsRegistry::Instance().Release(visualizer_id_, latest_bands_);
+}
+
+void VisualizerSink::OnBands(const std::vector<float>& analysed_bands,
+                             int sample_rate,
+                             size_t number_of_frames) {
+  bool listening = events_.IsListening();
+  if (!listening && !publish_latest_) {
+    return;
+  }
+  std::vector<float> bands = analysed_bands;
+  std::vector<float> peaks;
+  if (envelope_ &&
+      !NextFrame(&bands, &peaks,
+                 double(number_of_frames) / std::max(sample_rate, 1))) {
+    return;
+  }
+  latest_bands_->Publish(bands.data(), bands.size());
+  if (listening) {
+    // Post the processed data to the event sink as a compact BandFrame.
+    BandFrame frame;
+    frame.timestamp_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    frame.sequence = sequence_++;
+    frame.sample_rate = sample_rate;
+    frame.bands = std::move(bands);
+    frame.peaks = std::move(peaks);
+    events_.Success(flutter::CustomEncodableValue(std::move(frame)));
+  }
+}
+
+bool VisualizerSink::NextFrame(std::vector<float>* bands,
+                               std::vector<float>* peaks,
+                               double seconds) {
+  if (pending_seconds_ == 0 || pending_bands_.size() != bands->size()) {
+    pending_bands_ = *bands;
+  } else {
+    for (size_t i = 0; i < bands->size(); ++i) {
+      pending_bands_[i] = std::max(pending_bands_[i], (*bands)[i]);
+    }
+  }
+  pending_seconds_ += seconds;
+  next_frame_seconds_ -= seconds;
+  if (next_frame_seconds_ > 0) {
+    return false;
+  }
+  // Keep the average frame rate when callbacks do not divide the interval,
+  // without bursting after a gap in the audio.
+  next_frame_seconds_ =
+      std::max(0.0, next_frame_seconds_ + frame_interval_seconds_);
+  envelope_->Process(pending_bands_.data(), pending_bands_.size(),
+                     pending_seconds_);
+  pending_seconds_ = 0;
+  *bands = envelope_->values();
+  *peaks = envelope_->peaks();
+  return true;
+}
+
+void VisualizerSink::OnListen() {
+  if (!active_) {
+    active_ = true;
+    visualizer_->Activate();
+  }
+}
+
+void VisualizerSink::OnCancel() {
+  if (active_ && !publish_latest_) {
+    active_ = false;
+    visualizer_->Deactivate(idle_release_ms_);
+  }
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,105 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef LIVEKIT_CLIENT_LINUX_VISUALIZER_SINK_H_
+#define LIVEKIT_CLIENT_LINUX_VISUALIZER_SINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "analysis_service.h"
+#include "band_envelope.h"
+#include "event_channel_proxy.h"
+#include "latest_bands.h"
+#include "thread_safe_binary_messenger.h"
+
+namespace livekit_client_plugin {
+
+// Sends the bands of a SharedVisualizer to one event channel. The sink keeps
+// the analysis active while the event channel has a listener (or always,
+// with |publish_latest|); once no sink of any engine keeps it active, its
+// buffers are released after |idle_release_ms|, so hidden or never shown
+// visualizers hold no analysis memory.
+//
+// With an |envelope|, bands go through a BandEnvelope evaluated |frame_rate|
+// times per second (every analysis when 0), and events carry the envelope
+// values and peaks instead of the raw bands. Each frame follows the loudest
+// bands analysed since the previous one, so short transients are not lost
+// between frames.
+//
+// Independent of libwebrtc: the plugin connects the shared visualizer to a
+// track's audio callbacks, and benchmarks drive it with synthetic audio.
+class VisualizerSink : public SharedVisualizer::Subscriber {
+ public:
+  static constexpr int kDefaultIdleReleaseMs = 5000;
+
+  // Bands are published to the LatestBandsRegistry slot of
+  // |visualizer_id|. With |publish_latest| they are computed even while
+  // nobody listens to the event channel, for callers that only pull them
+  // with getLatestBands.
+  VisualizerSink(ThreadSafeBinaryMessenger* messenger,
+                 const std::string& event_channel_name,
+                 const std::string& visualizer_id,
+                 std::shared_ptr<SharedVisualizer> visualizer,
+                 bool publish_latest = false,
+                 int idle_release_ms = kDefaultIdleReleaseMs,
+                 const BandEnvelope::Options* envelope = nullptr,
+                 int frame_rate = 0);
+  ~VisualizerSink() override;
+
+  // Prevent copying.
+  VisualizerSink(VisualizerSink const&) = delete;
+  VisualizerSink& operator=(VisualizerSink const&) = delete;
+
+  // SharedVisualizer::Subscriber implementation.
+  void OnBands(const std::vector<float>& bands,
+               int sample_rate,
+               size_t number_of_frames) override;
+
+ private:
+  // Called on the main thread.
+  void OnListen();
+  void OnCancel();
+
+  // Folds |bands| analysed over |seconds| into the next frame. Once a frame
+  // is due, replaces |bands| with the envelope values, fills |peaks| and
+  // returns true. Audio thread only.
+  bool NextFrame(std::vector<float>* bands,
+                 std::vector<float>* peaks,
+                 double seconds);
+
+  EventChannelProxy events_;
+  const std::string visualizer_id_;
+  std::shared_ptr<SharedVisualizer> visualizer_;
+  bool publish_latest_ = false;
+  int idle_release_ms_ = kDefaultIdleReleaseMs;
+  // Whether this sink keeps |visualizer_| active. Main thread only.
+  bool active_ = false;
+  uint32_t sequence_ = 0;
+  std::shared_ptr<LatestBandsRegistry::Slot> latest_bands_;
+  // Audio thread only.
+  std::unique_ptr<BandEnvelope> envelope_;
+  double frame_interval_seconds_ = 0;
+  // Time until the next frame is due, and analysed since the last one.
+  double next_frame_seconds_ = 0;
+  double pending_seconds_ = 0;
+  // Per band maximum of the analyses since the last frame.
+  std::vector<float> pending_bands_;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_VISUALIZER_SINK_H_
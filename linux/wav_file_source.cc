@@ -0,0 +1,115 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wav_file_source.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace livekit_client_plugin {
+
+// static
+std::unique_ptr<WavFileSource> WavFileSource::Open(const std::string& path,
+                                                   int sample_rate,
+                                                   size_t channels,
+                                                   bool loop,
+                                                   AudioFrameCallback on_frame,
+                                                   std::string* error) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *error = path + ": " + std::strerror(errno);
+    return nullptr;
+  }
+  struct stat info;
+  void* mapping = MAP_FAILED;
+  size_t size = 0;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    size = size_t(info.st_size);
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  int mmap_errno = errno;
+  // The mapping keeps the file referenced.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    *error = path + ": " + (size == 0 ? std::string("empty file")
+                                      : std::strerror(mmap_errno));
+    return nullptr;
+  }
+  madvise(mapping, size, MADV_SEQUENTIAL);
+
+  WavFormat format;
+  if (!ParseWav(static_cast<const uint8_t*>(mapping), size, &format, error)) {
+    *error = path + ": " + *error;
+    munmap(mapping, size);
+    return nullptr;
+  }
+  if (sample_rate <= 0) {
+    sample_rate = format.sample_rate % 100 == 0 ? format.sample_rate : 48000;
+  }
+  if (channels == 0) {
+    channels = std::min<size_t>(format.channels, 2);
+  }
+  return std::unique_ptr<WavFileSource>(
+      new WavFileSource(mapping, size, format, sample_rate, channels, loop,
+                        std::move(on_frame)));
+}
+
+WavFileSource::WavFileSource(void* mapping,
+                             size_t mapping_size,
+                             const WavFormat& format,
+                             int sample_rate,
+                             size_t channels,
+                             bool loop,
+                             AudioFrameCallback on_frame)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      sample_rate_(sample_rate),
+      channels_(channels),
+      duration_seconds_(double(format.frame_count) / format.sample_rate),
+      on_frame_(std::move(on_frame)),
+      playback_(format, sample_rate, channels, loop),
+      frame_(size_t(sample_rate) * AudioFrameClock::kTickMs / 1000 * channels),
+      clock_(AudioFrameClock::Acquire()) {
+  tick_id_ = clock_->Add([this] { Tick(); });
+}
+
+WavFileSource::~WavFileSource() {
+  clock_->Remove(tick_id_);
+  munmap(mapping_, mapping_size_);
+}
+
+void WavFileSource::Seek(double seconds) {
+  seek_us_.store(int64_t(std::max(seconds, 0.0) * 1e6),
+                 std::memory_order_relaxed);
+}
+
+void WavFileSource::Tick() {
+  int64_t seek_us = seek_us_.exchange(-1, std::memory_order_relaxed);
+  if (seek_us >= 0) {
+    playback_.Seek(double(seek_us) * 1e-6);
+  }
+  const size_t frames = frame_.size() / channels_;
+  playback_.Render(frame_.data(), frames);
+  finished_.store(playback_.finished(), std::memory_order_relaxed);
+  on_frame_(frame_.data(), sample_rate_, channels_, frames);
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,102 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_WAV_FILE_SOURCE_H_
+#define LIVEKIT_CLIENT_LINUX_WAV_FILE_SOURCE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "audio_frame_clock.h"
+#include "wav_playback.h"
+
+namespace livekit_client_plugin {
+
+// Plays a WAV file into an audio source on the AudioFrameClock, for
+// synthetic participants and load tests.
+//
+// The file is memory-mapped and converted 10 ms at a time as the clock asks
+// for frames, so opening it decodes nothing, a source holds only its
+// conversion buffers whatever the file length, and sources of the same file
+// share its pages in the page cache. Past the end of a file that does not
+// loop, the source plays silence.
+//
+// Independent of libwebrtc: the plugin forwards frames to a custom
+// RTCAudioSource.
+class WavFileSource {
+ public:
+  // Maps |path| and starts delivering frames to |on_frame| on the clock
+  // thread. A |sample_rate| of 0 keeps the file's, or uses 48 kHz if it is
+  // not a multiple of 100 and so has no whole 10 ms frames; a |channels| of 0
+  // keeps the file's, capped to stereo. Returns null and sets |error| if the
+  // file cannot be mapped or is not a supported WAV file.
+  static std::unique_ptr<WavFileSource> Open(const std::string& path,
+                                             int sample_rate,
+                                             size_t channels,
+                                             bool loop,
+                                             AudioFrameCallback on_frame,
+                                             std::string* error);
+  ~WavFileSource();
+
+  // Prevent copying.
+  WavFileSource(WavFileSource const&) = delete;
+  WavFileSource& operator=(WavFileSource const&) = delete;
+
+  // Moves playback to |seconds| into the file on the next tick. May be called
+  // from any thread.
+  void Seek(double seconds);
+
+  double duration_seconds() const { return duration_seconds_; }
+  int sample_rate() const { return sample_rate_; }
+  size_t channels() const { return channels_; }
+
+  // Whether a file that does not loop has played to its end. May be called
+  // from any thread.
+  bool finished() const { return finished_.load(std::memory_order_relaxed); }
+
+ private:
+  WavFileSource(void* mapping,
+                size_t mapping_size,
+                const WavFormat& format,
+                int sample_rate,
+                size_t channels,
+                bool loop,
+                AudioFrameCallback on_frame);
+
+  // Clock thread.
+  void Tick();
+
+  void* mapping_;
+  size_t mapping_size_;
+  const int sample_rate_;
+  const size_t channels_;
+  const double duration_seconds_;
+  AudioFrameCallback on_frame_;
+  // Seek target in microseconds, or -1.
+  std::atomic<int64_t> seek_us_{-1};
+  std::atomic<bool> finished_{false};
+  // Clock thread only.
+  WavPlayback playback_;
+  std::vector<int16_t> frame_;
+  std::shared_ptr<AudioFrameClock> clock_;
+  int tick_id_ = 0;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_WAV_FILE_SOURCE_H_
@@ -0,0 +1,96 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "zlib_stream.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace livekit_client_plugin {
+
+ZlibStream::ZlibStream(Mode mode, int level) : mode_(mode) {
+  std::memset(&stream_, 0, sizeof(stream_));
+  if (mode_ == Mode::kDeflate) {
+    // Z_DEFAULT_COMPRESSION (-1) is below Z_NO_COMPRESSION, so keep it out
+    // of the clamp.
+    if (level != Z_DEFAULT_COMPRESSION) {
+      level = std::min(std::max(level, Z_NO_COMPRESSION), Z_BEST_COMPRESSION);
+    }
+    initialized_ = deflateInit(&stream_, level) == Z_OK;
+  } else {
+    initialized_ = inflateInit(&stream_) == Z_OK;
+  }
+}
+
+ZlibStream::~ZlibStream() {
+  if (!initialized_) {
+    return;
+  }
+  if (mode_ == Mode::kDeflate) {
+    deflateEnd(&stream_);
+  } else {
+    inflateEnd(&stream_);
+  }
+}
+
+int64_t ZlibStream::Process(const uint8_t* input,
+                            size_t input_size,
+                            size_t* input_consumed,
+                            uint8_t* output,
+                            size_t output_capacity,
+                            Flush flush) {
+  *input_consumed = 0;
+  if (!initialized_) {
+    return -1;
+  }
+  // zlib counts in uInt; larger buffers are processed in several calls.
+  input_size = std::min<size_t>(input_size, UINT_MAX);
+  output_capacity = std::min<size_t>(output_capacity, UINT_MAX);
+  if (finished_ || output_capacity == 0) {
+    return input_size > 0 && finished_ ? -1 : 0;
+  }
+  stream_.next_in = const_cast<Bytef*>(input);
+  stream_.avail_in = static_cast<uInt>(input_size);
+  stream_.next_out = output;
+  stream_.avail_out = static_cast<uInt>(output_capacity);
+
+  int result;
+  if (mode_ == Mode::kDeflate) {
+    int zlib_flush = flush == Flush::kFinish ? Z_FINISH
+                     : flush == Flush::kSync ? Z_SYNC_FLUSH
+                                             : Z_NO_FLUSH;
+    result = deflate(&stream_, zlib_flush);
+  } else {
+    result = inflate(&stream_, Z_NO_FLUSH);
+  }
+  *input_consumed = input_size - stream_.avail_in;
+  const size_t written = output_capacity - stream_.avail_out;
+  stream_.next_in = nullptr;
+  stream_.next_out = nullptr;
+
+  switch (result) {
+    case Z_STREAM_END:
+      finished_ = true;
+      return static_cast<int64_t>(written);
+    case Z_OK:
+    // No progress was possible, e.g. no input and nothing pending.
+    case Z_BUF_ERROR:
+      return static_cast<int64_t>(written);
+    default:
+      return -1;
+  }
+}
+
+}  // namespace livekit_client_plugin
@@ -0,0 +1,68 @@
+// Copyright 2024 LiveKit, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVEKIT_CLIENT_LINUX_ZLIB_STREAM_H_
+#define LIVEKIT_CLIENT_LINUX_ZLIB_STREAM_H_
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace livekit_client_plugin {
+
+// One direction of a streaming zlib (RFC 1950) coder working on caller
+// provided buffers, for compressing data stream payloads off the Dart heap.
+//
+// The compressor ends every Process() call with a sync flush unless told to
+// finish, so that the receiver can decode each data stream chunk as it
+// arrives, and output is produced in pieces of at most the buffer size given
+// to Process(), which callers set to the data stream chunk size.
+class ZlibStream {
+ public:
+  enum class Mode { kDeflate, kInflate };
+  enum class Flush { kNone = 0, kSync = 1, kFinish = 2 };
+
+  // |level| is a zlib compression level, ignored when inflating.
+  ZlibStream(Mode mode, int level);
+  ~ZlibStream();
+
+  // Prevent copying.
+  ZlibStream(ZlibStream const&) = delete;
+  ZlibStream& operator=(ZlibStream const&) = delete;
+
+  bool ok() const { return initialized_; }
+
+  // Consumes input and writes up to |output_capacity| bytes. Returns the
+  // number of bytes written, or -1 on corrupt input or misuse. While it
+  // returns |output_capacity| there may be more output: call again with the
+  // unconsumed input, or none, and the same |flush|. |flush| is ignored when
+  // inflating.
+  int64_t Process(const uint8_t* input,
+                  size_t input_size,
+                  size_t* input_consumed,
+                  uint8_t* output,
+                  size_t output_capacity,
+                  Flush flush);
+
+ private:
+  Mode mode_;
+  z_stream stream_;
+  bool initialized_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace livekit_client_plugin
+
+#endif  // LIVEKIT_CLIENT_LINUX_ZLIB_STREAM_H_
@@ -0,0 +1,237 @@
+#include "audio_replay_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_REPLAY_BUFFER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_REPLAY_BUFFER_NEON
+#endif
+
+namespace {
+
+constexpr int kMuLawBias = 0x84;
+constexpr int kMuLawClip = 32635;
+// The float exponent field of 128, the smallest biased magnitude, in the
+// position EncodeMuLawSample() reads it at.
+constexpr int kMuLawExponentBase = (127 + 7) << 4;
+
+size_t BlockCount(double seconds, int sample_rate) {
+  // The oldest block is partly overwritten by the time the newest one fills,
+  // so keep one more than |seconds| needs.
+  return size_t(std::ceil(std::max(seconds, 0.0) * std::max(sample_rate, 1) /
+                          AudioReplayBuffer::kBlockSamples)) +
+         1;
+}
+
+// The segment of a biased magnitude is the position of its highest bit
+// above bit 7, and its mantissa the four bits below that. Both are read off
+// the exponent and mantissa fields of the magnitude converted to float,
+// which is exact below 2^24, so the vector versions need no bit scan.
+uint8_t EncodeMuLawSample(int16_t sample) {
+  int value = sample;
+  const int sign = value < 0 ? 0x80 : 0;
+  const int magnitude = std::min(std::abs(value), kMuLawClip) + kMuLawBias;
+  const float f = float(magnitude);
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const int code = int(bits >> 19) - kMuLawExponentBase;
+  return uint8_t(~(sign | code));
+}
+
+int16_t DecodeMuLawSample(uint8_t code) {
+  code = uint8_t(~code);
+  const int magnitude = (((code & 0x0F) << 3) + kMuLawBias)
+                        << ((code & 0x70) >> 4);
+  return int16_t(code & 0x80 ? kMuLawBias - magnitude
+                             : magnitude - kMuLawBias);
+}
+
+const std::array<int16_t, 256> &MuLawTable() {
+  static const std::array<int16_t, 256> table = [] {
+    std::array<int16_t, 256> values;
+    for (int code = 0; code < 256; ++code) {
+      values[code] = DecodeMuLawSample(uint8_t(code));
+    }
+    return values;
+  }();
+  return table;
+}
+
+} // namespace
+
+void EncodeMuLaw(const int16_t *input, size_t size, uint8_t *output) {
+  size_t i = 0;
+#if defined(AUDIO_REPLAY_BUFFER_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i clip = _mm_set1_epi16(kMuLawClip);
+  const __m128i bias = _mm_set1_epi16(kMuLawBias);
+  const __m128i base = _mm_set1_epi32(kMuLawExponentBase);
+  const __m128i sign_bit = _mm_set1_epi16(0x80);
+  const __m128i all_ones = _mm_set1_epi16(0xFF);
+  auto encode8 = [&](__m128i x) {
+    const __m128i sign = _mm_srai_epi16(x, 15);
+    // Saturates -32768 to 32767.
+    __m128i magnitude = _mm_subs_epi16(_mm_xor_si128(x, sign), sign);
+    magnitude = _mm_add_epi16(_mm_min_epi16(magnitude, clip), bias);
+    const __m128i lo = _mm_sub_epi32(
+        _mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(
+                           _mm_unpacklo_epi16(magnitude, zero))),
+                       19),
+        base);
+    const __m128i hi = _mm_sub_epi32(
+        _mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(
+                           _mm_unpackhi_epi16(magnitude, zero))),
+                       19),
+        base);
+    const __m128i code = _mm_or_si128(_mm_packs_epi32(lo, hi),
+                                      _mm_and_si128(sign, sign_bit));
+    return _mm_xor_si128(code, all_ones);
+  };
+  for (; i + 16 <= size; i += 16) {
+    const __m128i a =
+        encode8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)));
+    const __m128i b = encode8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i),
+                     _mm_packus_epi16(a, b));
+  }
+#elif defined(AUDIO_REPLAY_BUFFER_NEON)
+  const int16x8_t clip = vdupq_n_s16(kMuLawClip);
+  const int16x8_t bias = vdupq_n_s16(kMuLawBias);
+  const uint32x4_t base = vdupq_n_u32(kMuLawExponentBase);
+  auto encode8 = [&](int16x8_t x) {
+    const uint16x8_t sign =
+        vandq_u16(vreinterpretq_u16_s16(vshrq_n_s16(x, 15)), vdupq_n_u16(0x80));
+    const uint16x8_t magnitude = vreinterpretq_u16_s16(
+        vaddq_s16(vminq_s16(vqabsq_s16(x), clip), bias));
+    const uint32x4_t lo = vsubq_u32(
+        vshrq_n_u32(vreinterpretq_u32_f32(
+                        vcvtq_f32_u32(vmovl_u16(vget_low_u16(magnitude)))),
+                    19),
+        base);
+    const uint32x4_t hi = vsubq_u32(
+        vshrq_n_u32(vreinterpretq_u32_f32(
+                        vcvtq_f32_u32(vmovl_u16(vget_high_u16(magnitude)))),
+                    19),
+        base);
+    const uint16x8_t code =
+        vorrq_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)), sign);
+    return vmvn_u8(vmovn_u16(code));
+  };
+  for (; i + 16 <= size; i += 16) {
+    vst1q_u8(output + i, vcombine_u8(encode8(vld1q_s16(input + i)),
+                                     encode8(vld1q_s16(input + i + 8))));
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = EncodeMuLawSample(input[i]);
+  }
+}
+
+void DecodeMuLaw(const uint8_t *input, size_t size, int16_t *output) {
+  const std::array<int16_t, 256> &table = MuLawTable();
+  for (size_t i = 0; i < size; ++i) {
+    output[i] = table[input[i]];
+  }
+}
+
+AudioReplayBuffer::AudioReplayBuffer(double seconds, int max_sample_rate)
+    : mono_(kBlockSamples), blocks_(BlockCount(seconds, max_sample_rate)),
+      storage_(blocks_.size() * kBlockSamples) {}
+
+void AudioReplayBuffer::Write(const int16_t *data, size_t frames,
+                              int sample_rate, size_t channels) {
+  if (frames == 0 || sample_rate <= 0 || channels == 0) {
+    return;
+  }
+  if (channels == 1) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Append(data, frames, sample_rate);
+    return;
+  }
+  // Mixed down at most a block at a time, so that mono_ keeps its size.
+  for (size_t done = 0; done < frames; done += mono_.size()) {
+    const size_t run = std::min(frames - done, mono_.size());
+    const int16_t *input = data + done * channels;
+    if (channels == 2) {
+      for (size_t frame = 0; frame < run; ++frame) {
+        mono_[frame] =
+            int16_t((input[2 * frame] + input[2 * frame + 1]) >> 1);
+      }
+    } else {
+      for (size_t frame = 0; frame < run; ++frame) {
+        int32_t sum = 0;
+        for (size_t channel = 0; channel < channels; ++channel) {
+          sum += input[frame * channels + channel];
+        }
+        mono_[frame] = int16_t(sum / int32_t(channels));
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Append(mono_.data(), run, sample_rate);
+  }
+}
+
+void AudioReplayBuffer::Append(const int16_t *samples, size_t size,
+                               int sample_rate) {
+  size_t done = 0;
+  while (done < size) {
+    Block *block = &blocks_[head_];
+    if (count_ == 0 || block->size == kBlockSamples ||
+        block->sample_rate != sample_rate) {
+      if (count_ > 0) {
+        head_ = (head_ + 1) % blocks_.size();
+        block = &blocks_[head_];
+      }
+      count_ = std::min(count_ + 1, blocks_.size());
+      block->sample_rate = sample_rate;
+      block->size = 0;
+    }
+    const size_t run = std::min(size - done, kBlockSamples - block->size);
+    EncodeMuLaw(samples + done, run,
+                &storage_[head_ * kBlockSamples + block->size]);
+    block->size += run;
+    done += run;
+  }
+}
+
+AudioReplayBuffer::Clip AudioReplayBuffer::Snapshot(double seconds) const {
+  Clip clip;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return clip;
+  }
+  clip.sample_rate = blocks_[head_].sample_rate;
+  size_t wanted = seconds > 0 ? size_t(seconds * clip.sample_rate) : SIZE_MAX;
+  // Walk back from the newest block to find where the clip starts.
+  size_t first = head_;
+  size_t total = 0;
+  for (size_t i = 0; i < count_; ++i) {
+    const size_t index = (head_ + blocks_.size() - i) % blocks_.size();
+    if (blocks_[index].sample_rate != clip.sample_rate || total >= wanted) {
+      break;
+    }
+    total += blocks_[index].size;
+    first = index;
+  }
+  const size_t skip = total > wanted ? total - wanted : 0;
+  clip.samples.reserve(total - skip);
+  for (size_t index = first;; index = (index + 1) % blocks_.size()) {
+    const uint8_t *begin = &storage_[index * kBlockSamples];
+    const size_t size = blocks_[index].size;
+    const size_t offset = index == first ? std::min(skip, size) : 0;
+    clip.samples.insert(clip.samples.end(), begin + offset, begin + size);
+    if (index == head_) {
+      break;
+    }
+  }
+  return clip;
+}
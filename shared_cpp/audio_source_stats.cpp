@@ -0,0 +1,105 @@
+#include "audio_source_stats.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUDIO_SOURCE_STATS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_SOURCE_STATS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_SOURCE_STATS_NEON
+#endif
+
+uint64_t SumOfSquaresS16(const int16_t *samples, size_t size) {
+  uint64_t sum = 0;
+  size_t i = 0;
+  // madd sums two squares per 32-bit lane, which only reaches 2^31 for two
+  // -32768 samples, so the lanes are read as unsigned and widened to 64 bits
+  // before accumulating.
+#if defined(AUDIO_SOURCE_STATS_AVX2)
+  __m256i accumulator = _mm256_setzero_si256();
+  const __m256i zero = _mm256_setzero_si256();
+  for (; i + 16 <= size; i += 16) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+    __m256i squares = _mm256_madd_epi16(x, x);
+    accumulator = _mm256_add_epi64(accumulator,
+                                   _mm256_unpacklo_epi32(squares, zero));
+    accumulator = _mm256_add_epi64(accumulator,
+                                   _mm256_unpackhi_epi32(squares, zero));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), accumulator);
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(AUDIO_SOURCE_STATS_SSE2)
+  __m128i accumulator = _mm_setzero_si128();
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= size; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+    __m128i squares = _mm_madd_epi16(x, x);
+    accumulator =
+        _mm_add_epi64(accumulator, _mm_unpacklo_epi32(squares, zero));
+    accumulator =
+        _mm_add_epi64(accumulator, _mm_unpackhi_epi32(squares, zero));
+  }
+  alignas(16) uint64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), accumulator);
+  sum = lanes[0] + lanes[1];
+#elif defined(AUDIO_SOURCE_STATS_NEON)
+  // Single squares fit in int32, so they can be pairwise added straight into
+  // 64-bit lanes.
+  int64x2_t accumulator = vdupq_n_s64(0);
+  for (; i + 8 <= size; i += 8) {
+    int16x8_t x = vld1q_s16(samples + i);
+    accumulator =
+        vpadalq_s32(accumulator, vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+    accumulator = vpadalq_s32(accumulator,
+                              vmull_s16(vget_high_s16(x), vget_high_s16(x)));
+  }
+  sum = uint64_t(vgetq_lane_s64(accumulator, 0) +
+                 vgetq_lane_s64(accumulator, 1));
+#endif
+  for (; i < size; ++i) {
+    sum += uint64_t(int32_t(samples[i]) * samples[i]);
+  }
+  return sum;
+}
+
+void AudioSourceStatsAccumulator::Process(const int16_t *data, size_t frames,
+                                          int sample_rate, size_t channels) {
+  if (frames == 0 || sample_rate <= 0 || channels == 0) {
+    return;
+  }
+  const size_t samples = frames * channels;
+  const uint64_t sum_of_squares = SumOfSquaresS16(data, samples);
+  const double duration = double(frames) / sample_rate;
+  const double mean_square =
+      double(sum_of_squares) / (double(samples) * 32768.0 * 32768.0);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshot_.total_audio_energy += mean_square * duration;
+  snapshot_.total_duration += duration;
+  window_sum_of_squares_ += sum_of_squares;
+  window_samples_ += samples;
+  window_duration_ += duration;
+  // With some slack, as ten 10 ms callbacks add up to slightly less than
+  // 0.1 s in floating point.
+  if (window_duration_ >= kLevelWindowSeconds * (1 - 1e-9)) {
+    snapshot_.audio_level =
+        std::sqrt(double(window_sum_of_squares_) /
+                  (double(window_samples_) * 32768.0 * 32768.0));
+    window_sum_of_squares_ = 0;
+    window_samples_ = 0;
+    window_duration_ = 0;
+  }
+}
+
+AudioSourceStatsAccumulator::Snapshot
+AudioSourceStatsAccumulator::GetSnapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return snapshot_;
+}
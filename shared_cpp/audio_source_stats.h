@@ -0,0 +1,50 @@
+#ifndef AUDIO_SOURCE_STATS_H
+#define AUDIO_SOURCE_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Returns the sum of squares of |size| int16 samples, vectorized with SSE2,
+// AVX2 or NEON where available. Exact for any input length.
+uint64_t SumOfSquaresS16(const int16_t *samples, size_t size);
+
+// Computes the audio level counters of WebRTC's RTCAudioSourceStats from the
+// audio callbacks of a track, so they can be read without a getStats()
+// round trip:
+//   audio_level         linear level in [0, 1] over the last complete
+//                       kLevelWindowSeconds, 1.0 being a full scale signal
+//   total_audio_energy  sum of level^2 * duration over all callbacks
+//   total_duration      seconds of audio processed
+// Levels are RMS based, as RFC 6464 audio levels, so the average level over
+// any interval is sqrt(delta energy / delta duration). libwebrtc's own
+// audioLevel is derived from sample peaks and therefore reads higher.
+class AudioSourceStatsAccumulator {
+public:
+  static constexpr double kLevelWindowSeconds = 0.1;
+
+  struct Snapshot {
+    double audio_level = 0;
+    double total_audio_energy = 0;
+    double total_duration = 0;
+  };
+
+public:
+  // Feeds one callback of interleaved 16-bit audio. Called on the audio
+  // thread.
+  void Process(const int16_t *data, size_t frames, int sample_rate,
+               size_t channels);
+
+  // May be called from any thread.
+  Snapshot GetSnapshot() const;
+
+private:
+  mutable std::mutex mutex_;
+  Snapshot snapshot_;
+  // Level window in progress.
+  uint64_t window_sum_of_squares_ = 0;
+  uint64_t window_samples_ = 0;
+  double window_duration_ = 0;
+};
+
+#endif // AUDIO_SOURCE_STATS_H
@@ -1,4 +1,5 @@
 #include "audio_visualizer.h"
+#include "math_extras.h"
 
 #include <algorithm>
 #include <chrono>
@@ -11,7 +12,8 @@ double CurrentTime() {
          1000.0;
 }
 
-int magnitudeIndex(std::vector<float> magnitudes, float frequency,
+template <typename T>
+int magnitudeIndex(const std::vector<T> &magnitudes, float frequency,
                    float sampleRate) {
   return static_cast<int>(float(magnitudes.size()) * frequency / sampleRate /
                           2);
@@ -49,6 +51,40 @@ std::vector<float> computeBands(std::vector<float> magnitudes,
   return bandMagnitudes;
 }
 
+/// Fixed point variant of computeBands(): averages Q10 log2 magnitudes per
+/// band in integer arithmetic and converts one value per band to decibels.
+std::vector<float> computeFixedPointBands(const std::vector<int32_t> &log2s,
+                                          float minFrequency,
+                                          float maxFrequency, int bandsCount,
+                                          float sampleRate) {
+  float actualMaxFrequency = std::min(sampleRate / 2, maxFrequency);
+  std::vector<float> bandMagnitudes(bandsCount, 0.0f);
+
+  int magLowerRange = magnitudeIndex(log2s, minFrequency, sampleRate);
+  int magUpperRange = magnitudeIndex(log2s, actualMaxFrequency, sampleRate);
+  float ratio = float(magUpperRange - magLowerRange) / float(bandsCount);
+
+  for (int i = 0; i < bandsCount; ++i) {
+    int magsStartIdx =
+        static_cast<int>(floorf(float(i) * ratio)) + magLowerRange;
+    int magsEndIdx =
+        static_cast<int>(floorf(float(i + 1) * ratio)) + magLowerRange;
+
+    int count = magsEndIdx - magsStartIdx;
+    int32_t log2_value = log2s[magsStartIdx];
+    if (count > 0) {
+      int64_t sum = 0;
+      for (int j = magsStartIdx; j < magsEndIdx; ++j) {
+        sum += log2s[j];
+      }
+      log2_value = static_cast<int32_t>(sum / count);
+    }
+    bandMagnitudes[i] = FixedPointFFTProcessor::Log2ToDecibels(log2_value);
+  }
+
+  return bandMagnitudes;
+}
+
 /// Centers the sorted bands by placing higher values in the middle.
 std::vector<float> centerBands(const std::vector<float> &sortedBands) {
   std::vector<float> centeredBands(sortedBands.size(), 0);
@@ -73,33 +109,52 @@ std::vector<float> centerBands(const std::vector<float> &sortedBands) {
 AudioVisualizer::AudioVisualizer(int bands_count, bool is_centered,
                                  double smoothing_time_constant,
                                  float min_frequency, float max_frequency,
-                                 float min_db, float max_db)
+                                 float min_db, float max_db,
+                                 bool use_fixed_point, unsigned fft_size)
     : bands_count_(bands_count), is_centered_(is_centered),
       min_frequency_(min_frequency), max_frequency_(max_frequency),
       min_db_(min_db), max_db_(max_db),
-      smoothing_time_constant_(smoothing_time_constant),
-      bands_(bands_count, 0.0f),
-      fft_processor_(std::make_unique<FFTProcessor>(
-          FFTProcessor::kDefaultFFTSize, smoothing_time_constant_)) {}
+      smoothing_time_constant_(smoothing_time_constant), fft_size_(fft_size),
+      bands_(bands_count, 0.0f) {
+  if (use_fixed_point) {
+    fixed_point_processor_ = std::make_unique<FixedPointFFTProcessor>(
+        fft_size_, smoothing_time_constant_);
+    log2_magnitudes_.resize(fft_size_ / 2, 0);
+  } else {
+    fft_processor_ = std::make_unique<FFTProcessor>(fft_size_,
+                                                    smoothing_time_constant_);
+  }
+}
 
 AudioVisualizer::~AudioVisualizer() {}
 
 bool AudioVisualizer::Process(const int16_t *audioData, unsigned int numSamples,
                               float sampleRate, std::vector<float> &output) {
 
-  fft_processor_->WriteInput(audioData, numSamples);
-  std::vector<float> magnitudes(FFTProcessor::kDefaultFFTSize / 2, 0.0f);
-  fft_processor_->GetFloatFrequencyData(magnitudes, CurrentTime());
-
-  auto bands = computeBands(magnitudes, min_frequency_, max_frequency_,
-                            bands_count_, sampleRate);
-
-  for (int i = 0; i < bands.size(); ++i) {
-    float db = 1.0f - (fmax(min_db_, fmin(max_db_, bands[i])) * -1.0f) / 100.0f;
-    db = std::sqrt(db);
-    bands_[i] = db;
+  std::vector<float> bands;
+  if (fixed_point_processor_) {
+    fixed_point_processor_->WriteInput(audioData, numSamples);
+    fixed_point_processor_->GetLog2FrequencyData(log2_magnitudes_,
+                                                 CurrentTime());
+    bands = computeFixedPointBands(log2_magnitudes_, min_frequency_,
+                                   max_frequency_, bands_count_, sampleRate);
+  } else {
+    fft_processor_->WriteInput(audioData, numSamples);
+    std::vector<float> magnitudes(fft_size_ / 2, 0.0f);
+    fft_processor_->GetFloatFrequencyData(magnitudes, CurrentTime());
+
+    bands = computeBands(magnitudes, min_frequency_, max_frequency_,
+                         bands_count_, sampleRate);
   }
 
+  // sqrt(1 - (-clamp(db) / 100)) per band.
+  FastMathTransform(
+      bands.data(), bands_.data(), bands.size(), [this](auto ops, auto db) {
+        using Ops = decltype(ops);
+        db = Ops::Max(Ops::Set(min_db_), Ops::Min(Ops::Set(max_db_), db));
+        return FastSqrt<Ops>(Ops::MulAdd(db, Ops::Set(0.01f), Ops::Set(1.0f)));
+      });
+
   if (is_centered_) {
     std::sort(bands_.begin(), bands_.end(), std::greater<float>());
     bands_ = centerBands(bands_);
@@ -2,6 +2,7 @@
 #define AUDIO_VISUALIZER_H
 
 #include "fft_processor.h"
+#include "fixed_point_fft.h"
 
 #include <complex>
 #include <iostream>
@@ -15,6 +16,11 @@ public:
   static constexpr float kDefaultMaxFrequency = 8000.0f; // Hz
   static constexpr float kDefaultMinDb = -100.0f;
   static constexpr float kDefaultMaxDb = -30.0f;
+#if defined(LIVEKIT_FIXED_POINT_ANALYSIS)
+  static constexpr bool kDefaultUseFixedPoint = true;
+#else
+  static constexpr bool kDefaultUseFixedPoint = false;
+#endif
 
 public:
   AudioVisualizer(
@@ -22,7 +28,9 @@ public:
       double smoothing_time_constant = kDefaultSmoothingTimeConstant,
       float min_frequency = kDefaultMinFrequency,
       float max_frequency = kDefaultMaxFrequency, float min_db = kDefaultMinDb,
-      float max_db = kDefaultMaxDb);
+      float max_db = kDefaultMaxDb,
+      bool use_fixed_point = kDefaultUseFixedPoint,
+      unsigned fft_size = FFTProcessor::kDefaultFFTSize);
 
   ~AudioVisualizer();
 
@@ -37,8 +45,13 @@ private:
   float min_db_;
   float max_db_;
   double smoothing_time_constant_;
+  unsigned fft_size_;
   std::vector<float> bands_;
   std::unique_ptr<FFTProcessor> fft_processor_;
+  // Integer pipeline used instead of |fft_processor_| when fixed point
+  // analysis is enabled; bins are only converted to float per band.
+  std::unique_ptr<FixedPointFFTProcessor> fixed_point_processor_;
+  std::vector<int32_t> log2_magnitudes_;
 };
 
 #endif // AUDIO_VISUALIZER_H
\ No newline at end of file
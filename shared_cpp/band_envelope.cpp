@@ -0,0 +1,57 @@
+#include "band_envelope.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Share of the distance to the target covered in |elapsed_seconds| by a one
+// pole filter with time constant |time_constant_ms|.
+float Coefficient(float time_constant_ms, double elapsed_seconds) {
+  if (time_constant_ms <= 0) {
+    return 1.0f;
+  }
+  return float(1.0 - std::exp(-elapsed_seconds * 1000.0 / time_constant_ms));
+}
+
+} // namespace
+
+BandEnvelope::BandEnvelope(const Options &options) : options_(options) {}
+
+void BandEnvelope::Process(const float *targets, size_t count,
+                           double elapsed_seconds) {
+  if (values_.size() != count) {
+    // Start from the targets rather than animating in from zero.
+    values_.assign(targets, targets + count);
+    peaks_ = values_;
+    hold_remaining_.assign(count, options_.peak_hold_ms * 0.001f);
+    return;
+  }
+  elapsed_seconds = std::max(0.0, elapsed_seconds);
+  const float attack = Coefficient(options_.attack_ms, elapsed_seconds);
+  const float release = Coefficient(options_.release_ms, elapsed_seconds);
+  const float elapsed = float(elapsed_seconds);
+  const float hold = options_.peak_hold_ms * 0.001f;
+  const float fall = options_.peak_fall_per_second * elapsed;
+  for (size_t i = 0; i < count; ++i) {
+    float value = values_[i];
+    const float target = targets[i];
+    value += (target - value) * (target > value ? attack : release);
+    values_[i] = value;
+
+    if (value >= peaks_[i]) {
+      peaks_[i] = value;
+      hold_remaining_[i] = hold;
+    } else if (hold_remaining_[i] > 0) {
+      hold_remaining_[i] -= elapsed;
+    } else {
+      peaks_[i] = std::max(value, peaks_[i] - fall);
+    }
+  }
+}
+
+void BandEnvelope::Reset() {
+  values_.clear();
+  peaks_.clear();
+  hold_remaining_.clear();
+}
@@ -0,0 +1,45 @@
+#ifndef BAND_ENVELOPE_H
+#define BAND_ENVELOPE_H
+
+#include <cstddef>
+#include <vector>
+
+// Attack/release envelope follower with peak hold for visualizer bands, so
+// that UIs can draw bars and peak markers as they come instead of animating
+// every bar between frames.
+//
+// Each band follows its target with a one pole filter whose time constant is
+// |attack_ms| while rising and |release_ms| while falling. Peaks jump to the
+// value, stay for |peak_hold_ms| and then fall linearly, never below the
+// value. Evaluate at the rate frames are shown: the coefficients are derived
+// from the elapsed time, so irregular intervals give the same motion.
+class BandEnvelope {
+public:
+  struct Options {
+    float attack_ms = 20.0f;
+    float release_ms = 250.0f;
+    float peak_hold_ms = 500.0f;
+    // Full scale is 1.
+    float peak_fall_per_second = 1.0f;
+  };
+
+  explicit BandEnvelope(const Options &options);
+
+  // Advances every band by |elapsed_seconds| towards |targets|. Resets the
+  // state when the band count changes.
+  void Process(const float *targets, size_t count, double elapsed_seconds);
+
+  void Reset();
+
+  const std::vector<float> &values() const { return values_; }
+  const std::vector<float> &peaks() const { return peaks_; }
+
+private:
+  Options options_;
+  std::vector<float> values_;
+  std::vector<float> peaks_;
+  // Hold time left per peak, in seconds.
+  std::vector<float> hold_remaining_;
+};
+
+#endif // BAND_ENVELOPE_H
@@ -0,0 +1,252 @@
+#include "echo_leak_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+namespace {
+
+constexpr unsigned kReferenceLength =
+    EchoLeakDetector::kCaptureWindow + EchoLeakDetector::kMaxDelay;
+static_assert(kReferenceLength <= EchoLeakDetector::kFFTSize,
+              "correlation would wrap around");
+
+// Windows below kMinLevelDb, as an energy per sample of a [-1, 1] signal.
+const double kMinEnergyPerSample =
+    std::pow(10.0, EchoLeakDetector::kMinLevelDb / 10.0);
+
+float *AllocateBuffer() {
+  float *buffer = static_cast<float *>(
+      pffft_aligned_malloc(EchoLeakDetector::kFFTSize * sizeof(float)));
+  memset(buffer, 0, EchoLeakDetector::kFFTSize * sizeof(float));
+  return buffer;
+}
+
+} // namespace
+
+// static
+bool EchoLeakDetector::IsSamePath(const Estimate &a, const Estimate &b) {
+  return a.reference_index == b.reference_index &&
+         std::max(a.delay, b.delay) - std::min(a.delay, b.delay) <=
+             kDelayTolerance;
+}
+
+void EchoLeakDetector::History::CopyLatest(float *destination,
+                                           size_t count) const {
+  size_t available =
+      static_cast<size_t>(std::min<uint64_t>(total_, samples_.size()));
+  size_t missing = count > available ? count - available : 0;
+  memset(destination, 0, missing * sizeof(float));
+  destination += missing;
+  count -= missing;
+
+  size_t start = (write_index_ + samples_.size() - count) % samples_.size();
+  size_t first = std::min(count, samples_.size() - start);
+  memcpy(destination, samples_.data() + start, first * sizeof(float));
+  memcpy(destination + first, samples_.data(), (count - first) * sizeof(float));
+}
+
+void EchoLeakDetector::Decimator::Process(const int16_t *data, size_t frames,
+                                          int sample_rate, size_t channels,
+                                          History &history) {
+  if (sample_rate < kAnalysisSampleRate || channels == 0) {
+    return;
+  }
+  if (sample_rate != sample_rate_) {
+    sample_rate_ = sample_rate;
+    phase_ = 0;
+    sum_ = 0;
+    count_ = 0;
+  }
+
+  const float scale = 1.0f / (32768.0f * channels);
+  for (size_t i = 0; i < frames; ++i) {
+    int32_t frame_sum = 0;
+    for (size_t c = 0; c < channels; ++c) {
+      frame_sum += data[i * channels + c];
+    }
+    sum_ += frame_sum * scale;
+    ++count_;
+    // Emit one output every sample_rate / kAnalysisSampleRate inputs, which
+    // also handles rates that are not a multiple, such as 44.1 kHz.
+    phase_ += kAnalysisSampleRate;
+    if (phase_ >= sample_rate_) {
+      phase_ -= sample_rate_;
+      history.Push(sum_ / count_);
+      sum_ = 0;
+      count_ = 0;
+    }
+  }
+}
+
+EchoLeakDetector::EchoLeakDetector(size_t reference_count,
+                                   float coherence_threshold)
+    : coherence_threshold_(coherence_threshold),
+      references_(reference_count), capture_history_(kCaptureWindow),
+      capture_window_(kCaptureWindow, 0.0f),
+      reference_energy_(kReferenceLength + 1, 0.0) {
+  setup_ = pffft_new_setup(kFFTSize, PFFFT_REAL);
+  capture_spectrum_ = AllocateBuffer();
+  reference_spectrum_ = AllocateBuffer();
+  time_buffer_ = AllocateBuffer();
+  product_ = AllocateBuffer();
+  scratch_ = AllocateBuffer();
+}
+
+EchoLeakDetector::~EchoLeakDetector() {
+  pffft_aligned_free(capture_spectrum_);
+  pffft_aligned_free(reference_spectrum_);
+  pffft_aligned_free(time_buffer_);
+  pffft_aligned_free(product_);
+  pffft_aligned_free(scratch_);
+  pffft_destroy_setup(setup_);
+}
+
+void EchoLeakDetector::ProcessReference(size_t index, const int16_t *data,
+                                        size_t frames, int sample_rate,
+                                        size_t channels) {
+  if (index >= references_.size()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(references_mutex_);
+  Reference &reference = references_[index];
+  reference.decimator.Process(data, frames, sample_rate, channels,
+                              reference.history);
+  reference.capture_clock = capture_clock_.load(std::memory_order_relaxed);
+}
+
+bool EchoLeakDetector::ProcessCapture(const int16_t *data, size_t frames,
+                                      int sample_rate, size_t channels,
+                                      Alert *alert) {
+  capture_decimator_.Process(data, frames, sample_rate, channels,
+                             capture_history_);
+  capture_clock_.store(capture_history_.total(), std::memory_order_relaxed);
+  if (capture_history_.total() < next_analysis_) {
+    return false;
+  }
+  next_analysis_ = capture_history_.total() + kHopSize;
+
+  Estimate estimate;
+  bool analysed = Analyze(&estimate);
+  return UpdateState(analysed, estimate, alert);
+}
+
+bool EchoLeakDetector::Analyze(Estimate *estimate) {
+  capture_history_.CopyLatest(capture_window_.data(), kCaptureWindow);
+  double capture_energy = 0;
+  for (float sample : capture_window_) {
+    capture_energy += sample * sample;
+  }
+  bool capture_active =
+      capture_energy >= kMinEnergyPerSample * kCaptureWindow;
+
+  if (capture_active) {
+    // Correlation is convolution with the time-reversed capture, and for a
+    // real signal circular time reversal is conjugation of its spectrum.
+    memset(time_buffer_, 0, kFFTSize * sizeof(float));
+    time_buffer_[0] = capture_window_[0];
+    for (unsigned i = 1; i < kCaptureWindow; ++i) {
+      time_buffer_[kFFTSize - i] = capture_window_[i];
+    }
+    pffft_transform(setup_, time_buffer_, capture_spectrum_, scratch_,
+                    PFFFT_FORWARD);
+  }
+
+  bool any_reference_active = false;
+  const uint64_t capture_clock = capture_history_.total();
+  for (size_t index = 0; index < references_.size(); ++index) {
+    memset(time_buffer_, 0, kFFTSize * sizeof(float));
+    {
+      std::lock_guard<std::mutex> lock(references_mutex_);
+      const Reference &reference = references_[index];
+      if (reference.history.total() == 0 ||
+          capture_clock - std::min(capture_clock, reference.capture_clock) >
+              kHopSize) {
+        continue;
+      }
+      reference.history.CopyLatest(time_buffer_, kReferenceLength);
+    }
+
+    // reference_energy_[j] is the energy of the first j reference samples.
+    for (unsigned j = 0; j < kReferenceLength; ++j) {
+      reference_energy_[j + 1] =
+          reference_energy_[j] + time_buffer_[j] * time_buffer_[j];
+    }
+    if (reference_energy_[kReferenceLength] <
+        kMinEnergyPerSample * kReferenceLength) {
+      continue;
+    }
+    any_reference_active = true;
+    if (!capture_active) {
+      continue;
+    }
+
+    pffft_transform(setup_, time_buffer_, reference_spectrum_, scratch_,
+                    PFFFT_FORWARD);
+    memset(product_, 0, kFFTSize * sizeof(float));
+    pffft_zconvolve_accumulate(setup_, capture_spectrum_, reference_spectrum_,
+                               product_, 1.0f / kFFTSize);
+    pffft_transform(setup_, product_, time_buffer_, scratch_, PFFFT_BACKWARD);
+
+    // time_buffer_[k] now sums capture[i] * reference[i + k]. The reference
+    // window ends with the capture window, so lag k is a delay of
+    // kMaxDelay - k.
+    for (unsigned k = 0; k <= kMaxDelay; ++k) {
+      double energy = reference_energy_[k + kCaptureWindow] -
+                      reference_energy_[k];
+      if (energy < kMinEnergyPerSample * kCaptureWindow) {
+        continue;
+      }
+      float correlation = time_buffer_[k];
+      float coherence = static_cast<float>(
+          std::fabs(correlation) / std::sqrt(capture_energy * energy));
+      if (coherence > estimate->coherence) {
+        estimate->reference_index = index;
+        estimate->delay = kMaxDelay - k;
+        estimate->coherence = std::min(coherence, 1.0f);
+        estimate->coupling_db = static_cast<float>(
+            20 * std::log10(std::fabs(correlation) / energy + 1e-12));
+      }
+    }
+  }
+  return any_reference_active;
+}
+
+bool EchoLeakDetector::UpdateState(bool analysed, const Estimate &estimate,
+                                   Alert *alert) {
+  // Nothing to learn while the remote side is silent.
+  if (!analysed) {
+    return false;
+  }
+
+  bool changed = false;
+  if (estimate.coherence >= coherence_threshold_) {
+    bool consistent = streak_ > 0 && IsSamePath(estimate, candidate_);
+    streak_ = consistent ? streak_ + 1 : 1;
+    candidate_ = estimate;
+    clean_streak_ = 0;
+    if (!detected_ && streak_ >= kConfirmations) {
+      detected_ = true;
+      changed = true;
+      reported_ = estimate;
+    } else if (detected_ && IsSamePath(estimate, reported_)) {
+      reported_ = estimate;
+    }
+  } else {
+    streak_ = 0;
+    if (detected_ && ++clean_streak_ >= kConfirmations) {
+      detected_ = false;
+      changed = true;
+    }
+  }
+
+  if (changed && alert) {
+    alert->echo_detected = detected_;
+    alert->reference_index = reported_.reference_index;
+    alert->delay_ms =
+        reported_.delay * 1000.0f / static_cast<float>(kAnalysisSampleRate);
+    alert->coupling_db = reported_.coupling_db;
+    alert->coherence = estimate.coherence;
+  }
+  return changed;
+}
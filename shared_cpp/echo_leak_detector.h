@@ -0,0 +1,175 @@
+#ifndef ECHO_LEAK_DETECTOR_H
+#define ECHO_LEAK_DETECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "pffft.h"
+
+// Detects remote audio leaking from the speakers into the local microphone,
+// the usual cause of remote participants hearing themselves.
+//
+// Both the remote audio (the reference, one stream per remote track) and the
+// local capture are downmixed and decimated to kAnalysisSampleRate. Every
+// kHopSize new capture samples, the latest kCaptureWindow capture samples are
+// cross-correlated against the matching reference history over lags
+// [0, kMaxDelay] with a single FFT-based correlation per reference: the
+// capture spectrum is computed once, multiplied with each reference spectrum
+// through pffft_zconvolve_accumulate() and transformed back. The lag with the
+// highest normalized correlation gives the speaker-to-microphone delay and
+// the gain along that path gives the coupling.
+//
+// Echo is reported once kConfirmations consecutive analyses exceed the
+// coherence threshold at a consistent delay, and cleared after as many
+// analyses without it. Only these transitions are reported, so callers see
+// alerts rather than a continuous stream of measurements.
+class EchoLeakDetector {
+public:
+  static constexpr int kAnalysisSampleRate = 8000;
+  // Capture audio correlated per analysis (512 ms).
+  static constexpr unsigned kCaptureWindow = 4096;
+  // Longest speaker-to-microphone delay searched (512 ms).
+  static constexpr unsigned kMaxDelay = 4096;
+  // Correlation length; reference history plus padding must not wrap.
+  static constexpr unsigned kFFTSize = 8192;
+  // New capture audio between two analyses (250 ms).
+  static constexpr unsigned kHopSize = 2000;
+  static constexpr float kDefaultCoherenceThreshold = 0.25f;
+  static constexpr int kConfirmations = 3;
+  // Largest delay change, in analysis samples, still considered consistent.
+  static constexpr unsigned kDelayTolerance = 8;
+  // Windows quieter than this, in dBFS, are not analysed.
+  static constexpr float kMinLevelDb = -55.0f;
+
+  struct Alert {
+    bool echo_detected = false;
+    // Reference stream the echo was found in.
+    size_t reference_index = 0;
+    float delay_ms = 0;
+    // Gain from the reference to the capture along the echo path, in dB.
+    float coupling_db = 0;
+    // Normalized cross-correlation at the detected delay, in [0, 1].
+    float coherence = 0;
+  };
+
+public:
+  explicit EchoLeakDetector(
+      size_t reference_count,
+      float coherence_threshold = kDefaultCoherenceThreshold);
+  ~EchoLeakDetector();
+
+  EchoLeakDetector(const EchoLeakDetector &) = delete;
+  EchoLeakDetector &operator=(const EchoLeakDetector &) = delete;
+
+  // Feeds interleaved 16-bit audio of reference stream |index|. May be called
+  // from any thread.
+  void ProcessReference(size_t index, const int16_t *data, size_t frames,
+                        int sample_rate, size_t channels);
+
+  // Feeds interleaved 16-bit capture audio and runs an analysis once per hop.
+  // Returns true and fills |alert| when the detection state changed. Must
+  // always be called from the same thread.
+  bool ProcessCapture(const int16_t *data, size_t frames, int sample_rate,
+                      size_t channels, Alert *alert);
+
+  bool echo_detected() const { return detected_; }
+  size_t reference_count() const { return references_.size(); }
+
+private:
+  // Fixed-size history of decimated samples.
+  class History {
+  public:
+    explicit History(size_t size) : samples_(size, 0.0f) {}
+
+    void Push(float sample) {
+      samples_[write_index_] = sample;
+      if (++write_index_ == samples_.size()) {
+        write_index_ = 0;
+      }
+      ++total_;
+    }
+
+    // Copies the latest |count| samples, oldest first, zero-filling what has
+    // not been written yet.
+    void CopyLatest(float *destination, size_t count) const;
+
+    uint64_t total() const { return total_; }
+
+  private:
+    std::vector<float> samples_;
+    size_t write_index_ = 0;
+    uint64_t total_ = 0;
+  };
+
+  // Averages all channels and boxcar-decimates to kAnalysisSampleRate.
+  class Decimator {
+  public:
+    void Process(const int16_t *data, size_t frames, int sample_rate,
+                 size_t channels, History &history);
+
+  private:
+    int sample_rate_ = 0;
+    int phase_ = 0;
+    float sum_ = 0;
+    int count_ = 0;
+  };
+
+  struct Reference {
+    Reference() : history(kCaptureWindow + kMaxDelay) {}
+
+    Decimator decimator;
+    History history;
+    // Capture clock when this reference was last written, to skip
+    // references that stopped receiving audio.
+    uint64_t capture_clock = 0;
+  };
+
+  struct Estimate {
+    size_t reference_index = 0;
+    unsigned delay = 0;
+    float coupling_db = 0;
+    float coherence = 0;
+  };
+
+  // Correlates the latest capture window against every active reference.
+  // Returns false if capture or all references are too quiet to tell.
+  bool Analyze(Estimate *estimate);
+
+  bool UpdateState(bool analysed, const Estimate &estimate, Alert *alert);
+
+  // Whether two estimates describe the same echo path.
+  static bool IsSamePath(const Estimate &a, const Estimate &b);
+
+private:
+  float coherence_threshold_;
+  std::vector<Reference> references_;
+  std::mutex references_mutex_;
+
+  Decimator capture_decimator_;
+  History capture_history_;
+  std::atomic<uint64_t> capture_clock_{0};
+  uint64_t next_analysis_ = kCaptureWindow;
+
+  PFFFT_Setup *setup_ = nullptr;
+  // pffft_aligned_malloc() buffers of kFFTSize floats.
+  float *capture_spectrum_ = nullptr;
+  float *reference_spectrum_ = nullptr;
+  float *time_buffer_ = nullptr;
+  float *product_ = nullptr;
+  float *scratch_ = nullptr;
+  std::vector<float> capture_window_;
+  std::vector<double> reference_energy_;
+
+  bool detected_ = false;
+  int streak_ = 0;
+  int clean_streak_ = 0;
+  // Latest estimate above the threshold.
+  Estimate candidate_;
+  // Echo path reported in alerts, tracked while echo is detected.
+  Estimate reported_;
+};
+
+#endif // ECHO_LEAK_DETECTOR_H
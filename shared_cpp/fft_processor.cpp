@@ -4,28 +4,40 @@
 #include <climits>
 #include <string.h>
 
-float LinearToDecibels(float linear) { return 20 * log10f(linear); }
+std::vector<float> MakeBlackmanWindow(size_t n) {
+  float alpha = 0.16f;
+  float a0 = 0.5f * (1 - alpha);
+  float a1 = 0.5f;
+  float a2 = 0.5f * alpha;
 
-void ApplyWindow(float *p, size_t n) {
-
-  // Blackman window
-  double alpha = 0.16;
-  double a0 = 0.5 * (1 - alpha);
-  double a1 = 0.5;
-  double a2 = 0.5 * alpha;
-
-  for (unsigned i = 0; i < n; ++i) {
-    double x = static_cast<double>(i) / static_cast<double>(n);
-    double window =
-        a0 - a1 * cos(kTwoPiDouble * x) + a2 * cos(kTwoPiDouble * 2.0 * x);
-    p[i] *= static_cast<float>(window);
+  std::vector<float> window(n);
+  for (size_t i = 0; i < n; ++i) {
+    float x = kTwoPiFloat * static_cast<float>(i) / static_cast<float>(n);
+    window[i] = a0 - a1 * FastCos(x) + a2 * FastCos(2.0f * x);
   }
+  return window;
 }
 
-// Returns x if x is finite (not NaN or infinite), otherwise returns
-// default_value
-float EnsureFinite(float x, float default_value) {
-  return std::isfinite(x) ? x : default_value;
+// Computes destination[i] = k * destination[i] + (1 - k) * |c[i]| * scale over
+// whole Ops vectors starting at |begin| and returns the index where it
+// stopped.
+template <typename Ops>
+size_t SmoothMagnitudes(const float *real, const float *imag, size_t begin,
+                        size_t end, float scale, float k, float *destination) {
+  const auto magnitude_scale = Ops::Set(scale);
+  const auto previous_weight = Ops::Set(k);
+  const auto current_weight = Ops::Set(1 - k);
+  size_t i = begin;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    auto re = Ops::Load(real + i);
+    auto im = Ops::Load(imag + i);
+    auto magnitude = Ops::Mul(
+        FastSqrt<Ops>(Ops::MulAdd(re, re, Ops::Mul(im, im))), magnitude_scale);
+    Ops::Store(destination + i,
+               Ops::MulAdd(previous_weight, Ops::Load(destination + i),
+                           Ops::Mul(current_weight, magnitude)));
+  }
+  return i;
 }
 
 float S16ToFloatV(int16_t v) {
@@ -45,6 +57,7 @@ FFTProcessor::FFTProcessor(int fftSize, double smoothing_time_constant)
   if (smoothing_time_constant > 0.0 && smoothing_time_constant < 1.0) {
     smoothing_time_constant_ = smoothing_time_constant;
   }
+  window_ = MakeBlackmanWindow(fft_size_);
   setup_ = std::make_unique<FFTSetup>(fft_size_);
   input_buffer_ = std::make_unique<std::vector<float>>(kInputBufferSize, 0.0f);
   pffft_work_ = std::make_unique<std::vector<float>>(fft_size_, 0.0f);
@@ -112,7 +125,10 @@ void FFTProcessor::DoFFTAnalysis() {
   }
 
   // Window the input samples.
-  ApplyWindow(temp_p, fft_size_);
+  const float *window = window_.data();
+  for (unsigned i = 0; i < fft_size_; ++i) {
+    temp_p[i] *= window[i];
+  }
 
   // Do the analysis.
   ComputeFFT(temp_p, fft_size_);
@@ -122,25 +138,25 @@ void FFTProcessor::DoFFTAnalysis() {
 
   // Normalize so than an input sine wave at 0dBfs registers as 0dBfs (undo FFT
   // scaling factor).
-  const double magnitude_scale = 1.0 / fft_size_;
+  const float magnitude_scale = 1.0f / fft_size_;
 
   // A value of 0 does no averaging with the previous result.  Larger values
   // produce slower, but smoother changes.
-  const double k = ClampTo(smoothing_time_constant_, 0.0, 1.0);
+  const float k =
+      static_cast<float>(ClampTo(smoothing_time_constant_, 0.0, 1.0));
 
   // Convert the analysis data from complex to magnitude and average with the
-  // previous result.
+  // previous result. The input is 16-bit PCM, so magnitudes are bounded and
+  // squaring them in float cannot overflow.
   float *destination = magnitude_buffer_->data();
   size_t n = magnitude_buffer_->size();
 
   const float *real_p_data = real_data_->data();
   const float *imag_p_data = imag_data_->data();
-  for (size_t i = 0; i < n; ++i) {
-    std::complex<double> c(real_p_data[i], imag_p_data[i]);
-    double scalar_magnitude = abs(c) * magnitude_scale;
-    destination[i] = EnsureFinite(
-        static_cast<float>(k * destination[i] + (1 - k) * scalar_magnitude), 0);
-  }
+  size_t i = SmoothMagnitudes<NativeMathOps>(real_p_data, imag_p_data, 0, n,
+                                             magnitude_scale, k, destination);
+  SmoothMagnitudes<ScalarMathOps>(real_p_data, imag_p_data, i, n,
+                                  magnitude_scale, k, destination);
 }
 
 bool FFTProcessor::ComputeFFT(const float *input, size_t numSamples) {
@@ -179,10 +195,11 @@ void FFTProcessor::ConvertFloatToDb(std::vector<float> &destination_array) {
     const float *source = magnitude_buffer_->data();
     float *destination = destination_array.data();
 
-    for (unsigned i = 0; i < len; ++i) {
-      float linear_value = source[i];
-      double db_mag = LinearToDecibels(linear_value);
-      destination[i] = static_cast<float>(db_mag);
-    }
+    // Zero magnitudes (digital silence) come out around -765 dB instead of
+    // -inf; either way far below any display floor.
+    FastMathTransform(source, destination, len, [](auto ops, auto linear) {
+      using Ops = decltype(ops);
+      return Ops::Mul(FastLog2<Ops>(linear), Ops::Set(kLog2ToDecibels));
+    });
   }
 }
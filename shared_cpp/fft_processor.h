@@ -61,6 +61,8 @@ private:
 
 private:
   unsigned int fft_size_;
+  // Blackman window, fft_size_ entries.
+  std::vector<float> window_;
   std::unique_ptr<std::vector<float>> pffft_work_;
   std::unique_ptr<std::vector<float>> complex_data_;
   std::unique_ptr<std::vector<float>> real_data_;
@@ -0,0 +1,283 @@
+#include "fixed_point_fft.h"
+#include "math_extras.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr int kQ15Shift = 15;
+constexpr int32_t kQ15One = 1 << kQ15Shift;
+
+int16_t ToQ15(double value) {
+  return static_cast<int16_t>(
+      ClampTo<int32_t>(lround(value * kQ15One), -kQ15One, kQ15One - 1));
+}
+
+// Index of the most significant set bit of |x|, which must be non-zero.
+int HighestBit(uint32_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, x);
+  return static_cast<int>(index);
+#else
+  return 31 - __builtin_clz(x);
+#endif
+}
+
+// Complex multiply of (re, im) by a Q15 twiddle (wr, wi).
+inline void MultiplyQ15(int32_t re, int32_t im, int32_t wr, int32_t wi,
+                        int32_t *out_re, int32_t *out_im) {
+  int64_t r = int64_t(re) * wr - int64_t(im) * wi;
+  int64_t i = int64_t(re) * wi + int64_t(im) * wr;
+  *out_re = static_cast<int32_t>((r + (1 << (kQ15Shift - 1))) >> kQ15Shift);
+  *out_im = static_cast<int32_t>((i + (1 << (kQ15Shift - 1))) >> kQ15Shift);
+}
+
+// Alpha-max-plus-beta-min: max(mx, 7/8 mx + 1/2 mn) stays within 3% of the
+// true magnitude.
+inline int32_t ApproximateMagnitude(int32_t re, int32_t im) {
+  int32_t a = std::abs(re);
+  int32_t b = std::abs(im);
+  int32_t mx = std::max(a, b);
+  int32_t mn = std::min(a, b);
+  return std::max(mx, mx - (mx >> 3) + (mn >> 1));
+}
+
+// log2(x) in Q10 for x > 0. The mantissa uses log2(1 + f) ~= f + c*f*(1 - f),
+// which is within 0.008 (0.05 dB) of the exact value.
+inline int32_t Log2Q10(uint32_t x) {
+  int n = HighestBit(x);
+  // Q15 fraction of the normalized mantissa.
+  int32_t f = static_cast<int32_t>(((x << (31 - n)) >> 16) & 0x7fff);
+  int32_t correction = (f * (kQ15One - f)) >> kQ15Shift;
+  int32_t log2_q15 = f + ((correction * 11360) >> kQ15Shift);
+  return (n << FixedPointFFTProcessor::kLog2FractionBits) +
+         (log2_q15 >> (kQ15Shift - FixedPointFFTProcessor::kLog2FractionBits));
+}
+
+} // namespace
+
+FixedPointFFTProcessor::FixedPointFFTProcessor(int fftSize,
+                                               double smoothing_time_constant)
+    : fft_size_(kDefaultFFTSize) {
+  if (fftSize >= static_cast<int>(kMinFFTSize) &&
+      fftSize <= static_cast<int>(kMaxFFTSize) &&
+      (fftSize & (fftSize - 1)) == 0) {
+    fft_size_ = fftSize;
+  }
+  double smoothing = kDefaultSmoothingTimeConstant;
+  if (smoothing_time_constant > 0.0 && smoothing_time_constant < 1.0) {
+    smoothing = smoothing_time_constant;
+  }
+  smoothing_q15_ = ToQ15(smoothing);
+
+  unsigned half_size = fft_size_ / 2;
+  log2_half_size_ = static_cast<unsigned>(HighestBit(half_size));
+
+  // Same Blackman window as FFTProcessor.
+  double alpha = 0.16;
+  double a0 = 0.5 * (1 - alpha);
+  double a1 = 0.5;
+  double a2 = 0.5 * alpha;
+  window_.resize(fft_size_);
+  for (unsigned i = 0; i < fft_size_; ++i) {
+    double x = static_cast<double>(i) / static_cast<double>(fft_size_);
+    window_[i] = ToQ15(a0 - a1 * cos(kTwoPiDouble * x) +
+                       a2 * cos(kTwoPiDouble * 2.0 * x));
+  }
+
+  twiddles_.resize(fft_size_ * 2);
+  for (unsigned k = 0; k < fft_size_; ++k) {
+    double phase = kTwoPiDouble * k / fft_size_;
+    twiddles_[2 * k] = ToQ15(cos(phase));
+    twiddles_[2 * k + 1] = ToQ15(-sin(phase));
+  }
+
+  bit_reverse_.resize(half_size);
+  for (unsigned i = 0; i < half_size; ++i) {
+    unsigned reversed = 0;
+    for (unsigned bit = 0; bit < log2_half_size_; ++bit) {
+      reversed |= ((i >> bit) & 1) << (log2_half_size_ - 1 - bit);
+    }
+    bit_reverse_[i] = reversed;
+  }
+
+  work_.resize(fft_size_, 0);
+  magnitude_buffer_.resize(half_size, 0);
+  input_buffer_.resize(kInputBufferSize, 0);
+}
+
+FixedPointFFTProcessor::~FixedPointFFTProcessor() {}
+
+void FixedPointFFTProcessor::WriteInput(const int16_t *input,
+                                        unsigned int frames_to_process) {
+  // Samples stay int16 all the way into the window; there is no S16ToFloat.
+  unsigned int write_index = GetWriteIndex();
+  if (write_index + frames_to_process >= kInputBufferSize) {
+    write_index = 0;
+  }
+  memcpy(input_buffer_.data() + write_index, input,
+         frames_to_process * sizeof(int16_t));
+  write_index += frames_to_process;
+
+  SetWriteIndex(write_index);
+}
+
+void FixedPointFFTProcessor::GetLog2FrequencyData(
+    std::vector<int32_t> &destination_array, double current_time) {
+  if (current_time > last_analysis_time_) {
+    last_analysis_time_ = current_time;
+    DoFFTAnalysis();
+  }
+  ConvertToLog2(destination_array);
+}
+
+float FixedPointFFTProcessor::Log2ToDecibels(int32_t log2_value) {
+  // 20 * log10(2) dB per octave of magnitude.
+  constexpr float kDecibelsPerLog2Unit =
+      6.0205999f / static_cast<float>(1 << kLog2FractionBits);
+  return static_cast<float>(log2_value) * kDecibelsPerLog2Unit;
+}
+
+void FixedPointFFTProcessor::DoFFTAnalysis() {
+  const int16_t *input_buffer = input_buffer_.data();
+  const int16_t *window = window_.data();
+  int32_t *data = work_.data();
+
+  // Window the previous fft_size_ samples straight into the work buffer. The
+  // even/odd samples become the real/imaginary parts of the packed N/2-point
+  // complex sequence.
+  unsigned write_index = GetWriteIndex();
+  unsigned start = write_index < fft_size_
+                       ? write_index - fft_size_ + kInputBufferSize
+                       : write_index - fft_size_;
+  constexpr int kWindowShift = kQ15Shift - kGuardBits;
+  for (unsigned i = 0; i < fft_size_; ++i) {
+    unsigned index = start + i;
+    if (index >= kInputBufferSize) {
+      index -= kInputBufferSize;
+    }
+    int32_t product = int32_t(input_buffer[index]) * window[i];
+    data[i] = (product + (1 << (kWindowShift - 1))) >> kWindowShift;
+  }
+
+  ComputeFFT(data);
+
+  // Split the packed transform into the first N/2 bins of the real FFT:
+  //   X[k] = (Z[k] + conj(Z[M-k])) / 2 + W^k (Z[k] - conj(Z[M-k])) / 2j
+  // with one more halving so that the output is X[k] / N.
+  const unsigned half_size = fft_size_ / 2;
+  const int16_t *twiddles = twiddles_.data();
+  int32_t *destination = magnitude_buffer_.data();
+  const int64_t k_smooth = smoothing_q15_;
+  for (unsigned k = 0; k < half_size; ++k) {
+    unsigned mirror = k == 0 ? 0 : half_size - k;
+    int32_t zr = data[2 * k];
+    int32_t zi = data[2 * k + 1];
+    int32_t cr = data[2 * mirror];
+    int32_t ci = data[2 * mirror + 1];
+
+    int32_t wfo_r, wfo_i;
+    MultiplyQ15(zi + ci, cr - zr, twiddles[2 * k], twiddles[2 * k + 1], &wfo_r,
+                &wfo_i);
+    int32_t xr = (zr + cr + wfo_r) >> 2;
+    int32_t xi = (zi - ci + wfo_i) >> 2;
+
+    // A value of 0 does no averaging with the previous result. Larger values
+    // produce slower, but smoother changes.
+    int64_t magnitude = ApproximateMagnitude(xr, xi);
+    destination[k] = static_cast<int32_t>(
+        (k_smooth * destination[k] + (kQ15One - k_smooth) * magnitude +
+         (1 << (kQ15Shift - 1))) >>
+        kQ15Shift);
+  }
+}
+
+void FixedPointFFTProcessor::ComputeFFT(int32_t *data) {
+  const unsigned half_size = fft_size_ / 2;
+  const int16_t *twiddles = twiddles_.data();
+
+  for (unsigned i = 0; i < half_size; ++i) {
+    unsigned j = bit_reverse_[i];
+    if (i < j) {
+      std::swap(data[2 * i], data[2 * j]);
+      std::swap(data[2 * i + 1], data[2 * j + 1]);
+    }
+  }
+
+  unsigned length = 1;
+  if (log2_half_size_ & 1) {
+    // Odd power of two: one radix-2 stage first, scaled by 1/2.
+    for (unsigned i = 0; i < half_size; i += 2) {
+      int32_t ar = data[2 * i], ai = data[2 * i + 1];
+      int32_t br = data[2 * i + 2], bi = data[2 * i + 3];
+      data[2 * i] = (ar + br) >> 1;
+      data[2 * i + 1] = (ai + bi) >> 1;
+      data[2 * i + 2] = (ar - br) >> 1;
+      data[2 * i + 3] = (ai - bi) >> 1;
+    }
+    length = 2;
+  }
+
+  // Radix-4 decimation-in-time stages, each scaled by 1/4. On bit-reversed
+  // input the four length-L sub-transforms of a block hold the samples
+  // 4n, 4n+2, 4n+1 and 4n+3, so B pairs with W^2k and C with W^k.
+  for (; length < half_size; length *= 4) {
+    const unsigned twiddle_stride = fft_size_ / (4 * length);
+    for (unsigned block = 0; block < half_size; block += 4 * length) {
+      for (unsigned k = 0; k < length; ++k) {
+        int32_t *a = data + 2 * (block + k);
+        int32_t *b = a + 2 * length;
+        int32_t *c = b + 2 * length;
+        int32_t *d = c + 2 * length;
+
+        const int16_t *w1 = twiddles + 2 * (k * twiddle_stride);
+        const int16_t *w2 = twiddles + 2 * (2 * k * twiddle_stride);
+        const int16_t *w3 = twiddles + 2 * (3 * k * twiddle_stride);
+
+        int32_t br, bi, cr, ci, dr, di;
+        MultiplyQ15(b[0], b[1], w2[0], w2[1], &br, &bi);
+        MultiplyQ15(c[0], c[1], w1[0], w1[1], &cr, &ci);
+        MultiplyQ15(d[0], d[1], w3[0], w3[1], &dr, &di);
+
+        int32_t s0r = a[0] + br, s0i = a[1] + bi;
+        int32_t s1r = a[0] - br, s1i = a[1] - bi;
+        int32_t s2r = cr + dr, s2i = ci + di;
+        int32_t s3r = cr - dr, s3i = ci - di;
+
+        // -j * (s3r + j s3i) = s3i - j s3r
+        a[0] = (s0r + s2r + 2) >> 2;
+        a[1] = (s0i + s2i + 2) >> 2;
+        b[0] = (s1r + s3i + 2) >> 2;
+        b[1] = (s1i - s3r + 2) >> 2;
+        c[0] = (s0r - s2r + 2) >> 2;
+        c[1] = (s0i - s2i + 2) >> 2;
+        d[0] = (s1r - s3i + 2) >> 2;
+        d[1] = (s1i + s3r + 2) >> 2;
+      }
+    }
+  }
+}
+
+void FixedPointFFTProcessor::ConvertToLog2(
+    std::vector<int32_t> &destination_array) const {
+  // Magnitudes are Q(15 + kGuardBits); shift so that 0 means full scale.
+  constexpr int32_t kFullScaleLog2 = (kQ15Shift + kGuardBits)
+                                     << kLog2FractionBits;
+  size_t len = std::min(magnitude_buffer_.size(), destination_array.size());
+  const int32_t *source = magnitude_buffer_.data();
+  int32_t *destination = destination_array.data();
+  for (size_t i = 0; i < len; ++i) {
+    int32_t magnitude = source[i];
+    destination[i] = magnitude > 0
+                         ? Log2Q10(static_cast<uint32_t>(magnitude)) -
+                               kFullScaleLog2
+                         : kSilenceLog2;
+  }
+}
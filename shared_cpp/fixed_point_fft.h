@@ -0,0 +1,98 @@
+#ifndef FIXED_POINT_FFT_H
+#define FIXED_POINT_FFT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Integer-only counterpart of FFTProcessor for targets where float throughput
+// is the bottleneck (e.g. low-power ARM Linux devices).
+//
+// Pipeline: int16 input ring -> Q15 Blackman window -> radix-4 complex FFT of
+// N/2 points on the packed real signal -> real split -> alpha-max-plus-beta-min
+// magnitude -> Q15 smoothing -> fixed-point log2 per bin. No float is touched
+// per sample or per bin; callers average the log2 values over a band and
+// convert a single value per band with Log2ToDecibels().
+//
+// Dynamic range: samples, window and twiddles are Q15. The FFT itself carries
+// Q15 samples in int32 with kGuardBits extra fractional bits, and every stage
+// scales by 1/radix so the output equals |X[k]| / N, the same normalization as
+// the float path. Rounding noise per bin stays around -130 dBFS, well below
+// AudioVisualizer's default -100 dB floor, so the usable range is bounded by
+// the 16-bit input (~96 dB) rather than by the transform. Magnitudes use an
+// alpha-max-plus-beta-min approximation (within +/-3%, i.e. +/-0.3 dB) and the
+// log2 approximation adds at most 0.05 dB. Bins that are exactly zero report
+// kSilenceLog2, which lands below any practical min_db.
+class FixedPointFFTProcessor {
+public:
+  static constexpr double kDefaultSmoothingTimeConstant = 0.5;
+  static constexpr unsigned kDefaultFFTSize = 2048;
+  static constexpr unsigned kMinFFTSize = 32;
+  static constexpr unsigned kMaxFFTSize = 32768;
+  static constexpr unsigned kInputBufferSize = kMaxFFTSize * 2;
+
+  // Extra fractional bits carried on top of Q15 inside the transform.
+  static constexpr int kGuardBits = 8;
+  // Fractional bits of the log2 values returned by GetLog2FrequencyData().
+  static constexpr int kLog2FractionBits = 10;
+  // Log2 (relative to full scale) reported for bins with zero magnitude.
+  static constexpr int32_t kSilenceLog2 = -24 * (1 << kLog2FractionBits);
+
+public:
+  FixedPointFFTProcessor(
+      int fftSize,
+      double smoothing_time_constant = kDefaultSmoothingTimeConstant);
+  ~FixedPointFFTProcessor();
+
+  void WriteInput(const int16_t *input, unsigned int frames_to_process);
+
+  // Fills |destination_array| with log2(|X[k]| / N) per bin in Q10, relative
+  // to full scale. Analysis only runs when |current_time| has advanced.
+  void GetLog2FrequencyData(std::vector<int32_t> &destination_array,
+                            double current_time);
+
+  unsigned int FFTSize() const { return fft_size_; }
+
+  // Converts a (possibly band-averaged) value from GetLog2FrequencyData() to
+  // decibels relative to full scale.
+  static float Log2ToDecibels(int32_t log2_value);
+
+private:
+  void DoFFTAnalysis();
+
+  void ComputeFFT(int32_t *data);
+
+  void ConvertToLog2(std::vector<int32_t> &destination_array) const;
+
+  unsigned GetWriteIndex() const {
+    return write_index_.load(std::memory_order_acquire);
+  }
+  void SetWriteIndex(unsigned new_index) {
+    write_index_.store(new_index, std::memory_order_release);
+  }
+
+private:
+  unsigned int fft_size_;
+  unsigned int log2_half_size_;
+  // Q15 Blackman window, fft_size_ entries.
+  std::vector<int16_t> window_;
+  // Q15 twiddles exp(-2*pi*i*k/N) for k < N, interleaved (cos, -sin).
+  std::vector<int16_t> twiddles_;
+  // Bit reversal permutation for the N/2-point complex transform.
+  std::vector<uint32_t> bit_reverse_;
+  // Interleaved complex work buffer of N/2 points.
+  std::vector<int32_t> work_;
+  // Smoothed linear magnitudes, Q15 + kGuardBits.
+  std::vector<int32_t> magnitude_buffer_;
+  double last_analysis_time_ = -1;
+
+  // The audio thread writes the input audio here.
+  std::vector<int16_t> input_buffer_;
+  std::atomic_uint write_index_{0};
+
+  // Q15 smoothing factor, see FFTProcessor::smoothing_time_constant_.
+  int32_t smoothing_q15_;
+};
+
+#endif // FIXED_POINT_FFT_H
@@ -0,0 +1,48 @@
+#include "latest_bands.h"
+
+// static
+LatestBandsRegistry &LatestBandsRegistry::Instance() {
+  static LatestBandsRegistry *instance = new LatestBandsRegistry();
+  return *instance;
+}
+
+std::shared_ptr<LatestBandsRegistry::Slot>
+LatestBandsRegistry::Acquire(const std::string &visualizer_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry &entry = slots_[visualizer_id];
+  if (!entry.slot) {
+    entry.slot = std::make_shared<Slot>();
+  }
+  ++entry.writers;
+  return entry.slot;
+}
+
+void LatestBandsRegistry::Release(const std::string &visualizer_id,
+                                  std::shared_ptr<Slot> &slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = slots_.find(visualizer_id);
+  if (slot && it != slots_.end() && it->second.slot == slot &&
+      --it->second.writers == 0) {
+    slots_.erase(it);
+  }
+  slot.reset();
+}
+
+bool LatestBandsRegistry::Read(const std::string &visualizer_id,
+                               float *destination, size_t capacity,
+                               size_t *count, uint64_t *version) const {
+  std::shared_ptr<Slot> slot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = slots_.find(visualizer_id);
+    if (it == slots_.end()) {
+      return false;
+    }
+    slot = it->second.slot;
+  }
+  if (!slot->Read(destination, capacity, count, version)) {
+    *count = 0;
+    *version = 0;
+  }
+  return true;
+}
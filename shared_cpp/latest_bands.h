@@ -0,0 +1,53 @@
+#ifndef LATEST_BANDS_H
+#define LATEST_BANDS_H
+
+#include "seqlock.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Process-wide latest bands of every visualizer, for UIs that pull levels on
+// their own schedule (e.g. once per frame) instead of receiving a message per
+// audio callback. Slots are keyed by visualizer id, so visualizers of the
+// same track with different settings, such as raw bands next to smoothed
+// ones, never overwrite each other.
+//
+// Writers hold a reference to their slot and publish into its seqlock
+// without ever taking the registry lock, so the audio thread never waits for
+// a reader. Readers take the lock only to look slots up.
+class LatestBandsRegistry {
+public:
+  static constexpr size_t kMaxBands = 64;
+  using Slot = SeqlockSnapshot<kMaxBands>;
+
+  static LatestBandsRegistry &Instance();
+
+  // Returns the slot of |visualizer_id|, creating it on first use.
+  std::shared_ptr<Slot> Acquire(const std::string &visualizer_id);
+  // Drops the registry's slot of |visualizer_id| once no writer holds it
+  // anymore. |slot| is reset.
+  void Release(const std::string &visualizer_id, std::shared_ptr<Slot> &slot);
+
+  // Reads the latest bands of |visualizer_id| into |destination|. Returns
+  // false when the visualizer has no slot; |version| is 0 while nothing was
+  // published.
+  bool Read(const std::string &visualizer_id, float *destination,
+            size_t capacity, size_t *count, uint64_t *version) const;
+
+private:
+  LatestBandsRegistry() = default;
+
+  struct Entry {
+    std::shared_ptr<Slot> slot;
+    int writers = 0;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> slots_;
+};
+
+#endif // LATEST_BANDS_H
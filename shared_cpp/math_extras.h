@@ -28,8 +28,26 @@
 
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MATH_EXTRAS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#define MATH_EXTRAS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATH_EXTRAS_NEON
+#endif
+
 #if defined(_MSC_VER)
 // Make math.h behave like other platforms.
 // #define _USE_MATH_DEFINES
@@ -266,4 +284,396 @@ constexpr size_t LowestCommonMultiple(size_t a, size_t b) {
   return a && b ? a / GreatestCommonDivisor(a, b) * b : 0;
 }
 
+
+// Fast float approximations for DSP kernels.
+//
+// Every function is a template over a "math ops" policy that supplies the
+// vector type and the handful of primitive operations the approximations are
+// built from, so the same code runs on plain floats (ScalarMathOps), SSE2,
+// AVX2 and NEON registers. NativeMathOps is the widest policy available in
+// the current build. Only basic arithmetic, min/max, floor and integer bit
+// manipulation are used. MulAdd is a fused multiply-add on AVX2 builds with
+// FMA and on 64-bit ARM, and rounds twice elsewhere (unless the compiler
+// contracts the scalar expression), so results may differ between policies
+// by about one unit in the last place; the bounds below hold for all of them.
+// Rsqrt, and Sqrt on 32-bit ARM, refine a hardware estimate and differ more.
+//
+// Maximum errors, measured over the stated domains against double precision:
+//   FastLog2   x > 0 (normal)      absolute 2.2e-6 plus rounding of the result
+//   FastLog10  x > 0 (normal)      absolute 7e-7 plus rounding of the result
+//   FastExp2   -126 <= x < 128     relative 2.4e-7
+//   FastSin    |x| <= 8192         absolute 1.8e-7
+//   FastCos    |x| <= 8192         absolute 1.8e-7
+//   FastSqrt   x >= 0              correctly rounded, except on 32-bit ARM
+//                                  where it is x * FastRsqrt(x)
+//   FastRsqrt  x > 0               relative 2.4e-7 (SSE/AVX); NEON refines
+//                                  its coarser estimate twice instead of once
+// For audio magnitudes in [1e-12, 1e3] FastLog2 stays within 4.1e-6, i.e.
+// 2.5e-5 dB. FastSin and FastCos are meant for table generation and per-block
+// phase evaluation, not for huge arguments.
+// FastLog2() ignores the sign bit and returns -127 for zero, i.e. zero maps to
+// roughly -765 dB instead of -inf. Results for NaN and infinity are
+// unspecified.
+
+struct ScalarMathOps {
+  using Float = float;
+  using Int = int32_t;
+  static constexpr size_t kWidth = 1;
+
+  static Float Set(float value) { return value; }
+  static Int SetInt(int32_t value) { return value; }
+  static Float Load(const float *source) { return *source; }
+  static void Store(float *destination, Float value) { *destination = value; }
+
+  static Float Add(Float a, Float b) { return a + b; }
+  static Float Sub(Float a, Float b) { return a - b; }
+  static Float Mul(Float a, Float b) { return a * b; }
+  // a * b + c
+  static Float MulAdd(Float a, Float b, Float c) { return a * b + c; }
+  static Float Min(Float a, Float b) { return a < b ? a : b; }
+  static Float Max(Float a, Float b) { return a > b ? a : b; }
+  static Float Sqrt(Float x) { return std::sqrt(x); }
+  static Float Rsqrt(Float x) { return 1.0f / std::sqrt(x); }
+  static Float Floor(Float x) { return std::floor(x); }
+
+  // Truncating conversion; exact for the integral values Floor() returns.
+  static Int ToInt(Float x) { return static_cast<Int>(x); }
+  static Float ToFloat(Int x) { return static_cast<Float>(x); }
+  static Int AsInt(Float x) {
+    Int bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+  }
+  static Float AsFloat(Int x) {
+    Float value;
+    memcpy(&value, &x, sizeof(value));
+    return value;
+  }
+  static Int IntAdd(Int a, Int b) {
+    return static_cast<Int>(static_cast<uint32_t>(a) +
+                            static_cast<uint32_t>(b));
+  }
+  static Int IntSub(Int a, Int b) {
+    return static_cast<Int>(static_cast<uint32_t>(a) -
+                            static_cast<uint32_t>(b));
+  }
+  static Int And(Int a, Int b) { return a & b; }
+  static Int Or(Int a, Int b) { return a | b; }
+  static Int Xor(Int a, Int b) { return a ^ b; }
+  template <int kBits> static Int ShiftLeft(Int x) {
+    return static_cast<Int>(static_cast<uint32_t>(x) << kBits);
+  }
+  // Logical shift.
+  template <int kBits> static Int ShiftRight(Int x) {
+    return static_cast<Int>(static_cast<uint32_t>(x) >> kBits);
+  }
+};
+
+#if defined(MATH_EXTRAS_SSE2)
+struct SseMathOps {
+  using Float = __m128;
+  using Int = __m128i;
+  static constexpr size_t kWidth = 4;
+
+  static Float Set(float value) { return _mm_set1_ps(value); }
+  static Int SetInt(int32_t value) { return _mm_set1_epi32(value); }
+  static Float Load(const float *source) { return _mm_loadu_ps(source); }
+  static void Store(float *destination, Float value) {
+    _mm_storeu_ps(destination, value);
+  }
+
+  static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float MulAdd(Float a, Float b, Float c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+  static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+  static Float Sqrt(Float x) { return _mm_sqrt_ps(x); }
+  static Float Rsqrt(Float x) {
+    // 12-bit estimate plus one Newton-Raphson step.
+    Float r = _mm_rsqrt_ps(x);
+    Float half_x_r2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x),
+                                 _mm_mul_ps(r, r));
+    return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), half_x_r2));
+  }
+  static Float Floor(Float x) {
+#if defined(__SSE4_1__)
+    return _mm_floor_ps(x);
+#else
+    // Truncate, then step down where truncation rounded up (x < 0).
+    Float truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    Float rounded_up = _mm_cmpgt_ps(truncated, x);
+    return _mm_sub_ps(truncated, _mm_and_ps(rounded_up, _mm_set1_ps(1.0f)));
+#endif
+  }
+
+  static Int ToInt(Float x) { return _mm_cvttps_epi32(x); }
+  static Float ToFloat(Int x) { return _mm_cvtepi32_ps(x); }
+  static Int AsInt(Float x) { return _mm_castps_si128(x); }
+  static Float AsFloat(Int x) { return _mm_castsi128_ps(x); }
+  static Int IntAdd(Int a, Int b) { return _mm_add_epi32(a, b); }
+  static Int IntSub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+  static Int And(Int a, Int b) { return _mm_and_si128(a, b); }
+  static Int Or(Int a, Int b) { return _mm_or_si128(a, b); }
+  static Int Xor(Int a, Int b) { return _mm_xor_si128(a, b); }
+  template <int kBits> static Int ShiftLeft(Int x) {
+    return _mm_slli_epi32(x, kBits);
+  }
+  template <int kBits> static Int ShiftRight(Int x) {
+    return _mm_srli_epi32(x, kBits);
+  }
+};
+#endif // defined(MATH_EXTRAS_SSE2)
+
+#if defined(MATH_EXTRAS_AVX2)
+struct AvxMathOps {
+  using Float = __m256;
+  using Int = __m256i;
+  static constexpr size_t kWidth = 8;
+
+  static Float Set(float value) { return _mm256_set1_ps(value); }
+  static Int SetInt(int32_t value) { return _mm256_set1_epi32(value); }
+  static Float Load(const float *source) { return _mm256_loadu_ps(source); }
+  static void Store(float *destination, Float value) {
+    _mm256_storeu_ps(destination, value);
+  }
+
+  static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+  static Float MulAdd(Float a, Float b, Float c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+  }
+  static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+  static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+  static Float Sqrt(Float x) { return _mm256_sqrt_ps(x); }
+  static Float Rsqrt(Float x) {
+    Float r = _mm256_rsqrt_ps(x);
+    Float half_x_r2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x),
+                                    _mm256_mul_ps(r, r));
+    return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), half_x_r2));
+  }
+  static Float Floor(Float x) { return _mm256_floor_ps(x); }
+
+  static Int ToInt(Float x) { return _mm256_cvttps_epi32(x); }
+  static Float ToFloat(Int x) { return _mm256_cvtepi32_ps(x); }
+  static Int AsInt(Float x) { return _mm256_castps_si256(x); }
+  static Float AsFloat(Int x) { return _mm256_castsi256_ps(x); }
+  static Int IntAdd(Int a, Int b) { return _mm256_add_epi32(a, b); }
+  static Int IntSub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+  static Int And(Int a, Int b) { return _mm256_and_si256(a, b); }
+  static Int Or(Int a, Int b) { return _mm256_or_si256(a, b); }
+  static Int Xor(Int a, Int b) { return _mm256_xor_si256(a, b); }
+  template <int kBits> static Int ShiftLeft(Int x) {
+    return _mm256_slli_epi32(x, kBits);
+  }
+  template <int kBits> static Int ShiftRight(Int x) {
+    return _mm256_srli_epi32(x, kBits);
+  }
+};
+#endif // defined(MATH_EXTRAS_AVX2)
+
+#if defined(MATH_EXTRAS_NEON)
+struct NeonMathOps {
+  using Float = float32x4_t;
+  using Int = int32x4_t;
+  static constexpr size_t kWidth = 4;
+
+  static Float Set(float value) { return vdupq_n_f32(value); }
+  static Int SetInt(int32_t value) { return vdupq_n_s32(value); }
+  static Float Load(const float *source) { return vld1q_f32(source); }
+  static void Store(float *destination, Float value) {
+    vst1q_f32(destination, value);
+  }
+
+  static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+  static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+  static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+  static Float MulAdd(Float a, Float b, Float c) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vfmaq_f32(c, a, b);
+#else
+    return vmlaq_f32(c, a, b);
+#endif
+  }
+  static Float Min(Float a, Float b) { return vminq_f32(a, b); }
+  static Float Max(Float a, Float b) { return vmaxq_f32(a, b); }
+  static Float Rsqrt(Float x) {
+    // 8-bit estimate plus two Newton-Raphson steps.
+    Float r = vrsqrteq_f32(x);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+  }
+  static Float Sqrt(Float x) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vsqrtq_f32(x);
+#else
+    // x * rsqrt(x), with x clamped away from 0 so that sqrt(0) == 0.
+    Float clamped =
+        vmaxq_f32(x, vdupq_n_f32(std::numeric_limits<float>::min()));
+    return vmulq_f32(x, Rsqrt(clamped));
+#endif
+  }
+  static Float Floor(Float x) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vrndmq_f32(x);
+#else
+    Float truncated = vcvtq_f32_s32(vcvtq_s32_f32(x));
+    uint32x4_t rounded_up = vcgtq_f32(truncated, x);
+    uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+    return vsubq_f32(truncated,
+                     vreinterpretq_f32_u32(vandq_u32(rounded_up, one)));
+#endif
+  }
+
+  static Int ToInt(Float x) { return vcvtq_s32_f32(x); }
+  static Float ToFloat(Int x) { return vcvtq_f32_s32(x); }
+  static Int AsInt(Float x) { return vreinterpretq_s32_f32(x); }
+  static Float AsFloat(Int x) { return vreinterpretq_f32_s32(x); }
+  static Int IntAdd(Int a, Int b) { return vaddq_s32(a, b); }
+  static Int IntSub(Int a, Int b) { return vsubq_s32(a, b); }
+  static Int And(Int a, Int b) { return vandq_s32(a, b); }
+  static Int Or(Int a, Int b) { return vorrq_s32(a, b); }
+  static Int Xor(Int a, Int b) { return veorq_s32(a, b); }
+  template <int kBits> static Int ShiftLeft(Int x) {
+    return vshlq_n_s32(x, kBits);
+  }
+  template <int kBits> static Int ShiftRight(Int x) {
+    return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(x), kBits));
+  }
+};
+#endif // defined(MATH_EXTRAS_NEON)
+
+#if defined(MATH_EXTRAS_AVX2)
+using NativeMathOps = AvxMathOps;
+#elif defined(MATH_EXTRAS_SSE2)
+using NativeMathOps = SseMathOps;
+#elif defined(MATH_EXTRAS_NEON)
+using NativeMathOps = NeonMathOps;
+#else
+using NativeMathOps = ScalarMathOps;
+#endif
+
+// 20 * log10(2): converts log2 of an amplitude ratio to decibels.
+constexpr float kLog2ToDecibels = 6.02059991f;
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastLog2(typename Ops::Float x) {
+  // x = 2^e * (1 + t) with t in [0, 1); log2(1 + t) ~= t * p(t), a degree 6
+  // minimax fit.
+  auto bits = Ops::AsInt(x);
+  auto biased_exponent =
+      Ops::And(Ops::template ShiftRight<23>(bits), Ops::SetInt(0xff));
+  auto exponent = Ops::IntSub(biased_exponent, Ops::SetInt(127));
+  auto mantissa = Ops::Or(Ops::And(bits, Ops::SetInt(0x007fffff)),
+                          Ops::SetInt(0x3f800000));
+  auto t = Ops::Sub(Ops::AsFloat(mantissa), Ops::Set(1.0f));
+  auto p = Ops::Set(-0.0264565539f);
+  p = Ops::MulAdd(p, t, Ops::Set(0.12344885f));
+  p = Ops::MulAdd(p, t, Ops::Set(-0.279535247f));
+  p = Ops::MulAdd(p, t, Ops::Set(0.458269364f));
+  p = Ops::MulAdd(p, t, Ops::Set(-0.718281604f));
+  p = Ops::MulAdd(p, t, Ops::Set(1.44255312f));
+  return Ops::MulAdd(p, t, Ops::ToFloat(exponent));
+}
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastLog10(typename Ops::Float x) {
+  return Ops::Mul(FastLog2<Ops>(x), Ops::Set(0.301029996f));
+}
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastExp2(typename Ops::Float x) {
+  // 2^x = 2^i * 2^f with i = floor(x) and f in [0, 1); 2^f is a degree 5
+  // minimax fit in [1, 2) and 2^i is added straight into the exponent bits.
+  x = Ops::Min(Ops::Max(x, Ops::Set(-126.0f)), Ops::Set(127.99999f));
+  auto i = Ops::Floor(x);
+  auto f = Ops::Sub(x, i);
+  auto p = Ops::Set(0.00189645949f);
+  p = Ops::MulAdd(p, f, Ops::Set(0.00894283313f));
+  p = Ops::MulAdd(p, f, Ops::Set(0.0558662427f));
+  p = Ops::MulAdd(p, f, Ops::Set(0.240139712f));
+  p = Ops::MulAdd(p, f, Ops::Set(0.693154752f));
+  p = Ops::MulAdd(p, f, Ops::Set(0.999999893f));
+  return Ops::AsFloat(Ops::IntAdd(
+      Ops::AsInt(p), Ops::template ShiftLeft<23>(Ops::ToInt(i))));
+}
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastSqrt(typename Ops::Float x) {
+  return Ops::Sqrt(x);
+}
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastRsqrt(typename Ops::Float x) {
+  return Ops::Rsqrt(x);
+}
+
+namespace fast_math_internal {
+
+// Returns (-1)^q * sin(x - q * pi) for integral (or, for cosine, half
+// integral) q, where x - q * pi must lie within [-pi/2, pi/2]. |sign| holds q
+// in bit 31.
+template <typename Ops>
+inline typename Ops::Float SinOfReduced(typename Ops::Float x,
+                                        typename Ops::Float q,
+                                        typename Ops::Int sign) {
+  // Cody-Waite reduction: pi split in three parts so that q * part is exact.
+  auto r = Ops::MulAdd(q, Ops::Set(-3.140625f), x);
+  r = Ops::MulAdd(q, Ops::Set(-9.67502593994140625e-4f), r);
+  r = Ops::MulAdd(q, Ops::Set(-1.509957990978376432e-7f), r);
+  // Odd degree 9 minimax fit of sin on [-pi/2, pi/2].
+  auto r2 = Ops::Mul(r, r);
+  auto p = Ops::Set(2.59048843e-06f);
+  p = Ops::MulAdd(p, r2, Ops::Set(-0.000198008977f));
+  p = Ops::MulAdd(p, r2, Ops::Set(0.00833289982f));
+  p = Ops::MulAdd(p, r2, Ops::Set(-0.166666476f));
+  p = Ops::MulAdd(p, r2, Ops::Set(0.999999977f));
+  return Ops::AsFloat(Ops::Xor(Ops::AsInt(Ops::Mul(p, r)), sign));
+}
+
+} // namespace fast_math_internal
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastSin(typename Ops::Float x) {
+  // q = round(x / pi).
+  auto q = Ops::Floor(
+      Ops::MulAdd(x, Ops::Set(static_cast<float>(M_1_PI)), Ops::Set(0.5f)));
+  return fast_math_internal::SinOfReduced<Ops>(
+      x, q, Ops::template ShiftLeft<31>(Ops::ToInt(q)));
+}
+
+template <typename Ops = ScalarMathOps>
+inline typename Ops::Float FastCos(typename Ops::Float x) {
+  // cos(x) = -(-1)^k * sin(x - (k + 1/2) * pi) with k = floor(x / pi).
+  auto k = Ops::Floor(Ops::Mul(x, Ops::Set(static_cast<float>(M_1_PI))));
+  return fast_math_internal::SinOfReduced<Ops>(
+      x, Ops::Add(k, Ops::Set(0.5f)),
+      Ops::template ShiftLeft<31>(
+          Ops::IntAdd(Ops::ToInt(k), Ops::SetInt(1))));
+}
+
+// Computes destination[i] = kernel(ops, source[i]) for |size| values, running
+// |kernel| on NativeMathOps vectors and on ScalarMathOps for the remainder.
+// |kernel| is a generic lambda taking an ops instance (used for its type) and
+// an Ops::Float. |source| and |destination| may alias.
+template <typename Kernel>
+inline void FastMathTransform(const float *source, float *destination,
+                              size_t size, Kernel kernel) {
+  size_t i = 0;
+  for (; i + NativeMathOps::kWidth <= size; i += NativeMathOps::kWidth) {
+    auto value = NativeMathOps::Load(source + i);
+    NativeMathOps::Store(destination + i, kernel(NativeMathOps(), value));
+  }
+  for (; i < size; ++i) {
+    destination[i] = kernel(ScalarMathOps(), source[i]);
+  }
+}
+
 #endif // THIRD_PARTY_BLINK_RENDERER_PLATFORM_WTF_MATH_EXTRAS_H_
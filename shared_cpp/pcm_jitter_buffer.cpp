@@ -0,0 +1,119 @@
+#include "pcm_jitter_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+PcmJitterBuffer::PcmJitterBuffer(size_t channels, size_t capacity_frames,
+                                 size_t prebuffer_frames)
+    : channels_(std::max<size_t>(channels, 1)),
+      capacity_(std::max<size_t>(capacity_frames, 1) * channels_),
+      prebuffer_(std::min(prebuffer_frames * channels_, capacity_)),
+      ring_(capacity_) {}
+
+size_t PcmJitterBuffer::Write(const void *samples, size_t frames) {
+  const uint64_t write = write_position_.load(std::memory_order_relaxed);
+  const uint64_t read = read_position_.load(std::memory_order_acquire);
+  const size_t free_frames = (capacity_ - size_t(write - read)) / channels_;
+  const size_t accepted = std::min(frames, free_frames);
+  if (accepted < frames) {
+    frames_dropped_.fetch_add(frames - accepted, std::memory_order_relaxed);
+  }
+  const size_t count = accepted * channels_;
+  const size_t start = size_t(write % capacity_);
+  const size_t head = std::min(count, capacity_ - start);
+  const uint8_t *bytes = static_cast<const uint8_t *>(samples);
+  std::memcpy(ring_.data() + start, bytes, head * sizeof(int16_t));
+  std::memcpy(ring_.data(), bytes + head * sizeof(int16_t),
+              (count - head) * sizeof(int16_t));
+  write_position_.store(write + count, std::memory_order_release);
+  return accepted;
+}
+
+bool PcmJitterBuffer::Read(int16_t *output, size_t frames) {
+  const size_t count = frames * channels_;
+  const uint64_t read = read_position_.load(std::memory_order_relaxed);
+  const size_t available =
+      size_t(write_position_.load(std::memory_order_acquire) - read);
+  if (available < count || (!playing_ && available < prebuffer_)) {
+    if (playing_) {
+      playing_ = false;
+      underruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Conceal(output, count);
+    frames_concealed_.fetch_add(frames, std::memory_order_relaxed);
+    return false;
+  }
+  playing_ = true;
+
+  const size_t start = size_t(read % capacity_);
+  const size_t head = std::min(count, capacity_ - start);
+  std::copy_n(ring_.data() + start, head, output);
+  std::copy_n(ring_.data(), count - head, output + head);
+  read_position_.store(read + count, std::memory_order_release);
+
+  if (concealed_frames_ > 0 && frames > 0) {
+    // Ramp from the level concealment left off at to full scale.
+    const float step = (1.0f - conceal_gain_) / float(frames);
+    for (size_t frame = 0; frame < frames; ++frame) {
+      const float gain = conceal_gain_ + step * float(frame);
+      for (size_t channel = 0; channel < channels_; ++channel) {
+        int16_t &sample = output[frame * channels_ + channel];
+        sample = int16_t(float(sample) * gain);
+      }
+    }
+  }
+  last_frame_.assign(output, output + count);
+  conceal_gain_ = 1.0f;
+  concealed_frames_ = 0;
+  frames_played_.fetch_add(frames, std::memory_order_relaxed);
+  return true;
+}
+
+void PcmJitterBuffer::Clear() {
+  read_position_.store(write_position_.load(std::memory_order_acquire),
+                       std::memory_order_release);
+  playing_ = false;
+}
+
+void PcmJitterBuffer::Conceal(int16_t *output, size_t samples) {
+  if (concealed_frames_ >= kMaxConcealedFrames ||
+      last_frame_.size() != samples) {
+    std::fill_n(output, samples, int16_t(0));
+    conceal_gain_ = 0;
+    concealed_frames_ = kMaxConcealedFrames;
+    return;
+  }
+  // Repeat the last frame, ramping the gain down to half of where it started
+  // so consecutive repetitions join without steps, and to zero on the last
+  // repetition.
+  const size_t frames = samples / channels_;
+  const float end_gain = concealed_frames_ + 1 == kMaxConcealedFrames
+                             ? 0.0f
+                             : conceal_gain_ * 0.5f;
+  const float step = (end_gain - conceal_gain_) / float(frames);
+  for (size_t frame = 0; frame < frames; ++frame) {
+    const float gain = conceal_gain_ + step * float(frame + 1);
+    for (size_t channel = 0; channel < channels_; ++channel) {
+      const size_t i = frame * channels_ + channel;
+      output[i] = int16_t(float(last_frame_[i]) * gain);
+    }
+  }
+  conceal_gain_ = end_gain;
+  ++concealed_frames_;
+}
+
+size_t PcmJitterBuffer::buffered_frames() const {
+  const uint64_t read = read_position_.load(std::memory_order_acquire);
+  return size_t(write_position_.load(std::memory_order_acquire) - read) /
+         channels_;
+}
+
+PcmJitterBuffer::Stats PcmJitterBuffer::GetStats() const {
+  Stats stats;
+  stats.frames_played = frames_played_.load(std::memory_order_relaxed);
+  stats.frames_concealed = frames_concealed_.load(std::memory_order_relaxed);
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  stats.buffered_frames = buffered_frames();
+  return stats;
+}
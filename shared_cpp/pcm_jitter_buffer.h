@@ -0,0 +1,80 @@
+#ifndef PCM_JITTER_BUFFER_H
+#define PCM_JITTER_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Single producer, single consumer buffer of interleaved 16-bit PCM that
+// absorbs the burstiness of audio generated ahead of time (speech synthesis,
+// bots) and plays it out in fixed size frames on the consumer's clock.
+//
+// Write() and Read() never lock or allocate. Playback starts once
+// |prebuffer_frames| are queued. When the buffer runs dry, the last frame is
+// repeated with halving gain for a few frames and then silence is played,
+// until the prebuffer has filled again; the first frame after concealment
+// fades in from the concealed gain so resuming does not click. Writes that do
+// not fit are truncated and counted.
+class PcmJitterBuffer {
+public:
+  // Number of Read() calls the last frame is repeated for before going
+  // silent.
+  static constexpr int kMaxConcealedFrames = 4;
+
+  // All counts are in frames of |channels| samples. Concealed frames include
+  // the silence played while prebuffering.
+  struct Stats {
+    uint64_t frames_played = 0;
+    uint64_t frames_concealed = 0;
+    uint64_t underruns = 0;
+    uint64_t frames_dropped = 0;
+    size_t buffered_frames = 0;
+  };
+
+  PcmJitterBuffer(size_t channels, size_t capacity_frames,
+                  size_t prebuffer_frames);
+
+  // Producer. Queues up to |frames| frames of interleaved int16 |samples|,
+  // which need not be aligned, and returns how many fit.
+  size_t Write(const void *samples, size_t frames);
+
+  // Consumer. Fills |output| with exactly |frames| frames, of queued audio if
+  // enough is available and of concealment otherwise, in which case it
+  // returns false. |frames| should stay the same from call to call.
+  bool Read(int16_t *output, size_t frames);
+
+  // Consumer. Drops everything queued and waits for the prebuffer again.
+  void Clear();
+
+  size_t channels() const { return channels_; }
+
+  // May be called from any thread.
+  size_t buffered_frames() const;
+  Stats GetStats() const;
+
+private:
+  void Conceal(int16_t *output, size_t samples);
+
+  const size_t channels_;
+  const size_t capacity_;   // In samples.
+  const size_t prebuffer_;  // In samples.
+  std::vector<int16_t> ring_;
+  // Total samples written and read, so that the fill level is their
+  // difference and wrap-around needs no special casing.
+  alignas(64) std::atomic<uint64_t> write_position_{0};
+  alignas(64) std::atomic<uint64_t> read_position_{0};
+
+  // Consumer state.
+  bool playing_ = false;
+  std::vector<int16_t> last_frame_;
+  float conceal_gain_ = 0;
+  int concealed_frames_ = 0;
+
+  std::atomic<uint64_t> frames_played_{0};
+  std::atomic<uint64_t> frames_concealed_{0};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> frames_dropped_{0};
+};
+
+#endif // PCM_JITTER_BUFFER_H
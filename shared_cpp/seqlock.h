@@ -0,0 +1,65 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single writer, many reader snapshot of up to kCapacity floats.
+//
+// The writer never blocks or waits: it makes the sequence odd, stores the
+// values and makes it even again. Readers copy the values and retry when the
+// sequence was odd or changed meanwhile, so they always observe the values of
+// one Publish() call. Values are relaxed atomics, which compile to plain
+// loads and stores but keep the racy copy well defined.
+template <size_t kCapacity> class SeqlockSnapshot {
+public:
+  // Publishes |count| values, truncated to kCapacity. Must only be called by
+  // one thread at a time.
+  void Publish(const float *values, size_t count) {
+    count = std::min(count, kCapacity);
+    uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    count_.store(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+      values_[i].store(values[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  // Copies the latest values into |destination|, which holds |capacity|
+  // floats, and returns how many were published. |version| is the number of
+  // Publish() calls so far, 0 meaning nothing was published yet. Returns
+  // false if the writer kept overlapping after |max_attempts| tries, which
+  // only happens when the reader is descheduled mid-copy repeatedly.
+  bool Read(float *destination, size_t capacity, size_t *count,
+            uint64_t *version, int max_attempts = 16) const {
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+      uint64_t before = sequence_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      size_t published = count_.load(std::memory_order_relaxed);
+      size_t copied = std::min(published, capacity);
+      for (size_t i = 0; i < copied; ++i) {
+        destination[i] = values_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before) {
+        *count = copied;
+        *version = before / 2;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<size_t> count_{0};
+  std::atomic<float> values_[kCapacity] = {};
+};
+
+#endif // SEQLOCK_H
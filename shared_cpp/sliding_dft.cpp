@@ -0,0 +1,151 @@
+#include "sliding_dft.h"
+#include "math_extras.h"
+#include "pffft.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SLIDING_DFT_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SLIDING_DFT_NEON
+#endif
+
+namespace {
+
+constexpr size_t kSimdWidth = 4;
+
+} // namespace
+
+SlidingDFTBank::SlidingDFTBank(const std::vector<float> &frequencies,
+                               float sample_rate, unsigned window_size)
+    : bin_count_(frequencies.size()),
+      padded_count_((frequencies.size() + kSimdWidth - 1) / kSimdWidth *
+                    kSimdWidth),
+      sample_rate_(sample_rate), window_size_(std::max(window_size, 1u)),
+      history_(window_size_, 0.0f) {
+  comb_gain_ = std::pow(kDampingFactor, static_cast<float>(window_size_));
+
+  // One aligned block holds the four SoA arrays.
+  float *block = static_cast<float *>(
+      pffft_aligned_malloc(4 * std::max(padded_count_, kSimdWidth) *
+                           sizeof(float)));
+  coefficient_real_ = block;
+  coefficient_imag_ = coefficient_real_ + padded_count_;
+  state_real_ = coefficient_imag_ + padded_count_;
+  state_imag_ = state_real_ + padded_count_;
+  memset(block, 0, 4 * padded_count_ * sizeof(float));
+
+  bin_frequencies_.resize(bin_count_);
+  const double bin_width = sample_rate_ / window_size_;
+  for (size_t i = 0; i < bin_count_; ++i) {
+    // Integer bins make e^(j*w*N) == 1, so the comb cancels exactly.
+    double bin = std::round(ClampTo<double>(frequencies[i], 0.0,
+                                            sample_rate_ / 2.0) /
+                            bin_width);
+    double omega = kTwoPiDouble * bin / window_size_;
+    bin_frequencies_[i] = static_cast<float>(bin * bin_width);
+    coefficient_real_[i] = static_cast<float>(kDampingFactor * cos(omega));
+    coefficient_imag_[i] = static_cast<float>(kDampingFactor * sin(omega));
+  }
+}
+
+SlidingDFTBank::~SlidingDFTBank() { pffft_aligned_free(coefficient_real_); }
+
+void SlidingDFTBank::Reset() {
+  memset(state_real_, 0, 2 * padded_count_ * sizeof(float));
+  std::fill(history_.begin(), history_.end(), 0.0f);
+  history_index_ = 0;
+}
+
+void SlidingDFTBank::Process(const int16_t *input, size_t frames,
+                             size_t stride) {
+  constexpr float kScaling = 1.f / 32768.f;
+  for (size_t i = 0; i < frames; ++i) {
+    float sample = input[i * stride] * kScaling;
+    float &oldest = history_[history_index_];
+    float delta = sample - comb_gain_ * oldest;
+    oldest = sample;
+    if (++history_index_ == window_size_) {
+      history_index_ = 0;
+    }
+    UpdateBins(delta);
+  }
+}
+
+void SlidingDFTBank::Process(const float *input, size_t frames,
+                             size_t stride) {
+  for (size_t i = 0; i < frames; ++i) {
+    float sample = input[i * stride];
+    float &oldest = history_[history_index_];
+    float delta = sample - comb_gain_ * oldest;
+    oldest = sample;
+    if (++history_index_ == window_size_) {
+      history_index_ = 0;
+    }
+    UpdateBins(delta);
+  }
+}
+
+void SlidingDFTBank::UpdateBins(float delta) {
+  // The input term is the same for every bin, so the update is a complex
+  // rotation of the state followed by a broadcast add.
+#if defined(SLIDING_DFT_SSE)
+  const __m128 d = _mm_set1_ps(delta);
+  for (size_t k = 0; k < padded_count_; k += kSimdWidth) {
+    __m128 cr = _mm_load_ps(coefficient_real_ + k);
+    __m128 ci = _mm_load_ps(coefficient_imag_ + k);
+    __m128 sr = _mm_load_ps(state_real_ + k);
+    __m128 si = _mm_load_ps(state_imag_ + k);
+    __m128 nr = _mm_sub_ps(_mm_mul_ps(cr, sr), _mm_mul_ps(ci, si));
+    __m128 ni = _mm_add_ps(_mm_mul_ps(cr, si), _mm_mul_ps(ci, sr));
+    _mm_store_ps(state_real_ + k, _mm_add_ps(nr, d));
+    _mm_store_ps(state_imag_ + k, ni);
+  }
+#elif defined(SLIDING_DFT_NEON)
+  const float32x4_t d = vdupq_n_f32(delta);
+  for (size_t k = 0; k < padded_count_; k += kSimdWidth) {
+    float32x4_t cr = vld1q_f32(coefficient_real_ + k);
+    float32x4_t ci = vld1q_f32(coefficient_imag_ + k);
+    float32x4_t sr = vld1q_f32(state_real_ + k);
+    float32x4_t si = vld1q_f32(state_imag_ + k);
+    float32x4_t nr = vmlsq_f32(vmulq_f32(cr, sr), ci, si);
+    float32x4_t ni = vmlaq_f32(vmulq_f32(cr, si), ci, sr);
+    vst1q_f32(state_real_ + k, vaddq_f32(nr, d));
+    vst1q_f32(state_imag_ + k, ni);
+  }
+#else
+  for (size_t k = 0; k < padded_count_; ++k) {
+    float sr = state_real_[k];
+    float si = state_imag_[k];
+    state_real_[k] =
+        coefficient_real_[k] * sr - coefficient_imag_[k] * si + delta;
+    state_imag_[k] = coefficient_real_[k] * si + coefficient_imag_[k] * sr;
+  }
+#endif
+}
+
+void SlidingDFTBank::GetAmplitudes(float *destination) const {
+  // A sine of amplitude A on a bin frequency accumulates A / 2 times the sum
+  // of r^m over the window, except for the DC bin which sees the full A.
+  const float scale = 2.0f * (1.0f - kDampingFactor) / (1.0f - comb_gain_);
+  for (size_t k = 0; k < bin_count_; ++k) {
+    float magnitude =
+        std::sqrt(state_real_[k] * state_real_[k] +
+                  state_imag_[k] * state_imag_[k]) *
+        scale;
+    destination[k] = bin_frequencies_[k] > 0 ? magnitude : magnitude * 0.5f;
+  }
+}
+
+void SlidingDFTBank::GetDecibels(float *destination, float floor_db) const {
+  GetAmplitudes(destination);
+  for (size_t k = 0; k < bin_count_; ++k) {
+    float amplitude = destination[k];
+    destination[k] =
+        amplitude > 0 ? std::max(floor_db, 20 * log10f(amplitude)) : floor_db;
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef SLIDING_DFT_H
+#define SLIDING_DFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A bank of sliding DFT bins for monitoring a handful of frequencies (tone
+// detection, mains hum, a narrow-band level meter) without a full FFT.
+//
+// Every bin k tracks the DFT of the last |window_size| samples at one
+// frequency and is updated per input sample with
+//   S_k[n] = r * e^(j*w_k) * S_k[n-1] + x[n] - r^N * x[n-N]
+// which costs one complex multiply-add per bin and sample, independent of the
+// window size. The damping factor r < 1 keeps float rounding errors from
+// accumulating. Bin state is stored as structure-of-arrays padded to the SIMD
+// width so the per-sample update runs over 4 bins at a time on SSE and NEON.
+//
+// Frequencies snap to the nearest multiple of sample_rate / window_size, and
+// the window is rectangular, so neighbouring tones leak with a sinc response.
+class SlidingDFTBank {
+public:
+  static constexpr float kDampingFactor = 0.99999f;
+
+public:
+  SlidingDFTBank(const std::vector<float> &frequencies, float sample_rate,
+                 unsigned window_size);
+  ~SlidingDFTBank();
+
+  // Feeds |frames| samples, reading every |stride|-th value of |input| so that
+  // interleaved audio can be analysed on its first channel.
+  void Process(const int16_t *input, size_t frames, size_t stride = 1);
+  void Process(const float *input, size_t frames, size_t stride = 1);
+
+  // Writes the amplitude of each monitored frequency, normalized so that a
+  // full scale sine on a bin frequency reads 1.0.
+  void GetAmplitudes(float *destination) const;
+
+  // Same as GetAmplitudes() but in dBFS, with silence clamped to |floor_db|.
+  void GetDecibels(float *destination, float floor_db = -120.0f) const;
+
+  // Resets all bins and the sample history.
+  void Reset();
+
+  size_t size() const { return bin_count_; }
+  float sample_rate() const { return sample_rate_; }
+  unsigned window_size() const { return window_size_; }
+  // The frequency actually analysed by bin |index| after snapping.
+  float BinFrequency(size_t index) const { return bin_frequencies_[index]; }
+
+private:
+  void UpdateBins(float delta);
+
+private:
+  size_t bin_count_;
+  // bin_count_ rounded up to the SIMD width.
+  size_t padded_count_;
+  float sample_rate_;
+  unsigned window_size_;
+  float comb_gain_;
+  std::vector<float> bin_frequencies_;
+
+  // r * e^(j*w_k), split in real and imaginary parts.
+  float *coefficient_real_ = nullptr;
+  float *coefficient_imag_ = nullptr;
+  // Running DFT values.
+  float *state_real_ = nullptr;
+  float *state_imag_ = nullptr;
+
+  // The last window_size_ samples, for the comb term x[n - N].
+  std::vector<float> history_;
+  size_t history_index_ = 0;
+};
+
+#endif // SLIDING_DFT_H
@@ -0,0 +1,129 @@
+#include "talk_stats.h"
+#include "audio_source_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Level reported for digital silence.
+constexpr float kSilenceDb = -100.0f;
+
+} // namespace
+
+NoiseFloorTracker::NoiseFloorTracker(double window_seconds, float initial_db)
+    : slot_seconds_(window_seconds / kSlots), floor_db_(initial_db) {
+  std::fill_n(slots_, kSlots, initial_db);
+}
+
+float NoiseFloorTracker::Update(float level_db, double duration) {
+  if (current_seconds_ >= slot_seconds_) {
+    // Start a new slot, forgetting the oldest one.
+    current_ = (current_ + 1) % kSlots;
+    slots_[current_] = level_db;
+    current_seconds_ = 0;
+    floor_db_ = *std::min_element(slots_, slots_ + kSlots);
+  } else if (level_db < slots_[current_]) {
+    slots_[current_] = level_db;
+    floor_db_ = std::min(floor_db_, level_db);
+  }
+  current_seconds_ += duration;
+  return floor_db_;
+}
+
+class TalkStatsTracker::Track {
+public:
+  Stats stats;
+  NoiseFloorTracker noise_floor{kNoiseFloorWindowSeconds,
+                                kMinSpeechDb - kSpeechOverNoiseDb};
+  double hangover_remaining = 0;
+  double last_update = -1;
+};
+
+TalkStatsTracker::TalkStatsTracker() {}
+
+TalkStatsTracker::~TalkStatsTracker() {}
+
+TalkStatsTracker::Track *TalkStatsTracker::AddTrack(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto &track = tracks_[id];
+  if (!track) {
+    track = std::make_unique<Track>();
+  }
+  return track.get();
+}
+
+void TalkStatsTracker::RemoveTrack(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracks_.erase(id);
+}
+
+void TalkStatsTracker::Process(Track *track, const int16_t *data,
+                               size_t frames, int sample_rate, size_t channels,
+                               double now) {
+  if (frames == 0 || sample_rate <= 0 || channels == 0) {
+    return;
+  }
+  const size_t samples = frames * channels;
+  const uint64_t sum_of_squares = SumOfSquaresS16(data, samples);
+  const double mean_square =
+      double(sum_of_squares) / (double(samples) * 32768.0 * 32768.0);
+  const float level_db =
+      mean_square > 0
+          ? std::max(kSilenceDb, float(10 * std::log10(mean_square)))
+          : kSilenceDb;
+  const double duration = double(frames) / sample_rate;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const float noise_floor_db = track->noise_floor.Update(level_db, duration);
+  const float threshold =
+      std::max(kMinSpeechDb, noise_floor_db + kSpeechOverNoiseDb);
+  if (level_db > threshold) {
+    track->hangover_remaining = kHangoverSeconds;
+  } else {
+    track->hangover_remaining =
+        std::max(0.0, track->hangover_remaining - duration);
+  }
+  const bool voiced = track->hangover_remaining > 0;
+
+  Stats &stats = track->stats;
+  stats.total_seconds += duration;
+  stats.energy += mean_square * duration;
+  if (voiced) {
+    bool overlapping = IsAnotherTrackVoiced(track, now);
+    stats.voiced_seconds += duration;
+    if (overlapping) {
+      stats.overlap_seconds += duration;
+    }
+    if (!stats.voiced) {
+      ++stats.talk_spurts;
+      if (overlapping) {
+        ++stats.interruptions;
+      }
+    }
+  }
+  stats.voiced = voiced;
+  track->last_update = now;
+}
+
+std::map<std::string, TalkStatsTracker::Stats>
+TalkStatsTracker::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Stats> result;
+  for (const auto &entry : tracks_) {
+    result[entry.first] = entry.second->stats;
+  }
+  return result;
+}
+
+bool TalkStatsTracker::IsAnotherTrackVoiced(const Track *track,
+                                            double now) const {
+  for (const auto &entry : tracks_) {
+    const Track *other = entry.second.get();
+    if (other != track && other->stats.voiced &&
+        now - other->last_update <= kStaleSeconds) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,101 @@
+#ifndef TALK_STATS_H
+#define TALK_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Estimates the noise floor of a level in dB as its minimum over the last
+// |window_seconds|, kept as the minima of kSlots consecutive parts of the
+// window. Unlike a floor that creeps up while the level stays above it,
+// sustained speech or music cannot drag the estimate into the signal, as
+// long as it pauses once per window; a louder background is followed
+// within one window.
+class NoiseFloorTracker {
+public:
+  static constexpr int kSlots = 8;
+
+  NoiseFloorTracker(double window_seconds, float initial_db);
+
+  // Adds |duration| seconds at |level_db| and returns the floor.
+  float Update(float level_db, double duration);
+
+  float floor_db() const { return floor_db_; }
+
+private:
+  const double slot_seconds_;
+  float slots_[kSlots];
+  int current_ = 0;
+  // Time covered by the current slot.
+  double current_seconds_ = 0;
+  float floor_db_;
+};
+
+// Accumulates talk time statistics for a set of audio tracks, updated from
+// each track's audio callback so that meeting analytics (talk time,
+// interruptions, silence ratio) need no per-track level streams.
+//
+// Every callback is classified as voiced or not by an energy detector with an
+// adaptive noise floor and a short hangover that bridges pauses between
+// words. Overlap is measured on the wall clock: a voiced callback counts as
+// overlapping when any other track of the same tracker is voiced at that
+// time.
+class TalkStatsTracker {
+public:
+  // Speech must exceed the noise floor by this much, and never be quieter
+  // than kMinSpeechDb.
+  static constexpr float kSpeechOverNoiseDb = 12.0f;
+  static constexpr float kMinSpeechDb = -50.0f;
+  // The noise floor is the lowest level of this window.
+  static constexpr double kNoiseFloorWindowSeconds = 8.0;
+  // Time a track stays voiced after its level drops below the threshold.
+  static constexpr double kHangoverSeconds = 0.2;
+  // Tracks that delivered no audio for this long are not counted as voiced by
+  // other tracks (e.g. muted or paused tracks).
+  static constexpr double kStaleSeconds = 0.1;
+
+  struct Stats {
+    // Duration of audio processed.
+    double total_seconds = 0;
+    double voiced_seconds = 0;
+    // Voiced time during which another track was voiced too.
+    double overlap_seconds = 0;
+    // Sum of mean square level times duration, as WebRTC's totalAudioEnergy.
+    double energy = 0;
+    // Transitions from silence to speech.
+    uint32_t talk_spurts = 0;
+    // Talk spurts that started while another track was voiced.
+    uint32_t interruptions = 0;
+    bool voiced = false;
+  };
+
+  class Track;
+
+public:
+  TalkStatsTracker();
+  ~TalkStatsTracker();
+
+  // Starts tracking |id|. The returned track stays valid until RemoveTrack()
+  // or destruction of the tracker.
+  Track *AddTrack(const std::string &id);
+  void RemoveTrack(const std::string &id);
+
+  // Feeds one callback of interleaved 16-bit audio of |track|. |now| is a
+  // monotonic time in seconds shared by all tracks.
+  void Process(Track *track, const int16_t *data, size_t frames,
+               int sample_rate, size_t channels, double now);
+
+  std::map<std::string, Stats> GetStats() const;
+
+private:
+  bool IsAnotherTrackVoiced(const Track *track, double now) const;
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Track>> tracks_;
+};
+
+#endif // TALK_STATS_H
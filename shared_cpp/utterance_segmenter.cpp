@@ -0,0 +1,228 @@
+#include "utterance_segmenter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Level reported for digital silence.
+constexpr float kSilenceDb = -100.0f;
+constexpr double kPi = 3.14159265358979323846;
+
+size_t SamplesForMs(int ms) {
+  return size_t(std::max(ms, 0)) * UtteranceSegmenter::kSampleRate / 1000;
+}
+
+} // namespace
+
+// Streaming windowed-sinc resampler to kSampleRate. The kernel is tabulated
+// at kPhases fractional offsets and low-passes at 90% of the lower Nyquist
+// frequency, so downsampling does not fold noise and sibilants back into the
+// speech band.
+class UtteranceSegmenter::Resampler {
+public:
+  static constexpr int kHalfTaps = 16;
+  static constexpr int kTaps = 2 * kHalfTaps;
+  static constexpr int kPhases = 128;
+
+  explicit Resampler(int input_rate)
+      : step_(double(input_rate) / kSampleRate),
+        table_((kPhases + 1) * kTaps), history_(kHalfTaps - 1, 0.0f),
+        position_(kHalfTaps - 1) {
+    const double cutoff = 0.9 * std::min(1.0, 1 / step_);
+    for (int phase = 0; phase <= kPhases; ++phase) {
+      float *row = &table_[phase * kTaps];
+      double sum = 0;
+      for (int k = 0; k < kTaps; ++k) {
+        // Distance from the output instant to input sample k.
+        const double x = double(phase) / kPhases - (k - kHalfTaps + 1);
+        const double y = kPi * cutoff * x;
+        const double sinc = y == 0 ? 1 : std::sin(y) / y;
+        const double window =
+            0.42 + 0.5 * std::cos(kPi * x / kHalfTaps) +
+            0.08 * std::cos(2 * kPi * x / kHalfTaps);
+        row[k] = float(sinc * std::max(window, 0.0));
+        sum += row[k];
+      }
+      for (int k = 0; k < kTaps; ++k) {
+        row[k] = float(row[k] / sum);
+      }
+    }
+  }
+
+  // Appends the output for |size| more input samples to |output|.
+  void Process(const float *input, size_t size, std::vector<float> *output) {
+    history_.insert(history_.end(), input, input + size);
+    while (size_t(position_) + kHalfTaps < history_.size()) {
+      const size_t index = size_t(position_);
+      const int phase = int((position_ - double(index)) * kPhases + 0.5);
+      const float *row = &table_[phase * kTaps];
+      const float *x = &history_[index + 1 - kHalfTaps];
+      float sum = 0;
+      for (int k = 0; k < kTaps; ++k) {
+        sum += x[k] * row[k];
+      }
+      output->push_back(sum);
+      position_ += step_;
+    }
+    // Keep the samples that later outputs still need.
+    const size_t consumed = size_t(position_) + 1 - kHalfTaps;
+    history_.erase(history_.begin(), history_.begin() + consumed);
+    position_ -= double(consumed);
+  }
+
+private:
+  const double step_;
+  std::vector<float> table_;
+  std::vector<float> history_;
+  // Input position of the next output in |history_|.
+  double position_;
+};
+
+UtteranceSegmenter::UtteranceSegmenter(const Options &options,
+                                       Callback callback)
+    : options_(options), pre_roll_size_(SamplesForMs(options.pre_roll_ms)),
+      max_utterance_size_(std::max(SamplesForMs(options.max_utterance_ms),
+                                   kBlockSize)),
+      callback_(std::move(callback)), pre_roll_(pre_roll_size_),
+      noise_floor_(kNoiseFloorWindowSeconds,
+                   options.min_speech_db - options.speech_over_noise_db) {}
+
+UtteranceSegmenter::~UtteranceSegmenter() {}
+
+void UtteranceSegmenter::Process(const int16_t *data, size_t frames,
+                                 int sample_rate, size_t channels) {
+  if (frames == 0 || sample_rate <= 0 || channels == 0) {
+    return;
+  }
+  mono_.resize(frames);
+  const float scale = 1.0f / (32768.0f * float(channels));
+  for (size_t frame = 0; frame < frames; ++frame) {
+    int32_t sum = 0;
+    for (size_t channel = 0; channel < channels; ++channel) {
+      sum += data[frame * channels + channel];
+    }
+    mono_[frame] = float(sum) * scale;
+  }
+
+  const float *samples = mono_.data();
+  size_t size = frames;
+  if (sample_rate != kSampleRate) {
+    if (sample_rate != input_rate_) {
+      resampler_ = std::make_unique<Resampler>(sample_rate);
+    }
+    resampled_.clear();
+    resampler_->Process(mono_.data(), frames, &resampled_);
+    samples = resampled_.data();
+    size = resampled_.size();
+  }
+  input_rate_ = sample_rate;
+
+  // Complete the block left over from the previous call first.
+  size_t offset = 0;
+  if (!pending_.empty()) {
+    offset = std::min(size, kBlockSize - pending_.size());
+    pending_.insert(pending_.end(), samples, samples + offset);
+    if (pending_.size() < kBlockSize) {
+      return;
+    }
+    ProcessBlock(pending_.data());
+    pending_.clear();
+  }
+  for (; offset + kBlockSize <= size; offset += kBlockSize) {
+    ProcessBlock(samples + offset);
+  }
+  pending_.assign(samples + offset, samples + size);
+}
+
+void UtteranceSegmenter::Flush() {
+  if (in_utterance_) {
+    EndUtterance();
+  }
+}
+
+bool UtteranceSegmenter::IsVoiced(const float *block) {
+  float sum_of_squares = 0;
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    sum_of_squares += block[i] * block[i];
+  }
+  const float mean_square = sum_of_squares / kBlockSize;
+  const float level_db =
+      mean_square > 0 ? std::max(kSilenceDb, 10 * std::log10(mean_square))
+                      : kSilenceDb;
+  const float noise_floor_db =
+      noise_floor_.Update(level_db, double(kBlockSize) / kSampleRate);
+  const float threshold = std::max(
+      options_.min_speech_db, noise_floor_db + options_.speech_over_noise_db);
+  return level_db > threshold;
+}
+
+void UtteranceSegmenter::ProcessBlock(const float *block) {
+  const bool voiced = IsVoiced(block);
+  if (!in_utterance_) {
+    if (voiced) {
+      // Start with the pre-roll, oldest sample first.
+      if (utterance_.capacity() < max_utterance_size_ + kBlockSize) {
+        utterance_.reserve(max_utterance_size_ + kBlockSize);
+      }
+      utterance_.clear();
+      for (size_t i = 0; i < pre_roll_count_; ++i) {
+        utterance_.push_back(pre_roll_[(pre_roll_start_ + i) % pre_roll_size_]);
+      }
+      utterance_start_ = double(processed_ - pre_roll_count_) / kSampleRate;
+      utterance_.insert(utterance_.end(), block, block + kBlockSize);
+      in_utterance_ = true;
+      voiced_blocks_ = 1;
+      silent_blocks_ = 0;
+    } else if (pre_roll_size_ > 0) {
+      for (size_t i = 0; i < kBlockSize; ++i) {
+        pre_roll_[(pre_roll_start_ + pre_roll_count_) % pre_roll_size_] =
+            block[i];
+        if (pre_roll_count_ < pre_roll_size_) {
+          ++pre_roll_count_;
+        } else {
+          pre_roll_start_ = (pre_roll_start_ + 1) % pre_roll_size_;
+        }
+      }
+    }
+    processed_ += kBlockSize;
+    return;
+  }
+
+  utterance_.insert(utterance_.end(), block, block + kBlockSize);
+  processed_ += kBlockSize;
+  if (voiced) {
+    ++voiced_blocks_;
+    silent_blocks_ = 0;
+  } else {
+    ++silent_blocks_;
+  }
+  if (silent_blocks_ * kBlockSize >= SamplesForMs(options_.hangover_ms)) {
+    EndUtterance();
+  } else if (utterance_.size() >= max_utterance_size_) {
+    // Cut mid-speech: the next utterance continues right away.
+    EndUtterance();
+    if (voiced) {
+      utterance_.clear();
+      utterance_start_ = double(processed_) / kSampleRate;
+      in_utterance_ = true;
+      voiced_blocks_ = 0;
+      silent_blocks_ = 0;
+    }
+  }
+}
+
+void UtteranceSegmenter::EndUtterance() {
+  in_utterance_ = false;
+  pre_roll_start_ = 0;
+  pre_roll_count_ = 0;
+  if (voiced_blocks_ * kBlockSize < SamplesForMs(options_.min_speech_ms)) {
+    return;
+  }
+  // Keep as much trailing silence as pre-roll.
+  const size_t trailing = silent_blocks_ * kBlockSize;
+  if (trailing > pre_roll_size_) {
+    utterance_.resize(utterance_.size() - (trailing - pre_roll_size_));
+  }
+  callback_(utterance_.data(), utterance_.size(), utterance_start_);
+}
@@ -0,0 +1,98 @@
+#ifndef UTTERANCE_SEGMENTER_H
+#define UTTERANCE_SEGMENTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "talk_stats.h"
+
+// Cuts the audio of a track into utterances for speech-to-text, so that a
+// transcriber receives each utterance whole instead of a stream of 10 ms
+// frames.
+//
+// Input of any rate and channel count is mixed to mono and resampled to
+// kSampleRate with a windowed-sinc filter. Every 10 ms block is classified as
+// voiced or not by an energy detector over the noise floor of a
+// NoiseFloorTracker, as in TalkStatsTracker. An utterance starts
+// |pre_roll_ms| before its first voiced block, so soft onsets are kept, and
+// ends once no voice was detected for |hangover_ms|; as much trailing
+// silence is kept as leading. Utterances with less than |min_speech_ms| of
+// voice are dropped as clicks and noise, and long ones are cut at
+// |max_utterance_ms| to bound transcription latency.
+//
+// Samples accumulate in buffers reused across utterances, so processing
+// allocates nothing once the first utterance reached its full length.
+class UtteranceSegmenter {
+public:
+  static constexpr int kSampleRate = 16000;
+  static constexpr size_t kBlockSize = kSampleRate / 100;
+  static constexpr double kNoiseFloorWindowSeconds =
+      TalkStatsTracker::kNoiseFloorWindowSeconds;
+
+  struct Options {
+    int pre_roll_ms = 300;
+    int hangover_ms = 600;
+    int min_speech_ms = 250;
+    int max_utterance_ms = 20000;
+    // Voice must exceed the noise floor by this much, and never be quieter
+    // than min_speech_db.
+    float speech_over_noise_db = 12.0f;
+    float min_speech_db = -50.0f;
+  };
+
+  // Receives a finished utterance of |size| mono samples in [-1, 1] at
+  // kSampleRate, starting |start_seconds| after the first processed sample.
+  // |samples| is only valid during the call.
+  using Callback = std::function<void(const float *samples, size_t size,
+                                      double start_seconds)>;
+
+  UtteranceSegmenter(const Options &options, Callback callback);
+  ~UtteranceSegmenter();
+
+  // Feeds one callback of interleaved 16-bit audio. The rate may change from
+  // call to call.
+  void Process(const int16_t *data, size_t frames, int sample_rate,
+               size_t channels);
+
+  // Ends the utterance in progress, emitting it if it has enough voice.
+  void Flush();
+
+  bool in_utterance() const { return in_utterance_; }
+
+private:
+  class Resampler;
+
+  void ProcessBlock(const float *block);
+  bool IsVoiced(const float *block);
+  void EndUtterance();
+
+  const Options options_;
+  const size_t pre_roll_size_;
+  const size_t max_utterance_size_;
+  Callback callback_;
+
+  std::unique_ptr<Resampler> resampler_;
+  int input_rate_ = 0;
+  std::vector<float> mono_;
+  std::vector<float> resampled_;
+  // Resampled samples not yet forming a whole block.
+  std::vector<float> pending_;
+  // Unvoiced audio before an utterance, as a ring of |pre_roll_size_|.
+  std::vector<float> pre_roll_;
+  size_t pre_roll_start_ = 0;
+  size_t pre_roll_count_ = 0;
+
+  NoiseFloorTracker noise_floor_;
+  bool in_utterance_ = false;
+  std::vector<float> utterance_;
+  double utterance_start_ = 0;
+  size_t voiced_blocks_ = 0;
+  size_t silent_blocks_ = 0;
+  // Output samples processed so far, for start times.
+  uint64_t processed_ = 0;
+};
+
+#endif // UTTERANCE_SEGMENTER_H
@@ -0,0 +1,187 @@
+#include "video_quality_analyzer.h"
+#include "math_extras.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+template <typename Ops> float HorizontalSum(typename Ops::Float value) {
+  float lanes[Ops::kWidth];
+  Ops::Store(lanes, value);
+  float sum = 0;
+  for (float lane : lanes) {
+    sum += lane;
+  }
+  return sum;
+}
+
+// Accumulates the Laplacian 4c - l - r - u - d of |row| at [begin, end) into
+// |sum| and |sum_of_squares|. Returns the first index not processed.
+template <typename Ops>
+size_t LaplacianSums(const float *above, const float *row, const float *below,
+                     size_t begin, size_t end, double *sum,
+                     double *sum_of_squares) {
+  const auto four = Ops::Set(4.0f);
+  auto row_sum = Ops::Set(0.0f);
+  auto row_sum_of_squares = Ops::Set(0.0f);
+  size_t i = begin;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    auto neighbours =
+        Ops::Add(Ops::Add(Ops::Load(row + i - 1), Ops::Load(row + i + 1)),
+                 Ops::Add(Ops::Load(above + i), Ops::Load(below + i)));
+    auto laplacian = Ops::MulAdd(four, Ops::Load(row + i),
+                                 Ops::Sub(Ops::Set(0.0f), neighbours));
+    row_sum = Ops::Add(row_sum, laplacian);
+    row_sum_of_squares = Ops::MulAdd(laplacian, laplacian, row_sum_of_squares);
+  }
+  // Per row float sums stay exact enough; rows are accumulated in double.
+  *sum += HorizontalSum<Ops>(row_sum);
+  *sum_of_squares += HorizontalSum<Ops>(row_sum_of_squares);
+  return i;
+}
+
+template <typename Ops>
+size_t SquaredDifferenceSum(const float *a, const float *b, size_t begin,
+                            size_t end, double *sum) {
+  auto row_sum = Ops::Set(0.0f);
+  size_t i = begin;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    auto difference = Ops::Sub(Ops::Load(a + i), Ops::Load(b + i));
+    row_sum = Ops::MulAdd(difference, difference, row_sum);
+  }
+  *sum += HorizontalSum<Ops>(row_sum);
+  return i;
+}
+
+} // namespace
+
+VideoQualityAnalyzer::VideoQualityAnalyzer(double analysis_interval,
+                                           double report_interval)
+    : analysis_interval_(analysis_interval),
+      report_interval_(report_interval) {}
+
+bool VideoQualityAnalyzer::Process(const uint8_t *luma, int width, int height,
+                                   int stride, double now, Report *report) {
+  if (!luma || width <= 0 || height <= 0 || stride < width) {
+    return false;
+  }
+  // Count frames in (report_start_, now], so the rate is right from the
+  // first report on.
+  if (report_start_ < 0) {
+    report_start_ = now;
+  } else {
+    ++frames_received_;
+  }
+  if (now >= next_analysis_) {
+    next_analysis_ = now + analysis_interval_;
+    Analyze(luma, width, height, stride, now);
+  }
+
+  double elapsed = now - report_start_;
+  if (elapsed < report_interval_ || frames_analysed_ == 0) {
+    return false;
+  }
+  const float scale = 1.0f / frames_analysed_;
+  *report = sums_;
+  report->width = width;
+  report->height = height;
+  report->frame_rate = static_cast<float>(frames_received_ / elapsed);
+  report->mean_luma *= scale;
+  report->contrast *= scale;
+  report->blur_score *= scale;
+  report->frame_difference *= scale;
+  for (float &bin : report->histogram) {
+    bin *= scale;
+  }
+  report->frozen =
+      unchanged_since_ >= 0 && now - unchanged_since_ >= kFrozenSeconds;
+
+  sums_ = Report();
+  report_start_ = now;
+  frames_received_ = 0;
+  frames_analysed_ = 0;
+  return true;
+}
+
+void VideoQualityAnalyzer::Analyze(const uint8_t *luma, int width, int height,
+                                   int stride, double now) {
+  const int step = (width + kMaxAnalysisWidth - 1) / kMaxAnalysisWidth;
+  const int grid_width = width / step;
+  const int grid_height = height / step;
+  if (grid_width == 0 || grid_height == 0) {
+    // A strip thinner than the sampling step has no samples to average.
+    return;
+  }
+  if (grid_width != grid_width_ || grid_height != grid_height_) {
+    // A new resolution; the previous frame is not comparable.
+    grid_width_ = grid_width;
+    grid_height_ = grid_height;
+    previous_.clear();
+    unchanged_since_ = -1;
+  }
+  const size_t size = size_t(grid_width) * grid_height;
+  current_.resize(size);
+
+  // Point sampling keeps the high frequencies the blur score looks for.
+  uint32_t histogram[kHistogramBins] = {};
+  uint64_t sum = 0;
+  uint64_t sum_of_squares = 0;
+  for (int y = 0; y < grid_height; ++y) {
+    const uint8_t *source = luma + size_t(y) * step * stride;
+    float *destination = current_.data() + size_t(y) * grid_width;
+    for (int x = 0; x < grid_width; ++x) {
+      uint32_t value = source[x * step];
+      destination[x] = static_cast<float>(value);
+      ++histogram[value * kHistogramBins / 256];
+      sum += value;
+      sum_of_squares += value * value;
+    }
+  }
+  const double mean = double(sum) / size;
+  const double variance =
+      std::max(0.0, double(sum_of_squares) / size - mean * mean);
+  sums_.mean_luma += static_cast<float>(mean / 255);
+  sums_.contrast += static_cast<float>(std::sqrt(variance) / 255);
+  for (int i = 0; i < kHistogramBins; ++i) {
+    sums_.histogram[i] += float(histogram[i]) / size;
+  }
+
+  if (grid_width >= 3 && grid_height >= 3) {
+    double laplacian_sum = 0;
+    double laplacian_sum_of_squares = 0;
+    for (int y = 1; y + 1 < grid_height; ++y) {
+      const float *row = current_.data() + size_t(y) * grid_width;
+      size_t end = grid_width - 1;
+      size_t i = LaplacianSums<NativeMathOps>(row - grid_width, row,
+                                              row + grid_width, 1, end,
+                                              &laplacian_sum,
+                                              &laplacian_sum_of_squares);
+      LaplacianSums<ScalarMathOps>(row - grid_width, row, row + grid_width, i,
+                                   end, &laplacian_sum,
+                                   &laplacian_sum_of_squares);
+    }
+    const double count = double(grid_width - 2) * (grid_height - 2);
+    const double laplacian_mean = laplacian_sum / count;
+    sums_.blur_score += static_cast<float>(
+        std::max(0.0, laplacian_sum_of_squares / count -
+                          laplacian_mean * laplacian_mean));
+  }
+
+  if (previous_.size() == size) {
+    double difference = 0;
+    size_t i = SquaredDifferenceSum<NativeMathOps>(
+        current_.data(), previous_.data(), 0, size, &difference);
+    SquaredDifferenceSum<ScalarMathOps>(current_.data(), previous_.data(), i,
+                                        size, &difference);
+    difference /= size;
+    sums_.frame_difference += static_cast<float>(difference);
+    if (difference >= kFrozenDifference) {
+      unchanged_since_ = -1;
+    } else if (unchanged_since_ < 0) {
+      unchanged_since_ = now;
+    }
+  }
+  std::swap(current_, previous_);
+  ++frames_analysed_;
+}
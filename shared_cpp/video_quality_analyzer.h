@@ -0,0 +1,78 @@
+#ifndef VIDEO_QUALITY_ANALYZER_H
+#define VIDEO_QUALITY_ANALYZER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Summarizes the picture quality of a video track from the luma planes of
+// its frames, for camera preflight checks and in-call diagnostics:
+//   histogram         distribution of luma in kHistogramBins bins, as
+//                     fractions of the pixels
+//   mean_luma         brightness in [0, 1]
+//   contrast          standard deviation of luma in [0, 1]
+//   blur_score        variance of the Laplacian, in 8-bit luma units
+//                     squared; low values mean a blurry or flat picture
+//   frame_difference  mean squared luma difference to the previous analysed
+//                     frame; 0 for repeated frames
+//   frozen            the picture did not change for kFrozenSeconds
+//
+// Only one frame per analysis interval is analysed, subsampled to at most
+// kMaxAnalysisWidth columns, so the cost does not depend on the resolution
+// or frame rate and blur scores are comparable between resolutions.
+class VideoQualityAnalyzer {
+public:
+  static constexpr int kHistogramBins = 32;
+  static constexpr int kMaxAnalysisWidth = 160;
+  // Frame differences below this count as an unchanged picture. Encoders
+  // leave more noise than this even on a static scene.
+  static constexpr float kFrozenDifference = 0.05f;
+  static constexpr double kFrozenSeconds = 1.0;
+
+  struct Report {
+    int width = 0;
+    int height = 0;
+    // Frames received per second over the last report interval.
+    float frame_rate = 0;
+    float mean_luma = 0;
+    float contrast = 0;
+    float blur_score = 0;
+    float frame_difference = 0;
+    bool frozen = false;
+    std::array<float, kHistogramBins> histogram{};
+  };
+
+public:
+  VideoQualityAnalyzer(double analysis_interval = 0.25,
+                       double report_interval = 1.0);
+
+  // Feeds a frame whose luma plane is |luma|. |now| is a monotonic time in
+  // seconds. Returns true when a report is due, with the averages over the
+  // frames analysed since the previous report in |report|.
+  bool Process(const uint8_t *luma, int width, int height, int stride,
+               double now, Report *report);
+
+private:
+  void Analyze(const uint8_t *luma, int width, int height, int stride,
+               double now);
+
+private:
+  const double analysis_interval_;
+  const double report_interval_;
+
+  // Subsampled luma of the current and previous analysed frame.
+  std::vector<float> current_;
+  std::vector<float> previous_;
+  int grid_width_ = 0;
+  int grid_height_ = 0;
+
+  double next_analysis_ = 0;
+  double report_start_ = -1;
+  double unchanged_since_ = -1;
+  int frames_received_ = 0;
+  int frames_analysed_ = 0;
+  Report sums_;
+};
+
+#endif // VIDEO_QUALITY_ANALYZER_H
@@ -0,0 +1,89 @@
+#include "visualizer_shadow.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double ThreadCpuSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+}
+
+// Runs |process| and adds the CPU seconds the calling thread spent in it to
+// |seconds|.
+template <typename F> bool Timed(double *seconds, F process) {
+  const double start = ThreadCpuSeconds();
+  const bool result = process();
+  *seconds += ThreadCpuSeconds() - start;
+  return result;
+}
+
+} // namespace
+
+void VisualizerShadow::Stats::Add(const Stats &other) {
+  compared += other.compared;
+  primary_seconds += other.primary_seconds;
+  candidate_seconds += other.candidate_seconds;
+  total_difference += other.total_difference;
+  bands_compared += other.bands_compared;
+  max_difference = std::max(max_difference, other.max_difference);
+  divergent += other.divergent;
+}
+
+VisualizerShadow::VisualizerShadow(int bands_count, bool is_centered,
+                                   const Candidate &candidate)
+    : candidate_(bands_count, is_centered,
+                 AudioVisualizer::kDefaultSmoothingTimeConstant,
+                 candidate.min_frequency, candidate.max_frequency,
+                 AudioVisualizer::kDefaultMinDb, AudioVisualizer::kDefaultMaxDb,
+                 candidate.use_fixed_point, candidate.fft_size) {}
+
+bool VisualizerShadow::Process(AudioVisualizer *primary,
+                               const int16_t *audio_data, unsigned int frames,
+                               float sample_rate, std::vector<float> &output) {
+  double primary_seconds = 0;
+  double candidate_seconds = 0;
+  auto run_primary = [&] {
+    return Timed(&primary_seconds, [&] {
+      return primary->Process(audio_data, frames, sample_rate, output);
+    });
+  };
+  auto run_candidate = [&] {
+    return Timed(&candidate_seconds, [&] {
+      return candidate_.Process(audio_data, frames, sample_rate,
+                                candidate_bands_);
+    });
+  };
+  bool primary_ok;
+  bool candidate_ok;
+  if (candidate_first_) {
+    candidate_ok = run_candidate();
+    primary_ok = run_primary();
+  } else {
+    primary_ok = run_primary();
+    candidate_ok = run_candidate();
+  }
+  candidate_first_ = !candidate_first_;
+
+  if (primary_ok && candidate_ok && output.size() == candidate_bands_.size()) {
+    ++stats_.compared;
+    stats_.primary_seconds += primary_seconds;
+    stats_.candidate_seconds += candidate_seconds;
+    float max_difference = 0;
+    for (size_t i = 0; i < output.size(); ++i) {
+      const float difference = std::fabs(output[i] - candidate_bands_[i]);
+      stats_.total_difference += difference;
+      max_difference = std::max(max_difference, difference);
+    }
+    stats_.bands_compared += output.size();
+    stats_.max_difference = std::max(stats_.max_difference, max_difference);
+    if (max_difference > kDivergenceThreshold) {
+      ++stats_.divergent;
+    }
+  }
+  return primary_ok;
+}
@@ -0,0 +1,66 @@
+#ifndef VISUALIZER_SHADOW_H
+#define VISUALIZER_SHADOW_H
+
+#include "audio_visualizer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Runs a candidate AudioVisualizer configuration alongside the one in use on
+// the same audio, to validate a new engine on production audio before
+// switching to it. Only the primary's bands are returned; the candidate's
+// are compared with them and dropped.
+//
+// Processing time is the CPU time of the calling thread in each Process()
+// call, so that time spent preempted is not charged to either. The two run in alternating order so that neither always finds
+// the input in a warm cache.
+class VisualizerShadow {
+public:
+  // An analysis diverges when any band differs by more than this on the
+  // [0, 1] scale of the bars, a tenth of their height.
+  static constexpr float kDivergenceThreshold = 0.1f;
+
+  // Engine settings that a candidate may change.
+  struct Candidate {
+    bool use_fixed_point = AudioVisualizer::kDefaultUseFixedPoint;
+    unsigned fft_size = FFTProcessor::kDefaultFFTSize;
+    float min_frequency = AudioVisualizer::kDefaultMinFrequency;
+    float max_frequency = AudioVisualizer::kDefaultMaxFrequency;
+  };
+
+  struct Stats {
+    // Analyses for which both engines produced bands.
+    uint64_t compared = 0;
+    // Total processing CPU time of those analyses.
+    double primary_seconds = 0;
+    double candidate_seconds = 0;
+    // Sum and maximum of the per band absolute differences.
+    double total_difference = 0;
+    uint64_t bands_compared = 0;
+    float max_difference = 0;
+    // Analyses with a band differing by more than kDivergenceThreshold.
+    uint64_t divergent = 0;
+
+    void Add(const Stats &other);
+  };
+
+  VisualizerShadow(int bands_count, bool is_centered,
+                   const Candidate &candidate);
+
+  // Analyses the audio with |primary| into |output|, and with the candidate
+  // for comparison. Returns what |primary| returned.
+  bool Process(AudioVisualizer *primary, const int16_t *audio_data,
+               unsigned int frames, float sample_rate,
+               std::vector<float> &output);
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  AudioVisualizer candidate_;
+  std::vector<float> candidate_bands_;
+  bool candidate_first_ = false;
+  Stats stats_;
+};
+
+#endif // VISUALIZER_SHADOW_H
@@ -0,0 +1,318 @@
+#include "wav_playback.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAV_PLAYBACK_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WAV_PLAYBACK_NEON
+#endif
+
+namespace {
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+// WAV files are little endian, as are all hosts this builds for.
+uint16_t ReadU16(const uint8_t *p) {
+  uint16_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t ReadU32(const uint8_t *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+float ReadU8Sample(const uint8_t *p) { return (float(*p) - 128) / 128; }
+
+float ReadS16Sample(const uint8_t *p) {
+  int16_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return float(value) / 32768;
+}
+
+float ReadS24Sample(const uint8_t *p) {
+  int32_t value = int32_t(uint32_t(p[0]) << 8 | uint32_t(p[1]) << 16 |
+                          uint32_t(p[2]) << 24) >>
+                  8;
+  return float(value) / 8388608;
+}
+
+float ReadS32Sample(const uint8_t *p) {
+  int32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return float(double(value) / 2147483648.0);
+}
+
+float ReadF32Sample(const uint8_t *p) {
+  float value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+template <float (*Read)(const uint8_t *)>
+void DecodeRun(const uint8_t *input, size_t frames, const WavFormat &format,
+               size_t channels, float *output) {
+  const size_t sample_size = size_t(format.bits_per_sample / 8);
+  for (size_t frame = 0; frame < frames; ++frame) {
+    const uint8_t *samples = input + frame * format.block_align;
+    if (channels == 1) {
+      float sum = 0;
+      for (size_t channel = 0; channel < format.channels; ++channel) {
+        sum += Read(samples + channel * sample_size);
+      }
+      output[frame] = sum / float(format.channels);
+    } else {
+      for (size_t channel = 0; channel < channels; ++channel) {
+        size_t source = std::min(channel, format.channels - 1);
+        output[frame * channels + channel] =
+            Read(samples + source * sample_size);
+      }
+    }
+  }
+}
+
+// Linear interpolation of |frames| frames of |kChannels| channels, starting
+// |fraction| frames into |input| and advancing |step| frames per output
+// frame. The position is kept in 32.32 fixed point so the loop needs no
+// float to integer conversion.
+template <size_t kChannels>
+void Interpolate(const float *input, double fraction, double step,
+                 size_t frames, float *output) {
+  const uint64_t increment = uint64_t(step * 4294967296.0);
+  uint64_t position = uint64_t(fraction * 4294967296.0);
+  for (size_t frame = 0; frame < frames; ++frame) {
+    const float *a = input + (position >> 32) * kChannels;
+    const float t = float(uint32_t(position)) * (1.0f / 4294967296.0f);
+    for (size_t channel = 0; channel < kChannels; ++channel) {
+      output[frame * kChannels + channel] =
+          a[channel] + (a[kChannels + channel] - a[channel]) * t;
+    }
+    position += increment;
+  }
+}
+
+} // namespace
+
+bool ParseWav(const uint8_t *file, size_t size, WavFormat *format,
+              std::string *error) {
+  if (size < 12 || std::memcmp(file, "RIFF", 4) != 0 ||
+      std::memcmp(file + 8, "WAVE", 4) != 0) {
+    *error = "not a RIFF WAVE file";
+    return false;
+  }
+  uint16_t tag = 0;
+  bool has_format = false;
+  size_t offset = 12;
+  while (offset + 8 <= size) {
+    const uint8_t *chunk = file + offset;
+    const size_t chunk_size = ReadU32(chunk + 4);
+    const size_t body = offset + 8;
+    // Compared against what is left rather than summed with the offset, so
+    // that sizes near 4 GB cannot wrap a 32-bit size_t.
+    const size_t remaining = size - body;
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 &&
+        chunk_size <= remaining) {
+      tag = ReadU16(chunk + 8);
+      format->channels = ReadU16(chunk + 10);
+      format->sample_rate = int(ReadU32(chunk + 12));
+      format->block_align = ReadU16(chunk + 20);
+      format->bits_per_sample = ReadU16(chunk + 22);
+      if (tag == kFormatExtensible && chunk_size >= 40) {
+        // The first two bytes of the sub-format GUID are the format tag.
+        tag = ReadU16(chunk + 32);
+      }
+      has_format = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      if (!has_format) {
+        break;
+      }
+      const bool supported =
+          (tag == kFormatPcm && (format->bits_per_sample == 8 ||
+                                 format->bits_per_sample == 16 ||
+                                 format->bits_per_sample == 24 ||
+                                 format->bits_per_sample == 32)) ||
+          (tag == kFormatFloat && format->bits_per_sample == 32);
+      if (!supported || format->channels == 0 || format->sample_rate <= 0 ||
+          format->block_align !=
+              format->channels * size_t(format->bits_per_sample / 8)) {
+        *error = "unsupported sample format";
+        return false;
+      }
+      format->is_float = tag == kFormatFloat;
+      format->data = file + body;
+      format->frame_count =
+          std::min(chunk_size, remaining) / format->block_align;
+      return true;
+    }
+    if (chunk_size >= remaining) {
+      break;
+    }
+    // Chunks are padded to an even size.
+    offset = body + chunk_size + (chunk_size & 1);
+  }
+  *error = has_format ? "no data chunk" : "no fmt chunk before the data";
+  return false;
+}
+
+void FloatToS16(const float *input, size_t size, int16_t *output) {
+  size_t i = 0;
+#if defined(WAV_PLAYBACK_SSE2)
+  const __m128 scale = _mm_set1_ps(32767.0f);
+  const __m128 low = _mm_set1_ps(-1.0f);
+  const __m128 high = _mm_set1_ps(1.0f);
+  for (; i + 8 <= size; i += 8) {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i), low), high);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), low), high);
+    __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)),
+                                     _mm_cvtps_epi32(_mm_mul_ps(b, scale)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), packed);
+  }
+#elif defined(WAV_PLAYBACK_NEON)
+  const float32x4_t scale = vdupq_n_f32(32767.0f);
+  const float32x4_t low = vdupq_n_f32(-1.0f);
+  const float32x4_t high = vdupq_n_f32(1.0f);
+  for (; i + 8 <= size; i += 8) {
+    float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(input + i), low), high);
+    float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(input + i + 4), low), high);
+    int16x8_t packed =
+        vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(vmulq_f32(a, scale))),
+                     vqmovn_s32(vcvtnq_s32_f32(vmulq_f32(b, scale))));
+    vst1q_s16(output + i, packed);
+  }
+#endif
+  for (; i < size; ++i) {
+    float value = std::min(std::max(input[i], -1.0f), 1.0f);
+    output[i] = int16_t(std::lrint(value * 32767.0f));
+  }
+}
+
+WavPlayback::WavPlayback(const WavFormat &format, int sample_rate,
+                         size_t channels, bool loop)
+    : format_(format), sample_rate_(sample_rate),
+      channels_(std::max<size_t>(channels, 1)), loop_(loop),
+      step_(double(format.sample_rate) / double(sample_rate)),
+      copy_(format.sample_rate == sample_rate && format.channels == channels &&
+            format.bits_per_sample == 16 && !format.is_float) {}
+
+bool WavPlayback::Render(int16_t *output, size_t frames) {
+  const size_t samples = frames * channels_;
+  if (finished() || format_.frame_count == 0) {
+    std::fill_n(output, samples, int16_t(0));
+    return false;
+  }
+  const uint64_t first = uint64_t(position_);
+  if (copy_) {
+    size_t done = 0;
+    while (done < frames) {
+      uint64_t at = first + done;
+      if (loop_) {
+        at %= format_.frame_count;
+      }
+      if (at >= format_.frame_count) {
+        std::fill_n(output + done * channels_, (frames - done) * channels_,
+                    int16_t(0));
+        break;
+      }
+      size_t run = size_t(
+          std::min<uint64_t>(frames - done, format_.frame_count - at));
+      std::memcpy(output + done * channels_,
+                  format_.data + at * format_.block_align,
+                  run * format_.block_align);
+      done += run;
+    }
+  } else {
+    // Frames |first| to |first| + |span| - 1 cover every interpolation.
+    const double fraction = position_ - double(first);
+    const size_t span = size_t(fraction + double(frames - 1) * step_) + 2;
+    decoded_.resize(span * channels_);
+    resampled_.resize(samples);
+    DecodeFrames(first, span, decoded_.data());
+    if (channels_ == 1) {
+      Interpolate<1>(decoded_.data(), fraction, step_, frames,
+                     resampled_.data());
+    } else if (channels_ == 2) {
+      Interpolate<2>(decoded_.data(), fraction, step_, frames,
+                     resampled_.data());
+    } else {
+      for (size_t frame = 0; frame < frames; ++frame) {
+        const double x = fraction + double(frame) * step_;
+        const size_t index = size_t(x);
+        const float t = float(x - double(index));
+        const float *a = decoded_.data() + index * channels_;
+        const float *b = a + channels_;
+        for (size_t channel = 0; channel < channels_; ++channel) {
+          resampled_[frame * channels_ + channel] =
+              a[channel] + (b[channel] - a[channel]) * t;
+        }
+      }
+    }
+    FloatToS16(resampled_.data(), samples, output);
+  }
+  position_ += double(frames) * step_;
+  if (loop_) {
+    position_ = std::fmod(position_, double(format_.frame_count));
+  }
+  return true;
+}
+
+void WavPlayback::DecodeFrames(uint64_t position, size_t frames,
+                               float *output) const {
+  size_t done = 0;
+  while (done < frames) {
+    uint64_t at = position + done;
+    if (loop_) {
+      at %= format_.frame_count;
+    }
+    if (at >= format_.frame_count) {
+      std::fill_n(output + done * channels_, (frames - done) * channels_,
+                  0.0f);
+      return;
+    }
+    const size_t run =
+        size_t(std::min<uint64_t>(frames - done, format_.frame_count - at));
+    const uint8_t *input = format_.data + at * format_.block_align;
+    float *destination = output + done * channels_;
+    if (format_.is_float) {
+      DecodeRun<ReadF32Sample>(input, run, format_, channels_, destination);
+    } else if (format_.bits_per_sample == 8) {
+      DecodeRun<ReadU8Sample>(input, run, format_, channels_, destination);
+    } else if (format_.bits_per_sample == 16) {
+      DecodeRun<ReadS16Sample>(input, run, format_, channels_, destination);
+    } else if (format_.bits_per_sample == 24) {
+      DecodeRun<ReadS24Sample>(input, run, format_, channels_, destination);
+    } else {
+      DecodeRun<ReadS32Sample>(input, run, format_, channels_, destination);
+    }
+    done += run;
+  }
+}
+
+void WavPlayback::Seek(double seconds) {
+  position_ = std::min(std::max(seconds, 0.0) * format_.sample_rate,
+                       double(format_.frame_count));
+  if (loop_ && format_.frame_count > 0) {
+    position_ = std::fmod(position_, double(format_.frame_count));
+  }
+}
+
+double WavPlayback::position_seconds() const {
+  return position_ / format_.sample_rate;
+}
+
+double WavPlayback::duration_seconds() const {
+  return double(format_.frame_count) / format_.sample_rate;
+}
+
+bool WavPlayback::finished() const {
+  return !loop_ && position_ >= double(format_.frame_count);
+}
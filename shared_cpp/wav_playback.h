@@ -0,0 +1,82 @@
+#ifndef WAV_PLAYBACK_H
+#define WAV_PLAYBACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The audio of a WAV file image.
+struct WavFormat {
+  int sample_rate = 0;
+  size_t channels = 0;
+  // 8, 16, 24 or 32.
+  int bits_per_sample = 0;
+  // 32-bit IEEE float rather than integer samples.
+  bool is_float = false;
+  // Bytes per frame.
+  size_t block_align = 0;
+  // First frame, inside the file image.
+  const uint8_t *data = nullptr;
+  uint64_t frame_count = 0;
+};
+
+// Parses the RIFF header of the WAV file image |file| of |size| bytes.
+// Supports 8, 16, 24 and 32-bit integer and 32-bit float samples, with
+// plain or WAVE_FORMAT_EXTENSIBLE headers. A data chunk running past the end
+// of the file, as left by interrupted recorders, is truncated to it. Returns
+// false and sets |error| for anything else.
+bool ParseWav(const uint8_t *file, size_t size, WavFormat *format,
+              std::string *error);
+
+// Converts |size| floats in [-1, 1] to int16, rounding and saturating,
+// vectorized with SSE2 or NEON where available.
+void FloatToS16(const float *input, size_t size, int16_t *output);
+
+// Renders a WAV file image as 16-bit audio of any rate and channel count,
+// converting only the frames asked for, so nothing is decoded up front and
+// the file image can be memory-mapped. Samples are converted to float,
+// channels are averaged down or duplicated up, and the rate is changed by
+// linear interpolation, which suits speech and test signals but does not
+// filter aliasing when downsampling. 16-bit files already at the output rate
+// and layout are copied as is.
+class WavPlayback {
+public:
+  WavPlayback(const WavFormat &format, int sample_rate, size_t channels,
+              bool loop);
+
+  // Fills |output| with |frames| frames of interleaved audio. Plays silence
+  // past the end of a file that does not loop, and returns false once it
+  // did.
+  bool Render(int16_t *output, size_t frames);
+
+  // Moves to |seconds| into the file, clamped to its duration.
+  void Seek(double seconds);
+
+  double position_seconds() const;
+  double duration_seconds() const;
+  bool finished() const;
+
+  int sample_rate() const { return sample_rate_; }
+  size_t channels() const { return channels_; }
+
+private:
+  // Decodes |frames| input frames from |position| into |output|, mixed to
+  // the output channels, wrapping around when looping and padding with
+  // silence otherwise.
+  void DecodeFrames(uint64_t position, size_t frames, float *output) const;
+
+  const WavFormat format_;
+  const int sample_rate_;
+  const size_t channels_;
+  const bool loop_;
+  // Input frames per output frame.
+  const double step_;
+  const bool copy_;
+  // In input frames.
+  double position_ = 0;
+  std::vector<float> decoded_;
+  std::vector<float> resampled_;
+};
+
+#endif // WAV_PLAYBACK_H
@@ -0,0 +1,217 @@
+#include "yuv_scaler.h"
+#include "math_extras.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define YUV_SCALER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUV_SCALER_NEON
+#endif
+
+namespace {
+
+// BT.601 limited range.
+constexpr float kLumaScale = 1.164f;
+constexpr float kVToRed = 1.596f;
+constexpr float kUToGreen = -0.392f;
+constexpr float kVToGreen = -0.813f;
+constexpr float kUToBlue = 2.017f;
+
+// Adds |size| bytes of |source| to |sums|, or stores them with |first|.
+void AccumulateRow(const uint8_t *source, uint16_t *sums, size_t size,
+                   bool first) {
+  size_t i = 0;
+#if defined(YUV_SCALER_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+    __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i *destination = reinterpret_cast<__m128i *>(sums + i);
+    if (!first) {
+      low = _mm_add_epi16(low, _mm_loadu_si128(destination));
+      high = _mm_add_epi16(high, _mm_loadu_si128(destination + 1));
+    }
+    _mm_storeu_si128(destination, low);
+    _mm_storeu_si128(destination + 1, high);
+  }
+#elif defined(YUV_SCALER_NEON)
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t bytes = vld1q_u8(source + i);
+    uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+    uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+    if (!first) {
+      low = vaddq_u16(low, vld1q_u16(sums + i));
+      high = vaddq_u16(high, vld1q_u16(sums + i + 8));
+    }
+    vst1q_u16(sums + i, low);
+    vst1q_u16(sums + i + 8, high);
+  }
+#endif
+  for (; i < size; ++i) {
+    sums[i] = first ? source[i] : uint16_t(sums[i] + source[i]);
+  }
+}
+
+// Averages |plane| over the box of every destination column of one
+// destination row, whose source rows are |rows|. The rows are first summed
+// over the whole span of |columns|, which vectorizes, and each column box is
+// then summed from |column_sums|.
+template <typename Box>
+void AverageRow(const uint8_t *plane, int stride, const Box &rows,
+                const std::vector<Box> &columns, uint16_t *column_sums,
+                float *destination) {
+  const int first = columns.front().begin;
+  const size_t span = columns.back().begin + columns.back().count - first;
+  for (int r = 0; r < rows.count; ++r) {
+    AccumulateRow(plane + size_t(rows.begin + r) * stride + first,
+                  column_sums + first, span, r == 0);
+  }
+  const float row_scale = 1.0f / rows.count;
+  for (size_t x = 0; x < columns.size(); ++x) {
+    const uint16_t *sums = column_sums + columns[x].begin;
+    uint32_t sum = 0;
+    for (int i = 0; i < columns[x].count; ++i) {
+      sum += sums[i];
+    }
+    destination[x] = float(sum) * (row_scale / columns[x].count);
+  }
+}
+
+template <typename Ops>
+uint32_t *ConvertPixels(const float *y, const float *u, const float *v,
+                        size_t begin, size_t end, uint32_t *destination) {
+  const auto zero = Ops::Set(0.0f);
+  const auto max = Ops::Set(255.0f);
+  const auto half = Ops::Set(0.5f);
+  const auto alpha = Ops::SetInt(int32_t(0xff000000u));
+  size_t i = begin;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    auto luma = Ops::Mul(Ops::Sub(Ops::Load(y + i), Ops::Set(16.0f)),
+                         Ops::Set(kLumaScale));
+    auto cb = Ops::Sub(Ops::Load(u + i), Ops::Set(128.0f));
+    auto cr = Ops::Sub(Ops::Load(v + i), Ops::Set(128.0f));
+    auto red = Ops::MulAdd(cr, Ops::Set(kVToRed), luma);
+    auto green = Ops::MulAdd(cr, Ops::Set(kVToGreen),
+                             Ops::MulAdd(cb, Ops::Set(kUToGreen), luma));
+    auto blue = Ops::MulAdd(cb, Ops::Set(kUToBlue), luma);
+    // Clamp, round and pack as R, G, B, A bytes.
+    auto r = Ops::ToInt(Ops::Add(Ops::Min(Ops::Max(red, zero), max), half));
+    auto g = Ops::ToInt(Ops::Add(Ops::Min(Ops::Max(green, zero), max), half));
+    auto b = Ops::ToInt(Ops::Add(Ops::Min(Ops::Max(blue, zero), max), half));
+    auto pixels = Ops::Or(Ops::Or(r, Ops::template ShiftLeft<8>(g)),
+                          Ops::Or(Ops::template ShiftLeft<16>(b), alpha));
+    Ops::Store(reinterpret_cast<float *>(destination + i),
+               Ops::AsFloat(pixels));
+  }
+  return destination + i;
+}
+
+uint32_t PackPixel(float y, float u, float v) {
+  float luma = (y - 16.0f) * kLumaScale;
+  float cb = u - 128.0f;
+  float cr = v - 128.0f;
+  auto channel = [](float value) {
+    return uint32_t(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+  };
+  return channel(luma + kVToRed * cr) |
+         channel(luma + kUToGreen * cb + kVToGreen * cr) << 8 |
+         channel(luma + kUToBlue * cb) << 16 | 0xff000000u;
+}
+
+} // namespace
+
+I420ToRGBAScaler::I420ToRGBAScaler(int destination_width,
+                                   int destination_height)
+    : destination_width_(std::max(destination_width, 1)),
+      destination_height_(std::max(destination_height, 1)),
+      y_row_(destination_width_), u_row_(destination_width_),
+      v_row_(destination_width_) {}
+
+// static
+std::vector<I420ToRGBAScaler::Box>
+I420ToRGBAScaler::MakeBoxes(int source_begin, int source_length,
+                            int destination, int subsampling) {
+  std::vector<Box> boxes(destination);
+  const double scale = double(source_length) / destination;
+  const int source_end = source_begin + source_length;
+  for (int i = 0; i < destination; ++i) {
+    // Each box spans the source pixels whose left edge falls inside the
+    // destination pixel, and at least the one under its center.
+    int begin = source_begin + int(std::ceil(scale * i));
+    int end = source_begin + int(std::ceil(scale * (i + 1)));
+    if (end <= begin) {
+      begin = source_begin + int(scale * (i + 0.5));
+      end = begin + 1;
+    }
+    end = std::min(end, source_end);
+    begin = std::min(begin, end - 1);
+    if (end - begin > kMaxBoxSize) {
+      begin += (end - begin - kMaxBoxSize) / 2;
+      end = begin + kMaxBoxSize;
+    }
+    // The pixels of a subsampled plane that the box overlaps.
+    boxes[i].begin = begin / subsampling;
+    boxes[i].count = (end - 1) / subsampling - boxes[i].begin + 1;
+  }
+  return boxes;
+}
+
+void I420ToRGBAScaler::Configure(int width, int height) {
+  width_ = width;
+  height_ = height;
+  // Center crop to the destination aspect ratio.
+  int crop_width = width;
+  int crop_height = height;
+  if (int64_t(width) * destination_height_ >
+      int64_t(height) * destination_width_) {
+    crop_width = std::max(
+        1, int(int64_t(height) * destination_width_ / destination_height_));
+  } else {
+    crop_height = std::max(
+        1, int(int64_t(width) * destination_height_ / destination_width_));
+  }
+  int left = (width - crop_width) / 2;
+  int top = (height - crop_height) / 2;
+  luma_columns_ = MakeBoxes(left, crop_width, destination_width_, 1);
+  luma_rows_ = MakeBoxes(top, crop_height, destination_height_, 1);
+  chroma_columns_ = MakeBoxes(left, crop_width, destination_width_, 2);
+  chroma_rows_ = MakeBoxes(top, crop_height, destination_height_, 2);
+  column_sums_.resize(width);
+}
+
+void I420ToRGBAScaler::Convert(const uint8_t *y, int stride_y,
+                               const uint8_t *u, int stride_u,
+                               const uint8_t *v, int stride_v, int width,
+                               int height, uint8_t *destination,
+                               int destination_stride) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  if (width != width_ || height != height_) {
+    Configure(width, height);
+  }
+  const size_t size = destination_width_;
+  for (int row = 0; row < destination_height_; ++row) {
+    AverageRow(y, stride_y, luma_rows_[row], luma_columns_,
+               column_sums_.data(), y_row_.data());
+    AverageRow(u, stride_u, chroma_rows_[row], chroma_columns_,
+               column_sums_.data(), u_row_.data());
+    AverageRow(v, stride_v, chroma_rows_[row], chroma_columns_,
+               column_sums_.data(), v_row_.data());
+
+    uint32_t *pixels = reinterpret_cast<uint32_t *>(
+        destination + size_t(row) * destination_stride);
+    uint32_t *tail = ConvertPixels<NativeMathOps>(
+        y_row_.data(), u_row_.data(), v_row_.data(), 0, size, pixels);
+    for (size_t i = tail - pixels; i < size; ++i) {
+      pixels[i] = PackPixel(y_row_[i], u_row_[i], v_row_[i]);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef YUV_SCALER_H
+#define YUV_SCALER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Converts I420 frames to RGBA and downscales them in one pass, for video
+// thumbnails that are far smaller than the frames they show.
+//
+// Every destination pixel is the average of the source box it covers, an
+// area filter whose size follows the ratio, so fine detail does not alias
+// or shimmer from frame to frame at any reduction. Upscaled pixels take the
+// nearest source pixel. The source is center-cropped to the destination's
+// aspect ratio. Colors use BT.601 limited range, as WebRTC's I420 frames.
+class I420ToRGBAScaler {
+public:
+  // Boxes are at most this many pixels on a side, which keeps the sums of
+  // box rows within 16 bits. Only reductions beyond 256:1 are affected.
+  static constexpr int kMaxBoxSize = 256;
+
+  I420ToRGBAScaler(int destination_width, int destination_height);
+
+  int destination_width() const { return destination_width_; }
+  int destination_height() const { return destination_height_; }
+
+  // Writes destination_width() x destination_height() RGBA pixels with a
+  // stride of |destination_stride| bytes.
+  void Convert(const uint8_t *y, int stride_y, const uint8_t *u, int stride_u,
+               const uint8_t *v, int stride_v, int width, int height,
+               uint8_t *destination, int destination_stride);
+
+private:
+  // Source pixels averaged for one destination column or row.
+  struct Box {
+    int begin = 0;
+    int count = 1;
+  };
+
+  void Configure(int width, int height);
+  static std::vector<Box> MakeBoxes(int source_begin, int source_length,
+                                    int destination, int subsampling);
+
+private:
+  const int destination_width_;
+  const int destination_height_;
+
+  // Source size the tables below were built for.
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<Box> luma_columns_;
+  std::vector<Box> luma_rows_;
+  std::vector<Box> chroma_columns_;
+  std::vector<Box> chroma_rows_;
+
+  // Box rows of one plane summed per source column.
+  std::vector<uint16_t> column_sums_;
+  // One destination row of averaged planes, in [0, 255].
+  std::vector<float> y_row_;
+  std::vector<float> u_row_;
+  std::vector<float> v_row_;
+};
+
+#endif // YUV_SCALER_H